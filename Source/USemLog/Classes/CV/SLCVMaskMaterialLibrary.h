@@ -0,0 +1,56 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "SLCVMaskMaterialLibrary.generated.h"
+
+// Forward declarations
+class UMaterial;
+class UMaterialInstanceDynamic;
+
+/**
+ * Dynamic mask materials cached by their mask color, every color is created once
+ * from the template material and shared by all the mask clones using it
+ */
+UCLASS()
+class USLCVMaskMaterialLibrary : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	// Ctor
+	USLCVMaskMaterialLibrary();
+
+	// Load the template mask material
+	bool Init(const TCHAR* MaterialPath);
+
+	// Get init state
+	bool IsInit() const { return TemplateMaterial != nullptr; };
+
+	// Get the mask material of the color (created on the first request)
+	UMaterialInstanceDynamic* GetMaterial(const FColor& Color);
+
+	// Number of created mask materials
+	int32 GetNumMaterials() const { return Materials.Num(); };
+
+	// Number of mask material requests
+	int32 GetNumRequests() const { return NumRequests; };
+
+private:
+	// Template of the colored mask materials
+	UPROPERTY() // Avoid GC
+	UMaterial* TemplateMaterial;
+
+	// Mask materials keyed by their packed color
+	UPROPERTY() // Avoid GC
+	TMap<uint32, UMaterialInstanceDynamic*> Materials;
+
+	// Number of mask material requests
+	int32 NumRequests;
+
+	/* Constants */
+	static constexpr auto MaskColorParamName = TEXT("MaskColorParam");
+};
@@ -16,6 +16,7 @@ class ASkeletalMeshActor;
 class UStaticMeshComponent;
 class UPoseableMeshComponent;
 class ASLPoseableMeshActorWithMask;
+class USLCVMaskMaterialLibrary;
 
 /**
  * Sets scenes from episodic memories for scanning
@@ -35,8 +36,8 @@ public:
 	// Hide executed scene
 	void HideScene();
 
-	// Generate mask clones
-	bool GenerateMaskClones(const TCHAR* MaterialPath, bool bUseIndividualMaskValue = true, FColor MaskColor = FColor::White);
+	// Generate mask clones (the mask materials are shared through the library)
+	bool GenerateMaskClones(USLCVMaskMaterialLibrary* MaskMaterials, bool bUseIndividualMaskValue = true, FColor MaskColor = FColor::White);
 
 	// Show mask values of the scenes
 	void ShowMaskMaterials();
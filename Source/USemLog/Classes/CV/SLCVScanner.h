@@ -16,6 +16,7 @@ class UGameViewportClient;
 class UMaterialInstanceDynamic;
 class ADirectionalLight;
 class USLCVQScene;
+class USLCVMaskMaterialLibrary;
 
 /**
 * Scan modes
@@ -183,6 +184,9 @@ private:
 	// Print progress to terminal
 	void PrintProgress() const;
 
+	// Store the duration of the init phase started at the given time
+	void AddInitPhaseTime(const FString& PhaseName, double StartTime);
+
 	// Save image to file
 	void SaveToFile(const TArray<uint8>& CompressedBitmap) const;
 
@@ -350,6 +354,10 @@ protected:
 	UPROPERTY()
 	AStaticMeshActor* BackgroundSMA;
 
+	// Mask materials shared by the mask clones
+	UPROPERTY()
+	USLCVMaskMaterialLibrary* MaskMaterials;
+
 private:
 	// Camera poses on the unit sphere (this will be multiplied with each scenes bounds spehre radius)
 	TArray<FTransform> CameraScanUnitPoses;
@@ -360,6 +368,9 @@ private:
 	// Clones with dynamic mask materials on
 	TMap<USLVisibleIndividual*, AStaticMeshActor*> IndividualsMaskClones;
 
+	// Durations of the init phases (printed with the progress)
+	TArray<TPair<FString, double>> InitPhaseTimes;
+
 	// Current active view mode
 	ESLCVRenderMode PrevRenderMode = ESLCVRenderMode::NONE;
 
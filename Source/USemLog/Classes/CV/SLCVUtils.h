@@ -19,4 +19,7 @@ public:
 	{
 		return FMath::Abs(C1.R - C2.R) + FMath::Abs(C1.G - C2.G) + FMath::Abs(C1.B - C2.B);
 	}
+
+	// Get the init phase durations as a single line (e.g. "Phase=1.234s; ")
+	static FString GetInitTimesString(const TArray<TPair<FString, double>>& InitPhaseTimes);
 };
@@ -5,6 +5,9 @@
 
 #include "Owl/SLOwlDoc.h"
 
+// Forward declarations
+class USLBaseIndividual;
+
 /**
 * Abstract class ensuring every event can be represented as an Owl Node;
 */
@@ -57,4 +60,10 @@ public:
 
 	// Type name
 	virtual FString TypeName() const = 0;
+
+	// Pair id of the event participants (0 if the event is not between a pair of individuals)
+	virtual uint64 GetPairId() const { return 0; };
+
+	// Get the participants of the event with their roles (e.g. performed_by, object_acted_on)
+	virtual void GetParticipants(TArray<TPair<FString, USLBaseIndividual*>>& OutParticipants) const {};
 };
\ No newline at end of file
@@ -55,5 +55,15 @@ public:
 
 	// Get the event type name
 	virtual FString TypeName() const override { return FString(TEXT("Contact")); };
+
+	// Get the pair id of the event
+	virtual uint64 GetPairId() const override { return PairId; };
+
+	// Get the participants of the event with their roles
+	virtual void GetParticipants(TArray<TPair<FString, USLBaseIndividual*>>& OutParticipants) const override
+	{
+		OutParticipants.Emplace(TEXT("in_contact"), Individual1);
+		OutParticipants.Emplace(TEXT("in_contact"), Individual2);
+	};
 	/* End IEvent interface */
 };
\ No newline at end of file
@@ -4,11 +4,12 @@
 #pragma once
 
 #include "Events/ISLEventHandler.h"
+#include "Events/SLStartedEventsRegistry.h"
+#include "Events/SLContactEvent.h"
+#include "Events/SLSupportedByEvent.h"
 
 // Forward declarations
 class USLBaseIndividual;
-class FSLContactEvent;
-class FSLSupportedByEvent;
 struct FSLContactResult;
 
 /**
@@ -31,7 +32,7 @@ private:
 	void AddNewContactEvent(const FSLContactResult& InResult);
 
 	// Finish then publish the event
-	bool FinishContactEvent(USLBaseIndividual* InOther, float EndTime);
+	bool FinishContactEvent(USLBaseIndividual* InSelf, USLBaseIndividual* InOther, float EndTime);
 
 	// Start new supported by event
 	void AddNewSupportedByEvent(USLBaseIndividual* Supported, USLBaseIndividual* Supporting, float StartTime, const uint64 EventPairId);
@@ -58,11 +59,11 @@ private:
 	// Parent semantic overlap area
 	class ISLContactMonitorInterface* Parent = nullptr;
 
-	// Array of started contact events
-	TArray<TSharedPtr<FSLContactEvent>> StartedContactEvents;
+	// Started contact events
+	TSLStartedEventsRegistry<FSLContactEvent> StartedContactEvents;
 
-	// Array of started supported by events
-	TArray<TSharedPtr<FSLSupportedByEvent>> StartedSupportedByEvents;
+	// Started supported by events
+	TSLStartedEventsRegistry<FSLSupportedByEvent> StartedSupportedByEvents;
 	
 	/* Constant values */
 	constexpr static float ContactEventMin = 0.3f;
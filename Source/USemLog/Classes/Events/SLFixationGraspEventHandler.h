@@ -4,11 +4,12 @@
 #pragma once
 
 #include "Events/ISLEventHandler.h"
+#include "Events/SLGraspEvent.h"
+#include "Events/SLStartedEventsRegistry.h"
 
 // Forward declarations
 class AActor;
 class USLBaseIndividual;
-class FSLGraspEvent;
 
 /**
  * Listens to fixation grasp events input, and outputs finished semantic grasp events
@@ -30,7 +31,7 @@ private:
 	void AddNewEvent(USLBaseIndividual* Self, USLBaseIndividual* Other, float StartTime);
 
 	// Finish then publish the event
-	bool FinishEvent(USLBaseIndividual* InOther, float EndTime);
+	bool FinishEvent(USLBaseIndividual* InSelf, USLBaseIndividual* InOther, float EndTime);
 
 	// Terminate and publish started events (this usually is called at end play)
 	void FinishAllEvents(float EndTime);
@@ -49,6 +50,6 @@ private:
 	USLBaseIndividual* Parent;
 #endif // SL_WITH_MC_GRASP
 
-	// Array of started events
-	TArray<TSharedPtr<FSLGraspEvent>> StartedEvents;
+	// Started events
+	TSLStartedEventsRegistry<FSLGraspEvent> StartedEvents;
 };
@@ -59,5 +59,15 @@ public:
 
 	// Get the event type name
 	virtual FString TypeName() const override { return FString(TEXT("Grasp")); };
+
+	// Get the pair id of the event
+	virtual uint64 GetPairId() const override { return PairId; };
+
+	// Get the participants of the event with their roles
+	virtual void GetParticipants(TArray<TPair<FString, USLBaseIndividual*>>& OutParticipants) const override
+	{
+		OutParticipants.Emplace(TEXT("performed_by"), Manipulator);
+		OutParticipants.Emplace(TEXT("object_acted_on"), Individual);
+	};
 	/* End IEvent interface */
 };
\ No newline at end of file
@@ -5,11 +5,11 @@
 
 #include "Events/ISLEventHandler.h"
 #include "Events/SLContactEvent.h"
+#include "Events/SLStartedEventsRegistry.h"
 #include "TimerManager.h"
 
 // Forward declarations
 class USLBaseIndividual;
-class FSLContactEvent;
 struct FSLContactResult;
 
 /**
@@ -32,7 +32,7 @@ private:
 	void AddNewEvent(const FSLContactResult& InResult);
 
 	// Finish then publish the event
-	bool FinishEvent(USLBaseIndividual* InOther, float EndTime);
+	bool FinishEvent(USLBaseIndividual* InSelf, USLBaseIndividual* InOther, float EndTime);
 
 	// Terminate and publish started events (this usually is called at end play)
 	void FinishAllEvents(float EndTime);
@@ -47,6 +47,6 @@ private:
 	// Parent semantic overlap area
 	class USLManipulatorMonitor* Parent = nullptr;
 
-	// Array of started contact events
-	TArray<TSharedPtr<FSLContactEvent>> StartedEvents;
+	// Started contact events
+	TSLStartedEventsRegistry<FSLContactEvent> StartedEvents;
 };
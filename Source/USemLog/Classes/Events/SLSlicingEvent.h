@@ -66,5 +66,17 @@ public:
 
 	// Get the event type name
 	virtual FString TypeName() const override { return FString(TEXT("Slicing")); };
+
+	// Get the pair id of the event
+	virtual uint64 GetPairId() const override { return PairId; };
+
+	// Get the participants of the event with their roles
+	virtual void GetParticipants(TArray<TPair<FString, USLBaseIndividual*>>& OutParticipants) const override
+	{
+		OutParticipants.Emplace(TEXT("performed_by"), PerformedBy);
+		OutParticipants.Emplace(TEXT("device_used"), DeviceUsed);
+		OutParticipants.Emplace(TEXT("object_acted_on"), ObjectActedOn);
+		OutParticipants.Emplace(TEXT("outputs_created"), CreatedSlice);
+	};
 	/* End IEvent interface */
 };
\ No newline at end of file
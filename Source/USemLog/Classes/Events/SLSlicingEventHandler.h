@@ -5,6 +5,7 @@
 
 #include "Events/ISLEventHandler.h"
 #include "Events/SLSlicingEvent.h"
+#include "Events/SLStartedEventsRegistry.h"
 
 /**
  * Listens to Slicing events input, and outputs finished semantic Slicing events
@@ -26,7 +27,7 @@ private:
 	void AddNewEvent(USLBaseIndividual* PerformedBy, USLBaseIndividual* DeviceUsed, USLBaseIndividual* ObjectActedOn, float StartTime);
 
 	// Finish then publish the event
-	bool FinishEvent(USLBaseIndividual* InObjectActedOn, bool bTaskSuccessful, float EndTime, USLBaseIndividual* OutputsCreated);
+	bool FinishEvent(USLBaseIndividual* InPerformedBy, USLBaseIndividual* InObjectActedOn, bool bTaskSuccessful, float EndTime, USLBaseIndividual* OutputsCreated);
 
 	// Terminate and publish started events (this usually is called at end play)
 	void FinishAllEvents(float EndTime);
@@ -54,6 +55,6 @@ private:
 	UObject* Parent;
 #endif // SL_WITH_Slicing
 
-	// Array of started events
-	TArray<TSharedPtr<FSLSlicingEvent>> StartedEvents;
+	// Started events
+	TSLStartedEventsRegistry<FSLSlicingEvent> StartedEvents;
 };
@@ -0,0 +1,82 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Started (not yet finished) events of a handler keyed by their (self, other) pair id (FSLUuid::PairEncodeCantor),
+ * events of the same pair are finished in their start order
+ */
+template<typename EventType>
+class TSLStartedEventsRegistry
+{
+public:
+	// Add a started event
+	void Add(const TSharedPtr<EventType>& Event)
+	{
+		PairIdToEvents.FindOrAdd(Event->PairId).Add(Event);
+		NumEvents++;
+	}
+
+	// Remove and return the earliest started event of the pair (invalid if the pair has no started events)
+	TSharedPtr<EventType> Remove(uint64 PairId)
+	{
+		TSharedPtr<EventType> Event;
+		if (FEventsArray* Events = PairIdToEvents.Find(PairId))
+		{
+			Event = (*Events)[0];
+			if (Events->Num() == 1)
+			{
+				PairIdToEvents.Remove(PairId);
+			}
+			else
+			{
+				Events->RemoveAt(0, 1, false);
+			}
+			NumEvents--;
+		}
+		return Event;
+	}
+
+	// Remove all the events, returned in their start order (used for finishing them at end play)
+	TArray<TSharedPtr<EventType>> RemoveAll()
+	{
+		TArray<TSharedPtr<EventType>> AllEvents;
+		AllEvents.Reserve(NumEvents);
+		for (const auto& Pair : PairIdToEvents)
+		{
+			AllEvents.Append(Pair.Value);
+		}
+		AllEvents.StableSort([](const TSharedPtr<EventType>& A, const TSharedPtr<EventType>& B)
+		{
+			return A->StartTime < B->StartTime;
+		});
+		Empty();
+		return AllEvents;
+	}
+
+	// True if the pair has started events
+	bool Contains(uint64 PairId) const { return PairIdToEvents.Contains(PairId); };
+
+	// Number of started events
+	int32 Num() const { return NumEvents; };
+
+	// Remove all the events without finishing them
+	void Empty()
+	{
+		PairIdToEvents.Empty();
+		NumEvents = 0;
+	}
+
+private:
+	// Usually there is only one started event per pair
+	typedef TArray<TSharedPtr<EventType>, TInlineAllocator<1>> FEventsArray;
+
+	// Pair id to the started events of the pair
+	TMap<uint64, FEventsArray> PairIdToEvents;
+
+	// Number of started events
+	int32 NumEvents = 0;
+};
@@ -55,5 +55,15 @@ public:
 
 	// Get the event type name
 	virtual FString TypeName() const override { return FString(TEXT("SupportedBy")); };
+
+	// Get the pair id of the event
+	virtual uint64 GetPairId() const override { return PairId; };
+
+	// Get the participants of the event with their roles
+	virtual void GetParticipants(TArray<TPair<FString, USLBaseIndividual*>>& OutParticipants) const override
+	{
+		OutParticipants.Emplace(TEXT("supported"), SupportedIndividual);
+		OutParticipants.Emplace(TEXT("supporting"), SupportingIndividual);
+	};
 	/* End IEvent interface */
 };
\ No newline at end of file
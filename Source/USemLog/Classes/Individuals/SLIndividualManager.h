@@ -75,6 +75,20 @@ public:
 	// Get the individual component owner from the unique id
 	AActor* GetIndividualActor(const FString& Id);
 
+	/* Handle based quick access (replay hot paths) */
+	// Get the dense handles of the ids (e.g. from the episode meta collection), new ids are appended to the handle table,
+	// ids without an individual in the world get INDEX_NONE
+	TArray<int32> GetIndividualHandles(const TArray<FString>& Ids);
+
+	// Get the dense handle of the id (INDEX_NONE if there is no such individual in the world)
+	int32 GetIndividualHandle(const FString& Id);
+
+	// Get the individual from its handle
+	USLBaseIndividual* GetIndividualByHandle(int32 Handle) const { return HandleToIndividuals.IsValidIndex(Handle) ? HandleToIndividuals[Handle] : nullptr; };
+
+	// Number of assigned handles (upper bound of the handle values, used for sizing handle indexed arrays)
+	int32 GetNumIndividualHandles() const { return HandleToIndividuals.Num(); };
+
 	// Spawn or get manager from the world
 	static ASLIndividualManager* GetExistingOrSpawnNew(UWorld* World);
 
@@ -119,6 +133,9 @@ private:
 	// Remove from cache
 	bool RemoveFromCache(USLIndividualComponent* IC);
 
+	// Invalidate the handle of the id
+	void RemoveHandle(const FString& Id);
+
 	// Triggered by external destruction of individual component
 	UFUNCTION()
 	void OnIndividualComponentDestroyed(USLIndividualComponent* DestroyedComponent);
@@ -178,6 +195,16 @@ private:
 	TMap<FString, USLIndividualComponent*> IdToIndividualComponents;
 
 
+	/* Handle based quick access mappings */
+	// Handle to individual object (removed individuals are kept as null to keep the handles stable)
+	UPROPERTY(VisibleAnywhere, Transient, Category = "Semantic Logger")
+	TArray<USLBaseIndividual*> HandleToIndividuals;
+
+	// Id to handle
+	UPROPERTY(VisibleAnywhere, Transient, Category = "Semantic Logger")
+	TMap<FString, int32> IdToHandle;
+
+
 
 
 
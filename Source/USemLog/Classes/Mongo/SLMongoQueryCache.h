@@ -0,0 +1,105 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/List.h"
+
+/*
+* Decoded result of an individual pose or trajectory query
+*/
+struct FSLMongoQueryCacheEntry
+{
+	// Individual poses
+	TArray<FTransform> Poses;
+
+	// Skeletal individual poses (root and bone poses)
+	TArray<TPair<FTransform, TMap<int32, FTransform>>> SkeletalPoses;
+
+	// Estimated memory usage of the entry
+	int64 SizeBytes = 0;
+
+	// Position in the recently used list
+	TDoubleLinkedList<FString>::TDoubleLinkedListNode* LruNode = nullptr;
+};
+
+/**
+ * Bounded least recently used cache of the decoded query results of the (task, episode) time windows,
+ * repeated queries are answered from memory, the least recently used results are evicted when the memory cap is reached
+ */
+class FSLMongoQueryCache
+{
+public:
+	// Ctor
+	FSLMongoQueryCache(int64 InMaxSizeBytes = 64 * 1024 * 1024);
+
+	// Set the memory cap (evicts the least recently used entries if needed)
+	void SetMaxSize(int64 InMaxSizeBytes);
+
+	// Get the cached poses of the query (marks the entry as recently used)
+	bool FindPoses(const FString& Key, TArray<FTransform>& OutPoses);
+
+	// Get the cached skeletal poses of the query (marks the entry as recently used)
+	bool FindSkeletalPoses(const FString& Key, TArray<TPair<FTransform, TMap<int32, FTransform>>>& OutSkeletalPoses);
+
+	// Cache the poses of the query
+	void AddPoses(const FString& Key, const TArray<FTransform>& Poses);
+
+	// Cache the skeletal poses of the query
+	void AddSkeletalPoses(const FString& Key, const TArray<TPair<FTransform, TMap<int32, FTransform>>>& SkeletalPoses);
+
+	// Remove all entries (the hit and miss counters are kept)
+	void Empty();
+
+	// Get the number of cached queries
+	int32 Num() const { return Entries.Num(); };
+
+	// Get the estimated memory usage
+	int64 GetSizeBytes() const { return SizeBytes; };
+
+	// Get the number of queries answered from the cache
+	int64 GetNumHits() const { return NumHits; };
+
+	// Get the number of queries forwarded to the database
+	int64 GetNumMisses() const { return NumMisses; };
+
+	// Get the cache usage as string
+	FString GetStatsString() const;
+
+	// Key of the query in the given task and episode (the timestamps are kept with microsecond precision)
+	static FString MakeKey(const TCHAR* QueryType, const FString& TaskId, const FString& EpisodeId, const FString& IndividualId,
+		float StartTs, float EndTs = 0.f, float DeltaT = 0.f);
+
+private:
+	// Find the entry and move it to the front of the recently used list
+	const FSLMongoQueryCacheEntry* FindAndTouch(const FString& Key);
+
+	// Insert the entry as the most recently used one, evicts the least recently used entries to fit it
+	void Add(const FString& Key, FSLMongoQueryCacheEntry&& Entry);
+
+	// Remove the least recently used entries until the given size fits in the memory cap
+	void EvictToFit(int64 NewEntrySize);
+
+	// Remove the entry
+	void Remove(const FString& Key);
+
+private:
+	// Cached results
+	TMap<FString, FSLMongoQueryCacheEntry> Entries;
+
+	// Keys from the most to the least recently used
+	TDoubleLinkedList<FString> LruList;
+
+	// Memory cap
+	int64 MaxSizeBytes;
+
+	// Estimated memory usage of the entries
+	int64 SizeBytes;
+
+	// Number of queries answered from the cache
+	int64 NumHits;
+
+	// Number of queries forwarded to the database
+	int64 NumMisses;
+};
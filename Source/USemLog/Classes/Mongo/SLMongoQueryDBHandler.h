@@ -4,9 +4,12 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Mongo/SLMongoQueryStructs.h"
+#include "HAL/CriticalSection.h"
 
 #if SL_WITH_LIBMONGO_C
 class ASLVisionPoseableMeshActor;
+struct FSLMongoRawFrameBatch;
 THIRD_PARTY_INCLUDES_START
 #if PLATFORM_WINDOWS
 	#include "Windows/AllowWindowsPlatformTypes.h"
@@ -42,32 +45,111 @@ public:
 	// Disconnect and clean db connection
 	void Disconnect();
 
+	// Initialize libmongoc on the first use, the handlers can connect from multiple threads (thread safe)
+	static void AcquireMongoLib();
+
+	// Clean up libmongoc when the last user releases it (thread safe)
+	static void ReleaseMongoLib();
+
 	// Everything is set in order to query the data
 	bool IsReady() const { return bConnected && bDatabaseSet && bCollectionSet; };
 
+	// True if the collection uses the compact binary world state schema
+	bool IsCompactBinary() const { return bCompactBinary; };
+
+	// True if the trajectory collection (<episode>.traj) is available, used by the individual pose and trajectory queries
+	bool HasTrajectoryCollection() const { return bHasTrajCollection; };
+
+	// Build (or rebuild) the trajectory collection of the current episode (offline indexing of already logged episodes)
+	bool BuildTrajectoryCollection(float BucketDuration = 10.f);
+
 	/* Queries */
-	// Get the pose of the individual at the given time
-	FTransform GetIndividualPoseAt(const FString& Id, float Ts) const;
+	// Get the pose of the individual at the given time (bOutFound is set if the pose was read from the database)
+	FTransform GetIndividualPoseAt(const FString& Id, float Ts, bool* bOutFound = nullptr) const;
 
-	// Get the poses of the individual between the given timestamps
-	TArray<FTransform> GetIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT = -1.f) const;
+	// Get the poses of the individual between the given timestamps (first pose of every DeltaT time bucket, sampled on the server),
+	// bOutFound is set if the poses were read from the database
+	TArray<FTransform> GetIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT = -1.f, bool* bOutFound = nullptr) const;
 
-	// Get skeletal individual pose
-	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(const FString& Id, float Ts) const;
+	// Get skeletal individual pose (bOutFound is set if the pose was read from the database)
+	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(const FString& Id, float Ts, bool* bOutFound = nullptr) const;
 
-	// Get skeletal individual trajectory
-	TArray<TPair<FTransform, TMap<int32, FTransform>>> GetSkeletalIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT = -1.f) const;
+	// Get skeletal individual trajectory (sampled on the server as above), only the given bones are returned if the bone indexes are set
+	TArray<TPair<FTransform, TMap<int32, FTransform>>> GetSkeletalIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT = -1.f,
+		const TArray<int32>& BoneIndexes = TArray<int32>(), bool* bOutFound = nullptr) const;
 
 	// Get the whole episode data
-	TArray<TPair<float, TMap<FString, FTransform>>> GetEpisodeData() const;
+	FSLMongoEpisodeData GetEpisodeData() const;
+
+	// Get the episode data between the given timestamps (inclusive)
+	FSLMongoEpisodeData GetEpisodeData(double StartTs, double EndTs) const;
+
+	// Individual ids in the meta collection order (the episode data pose indexes)
+	const TArray<FString>& GetMetaIndividualIds() const { return MetaIndividualIds; };
 
-	// Get the whole episode data in an async thread
-	TArray<TPair<float, TMap<FString, FTransform>>> GetEpisodeDataAsync() const;
+	// Get the sorted timestamps of all the episode frames (used for windowed loading, see FSLVizEpisodeStreamer)
+	TArray<double> GetEpisodeTimestamps() const;
 
 	// Get the episode data at the given timestamp (frame)
 	TMap<FString, FTransform> GetFrameData(float Ts);
 
 private:
+	/* Trajectory collection queries */
+	// Get the pose of the individual at the given time from its trajectory bucket
+	FTransform GetIndividualPoseAtTraj(const FString& Id, float Ts, bool* bOutFound = nullptr) const;
+
+	// Get the poses of the individual between the given timestamps from its trajectory buckets
+	TArray<FTransform> GetIndividualTrajectoryTraj(const FString& Id, float StartTs, float EndTs, float DeltaT, bool* bOutFound = nullptr) const;
+
+	/* Compact binary schema queries */
+	// Get the pose of the individual at the given time
+	FTransform GetIndividualPoseAtCompact(const FString& Id, float Ts, bool* bOutFound = nullptr) const;
+
+	// Get the poses of the individual between the given timestamps
+	TArray<FTransform> GetIndividualTrajectoryCompact(const FString& Id, float StartTs, float EndTs, float DeltaT, bool* bOutFound = nullptr) const;
+
+	// Get skeletal individual pose
+	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAtCompact(const FString& Id, float Ts, bool* bOutFound = nullptr) const;
+
+	// Get skeletal individual trajectory
+	TArray<TPair<FTransform, TMap<int32, FTransform>>> GetSkeletalIndividualTrajectoryCompact(const FString& Id, float StartTs, float EndTs, float DeltaT,
+		const TArray<int32>& BoneIndexes, bool* bOutFound = nullptr) const;
+
+	// Check if the collection frames are written with the compact binary schema
+	bool DetectCompactBinarySchema();
+
+	// Load the individual ids from the meta collection (the position in the array is the compact schema index)
+	bool LoadMetaIndividualIds();
+
+	// Get the meta index of the individual (INDEX_NONE if not found)
+	int32 GetMetaIdx(const FString& Id) const;
+
+#if SL_WITH_LIBMONGO_C
+	/* Compact binary schema helpers */
+	// Get the pose of the individual with the given meta index from the binary blob
+	bool GetBinaryPose(const bson_t* doc, int32 MetaIdx, FTransform& OutPose) const;
+
+	// Get the skeletal pose of the individual with the given meta index from the binary blob (optionally only the given bones)
+	bool GetBinarySkeletalPose(const bson_t* doc, int32 MetaIdx, TPair<FTransform, TMap<int32, FTransform>>& OutSkeletalPose,
+		const TArray<int32>* BoneIndexes = nullptr) const;
+
+	// Get all the individual poses (keyed by the meta index) from the binary blob
+	void GetBinaryFrame(const bson_t* doc, TArray<TPair<int32, FTransform>>& OutPoses) const;
+
+	// Get the binary blob data from the document
+	bool GetBinaryData(const bson_t* doc, const char* key, const uint8*& OutData, const uint8*& OutEnd) const;
+
+	// Convert the stored pose to the engine frame
+	FTransform ToEnginePose(const FTransform& StoredPose) const;
+
+	// Decode the raw frame documents of the batch (called from the task graph, only reads the handler data)
+	void DecodeEpisodeBatch(FSLMongoRawFrameBatch& Batch) const;
+
+	// Append the server side filtering stages to the aggregation pipeline (the input pipeline is destroyed):
+	// keep only the given bones and the first sample of every DeltaT time bucket
+	bson_t* AppendSamplingStages(bson_t* pipeline, const char* TsKey, float StartTs, float DeltaT, const TArray<int32>* BoneIndexes = nullptr) const;
+#endif // SL_WITH_LIBMONGO_C
+
 #if SL_WITH_LIBMONGO_C
 	/* Helpers */
 	// Get the pose data from bson document
@@ -90,6 +172,27 @@ private:
 	// Connected to a database
 	bool bCollectionSet;
 
+	// The collection uses the compact binary world state schema
+	bool bCompactBinary;
+
+	// The trajectory collection of the episode is available
+	bool bHasTrajCollection;
+
+	// The handler holds a libmongoc reference (released on disconnect)
+	bool bMongoLibAcquired;
+
+	// Number of libmongoc users, it is cleaned up only when no clients remain
+	static int32 MongoLibNumUsers;
+
+	// Guards the libmongoc init and cleanup
+	static FCriticalSection MongoLibCS;
+
+	// Individual ids in the meta collection order (compact binary schema index to id)
+	TArray<FString> MetaIndividualIds;
+
+	// Individual id to meta collection index
+	TMap<FString, int32> MetaIdToIdx;
+
 #if SL_WITH_LIBMONGO_C
 	// Server uri
 	mongoc_uri_t* uri;
@@ -105,5 +208,8 @@ private:
 
 	// Entity ids meta data collection
 	mongoc_collection_t* meta_collection;
+
+	// Per individual trajectory buckets collection (optional)
+	mongoc_collection_t* traj_collection;
 #endif // SL_WITH_LIBMONGO_C
 };
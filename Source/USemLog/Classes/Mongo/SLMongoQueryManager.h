@@ -6,6 +6,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Info.h"
 #include "Mongo/SLMongoQueryDBHandler.h"
+#include "Mongo/SLMongoQueryCache.h"
 #include "SLMongoQueryManager.generated.h"
 
 /**
@@ -27,7 +28,7 @@ public:
 
 public:
 	// Connect to the server
-	bool Connect(const FString& ServerIp, uint16 ServerPort);
+	bool Connect(const FString& InServerIp, uint16 InServerPort);
 
 	// Disconnect from server
 	void Disconnect();
@@ -47,6 +48,21 @@ public:
 	// Check if the episode is selected
 	bool IsEpisodeSet() const { return bEpisodeSet; };
 
+	// Get the connected server ip (used for opening additional connections, e.g. episode streaming)
+	FString GetServerIp() const { return ServerIp; };
+
+	// Get the connected server port
+	uint16 GetServerPort() const { return ServerPort; };
+
+	// Build the trajectory collection of the active episode (offline indexing), the pose and trajectory queries use it once available
+	bool BuildTrajectoryCollection(float BucketDuration = 10.f);
+
+	// Remove the cached query results
+	void EmptyQueryCache() { QueryCache.Empty(); };
+
+	// Get the query cache usage (entries, memory, hits and misses) as string
+	FString GetQueryCacheStats() const { return QueryCache.GetStatsString(); };
+
 	/* Queries */
 	// Get the individual pose
 	FTransform GetIndividualPoseAt(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts);
@@ -63,15 +79,15 @@ public:
 	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(const FString& InEpisodeId, const FString& IndividualId, float Ts);
 	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(const FString& IndividualId, float Ts) const;
 
-	// Get skeletal individual trajectory
-	TArray<TPair<FTransform, TMap<int32, FTransform>>>  GetSkeletalIndividualTrajectory(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT = -1.f);
-	TArray<TPair<FTransform, TMap<int32, FTransform>>>  GetSkeletalIndividualTrajectory(const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT = -1.f);
-	TArray<TPair<FTransform, TMap<int32, FTransform>>>  GetSkeletalIndividualTrajectory(const FString& IndividualId, float StartTs, float EndTs, float DeltaT = -1.f) const;
+	// Get skeletal individual trajectory (only the given bones if the bone indexes are set)
+	TArray<TPair<FTransform, TMap<int32, FTransform>>>  GetSkeletalIndividualTrajectory(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT = -1.f, const TArray<int32>& BoneIndexes = TArray<int32>());
+	TArray<TPair<FTransform, TMap<int32, FTransform>>>  GetSkeletalIndividualTrajectory(const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT = -1.f, const TArray<int32>& BoneIndexes = TArray<int32>());
+	TArray<TPair<FTransform, TMap<int32, FTransform>>>  GetSkeletalIndividualTrajectory(const FString& IndividualId, float StartTs, float EndTs, float DeltaT = -1.f, const TArray<int32>& BoneIndexes = TArray<int32>()) const;
 
 	// Get the episode data
-	TArray<TPair<float, TMap<FString, FTransform>>> GetEpisodeData(const FString& InTaskId, const FString& InEpisodeId);
-	TArray<TPair<float, TMap<FString, FTransform>>> GetEpisodeData(const FString& InEpisodeId);
-	TArray<TPair<float, TMap<FString, FTransform>>> GetEpisodeData() const;
+	FSLMongoEpisodeData GetEpisodeData(const FString& InTaskId, const FString& InEpisodeId);
+	FSLMongoEpisodeData GetEpisodeData(const FString& InEpisodeId);
+	FSLMongoEpisodeData GetEpisodeData() const;
 
 	// Spawn or get manager from the world
 	static ASLMongoQueryManager* GetExistingOrSpawnNew(UWorld* World);
@@ -86,6 +102,14 @@ protected:
 	// Episode set to query from
 	bool bEpisodeSet : 1;
 
+	// Answer the repeated individual pose and trajectory queries from memory
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	bool bUseQueryCache = true;
+
+	// Memory cap of the cached query results (MB)
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bUseQueryCache", ClampMin = 1))
+	int32 QueryCacheMaxSizeMb = 64;
+
 private:
 	// Current active task
 	FString TaskId;
@@ -93,9 +117,18 @@ private:
 	// Current active episode
 	FString EpisodeId;
 
+	// Connected server ip
+	FString ServerIp;
+
+	// Connected server port
+	uint16 ServerPort;
+
 	// Database handler
 	FSLMongoQueryDBHandler DBHandler;
 
+	// Least recently used cache of the decoded query results (filled by the const queries)
+	mutable FSLMongoQueryCache QueryCache;
+
 	///* Editor button hacks */
 	//// Server ip to connect to
 	//UPROPERTY(EditAnywhere, Category = "Semantic Logger|Buttons")
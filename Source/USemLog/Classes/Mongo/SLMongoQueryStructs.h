@@ -0,0 +1,40 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*
+* Episode frame as read from the database,
+* the poses are keyed by the individual index in the episode meta collection (see FSLMongoEpisodeData::IndividualIds)
+*/
+struct FSLMongoEpisodeFrame
+{
+	// Timestamp of the frame
+	float Timestamp = 0.f;
+
+	// Meta collection index of the individual and its pose
+	TArray<TPair<int32, FTransform>> Poses;
+
+	// Default ctor
+	FSLMongoEpisodeFrame() {};
+
+	// Init ctor
+	FSLMongoEpisodeFrame(float InTimestamp) : Timestamp(InTimestamp) {};
+};
+
+/*
+* Episode as read from the database
+*/
+struct FSLMongoEpisodeData
+{
+	// Individual ids in the meta collection order (the frame pose index to id)
+	TArray<FString> IndividualIds;
+
+	// Frames sorted by their timestamps
+	TArray<FSLMongoEpisodeFrame> Frames;
+
+	// Number of frames
+	int32 Num() const { return Frames.Num(); };
+};
@@ -0,0 +1,53 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if SL_WITH_LIBMONGO_C
+THIRD_PARTY_INCLUDES_START
+#if PLATFORM_WINDOWS
+	#include "Windows/AllowWindowsPlatformTypes.h"
+	#include <mongoc/mongoc.h>
+	#include "Windows/HideWindowsPlatformTypes.h"
+#else
+	#include <mongoc/mongoc.h>
+#endif // #if PLATFORM_WINDOWS
+THIRD_PARTY_INCLUDES_END
+#endif //SL_WITH_LIBMONGO_C
+
+/**
+ * Materializes the world state frames of an episode into per individual trajectory documents (<episode>.traj),
+ * each document holds the time sorted samples of one individual in a fixed duration bucket:
+ *	{ id, start_ts, end_ts, samples : [ { ts, loc : {x,y,z}, quat : {x,y,z,w} } ] }
+ * the (id, start_ts) and (id, end_ts) compound indexes turn the individual pose and trajectory queries into index lookups,
+ * the poses are kept in the stored frame (same as the world state documents)
+ */
+class FSLMongoTrajectoryIndexer
+{
+public:
+	// Name of the trajectory collection of the world state collection
+	static FString GetCollectionName(const FString& WorldStateCollName) { return WorldStateCollName + TEXT(".traj"); };
+
+#if SL_WITH_LIBMONGO_C
+	// Build (or rebuild) the trajectory collection of the world state collection,
+	// the meta individual ids are required to resolve the compact binary schema indexes
+	static bool Build(mongoc_database_t* database, mongoc_collection_t* collection, bool bCompactBinary,
+		const TArray<FString>& MetaIndividualIds, float BucketDuration);
+
+private:
+	// Group the documents schema individuals into buckets on the server ($unwind, $group, $out)
+	static bool BuildFromDocuments(mongoc_collection_t* collection, const FString& TrajCollName, float BucketDuration);
+
+	// Decode the compact binary frames and upload the buckets (one open bucket per individual)
+	static bool BuildFromCompactBinary(mongoc_database_t* database, mongoc_collection_t* collection, const FString& TrajCollName,
+		const TArray<FString>& MetaIndividualIds, float BucketDuration);
+
+	// Append the bucket document to the bulk operation
+	static void AddBucket(mongoc_bulk_operation_t* bulk, const FString& Id, const TArray<TPair<double, FTransform>>& Samples);
+
+	// Create the compound indexes of the trajectory collection
+	static bool CreateIndexes(mongoc_collection_t* traj_collection);
+#endif //SL_WITH_LIBMONGO_C
+};
@@ -189,16 +189,47 @@ public:
 	// Return document as string
 	FString ToString() const
 	{
-		FString Indent = "";
-		FString DocStr = TEXT("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n\n");
-		DocStr += EntityDefinitions.ToString();
-		FSLOwlNode Root(FSLOwlPrefixName("rdf", "RDF"), Namespaces);
-		Root.AddChildNode(OntologyImports);
-		Root.AddChildNodes(PropertyDefinitions);
-		Root.AddChildNodes(DatatypeDefinitions);
-		Root.AddChildNodes(ClassDefinitions);
-		Root.AddChildNodes(Individuals);
-		DocStr += Root.ToString(Indent);
+		FString DocStr;
+		AppendBeginningToString(DocStr);
+		FString Indent = INDENT_STEP;
+		for (const auto& Individual : Individuals)
+		{
+			Individual.AppendToString(DocStr, Indent);
+		}
+		AppendEndToString(DocStr);
 		return DocStr;
 	}
+
+	// Append the beginning of the document to the string (everything before the individuals)
+	void AppendBeginningToString(FString& OutStr) const
+	{
+		OutStr += TEXT("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n\n");
+		OutStr += EntityDefinitions.ToString();
+
+		// Open the root node
+		const FSLOwlNode Root(FSLOwlPrefixName("rdf", "RDF"), Namespaces);
+		Root.AppendTagStart(OutStr, FString(), Root.Name.ToString());
+		OutStr += TEXT(">\n");
+
+		FString Indent = INDENT_STEP;
+		OntologyImports.AppendToString(OutStr, Indent);
+		for (const auto& Node : PropertyDefinitions)
+		{
+			Node.AppendToString(OutStr, Indent);
+		}
+		for (const auto& Node : DatatypeDefinitions)
+		{
+			Node.AppendToString(OutStr, Indent);
+		}
+		for (const auto& Node : ClassDefinitions)
+		{
+			Node.AppendToString(OutStr, Indent);
+		}
+	}
+
+	// Append the end of the document to the string (closes the root node)
+	static void AppendEndToString(FString& OutStr)
+	{
+		OutStr += TEXT("</rdf:RDF>\n");
+	}
 };
@@ -152,41 +152,32 @@ public:
 	FString ToString(FString& Indent) const
 	{
 		FString NodeStr;
+		AppendToString(NodeStr, Indent);
+		return NodeStr;
+	}
+
+	// Append node to the string (avoids the intermediate strings of the children)
+	void AppendToString(FString& OutStr, FString& Indent) const
+	{
 		// Add comment
 		if (!Comment.IsEmpty())
 		{
-			NodeStr += TEXT("\n") + Indent + TEXT("<!-- ") + Comment + TEXT(" -->\n");
+			OutStr += TEXT("\n");
+			OutStr += Indent;
+			OutStr += TEXT("<!-- ");
+			OutStr += Comment;
+			OutStr += TEXT(" -->\n");
 		}
 
 		// Comment only OR empty node
-		if (Name.ToString().IsEmpty())
+		if (Name.IsEmpty())
 		{
-			return NodeStr;
+			return;
 		}
 
-		// Add node name
-		NodeStr += Indent + TEXT("<") + Name.ToString();
-
-		// Add attributes to tag
-		for (int32 i = 0; i < Attributes.Num(); ++i)
-		{
-			if (Attributes.Num() == 1)
-			{
-				NodeStr += TEXT(" ") + Attributes[i].ToString();
-			}
-			else
-			{
-				if (i < (Attributes.Num() - 1))
-				{
-					NodeStr += TEXT(" ") + Attributes[i].ToString() + TEXT("\n") + Indent + INDENT_STEP;
-				}
-				else
-				{
-					// Last attribute does not have new line
-					NodeStr += TEXT(" ") + Attributes[i].ToString();
-				}
-			}
-		}
+		// Add node name and attributes
+		const FString NameStr = Name.ToString();
+		AppendTagStart(OutStr, Indent, NameStr);
 
 		// Check node data (children/value)
 		bool bHasChildren = ChildNodes.Num() != 0;
@@ -196,17 +187,21 @@ public:
 		if (!bHasChildren && !bHasValue)
 		{
 			// No children nor value, close tag
-			NodeStr += TEXT("/>\n");
+			OutStr += TEXT("/>\n");
 		}
 		else if (bHasValue)
 		{
 			// Node has a value, add value
-			NodeStr += TEXT(">") + Value + TEXT("</") + Name.ToString() + TEXT(">\n");
+			OutStr += TEXT(">");
+			OutStr += Value;
+			OutStr += TEXT("</");
+			OutStr += NameStr;
+			OutStr += TEXT(">\n");
 		}
 		else if(bHasChildren)
 		{
 			// Node has children, add children
-			NodeStr += TEXT(">\n");
+			OutStr += TEXT(">\n");
 			
 			// Increase indentation
 			Indent += INDENT_STEP;
@@ -214,16 +209,41 @@ public:
 			// Iterate children and add nodes
 			for (auto& ChildItr : ChildNodes)
 			{
-				NodeStr += ChildItr.ToString(Indent);
+				ChildItr.AppendToString(OutStr, Indent);
 			}
 			
 			// Decrease indentation
 			Indent.RemoveFromEnd(INDENT_STEP);
 			
 			// Close tag
-			NodeStr += Indent + Value + TEXT("</") + Name.ToString() + TEXT(">\n");
+			OutStr += Indent;
+			OutStr += TEXT("</");
+			OutStr += NameStr;
+			OutStr += TEXT(">\n");
+		}
+	}
+
+	// Append the beginning of the tag (name and attributes, without the closing bracket)
+	void AppendTagStart(FString& OutStr, const FString& Indent, const FString& NameStr) const
+	{
+		OutStr += Indent;
+		OutStr += TEXT("<");
+		OutStr += NameStr;
+
+		// Add attributes to tag
+		for (int32 i = 0; i < Attributes.Num(); ++i)
+		{
+			OutStr += TEXT(" ");
+			OutStr += Attributes[i].ToString();
+
+			// Last attribute does not have new line
+			if (i < (Attributes.Num() - 1))
+			{
+				OutStr += TEXT("\n");
+				OutStr += Indent;
+				OutStr += INDENT_STEP;
+			}
 		}
-		return NodeStr;
 	}
 
 	/* Static helper functions */
@@ -0,0 +1,63 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Owl/SLOwlDoc.h"
+
+/**
+* Writes an owl document to file incrementally (UTF-8, buffered),
+* the beginning of the document is written when opened, the individuals as they are added,
+* and the root node is closed at the end
+*/
+class USEMLOG_API FSLOwlStreamWriter
+{
+public:
+	// Ctor
+	FSLOwlStreamWriter();
+
+	// Dtor, closes the document if still open
+	~FSLOwlStreamWriter();
+
+	// Create the file and write the beginning of the document (everything before the individuals)
+	bool Open(const FString& FilePath, const FSLOwlDoc& Doc, bool bOverwrite);
+
+	// Write the current individuals of the document, then remove them from it
+	void WriteIndividuals(FSLOwlDoc& Doc);
+
+	// Write a node as a child of the root node
+	void WriteNode(const FSLOwlNode& Node);
+
+	// Close the root node and the file
+	void Close();
+
+	// True if the file is open
+	bool IsOpen() const { return Archive.IsValid(); };
+
+	// Path of the written file
+	const FString& GetFilePath() const { return FilePath; };
+
+private:
+	// Write the buffer to the file if it reached the threshold (or always if forced)
+	void Flush(bool bForce = false);
+
+private:
+	// File writer
+	TUniquePtr<FArchive> Archive;
+
+	// Path of the written file
+	FString FilePath;
+
+	// Text waiting to be written
+	FString Buffer;
+
+	// Indentation of the root children
+	FString Indent;
+
+	// Number of written bytes
+	int64 NumBytesWritten;
+
+	// Write the buffer when it has at least this many characters
+	static constexpr int32 FlushThreshold = 1 << 20;
+};
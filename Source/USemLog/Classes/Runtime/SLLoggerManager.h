@@ -153,7 +153,7 @@ private:
 	UPROPERTY(EditAnywhere, Category = "Semantic Logger|World State Logger", meta = (editcondition = "bLogWorldState"))
 	FSLWorldStateLoggerParams WorldStateLoggerParams;
 	
-	// DB server parameters
+	// DB server parameters (also used by the symbolic logger when writing the events to the database)
 	UPROPERTY(EditAnywhere, Category = "Semantic Logger|World State Logger", meta = (editcondition = "bLogWorldState"))
 	FSLLoggerDBServerParams DBServerParams;
 
@@ -94,6 +94,31 @@ struct FSLLoggerStartParams
 	FName UserInputActionName = TEXT("SLTrigger");
 };
 
+/* World state database write acknowledgement */
+UENUM()
+enum class ESLWorldStateWriteConcern : uint8
+{
+	Unacknowledged		UMETA(DisplayName = "Unacknowledged (w:0)"),
+	Acknowledged		UMETA(DisplayName = "Acknowledged (w:1)"),
+	Journaled			UMETA(DisplayName = "Journaled (w:1, j:true)"),
+};
+
+/* World state document layout */
+UENUM()
+enum class ESLWorldStateSchema : uint8
+{
+	Documents			UMETA(DisplayName = "Documents (v1)"),
+	CompactBinary		UMETA(DisplayName = "Compact Binary (v2)"),
+};
+
+/* World state snapshots destination */
+UENUM()
+enum class ESLWorldStateSinkType : uint8
+{
+	Mongo				UMETA(DisplayName = "MongoDB"),
+	LocalFile			UMETA(DisplayName = "Local File (import later)"),
+};
+
 /* Holds the data needed to setup the world state logger */
 USTRUCT()
 struct FSLWorldStateLoggerParams
@@ -119,6 +144,62 @@ struct FSLWorldStateLoggerParams
 	// Remove and overwrite any previously included metadata
 	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bIncludeMetadata"))
 	bool bOverwriteMetadata = false;
+
+	// Max number of pose snapshots waiting to be written (snapshots are dropped if the queue is full)
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (ClampMin = 2))
+	int32 WriteQueueSize = 256;
+
+	// Log the writer queue and timing stats every given number of seconds (0 = only when finished)
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (ClampMin = 0))
+	float StatsLogInterval = 0.f;
+
+	// Where to write the snapshots, the local file can be imported into the database after the episode
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	ESLWorldStateSinkType SinkType = ESLWorldStateSinkType::Mongo;
+
+	// Directory of the local episode files (empty = <ProjectSaved>/SL), files are written as <Dir>/<TaskId>/<EpisodeId>.slws
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "SinkType == ESLWorldStateSinkType::LocalFile"))
+	FString LocalFileDirectory;
+
+	// Write all the individuals every given number of frames (sparse mode), local file chunks start at these keyframes
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "SinkType == ESLWorldStateSinkType::LocalFile", ClampMin = 1))
+	int32 KeyframeInterval = 100;
+
+	// Max size (KB) of a local file chunk before it is written to disk
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "SinkType == ESLWorldStateSinkType::LocalFile", ClampMin = 1))
+	int32 FileChunkSizeKb = 1024;
+
+	// Layout of the frame documents, the compact binary layout uses the individual indexes from the metadata collection
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	ESLWorldStateSchema Schema = ESLWorldStateSchema::Documents;
+
+	// Write acknowledgement requested from the server
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	ESLWorldStateWriteConcern WriteConcern = ESLWorldStateWriteConcern::Acknowledged;
+
+	// Accumulate the frames and insert them with a single bulk operation
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	bool bBulkWrite = false;
+
+	// Keep the insertion order of the frames in the bulk operation (unordered is faster)
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bBulkWrite"))
+	bool bBulkOrdered = false;
+
+	// Flush the bulk operation after the given number of frames
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bBulkWrite", ClampMin = 1))
+	int32 BulkMaxFrames = 50;
+
+	// Flush the bulk operation after the given duration (ms) since its first frame
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bBulkWrite", ClampMin = 1))
+	int32 BulkMaxDurationMs = 500;
+
+	// Build the per individual trajectory collection (<episode>.traj) when the episode is finished, used by the pose and trajectory queries
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	bool bIndexTrajectories = false;
+
+	// Duration (seconds) of the trajectory buckets, every trajectory document holds the samples of one individual in the bucket
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bIndexTrajectories", ClampMin = 0.1))
+	float TrajectoryBucketDuration = 10.f;
 };
 
 
@@ -187,4 +268,17 @@ struct FSLSymbolicLoggerParams
 	/* ROS */
 	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
 	bool bPublishToROS = false;
+
+	/* Database */
+	// Write the finished events to the episode events collection (<EpisodeId>.events) as they finish
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	bool bWriteEventsToDB = false;
+
+	// Flush the bulk operation after the given number of events
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bWriteEventsToDB", ClampMin = 1))
+	int32 EventsBulkMaxNum = 100;
+
+	// Flush the bulk operation after the given duration (ms) since its first event
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bWriteEventsToDB", ClampMin = 1))
+	int32 EventsBulkMaxDurationMs = 1000;
 };
@@ -0,0 +1,182 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Runtime/SLLoggerStructs.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Containers/Queue.h"
+#if SL_WITH_LIBMONGO_C
+THIRD_PARTY_INCLUDES_START
+#if PLATFORM_WINDOWS
+	#include "Windows/AllowWindowsPlatformTypes.h"
+	#include <mongoc/mongoc.h>
+	#include "Windows/HideWindowsPlatformTypes.h"
+#else
+	#include <mongoc/mongoc.h>
+#endif // #if PLATFORM_WINDOWS
+THIRD_PARTY_INCLUDES_END
+#endif //SL_WITH_LIBMONGO_C
+
+// Forward declarations
+class ISLEvent;
+class FRunnableThread;
+class FEvent;
+
+/*
+* Participant of a symbolic event as written to the database
+*/
+struct FSLSymbolicEventParticipant
+{
+	// Role of the participant in the event (e.g. performed_by, object_acted_on)
+	FString Role;
+
+	// Id of the individual
+	FString Id;
+
+	// Class of the individual
+	FString Class;
+};
+
+/*
+* Finished symbolic event copied on the game thread (the individuals are not accessed by the writer thread)
+*/
+struct FSLSymbolicEventRecord
+{
+	// Unique id of the event
+	FString Id;
+
+	// Type name of the event
+	FString Type;
+
+	// Start time of the event
+	float StartTime = 0.f;
+
+	// End time of the event
+	float EndTime = 0.f;
+
+	// Pair id of the participants (0 if not available)
+	uint64 PairId = 0;
+
+	// Participants of the event
+	TArray<FSLSymbolicEventParticipant> Participants;
+};
+
+/**
+ * Dedicated thread writing the finished symbolic events to the episode events collection (<EpisodeId>.events),
+ * events are inserted in bulk operations flushed by count or duration, the time and participant indexes
+ * are created when the writer finishes
+ */
+class FSLSymbolicEventsDBWriter : public FRunnable
+{
+public:
+	// Ctor
+	FSLSymbolicEventsDBWriter();
+
+	// Dtor
+	virtual ~FSLSymbolicEventsDBWriter();
+
+	// Connect to the database and set the write options (called on the game thread before start)
+	bool Init(const FSLSymbolicLoggerParams& InLoggerParameters,
+		const FSLLoggerLocationParams& InLocationParameters,
+		const FSLLoggerDBServerParams& InDBServerParameters);
+
+	// Start the writer thread
+	bool Start();
+
+	// Signal the thread to write the remaining events and stop, blocks until done
+	virtual void Stop() override;
+
+	// Stop the thread, create the indexes and disconnect
+	void Finish();
+
+	// Copy the event and queue it for writing (game thread)
+	void Enqueue(const ISLEvent& Event);
+
+	// Get init state
+	bool IsInit() const { return bIsInit; };
+
+	/* Begin FRunnable interface */
+	virtual uint32 Run() override;
+	/* End FRunnable interface */
+
+private:
+	// Write all the queued events
+	void WriteQueuedEvents();
+
+	// Connect to the database
+	bool Connect(const FString& DBName, const FString& CollName, const FString& ServerIp,
+		uint16 ServerPort, bool bOverwrite);
+
+	// Disconnect and clean db connection
+	void Disconnect();
+
+	// Create indexes on the inserted events
+	bool CreateIndexes() const;
+
+#if SL_WITH_LIBMONGO_C
+	// Add the event to the current bulk operation
+	bool AddToBulk(const FSLSymbolicEventRecord& Record);
+
+	// Execute and clear the current bulk operation
+	bool FlushBulk();
+#endif //SL_WITH_LIBMONGO_C
+
+private:
+	// True if connected
+	bool bIsInit;
+
+	// Events waiting to be written
+	TQueue<FSLSymbolicEventRecord, EQueueMode::Spsc> EventQueue;
+
+	// Wakes up the writer thread when new events are available
+	FEvent* WorkEvent;
+
+	// The writer thread
+	FRunnableThread* Thread;
+
+	// Set when the thread should write the remaining events and exit
+	FThreadSafeBool bStopRequested;
+
+	// Number of written and failed events
+	FThreadSafeCounter NumWritten;
+	FThreadSafeCounter NumFailed;
+
+	// Flush the bulk operation after the given number of events
+	int32 BulkMaxNum;
+
+	// Flush the bulk operation after the given duration (seconds) since its first event
+	double BulkMaxDuration;
+
+	// Number of events in the current bulk operation
+	int32 BulkNum;
+
+	// Time when the current bulk operation was started
+	double BulkStartTime;
+
+	// Id of the episode (added to every event)
+	FString EpisodeId;
+
+#if SL_WITH_LIBMONGO_C
+	// Server uri
+	mongoc_uri_t* uri;
+
+	// MongoC connection client
+	mongoc_client_t* client;
+
+	// Database to access
+	mongoc_database_t* database;
+
+	// Database collection
+	mongoc_collection_t* collection;
+
+	// Write acknowledgement of the bulk operations
+	mongoc_write_concern_t* write_concern;
+
+	// Current bulk operation (nullptr if none is started)
+	mongoc_bulk_operation_t* bulk_op;
+#endif //SL_WITH_LIBMONGO_C
+};
@@ -9,6 +9,8 @@
 #include "Events/ISLEventHandler.h"
 #include "ROSProlog/SLPrologClient.h"
 #include "Owl/SLOwlExperiment.h"
+#include "Owl/SLOwlStreamWriter.h"
+#include "Runtime/SLSymbolicEventsDBWriter.h"
 #include "SLSymbolicLogger.generated.h"
 
 // Forward declarations
@@ -41,7 +43,8 @@ protected:
 
 public:
 	// Init logger (called when the logger is synced externally)
-	void Init(const FSLSymbolicLoggerParams& InLoggerParameters, const FSLLoggerLocationParams& InLocationParameters);
+	void Init(const FSLSymbolicLoggerParams& InLoggerParameters, const FSLLoggerLocationParams& InLocationParameters,
+		const FSLLoggerDBServerParams& InDBServerParameters = FSLLoggerDBServerParams());
 
 	// Start logger (called when the logger is synced externally)
 	void Start();
@@ -83,6 +86,15 @@ protected:
 	// Write data to file
 	void WriteToFile();
 
+	// Create the experiment file and write the beginning of the document, the events are written as they finish
+	void OpenExperimentWriter();
+
+	// Directory of the task files
+	FString GetTaskDirPath() const;
+
+	// Connect and start the writer streaming the finished events to the database
+	void StartEventsDBWriter();
+
 	// Create events doc template
 	TSharedPtr<FSLOwlExperiment> CreateEventsDocTemplate(
 		ESLOwlExperimentTemplate TemplateType, const FString& InDocId);
@@ -148,17 +160,30 @@ private:
 	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bUseIndependently"))
 	FSLLoggerStartParams StartParameters;
 
+	// Database server parameters (used if the events are written to the database)
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bUseIndependently"))
+	FSLLoggerDBServerParams DBServerParameters;
+
 	// Access to all individuals in the world
 	UPROPERTY(VisibleAnywhere, Transient, Category = "Semantic Logger")
 	ASLIndividualManager* IndividualManager;
 
 
-	// Array of finished events
+	// Array of finished events (only kept if the timelines are written)
 	TArray<TSharedPtr<ISLEvent>> FinishedEvents;
 
-	// Owl document of the finished events
+	// Ids of the finished events (sub-actions of the experiment)
+	TArray<FString> FinishedEventIds;
+
+	// Owl document of the finished events, the event individuals are removed once written
 	TSharedPtr<FSLOwlExperiment> ExperimentDoc;
 
+	// Writes the experiment document to file as the events finish
+	TSharedPtr<FSLOwlStreamWriter> ExperimentWriter;
+
+	// Writes the finished events to the episode events collection on a background thread
+	TSharedPtr<FSLSymbolicEventsDBWriter> EventsDBWriter;
+
 	// Semantic event handlers (takes input raw events, outputs finished semantic events)
 	TArray<TSharedPtr<ISLEventHandler>> EventHandlers;
 
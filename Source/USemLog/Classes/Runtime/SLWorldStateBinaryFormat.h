@@ -0,0 +1,94 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Compact world state schema (v2) helpers, shared by the writer and the readers
+ * Each frame document stores the individuals as a single binary blob instead of sub-documents:
+ *	individuals_bin			: [int32 idx, float32 x y z qx qy qz qw] * N
+ *	skel_individuals_bin	: [int32 idx, float32 x y z qx qy qz qw, int32 num_bones, [int32 bone_idx, float32 x y z qx qy qz qw] * num_bones] * N
+ * The indexes are the positions of the individuals in the metadata collection individuals array,
+ * they are additionally stored as int32 arrays (individuals_idx, skel_individuals_idx) for server side matching and indexing
+ * Values are little endian, poses are already converted to the stored frame (ROS if SL_WITH_ROS_CONVERSIONS)
+ */
+struct FSLWorldStateBinaryFormat
+{
+	// Schema version stored in the frame documents
+	static constexpr int32 SchemaVersion = 2;
+
+	// Number of floats in a pose
+	static constexpr int32 PoseNumFloats = 7;
+
+	// Size in bytes of a pose
+	static constexpr int32 PoseSize = PoseNumFloats * sizeof(float);
+
+	// Size in bytes of an individual record
+	static constexpr int32 IndividualRecordSize = sizeof(int32) + PoseSize;
+
+	// Document keys
+	static constexpr const char* IndividualsBinKey = "individuals_bin";
+	static constexpr const char* IndividualsIdxKey = "individuals_idx";
+	static constexpr const char* SkelIndividualsBinKey = "skel_individuals_bin";
+	static constexpr const char* SkelIndividualsIdxKey = "skel_individuals_idx";
+
+	/* Write */
+	// Append int32 value
+	static void WriteInt(TArray<uint8>& OutData, int32 Value)
+	{
+		const int32 Offset = OutData.AddUninitialized(sizeof(int32));
+		FMemory::Memcpy(OutData.GetData() + Offset, &Value, sizeof(int32));
+	}
+
+	// Append packed pose
+	static void WritePose(TArray<uint8>& OutData, const FTransform& Pose)
+	{
+		const FVector Loc = Pose.GetLocation();
+		const FQuat Quat = Pose.GetRotation();
+		const float Values[PoseNumFloats] = { Loc.X, Loc.Y, Loc.Z, Quat.X, Quat.Y, Quat.Z, Quat.W };
+		const int32 Offset = OutData.AddUninitialized(PoseSize);
+		FMemory::Memcpy(OutData.GetData() + Offset, Values, PoseSize);
+	}
+
+	/* Read */
+	// Read int32 value and advance the data pointer (false if out of bounds)
+	static bool ReadInt(const uint8*& Data, const uint8* End, int32& OutValue)
+	{
+		if (Data + sizeof(int32) > End)
+		{
+			return false;
+		}
+		FMemory::Memcpy(&OutValue, Data, sizeof(int32));
+		Data += sizeof(int32);
+		return true;
+	}
+
+	// Read packed pose and advance the data pointer (false if out of bounds)
+	static bool ReadPose(const uint8*& Data, const uint8* End, FTransform& OutPose)
+	{
+		if (Data + PoseSize > End)
+		{
+			return false;
+		}
+		float Values[PoseNumFloats];
+		FMemory::Memcpy(Values, Data, PoseSize);
+		Data += PoseSize;
+		FQuat Quat(Values[3], Values[4], Values[5], Values[6]);
+		Quat.Normalize();
+		OutPose = FTransform(Quat, FVector(Values[0], Values[1], Values[2]));
+		return true;
+	}
+
+	// Skip the given number of bytes (false if out of bounds)
+	static bool Skip(const uint8*& Data, const uint8* End, int32 NumBytes)
+	{
+		if (NumBytes < 0 || Data + NumBytes > End)
+		{
+			return false;
+		}
+		Data += NumBytes;
+		return true;
+	}
+};
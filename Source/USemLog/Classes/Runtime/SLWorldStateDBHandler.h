@@ -5,116 +5,101 @@
 
 #include "CoreMinimal.h"
 #include "Runtime/SLLoggerStructs.h"
-#include "Async/AsyncWork.h"
-#if SL_WITH_LIBMONGO_C
-class ASLVisionPoseableMeshActor;
-THIRD_PARTY_INCLUDES_START
-#if PLATFORM_WINDOWS
-	#include "Windows/AllowWindowsPlatformTypes.h"
-	#include <mongoc/mongoc.h>
-	#include "Windows/HideWindowsPlatformTypes.h"
-#else
-	#include <mongoc/mongoc.h>
-#endif // #if PLATFORM_WINDOWS
-THIRD_PARTY_INCLUDES_END
-#endif //SL_WITH_LIBMONGO_C
+#include "Runtime/SLWorldStateSnapshot.h"
+#include "Runtime/SLWorldStateSink.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Containers/CircularQueue.h"
 
 // Forward declarations
 class ASLIndividualManager;
 class USLBaseIndiviual;
-class USLBoneIndividual;
-class USLVirtualBoneIndividual;
-class USLBoneConstraintIndividual;
+class FRunnableThread;
+class FEvent;
 
 /**
- * Async task to write to the database
+ * Dedicated thread writing the world state snapshots to the sink (database, local file),
+ * snapshots are consumed from a bounded single producer (game thread) single consumer (writer thread) queue,
+ * processed snapshots are sent back through a second queue to be reused by the game thread
  */
-class FSLWorldStateDBWriterAsyncTask : public FNonAbandonableTask
+class FSLWorldStateDBWriter : public FRunnable
 {
 public:
-#if SL_WITH_LIBMONGO_C
-	// Set the individuals
-	bool Init(mongoc_collection_t* in_collection, ASLIndividualManager* Manager, float PoseTolerance, bool bInWriteSparse);
-#endif //SL_WITH_LIBMONGO_C	
-
-	// Do the db writing here
-	void DoWork();
+	// Ctor
+	FSLWorldStateDBWriter(int32 InQueueSize);
 
-	// Needed internally
-	FORCEINLINE TStatId GetStatId() const { RETURN_QUICK_DECLARE_CYCLE_STAT(FAnalyzeMaterialTreeAsyncTask, STATGROUP_ThreadPoolAsyncTasks); }
+	// Dtor
+	virtual ~FSLWorldStateDBWriter();
 
-	// Set the simulation time
-	void SetTimestamp(float InTs) { Timestamp = InTs; };
+	// Set the sink the snapshots are written to (called on the game thread before start)
+	bool Init(TUniquePtr<ISLWorldStateSink> InSink);
 
-private:
-	// First write where all the individuals are written irregardresly of their previous position
-	int32 FirstWrite();
+	// Start the writer thread
+	bool Start();
 
-	// Write sparse (only individuals that moved)
-	int32 WriteSparse();
+	// Signal the thread to write the remaining snapshots and stop, blocks until done
+	void Stop();
 
-	// Write all individuals (event if they did not move)
-	int32 WriteAll();
+	// Stop the thread and close the sink
+	void Finish();
 
-#if SL_WITH_LIBMONGO_C
-	// Add timestamp to the bson doc
-	void AddTimestamp(bson_t* doc);
+	/* Producer (game thread) */
+	// Get an empty snapshot (reused from the written ones if available)
+	FSLWorldStateSnapshot* GetFreeSnapshot();
 
-	// Add all individuals (return the number of individuals added)
-	int32 AddAllIndividuals(bson_t* doc);
+	// Push the snapshot to the writing queue, returns false and keeps the snapshot for reuse if the queue is full
+	bool Enqueue(FSLWorldStateSnapshot* Snapshot);
 
-	// Add only the individuals that moved (return the number of individuals added)
-	int32 AddIndividualsThatMoved(bson_t* doc);
+	// True if the sink requested a keyframe since the last call
+	bool ConsumeKeyframeRequest() { return bKeyframeRequested.AtomicSet(false); };
 
-	// Add skeletal individuals (return the number of individuals added)
-	int32 AddSkeletalIndividals(bson_t* doc);
+	// Get the writer counters and timings
+	const FSLWorldStateWriterStats& GetStats() const { return Stats; };
+	FSLWorldStateWriterStats& GetStatsMutable() { return Stats; };
 
-	// Add skeletal bones to the document
-	void AddSkeletalBoneIndividuals(const TArray<USLBoneIndividual*>& BoneIndividuals,
-		const TArray<USLVirtualBoneIndividual*>& VirtualBoneIndividuals,
-		bson_t* doc);
+	/* Begin FRunnable interface */
+	virtual uint32 Run() override;
+	/* End FRunnable interface */
 
-	// Add skeletal bone constraints to the document
-	void AddSkeletalConstraintIndividuals(const TArray<USLBoneConstraintIndividual*>& ConstraintIndividuals,
-		bson_t* doc);
+private:
+	// Write all the queued snapshots
+	void WriteQueuedSnapshots();
 
-	// Add robot individuals (return the number of individuals added)
-	int32 AddRobotIndividuals(bson_t* doc);
+	// Give back the snapshot to be reused by the game thread (writer thread only)
+	void RecycleSnapshot(FSLWorldStateSnapshot* Snapshot);
 
-	// Add pose document
-	void AddPose(FTransform Pose, bson_t* doc);
+private:
+	// Snapshots waiting to be written
+	TCircularQueue<FSLWorldStateSnapshot*> SnapshotQueue;
 
-	// Write the bson doc to the collection
-	bool UploadDoc(bson_t* doc);
-#endif //SL_WITH_LIBMONGO_C
+	// Written snapshots waiting to be reused
+	TCircularQueue<FSLWorldStateSnapshot*> FreeQueue;
 
+	// Dropped snapshot kept for reuse (game thread only)
+	FSLWorldStateSnapshot* SpareSnapshot;
 
-private:
-	// DoWork function pointers
-	typedef int32 (FSLWorldStateDBWriterAsyncTask::*WriteTypeFunctionPtr)();
-	WriteTypeFunctionPtr WriteFunctionPtr;
+	// Wakes up the writer thread when new snapshots are available
+	FEvent* WorkEvent;
 
-	// Access to the individual manager
-	ASLIndividualManager* IndividualManager;
+	// The writer thread
+	FRunnableThread* Thread;
 
-	// The timestamp to write to the collection
-	float Timestamp;
+	// Set when the thread should write the remaining snapshots and exit
+	FThreadSafeBool bStopRequested;
 
-	// Pose diff tolerance
-	float MinPoseDiff;
+	// Set by the writer thread when the sink needs a keyframe, consumed by the game thread
+	FThreadSafeBool bKeyframeRequested;
 
-	// Write mode
-	bool bWriteSparse;
+	// Counters and timings
+	FSLWorldStateWriterStats Stats;
 
-#if SL_WITH_LIBMONGO_C
-	// Database collection
-	mongoc_collection_t* mongo_collection;
-#endif //SL_WITH_LIBMONGO_C	
+	// Destination of the snapshots (only accessed by the writer thread while it runs)
+	TUniquePtr<ISLWorldStateSink> Sink;
 };
 
 
 /**
- * Helper class for connecting and writing to the database
+ * Helper class capturing the world state on the game thread and passing it to the writer
  */
 class FSLWorldStateDBHandler
 {
@@ -125,63 +110,71 @@ public:
 	// Dtor
 	~FSLWorldStateDBHandler();
 
-	// Connect to the db and set up the async writer
-	bool Init(ASLIndividualManager* IndividualManager,
+	// Set up the sink and the async writer
+	bool Init(ASLIndividualManager* InIndividualManager,
 		const FSLWorldStateLoggerParams& InLoggerParameters,
 		const FSLLoggerLocationParams& InLocationParameters,
 		const FSLLoggerDBServerParams& InDBServerParameters);
 
-	// Delegate first job to the async task
+	// Capture all the individual poses and queue them for writing
 	void FirstWrite(float Timestamp);
 
-	// Delegate job to the async task (true if the previous job was done)
+	// Capture the individual poses and queue them for writing (false if the snapshot was dropped)
 	bool Write(float Timestamp);
 
-	// Disconnect from db, clear task
+	// Get the writer counters and timings (nullptr if there is no writer)
+	const FSLWorldStateWriterStats* GetWriterStats() const;
+
+	// Write the remaining snapshots and close the sink
 	void Finish();
 
 private:
-	// Connect to the database
-	bool Connect(const FString& DBName, const FString& CollName, const FString& ServerIp,
-		uint16 ServerPort, bool bOverwrite);
-
-	// Write metadata
-	bool WriteMetadata(ASLIndividualManager* IndividualManager, const FString& MetaCollName, bool bOverwrite);
-
-#if SL_WITH_LIBMONGO_C
-	int32 AddIndividualsMetadata(ASLIndividualManager* IndividualManager, bson_t* doc);
-#endif //SL_WITH_LIBMONGO_C	
+	// Cache the ids and classes of the individuals, and the individual indexes of the skeletal individuals
+	void SetIndividualsTable();
 
-	// Disconnect and clean db connection
-	void Disconnect() const;
+	// Create the sink of the given type
+	TUniquePtr<ISLWorldStateSink> CreateSink(ESLWorldStateSinkType SinkType) const;
 
-	// Create indexes on the inserted data
-	bool CreateIndexes() const;
+	// Copy the poses into the snapshot (game thread)
+	void CaptureSnapshot(FSLWorldStateSnapshot& OutSnapshot, bool bCaptureAll);
 
 private:
-	// True if connected to the db
+	// True if the writer is running
 	bool bIsInit;
 
 	// Pointers are reset
 	bool bIsFinished;
 
-	// Call time of the previous writing task
-	double PrevWriteCallTime;
+	// Write only the individuals that moved
+	bool bWriteSparse;
+
+	// Write all the individuals every given number of frames (0 = only the first frame)
+	int32 KeyframeInterval;
+
+	// Number of frames since the last keyframe
+	int32 FramesSinceKeyframe;
 
-	// Async writing to the database
-	FAsyncTask<FSLWorldStateDBWriterAsyncTask>* DBWriterTask;
+	// Set when a snapshot was dropped, the following deltas would miss its changes
+	bool bForceKeyframe;
 
-#if SL_WITH_LIBMONGO_C
-	// Server uri
-	mongoc_uri_t* uri;
+	// Pose diff tolerance
+	float MinPoseDiff;
+
+	// Log the stats every given number of seconds (0 = only when finished)
+	float StatsLogInterval;
+
+	// Platform time of the last stats log
+	double PrevStatsLogTime;
+
+	// Access to the individuals (only used on the game thread)
+	ASLIndividualManager* IndividualManager;
 
-	// MongoC connection client
-	mongoc_client_t* client;
+	// Ids and classes of the individuals (the snapshots store indexes in this table)
+	FSLWorldStateIndividualsTable IndividualsTable;
 
-	// Database to access
-	mongoc_database_t* database;
+	// Individuals table indexes of the skeletal individuals
+	TArray<int32> SkeletalIndividualIndexes;
 
-	// Database collection
-	mongoc_collection_t* collection;
-#endif //SL_WITH_LIBMONGO_C	
+	// Writing to the sink on a dedicated thread
+	FSLWorldStateDBWriter* DBWriter;
 };
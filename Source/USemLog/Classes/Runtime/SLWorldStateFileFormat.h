@@ -0,0 +1,210 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Runtime/SLWorldStateSnapshot.h"
+#include "Runtime/SLWorldStateBinaryFormat.h"
+
+/**
+ * Local append-only world state episode file (.slws), written by the file sink and read by the importer
+ *	header	: uint32 magic, int32 version, int32 num_individuals, [utf8 id, utf8 class] * num_individuals
+ *	chunk	: uint32 magic, int32 num_frames, int32 payload_size, uint32 payload_crc, payload
+ *	payload	: [float32 timestamp, int32 flags, int32 num_individuals, individuals records,
+ *			   int32 num_skel_individuals, skeletal records] * num_frames
+ *	index	: uint32 magic, int32 num_chunks, [int64 offset, float32 first_timestamp, int32 num_frames] * num_chunks,
+ *			  int64 index_offset, uint32 end_magic
+ * The records use the compact binary layout (FSLWorldStateBinaryFormat) with the individuals table indexes,
+ * poses are stored in the engine frame. Chunks start at keyframes and are flushed to disk when full,
+ * the index is only written when the episode finishes, a file without it is read by scanning the chunks
+ * until the first incomplete or corrupted one (e.g. after a crash)
+ */
+struct FSLWorldStateFileFormat
+{
+	// Magic values
+	static constexpr uint32 HeaderMagic = 0x53574C53; // "SLWS"
+	static constexpr uint32 ChunkMagic = 0x43574C53; // "SLWC"
+	static constexpr uint32 IndexMagic = 0x49574C53; // "SLWI"
+	static constexpr uint32 EndMagic = 0x45574C53; // "SLWE"
+
+	// File version
+	static constexpr int32 Version = 1;
+
+	// Frame flags
+	static constexpr int32 KeyframeFlag = 1 << 0;
+
+	// Size in bytes of a chunk header
+	static constexpr int32 ChunkHeaderSize = 4 * sizeof(int32);
+
+	// Size in bytes of the index trailer (offset + end magic)
+	static constexpr int32 IndexTrailerSize = sizeof(int64) + sizeof(uint32);
+
+	// File extension
+	static const TCHAR* GetExtension() { return TEXT(".slws"); };
+
+	/* Write */
+	// Append raw value
+	template<typename T>
+	static void WriteValue(TArray<uint8>& OutData, const T& Value)
+	{
+		const int32 Offset = OutData.AddUninitialized(sizeof(T));
+		FMemory::Memcpy(OutData.GetData() + Offset, &Value, sizeof(T));
+	}
+
+	// Append length prefixed utf8 string
+	static void WriteString(TArray<uint8>& OutData, const FString& Value)
+	{
+		FTCHARToUTF8 Converter(*Value);
+		WriteValue<int32>(OutData, Converter.Length());
+		OutData.Append(reinterpret_cast<const uint8*>(Converter.Get()), Converter.Length());
+	}
+
+	// Append the file header
+	static void WriteHeader(TArray<uint8>& OutData, const FSLWorldStateIndividualsTable& Table)
+	{
+		WriteValue<uint32>(OutData, HeaderMagic);
+		WriteValue<int32>(OutData, Version);
+		WriteValue<int32>(OutData, Table.Num());
+		for (int32 Idx = 0; Idx < Table.Num(); ++Idx)
+		{
+			WriteString(OutData, Table.Ids[Idx]);
+			WriteString(OutData, Table.Classes[Idx]);
+		}
+	}
+
+	// Append the snapshot as a frame
+	static void WriteFrame(TArray<uint8>& OutData, const FSLWorldStateSnapshot& Snapshot)
+	{
+		WriteValue<float>(OutData, Snapshot.Timestamp);
+		WriteValue<int32>(OutData, Snapshot.bIsKeyframe ? KeyframeFlag : 0);
+
+		WriteValue<int32>(OutData, Snapshot.IndividualIndexes.Num());
+		for (int32 EntryIdx = 0; EntryIdx < Snapshot.IndividualIndexes.Num(); ++EntryIdx)
+		{
+			FSLWorldStateBinaryFormat::WriteInt(OutData, Snapshot.IndividualIndexes[EntryIdx]);
+			FSLWorldStateBinaryFormat::WritePose(OutData, FSLWorldStateSnapshot::GetPose(Snapshot.IndividualPoses, EntryIdx));
+		}
+
+		WriteValue<int32>(OutData, Snapshot.SkeletalIndexes.Num());
+		int32 BoneEntryIdx = 0;
+		for (int32 EntryIdx = 0; EntryIdx < Snapshot.SkeletalIndexes.Num(); ++EntryIdx)
+		{
+			FSLWorldStateBinaryFormat::WriteInt(OutData, Snapshot.SkeletalIndexes[EntryIdx]);
+			FSLWorldStateBinaryFormat::WritePose(OutData, FSLWorldStateSnapshot::GetPose(Snapshot.SkeletalPoses, EntryIdx));
+			const int32 NumBones = Snapshot.SkeletalBoneNums[EntryIdx];
+			FSLWorldStateBinaryFormat::WriteInt(OutData, NumBones);
+			for (const int32 BoneEntryEndIdx = BoneEntryIdx + NumBones; BoneEntryIdx < BoneEntryEndIdx; ++BoneEntryIdx)
+			{
+				FSLWorldStateBinaryFormat::WriteInt(OutData, Snapshot.BoneIndexes[BoneEntryIdx]);
+				FSLWorldStateBinaryFormat::WritePose(OutData, FSLWorldStateSnapshot::GetPose(Snapshot.BonePoses, BoneEntryIdx));
+			}
+		}
+	}
+
+	/* Read */
+	// Read raw value and advance the data pointer (false if out of bounds)
+	template<typename T>
+	static bool ReadValue(const uint8*& Data, const uint8* End, T& OutValue)
+	{
+		if (Data + sizeof(T) > End)
+		{
+			return false;
+		}
+		FMemory::Memcpy(&OutValue, Data, sizeof(T));
+		Data += sizeof(T);
+		return true;
+	}
+
+	// Read length prefixed utf8 string and advance the data pointer (false if out of bounds)
+	static bool ReadString(const uint8*& Data, const uint8* End, FString& OutValue)
+	{
+		int32 Len = 0;
+		if (!ReadValue(Data, End, Len) || Len < 0 || Data + Len > End)
+		{
+			return false;
+		}
+		FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Data), Len);
+		OutValue = FString(Converter.Length(), Converter.Get());
+		Data += Len;
+		return true;
+	}
+
+	// Read the file header (false if invalid)
+	static bool ReadHeader(const uint8*& Data, const uint8* End, FSLWorldStateIndividualsTable& OutTable)
+	{
+		uint32 Magic = 0;
+		int32 FileVersion = 0;
+		int32 Num = 0;
+		if (!ReadValue(Data, End, Magic) || Magic != HeaderMagic
+			|| !ReadValue(Data, End, FileVersion) || FileVersion != Version
+			|| !ReadValue(Data, End, Num) || Num < 0)
+		{
+			return false;
+		}
+		for (int32 Idx = 0; Idx < Num; ++Idx)
+		{
+			FString Id;
+			FString Class;
+			if (!ReadString(Data, End, Id) || !ReadString(Data, End, Class))
+			{
+				return false;
+			}
+			OutTable.Add(Id, Class);
+		}
+		return true;
+	}
+
+	// Read a frame into the snapshot (false if out of bounds or if it references unknown individuals)
+	static bool ReadFrame(const uint8*& Data, const uint8* End, int32 NumIndividuals, FSLWorldStateSnapshot& OutSnapshot)
+	{
+		int32 Flags = 0;
+		int32 Num = 0;
+		if (!ReadValue(Data, End, OutSnapshot.Timestamp) || !ReadValue(Data, End, Flags) || !ReadValue(Data, End, Num))
+		{
+			return false;
+		}
+		OutSnapshot.bIsKeyframe = (Flags & KeyframeFlag) != 0;
+
+		FTransform Pose;
+		int32 Idx = INDEX_NONE;
+		for (int32 EntryIdx = 0; EntryIdx < Num; ++EntryIdx)
+		{
+			if (!FSLWorldStateBinaryFormat::ReadInt(Data, End, Idx) || !FMath::IsWithin(Idx, 0, NumIndividuals)
+				|| !FSLWorldStateBinaryFormat::ReadPose(Data, End, Pose))
+			{
+				return false;
+			}
+			OutSnapshot.IndividualIndexes.Add(Idx);
+			FSLWorldStateSnapshot::AddPose(OutSnapshot.IndividualPoses, Pose);
+		}
+
+		if (!ReadValue(Data, End, Num))
+		{
+			return false;
+		}
+		for (int32 EntryIdx = 0; EntryIdx < Num; ++EntryIdx)
+		{
+			int32 NumBones = 0;
+			if (!FSLWorldStateBinaryFormat::ReadInt(Data, End, Idx) || !FMath::IsWithin(Idx, 0, NumIndividuals)
+				|| !FSLWorldStateBinaryFormat::ReadPose(Data, End, Pose)
+				|| !FSLWorldStateBinaryFormat::ReadInt(Data, End, NumBones) || NumBones < 0)
+			{
+				return false;
+			}
+			OutSnapshot.SkeletalIndexes.Add(Idx);
+			FSLWorldStateSnapshot::AddPose(OutSnapshot.SkeletalPoses, Pose);
+			OutSnapshot.SkeletalBoneNums.Add(NumBones);
+			for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+			{
+				if (!FSLWorldStateBinaryFormat::ReadInt(Data, End, Idx) || !FSLWorldStateBinaryFormat::ReadPose(Data, End, Pose))
+				{
+					return false;
+				}
+				OutSnapshot.BoneIndexes.Add(Idx);
+				FSLWorldStateSnapshot::AddPose(OutSnapshot.BonePoses, Pose);
+			}
+		}
+		return true;
+	}
+};
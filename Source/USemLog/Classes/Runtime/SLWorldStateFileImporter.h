@@ -0,0 +1,26 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Runtime/SLLoggerStructs.h"
+
+/**
+ * Imports a local world state episode file (written by FSLWorldStateFileSink) into the database,
+ * the frames are written with the mongo sink using bulk inserts
+ */
+class FSLWorldStateFileImporter
+{
+public:
+	// Import the episode file of the given task and episode (returns the number of imported frames, INDEX_NONE on failure)
+	static int32 Import(const FSLWorldStateLoggerParams& InLoggerParameters,
+		const FSLLoggerLocationParams& InLocationParameters,
+		const FSLLoggerDBServerParams& InDBServerParameters);
+
+	// Import the given episode file (returns the number of imported frames, INDEX_NONE on failure)
+	static int32 ImportFile(const FString& FilePath,
+		const FSLWorldStateLoggerParams& InLoggerParameters,
+		const FSLLoggerLocationParams& InLocationParameters,
+		const FSLLoggerDBServerParams& InDBServerParameters);
+};
@@ -0,0 +1,99 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Runtime/SLWorldStateSink.h"
+
+// Forward declarations
+class IFileHandle;
+
+/**
+ * Writes the world state snapshots to a local append-only episode file (see FSLWorldStateFileFormat),
+ * the file can be imported into the database after the episode (FSLWorldStateFileImporter)
+ */
+class FSLWorldStateFileSink : public ISLWorldStateSink
+{
+public:
+	// Ctor
+	FSLWorldStateFileSink();
+
+	// Dtor
+	virtual ~FSLWorldStateFileSink();
+
+	/* Begin ISLWorldStateSink interface */
+	// Create the episode file and write the header
+	virtual bool Init(const FSLWorldStateIndividualsTable& InIndividualsTable,
+		const FSLWorldStateLoggerParams& InLoggerParameters,
+		const FSLLoggerLocationParams& InLocationParameters,
+		const FSLLoggerDBServerParams& InDBServerParameters) override;
+
+	// Append the snapshot to the current chunk
+	virtual int32 Write(const FSLWorldStateSnapshot& Snapshot, FSLWorldStateWriterStats& Stats) override;
+
+	// Write the current chunk to disk
+	virtual void Flush(FSLWorldStateWriterStats& Stats) override;
+
+	// Write the chunk index and close the file
+	virtual void Finish() override;
+
+	// True if the current chunk is full and the next chunk needs to start with a keyframe
+	virtual bool ConsumeKeyframeRequest() override;
+
+	// Name of the sink used in the logs
+	virtual FString GetName() const override { return TEXT("FileSink"); };
+	/* End ISLWorldStateSink interface */
+
+	// Get the episode file path (<Dir>/<TaskId>/<EpisodeId>.slws)
+	static FString GetEpisodeFilePath(const FString& Directory, const FString& TaskId, const FString& EpisodeId);
+
+private:
+	// Write the current chunk to disk and add it to the index
+	bool WriteChunk(FSLWorldStateWriterStats& Stats);
+
+	// Write the buffer to the file (false on failure)
+	bool WriteBuffer(const TArray<uint8>& Buffer);
+
+private:
+	// Chunk index entry
+	struct FChunkEntry
+	{
+		int64 Offset;
+		float FirstTimestamp;
+		int32 NumFrames;
+	};
+
+	// Path of the episode file
+	FString FilePath;
+
+	// Open file (nullptr if not writing)
+	IFileHandle* FileHandle;
+
+	// Current position in the file
+	int64 FileOffset;
+
+	// Frames of the current chunk
+	TArray<uint8> ChunkBuffer;
+
+	// Number of frames in the current chunk
+	int32 ChunkNumFrames;
+
+	// Timestamp of the first frame of the current chunk
+	float ChunkFirstTimestamp;
+
+	// Request a keyframe once the chunk reaches this size, the chunk is written when the keyframe arrives
+	int32 ChunkMaxSize;
+
+	// Set when the chunk is full, until the request is passed to the game thread
+	bool bKeyframeRequested;
+
+	// Written chunks
+	TArray<FChunkEntry> ChunkIndex;
+
+	// Reused buffer for the chunk header and the index
+	TArray<uint8> HeaderBuffer;
+
+	// True if a write failed, no further data is written
+	bool bWriteFailed;
+};
@@ -40,6 +40,11 @@ protected:
 	// Called when actor removed from game or game ended
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
+#if WITH_EDITOR
+	// Called when a property is changed in the editor
+	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif // WITH_EDITOR
+
 public:
 	// Init logger (called when the logger is synced externally)
 	void Init(const FSLWorldStateLoggerParams& InLoggerParameters,
@@ -128,6 +133,11 @@ private:
 	UPROPERTY(VisibleAnywhere, Transient, Category = "Semantic Logger")
 	ASLIndividualManager* IndividualManager;
 
+	/* Editor button hacks */
+	// Import the local episode file (of the current task and episode) into the database
+	UPROPERTY(EditAnywhere, Transient, Category = "Semantic Logger|Edit")
+	bool bImportLocalFileButton = false;
+
 	// Database handler
 	TSharedPtr<FSLWorldStateDBHandler> DBHandler;
 };
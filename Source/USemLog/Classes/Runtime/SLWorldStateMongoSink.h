@@ -0,0 +1,172 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Runtime/SLWorldStateSink.h"
+#if SL_WITH_LIBMONGO_C
+THIRD_PARTY_INCLUDES_START
+#if PLATFORM_WINDOWS
+	#include "Windows/AllowWindowsPlatformTypes.h"
+	#include <mongoc/mongoc.h>
+	#include "Windows/HideWindowsPlatformTypes.h"
+#else
+	#include <mongoc/mongoc.h>
+#endif // #if PLATFORM_WINDOWS
+THIRD_PARTY_INCLUDES_END
+#endif //SL_WITH_LIBMONGO_C
+
+/**
+ * Writes the world state snapshots to a mongo collection (one document per frame)
+ */
+class FSLWorldStateMongoSink : public ISLWorldStateSink
+{
+public:
+	// Ctor
+	FSLWorldStateMongoSink();
+
+	// Dtor
+	virtual ~FSLWorldStateMongoSink();
+
+	/* Begin ISLWorldStateSink interface */
+	// Connect to the db, write the metadata and set the write options
+	virtual bool Init(const FSLWorldStateIndividualsTable& InIndividualsTable,
+		const FSLWorldStateLoggerParams& InLoggerParameters,
+		const FSLLoggerLocationParams& InLocationParameters,
+		const FSLLoggerDBServerParams& InDBServerParameters) override;
+
+	// Serialize and upload (or append to the bulk) the snapshot
+	virtual int32 Write(const FSLWorldStateSnapshot& Snapshot, FSLWorldStateWriterStats& Stats) override;
+
+	// Flush the bulk operation if it is older than the max duration
+	virtual void Tick(FSLWorldStateWriterStats& Stats) override;
+
+	// Flush the bulk operation
+	virtual void Flush(FSLWorldStateWriterStats& Stats) override;
+
+	// Create indexes, build the trajectory collection (if requested) and disconnect
+	virtual void Finish() override;
+
+	// Wake up often enough to respect the bulk duration
+	virtual uint32 GetTickIntervalMs() const override;
+
+	// Name of the sink used in the logs
+	virtual FString GetName() const override { return TEXT("MongoSink"); };
+	/* End ISLWorldStateSink interface */
+
+private:
+	// Connect to the database
+	bool Connect(const FString& DBName, const FString& CollName, const FString& ServerIp,
+		uint16 ServerPort, bool bOverwrite);
+
+	// Write metadata
+	bool WriteMetadata(const FString& MetaCollName, bool bOverwrite);
+
+	// Read the individual id to index mapping from the metadata collection
+	bool ReadMetadataIndexes(const FString& MetaCollName, TMap<FString, int32>& OutIdToMetaIdx);
+
+	// Map the individuals table to the metadata collection indexes
+	bool SetMetadataIndexes(const TMap<FString, int32>& IdToMetaIdx);
+
+	// Disconnect and clean db connection
+	void Disconnect();
+
+	// Create indexes on the inserted data
+	bool CreateIndexes() const;
+
+#if SL_WITH_LIBMONGO_C
+	// Add individuals metadata
+	int32 AddIndividualsMetadata(bson_t* doc);
+
+	// Add timestamp to the bson doc
+	void AddTimestamp(float Timestamp, bson_t* doc);
+
+	// Add the individuals of the snapshot (return the number of individuals added)
+	int32 AddIndividuals(const FSLWorldStateSnapshot& Snapshot, bson_t* doc);
+
+	// Add skeletal individuals of the snapshot (return the number of individuals added)
+	int32 AddSkeletalIndividals(const FSLWorldStateSnapshot& Snapshot, bson_t* doc);
+
+	// Add the individuals of the snapshot as a binary blob (return the number of individuals added)
+	int32 AddIndividualsBinary(const FSLWorldStateSnapshot& Snapshot, bson_t* doc);
+
+	// Add the skeletal individuals of the snapshot as a binary blob (return the number of individuals added)
+	int32 AddSkeletalIndividualsBinary(const FSLWorldStateSnapshot& Snapshot, bson_t* doc);
+
+	// Add int32 array with the metadata indexes of the entries
+	void AddMetaIndexes(const char* key, const TArray<int32>& EntryIndexes, bson_t* doc);
+
+	// Add pose document
+	void AddPose(FTransform Pose, bson_t* doc);
+
+	// Write the bson doc to the collection (or append it to the bulk operation)
+	bool UploadDoc(bson_t* doc, FSLWorldStateWriterStats& Stats);
+
+	// Execute and clear the current bulk operation
+	bool FlushBulk(FSLWorldStateWriterStats& Stats);
+#endif //SL_WITH_LIBMONGO_C
+
+private:
+	// True if connected to the db
+	bool bIsInit;
+
+	// Ids and classes of the individuals
+	FSLWorldStateIndividualsTable IndividualsTable;
+
+	// Metadata collection indexes of the individuals (same order as the individuals table)
+	TArray<int32> MetaIndexes;
+
+	// Layout of the frame documents
+	ESLWorldStateSchema Schema;
+
+	// Insert the frames in bulks
+	bool bBulkWrite;
+
+	// Keep the insertion order in the bulk
+	bool bBulkOrdered;
+
+	// Max number of frames in a bulk
+	int32 BulkMaxFrames;
+
+	// Max duration (seconds) of a bulk
+	double BulkMaxDuration;
+
+	// Number of frames in the current bulk
+	int32 BulkNumFrames;
+
+	// Platform time of the first frame in the current bulk
+	double BulkStartTime;
+
+	// Build the trajectory collection when finished
+	bool bIndexTrajectories;
+
+	// Duration (seconds) of the trajectory buckets
+	float TrajectoryBucketDuration;
+
+	// Reused binary blob buffer
+	TArray<uint8> BinBuffer;
+
+#if SL_WITH_LIBMONGO_C
+	// Server uri
+	mongoc_uri_t* uri;
+
+	// MongoC connection client
+	mongoc_client_t* client;
+
+	// Database to access
+	mongoc_database_t* database;
+
+	// Database collection
+	mongoc_collection_t* collection;
+
+	// Requested write acknowledgement
+	mongoc_write_concern_t* write_concern;
+
+	// Insert options (write concern)
+	bson_t* insert_opts;
+
+	// Current bulk operation (nullptr if empty)
+	mongoc_bulk_operation_t* bulk_op;
+#endif //SL_WITH_LIBMONGO_C
+};
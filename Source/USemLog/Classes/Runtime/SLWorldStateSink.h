@@ -0,0 +1,46 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Runtime/SLLoggerStructs.h"
+#include "Runtime/SLWorldStateSnapshot.h"
+
+/**
+ * Destination of the world state snapshots (database, local file etc.)
+ * Init and Finish are called on the game thread, the rest on the writer thread
+ */
+class ISLWorldStateSink
+{
+public:
+	// Virtual dtor
+	virtual ~ISLWorldStateSink() {};
+
+	// Prepare the sink for writing (called before the writer thread starts)
+	virtual bool Init(const FSLWorldStateIndividualsTable& InIndividualsTable,
+		const FSLWorldStateLoggerParams& InLoggerParameters,
+		const FSLLoggerLocationParams& InLocationParameters,
+		const FSLLoggerDBServerParams& InDBServerParameters) = 0;
+
+	// Write the snapshot (return the number of entries written)
+	virtual int32 Write(const FSLWorldStateSnapshot& Snapshot, FSLWorldStateWriterStats& Stats) = 0;
+
+	// Called periodically when the writer thread is idle (e.g. time based flushes)
+	virtual void Tick(FSLWorldStateWriterStats& Stats) {};
+
+	// Write any buffered data (called before the writer thread exits)
+	virtual void Flush(FSLWorldStateWriterStats& Stats) {};
+
+	// Close the sink (called after the writer thread stopped)
+	virtual void Finish() = 0;
+
+	// True if the next snapshot should be a keyframe, clears the request (e.g. a new file chunk needs a full frame)
+	virtual bool ConsumeKeyframeRequest() { return false; };
+
+	// Max time the writer thread waits for new snapshots before calling tick
+	virtual uint32 GetTickIntervalMs() const { return 100; };
+
+	// Name of the sink used in the logs
+	virtual FString GetName() const = 0;
+};
@@ -0,0 +1,177 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "HAL/ThreadSafeCounter64.h"
+
+/**
+ * Ids and classes of the logged individuals, the snapshots reference the individuals by their index in this table
+ */
+struct FSLWorldStateIndividualsTable
+{
+	// Unique ids of the individuals
+	TArray<FString> Ids;
+
+	// Classes of the individuals
+	TArray<FString> Classes;
+
+	// Number of individuals
+	int32 Num() const { return Ids.Num(); };
+
+	// Add individual
+	void Add(const FString& Id, const FString& Class)
+	{
+		Ids.Add(Id);
+		Classes.Add(Class);
+	}
+};
+
+/**
+ * Compact (SoA) copy of the world state poses taken on the game thread,
+ * the writer thread only reads from it and never touches UObjects
+ * Individuals are stored as indexes in the individuals table (same order as the individual manager individuals array),
+ * poses are stored as packed [x y z qx qy qz qw] floats
+ */
+struct FSLWorldStateSnapshot
+{
+	// Number of floats per pose [x y z qx qy qz qw]
+	static constexpr int32 PoseStride = 7;
+
+	// Simulation time of the snapshot
+	float Timestamp = 0.f;
+
+	// Platform time when the snapshot was taken (used for measuring the queue latency)
+	double CaptureTime = 0.0;
+
+	// True if all individuals are included (otherwise only the ones that moved)
+	bool bIsKeyframe = false;
+
+	// Indexes of the individuals (in the individuals table)
+	TArray<int32> IndividualIndexes;
+
+	// Poses of the individuals
+	TArray<float> IndividualPoses;
+
+	// Indexes of the skeletal individuals (in the individuals table)
+	TArray<int32> SkeletalIndexes;
+
+	// Poses of the skeletal individuals
+	TArray<float> SkeletalPoses;
+
+	// Number of bones of each skeletal individual (the bones are stored consecutively)
+	TArray<int32> SkeletalBoneNums;
+
+	// Skeletal mesh bone indexes
+	TArray<int32> BoneIndexes;
+
+	// Poses of the bones
+	TArray<float> BonePoses;
+
+	// Clear the data but keep the allocations (snapshots are recycled)
+	void Reset()
+	{
+		Timestamp = 0.f;
+		CaptureTime = 0.0;
+		bIsKeyframe = false;
+		IndividualIndexes.Reset();
+		IndividualPoses.Reset();
+		SkeletalIndexes.Reset();
+		SkeletalPoses.Reset();
+		SkeletalBoneNums.Reset();
+		BoneIndexes.Reset();
+		BonePoses.Reset();
+	}
+
+	// Number of entries (individuals + skeletal individuals)
+	int32 Num() const { return IndividualIndexes.Num() + SkeletalIndexes.Num(); };
+
+	// Add pose to the given packed array
+	static void AddPose(TArray<float>& OutPoses, const FTransform& Pose)
+	{
+		const FVector Loc = Pose.GetLocation();
+		const FQuat Quat = Pose.GetRotation();
+		const int32 Idx = OutPoses.AddUninitialized(PoseStride);
+		float* Data = OutPoses.GetData() + Idx;
+		Data[0] = Loc.X;
+		Data[1] = Loc.Y;
+		Data[2] = Loc.Z;
+		Data[3] = Quat.X;
+		Data[4] = Quat.Y;
+		Data[5] = Quat.Z;
+		Data[6] = Quat.W;
+	}
+
+	// Read pose from the given packed array at the given entry index
+	static FTransform GetPose(const TArray<float>& InPoses, int32 EntryIdx)
+	{
+		const float* Data = InPoses.GetData() + EntryIdx * PoseStride;
+		return FTransform(FQuat(Data[3], Data[4], Data[5], Data[6]), FVector(Data[0], Data[1], Data[2]));
+	}
+};
+
+/**
+ * Counters and timings of the world state writing pipeline,
+ * written from both the game and the writer thread
+ */
+struct FSLWorldStateWriterStats
+{
+	// Snapshots pushed into the queue
+	FThreadSafeCounter NumEnqueued;
+
+	// Snapshots written to the database
+	FThreadSafeCounter NumWritten;
+
+	// Snapshots dropped because the queue was full
+	FThreadSafeCounter NumDropped;
+
+	// Snapshots currently waiting in the queue
+	FThreadSafeCounter QueueDepth;
+
+	// Max number of snapshots waiting in the queue
+	FThreadSafeCounter MaxQueueDepth;
+
+	// Bulk operations executed
+	FThreadSafeCounter NumBulkFlushes;
+
+	// Accumulated per stage durations (microseconds)
+	FThreadSafeCounter64 CaptureTimeUs;
+	FThreadSafeCounter64 SerializeTimeUs;
+	FThreadSafeCounter64 UploadTimeUs;
+	FThreadSafeCounter64 QueueLatencyUs;
+
+	// Add duration in seconds to the given microseconds counter
+	static void AddDuration(FThreadSafeCounter64& Counter, double DurationSeconds)
+	{
+		Counter.Add(static_cast<int64>(DurationSeconds * 1000000.0));
+	}
+
+	// Update the queue depth counters after a push
+	void OnEnqueued()
+	{
+		NumEnqueued.Increment();
+		const int32 Depth = QueueDepth.Increment();
+		if (Depth > MaxQueueDepth.GetValue())
+		{
+			MaxQueueDepth.Set(Depth);
+		}
+	}
+
+	// Get the stats as string
+	FString ToString() const
+	{
+		const int32 Enqueued = NumEnqueued.GetValue();
+		const int32 Written = NumWritten.GetValue();
+		const double EnqueuedDiv = Enqueued > 0 ? Enqueued : 1.0;
+		const double WrittenDiv = Written > 0 ? Written : 1.0;
+		return FString::Printf(TEXT("Enqueued=%d; Written=%d; Dropped=%d; QueueDepth=%d; MaxQueueDepth=%d; BulkFlushes=%d; "
+			"AvgCapture=%.3fms; AvgSerialize=%.3fms; AvgUpload=%.3fms; AvgQueueLatency=%.3fms;"),
+			Enqueued, Written, NumDropped.GetValue(), QueueDepth.GetValue(), MaxQueueDepth.GetValue(), NumBulkFlushes.GetValue(),
+			CaptureTimeUs.GetValue() / EnqueuedDiv / 1000.0,
+			SerializeTimeUs.GetValue() / WrittenDiv / 1000.0,
+			UploadTimeUs.GetValue() / WrittenDiv / 1000.0,
+			QueueLatencyUs.GetValue() / WrittenDiv / 1000.0);
+	}
+};
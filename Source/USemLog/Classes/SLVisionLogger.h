@@ -11,8 +11,11 @@
 #include "Vision/SLVisionStructs.h"
 #include "Vision/SLVisionPoseableMeshActor.h"
 #include "Vision/SLVisionDBHandler.h"
+#include "Vision/SLVisionEpisodeReader.h"
 #include "Vision/SLVisionMaskImageHandler.h"
 #include "Vision/SLVisionOverlapCalc.h"
+#include "Vision/SLVisionImagePipeline.h"
+#include "Vision/SLVisionSceneCaptureRenderer.h"
 
 #include "SLVisionLogger.generated.h"
 
@@ -20,6 +23,7 @@
 class UGameViewportClient;
 class ASLVirtualCameraView;
 class USLSkeletalDataComponent;
+class USLCVMaskMaterialLibrary;
 
 /**
  * Replays episodes from different perspectives and view modes,
@@ -68,6 +72,9 @@ public:
 	// Get access to the poseable skeletal mesh clone from the id
 	ASLVisionPoseableMeshActor* GetPoseableSkeletalMaskCloneFromId(const FString& Id, USLSkeletalDataComponent** OutSkelDataAsset = nullptr);
 
+	// Hide or show all the mask clones (used by the overlap calculation to render only a subset of the clones)
+	void SetMaskClonesHiddenInGame(bool bHidden);
+
 protected:
 	// Trigger the screenshot on the game thread
 	void RequestScreenshot();
@@ -75,6 +82,18 @@ protected:
 	// Called when the screenshot is captured
 	void ScreenshotCB(int32 SizeX, int32 SizeY, const TArray<FColor>& Bitmap);
 
+	// Called when the scene captures of all the views of the frame are read back
+	void SceneCapturesCB(TArray<FSLVisionCapturedImage>& Images);
+
+	// Add the image of the current view and view mode (processed in the background if the pipeline is running)
+	void AddImage(int32 SizeX, int32 SizeY, const TArray<FColor>& Bitmap, bool bRestoreMaskOnGameThread);
+
+	// Restore (mask), compress and cache the image on the game thread
+	void ProcessImage(int32 SizeX, int32 SizeY, const TArray<FColor>& Bitmap);
+
+	// Write the current frame data to the database
+	void WriteCurrFrame();
+
 	// Start the dominoes, setup the first frame, camera and view mode, return true if succesfull
 	bool FirstStep();
 
@@ -132,13 +151,25 @@ private:
 	
 	// Save the compressed screenshot image locally
 	void SaveImageLocally(const TArray<uint8>& CompressedBitmap);
+
+	// Path of the current image if it is saved locally
+	FString GetLocalImagePath() const;
 	
 	// Output progress to terminal
 	void PrintProgress() const;
 
+	// Store the duration of the init phase started at the given time
+	void AddInitPhaseTime(const FString& PhaseName, double StartTime);
+
 	// Get view mode as string
 	FString GetViewModeName(ESLVisionViewMode Mode) const;
 
+	// Get view mode filename postfix
+	FString GetViewModePostfix(ESLVisionViewMode Mode) const;
+
+	// Set the filename of the current image
+	void SetCurrImageFilename();
+
 protected:
 	// Set when initialized
 	bool bIsInit;
@@ -159,6 +190,13 @@ private:
 	// Gathers semantics from the images
 	FSLVisionMaskImageHandler MaskImgHandler;
 
+	// Processes and writes the images in the background while the next views are rendered
+	FSLVisionImagePipeline ImagePipeline;
+
+	// Renders all the views of a frame with scene captures (nullptr if the viewport screenshots are used)
+	UPROPERTY() // Avoid GC
+	USLVisionSceneCaptureRenderer* SceneCaptureRenderer;
+
 	// Calculates entities overlap percentages in images
 	UPROPERTY() // Avoid GC
 	USLVisionOverlapCalc* OverlapCalc;
@@ -166,8 +204,8 @@ private:
 	// Current frame timestamp
 	float CurrTimestamp;
 
-	// Episode data to replay
-	FSLVisionEpisode Episode;
+	// Streams the episode data to replay
+	FSLVisionEpisodeReader Episode;
 
 	// Holds the vision data of all the views
 	FSLVisionFrameData CurrFrameData;
@@ -179,6 +217,10 @@ private:
 	UPROPERTY() // Avoid GC
 	TMap<ASkeletalMeshActor*, ASLVisionPoseableMeshActor*> SkelToPoseableMap;
 
+	// Mask materials shared by the mask clones with the same color
+	UPROPERTY() // Avoid GC
+	USLCVMaskMaterialLibrary* MaskMaterials;
+
 	// Copies of the static meshes with mask materials on top
 	UPROPERTY() // Avoid GC
 	TMap<AStaticMeshActor*, AStaticMeshActor*> OrigToMaskClones;
@@ -222,4 +264,7 @@ private:
 
 	// Image resolution 
 	FIntPoint Resolution;
+
+	// Durations of the init phases (printed with the progress)
+	TArray<TPair<FString, double>> InitPhaseTimes;
 };
@@ -5,10 +5,8 @@
 
 #include "CoreMinimal.h"
 #include "Vision/SLVisionStructs.h"
-#include "Animation/SkeletalMeshActor.h"
 
 #if SL_WITH_LIBMONGO_C
-class ASLVisionPoseableMeshActor;
 THIRD_PARTY_INCLUDES_START
 	#if PLATFORM_WINDOWS
 	#include "Windows/AllowWindowsPlatformTypes.h"
@@ -39,11 +37,6 @@ public:
 	// Create indexes on the inserted data
 	void CreateIndexes() const;
 
-	// Get episode data from the database (UpdateRate = 0 means all the data)
-	bool GetEpisodeData(float UpdateRate, const TMap<ASkeletalMeshActor*,
-		ASLVisionPoseableMeshActor*>& InSkelToPoseableMap,
-		FSLVisionEpisode& OutEpisode);
-
 	// Write current frame
 	void WriteFrame(const FSLVisionFrameData& Frame) const;
 
@@ -55,16 +48,6 @@ private:
 	void DropPreviousEntries(const FString& DBName, const FString& CollName) const;
 
 #if SL_WITH_LIBMONGO_C
-	// Helper function to get the entities data out of the bson iterator, returns false if there are no entities
-	bool GetEntitiesData(bson_iter_t* doc,
-		TMap<AStaticMeshActor*, FTransform>& OutEntityPoses,
-		TMap<ASLVirtualCameraView*, FTransform>& OutVirtualCameraPoses) const;
-
-	// Helper function to get the entities data out of the bson iterator, returns false if there are no entities
-	bool GetSkeletalEntitiesData(bson_iter_t* doc,
-		const TMap<ASkeletalMeshActor*, ASLVisionPoseableMeshActor*>& InSkelToPoseableMap,
-		TMap<ASLVisionPoseableMeshActor*, TMap<FName, FTransform>>& OutSkeletalPoses) const;
-
 	// Save image to gridfs, get the file oid and return true if succeeded
 	bool AddToGridFs(const TArray<uint8>& InData, bson_oid_t* out_oid) const;
 
@@ -0,0 +1,165 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Vision/SLVisionStructs.h"
+#include "Animation/SkeletalMeshActor.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Containers/Queue.h"
+
+#if SL_WITH_LIBMONGO_C
+THIRD_PARTY_INCLUDES_START
+	#if PLATFORM_WINDOWS
+	#include "Windows/AllowWindowsPlatformTypes.h"
+	#include <mongoc/mongoc.h>
+	#include "Windows/HideWindowsPlatformTypes.h"
+	#else
+	#include <mongoc/mongoc.h>
+	#endif // #if PLATFORM_WINDOWS
+THIRD_PARTY_INCLUDES_END
+#endif //SL_WITH_LIBMONGO_C
+
+// Forward declarations
+class FRunnableThread;
+class FEvent;
+
+/**
+ * Streams the episode frames from the world state collection, a dedicated thread (with its own db connection)
+ * iterates the cursor and keeps a small read-ahead buffer of frames, so the replay starts right away
+ * and its memory does not depend on the episode length
+ */
+class FSLVisionEpisodeReader : public FRunnable
+{
+public:
+	// Ctor
+	FSLVisionEpisodeReader();
+
+	// Dtor
+	virtual ~FSLVisionEpisodeReader();
+
+	// Connect to the episode collection and read its time range (UpdateRate = 0 means all the data)
+	bool Init(const FString& DBName, const FString& CollName, const FString& ServerIp, uint16 ServerPort,
+		float InUpdateRate, const TMap<ASkeletalMeshActor*, ASLVisionPoseableMeshActor*>& InSkelToPoseableMap,
+		int32 InMaxReadAheadFrames);
+
+	// Start reading the frames in the background
+	bool Start();
+
+	// Signal the reader thread to stop, blocks until done
+	virtual void Stop() override;
+
+	// Stop reading, free the buffered frames and disconnect
+	void Finish();
+
+	// Move actors to the first frame (the stream cannot be rewound)
+	bool SetupFirstFrame(float& OutTimestamp,
+		bool bIncludeMasks,
+		TMap<AStaticMeshActor*, AStaticMeshActor*>& MaskClones,
+		TMap<ASLVisionPoseableMeshActor*, ASLVisionPoseableMeshActor*>& SkelMaskClones);
+
+	// Move actors to the next frame transformations, return false if no more frames are available
+	bool SetupNextFrame(float& OutTimestamp,
+		bool bIncludeMasks,
+		TMap<AStaticMeshActor*, AStaticMeshActor*>& MaskClones,
+		TMap<ASLVisionPoseableMeshActor*, ASLVisionPoseableMeshActor*>& SkelMaskClones);
+
+	// Get the active frame in the episode
+	int32 GetCurrIndex() const { return FrameIdx; };
+
+	// Get the estimated total number of frames (the frames are not known before they are read)
+	int32 GetFramesNum() const { return NumFramesEstimate; };
+
+	// Get first timestamp
+	FORCEINLINE float GetFirstTimestamp() const { return FirstTimestamp; };
+
+	// Get last timestamp
+	FORCEINLINE float GetLastTimestamp() const { return LastTimestamp; };
+
+	/* Begin FRunnable interface */
+	virtual uint32 Run() override;
+	/* End FRunnable interface */
+
+private:
+	// Wait for the next frame from the reader thread, returns false if there are no more frames
+	bool PopFrame();
+
+	// Read the first and last timestamp of the episode and estimate the number of frames
+	bool ReadTimeRange();
+
+	// Release the db handles
+	void Disconnect();
+
+#if SL_WITH_LIBMONGO_C
+	// Get the value of the first or last (sorted) timestamp, returns false if there are no entries
+	bool ReadBoundaryTimestamp(bool bFirst, float& OutTimestamp) const;
+
+	// Helper function to get the entities data out of the bson iterator, returns false if there are no entities
+	bool GetEntitiesData(bson_iter_t* doc,
+		TMap<AStaticMeshActor*, FTransform>& OutEntityPoses,
+		TMap<ASLVirtualCameraView*, FTransform>& OutVirtualCameraPoses) const;
+
+	// Helper function to get the entities data out of the bson iterator, returns false if there are no entities
+	bool GetSkeletalEntitiesData(bson_iter_t* doc,
+		const TMap<ASkeletalMeshActor*, ASLVisionPoseableMeshActor*>& InSkelToPoseableMap,
+		TMap<ASLVisionPoseableMeshActor*, TMap<FName, FTransform>>& OutSkeletalPoses) const;
+#endif //SL_WITH_LIBMONGO_C
+
+private:
+	// Min time between two frames
+	float UpdateRate;
+
+	// Map from the skeletal entities to the poseable meshes (read only while the thread runs)
+	TMap<ASkeletalMeshActor*, ASLVisionPoseableMeshActor*> SkelToPoseableMap;
+
+	// Max number of frames waiting to be replayed
+	int32 MaxReadAheadFrames;
+
+	// Frames read ahead
+	TQueue<FSLVisionFrame*, EQueueMode::Spsc> FrameQueue;
+
+	// Number of frames read ahead
+	FThreadSafeCounter NumQueuedFrames;
+
+	// Currently applied frame
+	FSLVisionFrame CurrFrame;
+
+	// Current frame index
+	int32 FrameIdx;
+
+	// Time range of the episode
+	float FirstTimestamp;
+	float LastTimestamp;
+
+	// Number of frames estimated from the time range and the update rate
+	int32 NumFramesEstimate;
+
+	// Triggered when a frame is replayed
+	FEvent* SlotEvent;
+
+	// Triggered when a frame is read (or the episode is done)
+	FEvent* FrameEvent;
+
+	// The reader thread
+	FRunnableThread* Thread;
+
+	// Set when all the frames are read
+	FThreadSafeBool bReadDone;
+
+	// Set when the thread should exit
+	FThreadSafeBool bStopRequested;
+
+#if SL_WITH_LIBMONGO_C
+	// Server uri
+	mongoc_uri_t* uri;
+
+	// MongoC connection client (only used by the reader thread once started)
+	mongoc_client_t* client;
+
+	// World state collection of the episode
+	mongoc_collection_t* collection;
+#endif //SL_WITH_LIBMONGO_C
+};
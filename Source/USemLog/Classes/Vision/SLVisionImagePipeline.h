@@ -0,0 +1,152 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Vision/SLVisionStructs.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Containers/Queue.h"
+#include "Async/Future.h"
+
+// Forward declarations
+class FSLVisionDBHandler;
+class FSLVisionMaskImageHandler;
+class FRunnableThread;
+class FEvent;
+
+/*
+* Processed image (and the mask data if the mask was restored by the job)
+*/
+struct FSLVisionImageJobResult
+{
+	// Compressed image
+	TArray<uint8> CompressedBitmap;
+
+	// Entities read from the mask image
+	TArray<FSLVisionViewEntityData> Entities;
+
+	// Skeletal entities read from the mask image
+	TArray<FSLVisionViewSkelData> SkelEntities;
+};
+
+/*
+* Image processed on the thread pool, the result is placed in the frame at the given view and image index
+*/
+struct FSLVisionImageJob
+{
+	// Index of the view in the frame
+	int32 ViewIdx = INDEX_NONE;
+
+	// Index of the image in the view
+	int32 ImageIdx = INDEX_NONE;
+
+	// Set when the job is done
+	TFuture<void> Future;
+
+	// Written by the job
+	TSharedPtr<FSLVisionImageJobResult, ESPMode::ThreadSafe> Result;
+};
+
+/*
+* Frame waiting for its images to be processed before being written to the database
+*/
+struct FSLVisionPendingFrame
+{
+	// Frame data with placeholder images
+	FSLVisionFrameData Frame;
+
+	// Image jobs of the frame
+	TArray<FSLVisionImageJob> Jobs;
+};
+
+/**
+ * Pipelines the vision logger screenshots: mask restoration, compression and local saving run on the thread pool
+ * while the next view is rendered, the frames are written to the database in order by a dedicated thread once
+ * all their images are processed; the number of images in flight is bounded (the game thread waits for a free slot)
+ */
+class FSLVisionImagePipeline : public FRunnable
+{
+public:
+	// Ctor
+	FSLVisionImagePipeline();
+
+	// Dtor
+	virtual ~FSLVisionImagePipeline();
+
+	// Set the frame writer, the mask restorer and the max number of images processed at the same time
+	bool Init(FSLVisionDBHandler* InDBHandler, const FSLVisionMaskImageHandler* InMaskImgHandler, int32 InMaxImagesInFlight);
+
+	// Start the frame writer thread
+	bool Start();
+
+	// Signal the writer thread to write the remaining frames and stop, blocks until done
+	virtual void Stop() override;
+
+	// Wait for the images and frames in flight and stop the writer thread
+	void Finish();
+
+	// True if the images are processed by the pipeline
+	bool IsStarted() const { return Thread != nullptr; };
+
+	/* Producer (game thread) */
+	// Copy the bitmap and queue it for processing, blocks if too many images are in flight
+	void AddImage(int32 ViewIdx, int32 ImageIdx, int32 SizeX, int32 SizeY, const TArray<FColor>& Bitmap,
+		bool bRestoreMask, const FString& LocalPath = FString());
+
+	// Queue the frame for writing once all its images are processed (the frame data is moved)
+	void AddFrame(FSLVisionFrameData& Frame);
+
+	/* Begin FRunnable interface */
+	virtual uint32 Run() override;
+	/* End FRunnable interface */
+
+private:
+	// Block until the number of images in flight and frames waiting to be written are below their limits
+	void WaitForSlot();
+
+	// Wait for the frame images, fill them in and write the frame to the database
+	void WriteFrame(FSLVisionPendingFrame& PendingFrame);
+
+	// Write all the queued frames
+	void WriteQueuedFrames();
+
+private:
+	// Writes the frames (only accessed by the writer thread while it runs)
+	FSLVisionDBHandler* DBHandler;
+
+	// Restores the mask images (read only, shared by the jobs)
+	const FSLVisionMaskImageHandler* MaskImgHandler;
+
+	// Image jobs of the frame currently rendered
+	TArray<FSLVisionImageJob> CurrFrameJobs;
+
+	// Frames waiting to be written
+	TQueue<FSLVisionPendingFrame*, EQueueMode::Spsc> FrameQueue;
+
+	// Max number of images processed at the same time
+	int32 MaxImagesInFlight;
+
+	// Max number of frames waiting to be written
+	int32 MaxPendingFrames;
+
+	// Number of images being processed
+	FThreadSafeCounter NumImagesInFlight;
+
+	// Number of frames waiting to be written
+	FThreadSafeCounter NumPendingFrames;
+
+	// Triggered when an image is processed or a frame is written
+	FEvent* SlotEvent;
+
+	// Wakes up the writer thread when new frames are available
+	FEvent* WorkEvent;
+
+	// The writer thread
+	FRunnableThread* Thread;
+
+	// Set when the thread should write the remaining frames and exit
+	FThreadSafeBool bStopRequested;
+};
@@ -79,6 +79,24 @@ struct FSLVisionImageColorInfo
 	FColor OriginalMaskColor;
 };
 
+/**
+* Rendered mask color slot, direct access to the semantic data of the color from the lookup table
+*/
+struct FSLVisionMaskColorSlot
+{
+	// Rendered color
+	FColor RenderedColor;
+
+	// Original mask color (used for restoring the mask image)
+	FColor OriginalMaskColor;
+
+	// Entity data of the color (points into the entity mapping)
+	const FSLVisionMaskEntityInfo* EntityInfo = nullptr;
+
+	// Skeletal entity data of the color (points into the skeletal mapping)
+	const FSLVisionMaskSkelInfo* SkelInfo = nullptr;
+};
+
 /**
  * 
  */
@@ -99,6 +117,16 @@ public:
 
 private:
 	/* Helper functions */
+	// Build the color slots and their lookup table from the mappings
+	void BuildColorLookupTable();
+
+	// Get the color slot index of the rendered color, INDEX_NONE if the color has no mapping
+	FORCEINLINE int32 GetColorSlotIndex(const FColor& Color) const
+	{
+		const int32 PageIdx = RGToColorPage[(Color.R << 8) | Color.G];
+		return PageIdx == INDEX_NONE ? INDEX_NONE : ColorPages[(PageIdx << 8) | Color.B];
+	}
+
 	// Restore the color of the pixel to its original mask value (offseted by screenshot rendering artifacts), returns true if restoration happened
 	bool RestoreColorValueFromArray(FColor& PixelColor, const TArray<FColor>& InOriginalMaskColors, uint8 Tolerance = 13) const;
 
@@ -117,4 +145,13 @@ private:
 
 	// Rendered color to skeletal entity data
 	TMap<FColor, FSLVisionMaskSkelInfo> RenderedColorToSkelInfo;
+
+	// Rendered colors with a mapping
+	TArray<FSLVisionMaskColorSlot> ColorSlots;
+
+	// Packed red and green channels to page in the color pages (INDEX_NONE if no rendered color uses the combination)
+	TArray<int32> RGToColorPage;
+
+	// Pages of 256 blue channel values to color slot index (INDEX_NONE if the color has no mapping)
+	TArray<int32> ColorPages;
 };
@@ -14,8 +14,28 @@ class USLVisionLogger;
 class AStaticMeshActor;
 class UMaterialInterface;
 class UMaterial;
+class UMaterialInstanceDynamic;
+class UMeshComponent;
 //class USLSkeletalDataComponent;
 
+/**
+ * Item rendered in a single pass overlap group
+ */
+struct FSLVisionOverlapGroupItem
+{
+	// Index in the entities or the skel entities array
+	int32 Index = INDEX_NONE;
+
+	// True if the index points to the skel entities array
+	bool bIsSkel = false;
+
+	// Mask clone of the item
+	AActor* Clone = nullptr;
+
+	// Mesh component of the mask clone
+	UMeshComponent* MC = nullptr;
+};
+
 /**
  * Calculates overlap percentages for entities in an image
  */
@@ -32,7 +52,7 @@ public:
 	~USLVisionOverlapCalc();
 
 	// Give control to the overlap calc to pause and start its parent (vision logger)
-	void Init(USLVisionLogger* InParent, FIntPoint InResolution, const FString& InSaveLocallyPath = FString());
+	void Init(USLVisionLogger* InParent, FIntPoint InResolution, const FString& InSaveLocallyPath = FString(), bool bInSinglePass = false);
 
 	// Calculate overlaps for the given scene
 	void Start(struct FSLVisionViewData* CurrViewData, float Timestamp, int32 FrameIdx);
@@ -96,10 +116,35 @@ private:
 	// Print out the progress in the terminal
 	void PrintProgress() const;
 
+	/* Single pass */
+	// Group the items in the view, items of a group do not overlap in screen space and are rendered with one screenshot
+	bool BuildSinglePassGroups();
+
+	// Show only the clones of the group with a uniquely colored non occluding material
+	void ApplyGroupNonOccludingMaterials(int32 GroupIdx);
+
+	// Re-apply the original materials of the group and show all the clones
+	void ReApplyGroupOriginalMaterials();
+
+	// Calculate the overlaps of all the items of the group from one image
+	void CalculateGroupOverlaps(const TArray<FColor>& NonOccludedImage, int32 ImgWidth, int32 ImgHeight);
+
+	// Get the screen space bounds of the actor in normalized viewport coordinates (the whole screen if it cannot be projected)
+	FBox2D GetScreenBounds(AActor* Actor) const;
+
+	// Color of the group item index (two bits per channel)
+	static FColor GetGroupItemColor(int32 ItemIdx);
+
+	// Group item index of the rendered color, INDEX_NONE if it is the background or too far off from the palette
+	static int32 GetGroupItemIndex(const FColor& Color);
+
 	/* Helper */
 	// Return INDEX_NONE if not possible
 	int32 GetMaterialIndexOfCurrentlySelectedBone();
 
+	// Occlusion percentage from the non occluded and the occluded image percentages
+	static float CalcOcclusionPercentage(float NonOccImgPerc, float ImgPerc);
+
 protected:
 	// Set when initialized
 	bool bIsInit;
@@ -133,6 +178,23 @@ private:
 	UPROPERTY() // Avoid GC
 	TArray<UMaterialInterface*> CachedMaterials;
 
+	// Calculate the overlaps with one screenshot per group of non overlapping items
+	bool bSinglePass;
+
+	// Uniquely colored non occluding materials of the group items (indexed by the group item index)
+	UPROPERTY() // Avoid GC
+	TArray<UMaterialInstanceDynamic*> GroupMaterials;
+
+	// Chached mask materials of the active group, (flattened, in the order of the group items and their material slots)
+	UPROPERTY() // Avoid GC
+	TArray<UMaterialInterface*> GroupCachedMaterials;
+
+	// Items of the current view grouped by the single pass
+	TArray<TArray<FSLVisionOverlapGroupItem>> Groups;
+
+	// Index of the active group (INDEX_NONE if not active/set)
+	int32 GroupIndex;
+
 	// Used for triggering the screenshot request
 	UGameViewportClient* ViewportClient;
 
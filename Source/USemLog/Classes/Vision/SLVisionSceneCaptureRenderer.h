@@ -0,0 +1,119 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "RenderCommandFence.h"
+#include "RHIGPUReadback.h"
+#include "Vision/SLVisionStructs.h"
+#include "SLVisionSceneCaptureRenderer.generated.h"
+
+// Forward declarations
+class ASLVirtualCameraView;
+class USceneCaptureComponent2D;
+class UTextureRenderTarget2D;
+
+/*
+* Image of a virtual camera in a view mode read back from the render target
+*/
+struct FSLVisionCapturedImage
+{
+	// Index of the virtual camera
+	int32 CameraIdx = INDEX_NONE;
+
+	// Index of the view mode
+	int32 ViewModeIdx = INDEX_NONE;
+
+	// Image size
+	FIntPoint Size;
+
+	// Image pixels
+	TArray<FColor> Bitmap;
+
+	// False if the image could not be read back (the bitmap is then empty)
+	bool bIsValid = false;
+};
+
+/** Notify when the images of all the views are read back (sorted by camera, then by view mode) */
+DECLARE_DELEGATE_OneParam(FSLVisionCapturesReadySignature, TArray<FSLVisionCapturedImage>& /*Images*/);
+
+/**
+ * Render backend of the vision logger using a scene capture component and render target for every
+ * virtual camera and view mode, all the views of a frame are rendered in the same engine tick
+ * and copied to staging textures by the GPU, the copies are polled and mapped without blocking the game or render thread
+ */
+UCLASS()
+class USLVisionSceneCaptureRenderer : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	// Ctor
+	USLVisionSceneCaptureRenderer();
+
+	// Create the capture components and render targets, the mask clones are only rendered by the mask captures
+	bool Init(const TArray<ASLVirtualCameraView*>& InCameras, const TArray<ESLVisionViewMode>& InViewModes,
+		FIntPoint InResolution, const TArray<AActor*>& InMaskClones);
+
+	// Render all the views of the current world state and start their read back (false if a read back is pending)
+	bool Capture();
+
+	// Wait for any pending read back and remove the capture components
+	void Finish();
+
+	// Get init state
+	bool IsInit() const { return bIsInit; };
+
+	// True while the images are being read back
+	bool IsReadbackPending() const { return bIsReadbackPending; };
+
+	// Called when the images of all the views are available
+	FSLVisionCapturesReadySignature OnCapturesReady;
+
+private:
+	// Create the capture component of the camera for the given view mode
+	USceneCaptureComponent2D* CreateCaptureComponent(ASLVirtualCameraView* Camera, ESLVisionViewMode Mode,
+		UTextureRenderTarget2D* RenderTarget, const TArray<AActor*>& InMaskClones) const;
+
+	// Check every tick if the read back is done and broadcast the images
+	void CheckReadback();
+
+private:
+	// Set when initialized
+	bool bIsInit;
+
+	// Set while the images are being read back
+	bool bIsReadbackPending;
+
+	// Set when the staging copies are done and are being mapped to the buffers
+	bool bIsLockPending;
+
+	// Rendered image resolution
+	FIntPoint Resolution;
+
+	// Used for scheduling the read back checks
+	UPROPERTY()
+	UWorld* World;
+
+	// Capture components (camera major, view mode minor)
+	UPROPERTY()
+	TArray<USceneCaptureComponent2D*> CaptureComponents;
+
+	// Render targets of the capture components
+	UPROPERTY()
+	TArray<UTextureRenderTarget2D*> RenderTargets;
+
+	// Camera and view mode index of the capture components
+	TArray<TPair<int32, int32>> CaptureIndexes;
+
+	// GPU copies of the render targets (one staging texture per render target)
+	TArray<TSharedPtr<FRHIGPUTextureReadback, ESPMode::ThreadSafe>> Readbacks;
+
+	// Read back buffers (written by the render thread)
+	TArray<TSharedPtr<TArray<FColor>, ESPMode::ThreadSafe>> ReadbackBuffers;
+
+	// Signals when the enqueued copy or lock commands are done
+	FRenderCommandFence ReadbackFence;
+};
@@ -43,6 +43,18 @@ struct FSLVisionLoggerParams
 	// Make screenshots for calculating overlaps smaller for faster logging
 	uint8 OverlapResolutionDivisor;
 
+	// Calculate the overlaps of all the items in the view with one screenshot per group of non-overlapping items (instead of one per item)
+	bool bSinglePassOverlaps = false;
+
+	// Max number of images compressed and uploaded while the next views are rendered (0 processes the images on the game thread)
+	int32 MaxImagesInFlight = 8;
+
+	// Render all the virtual cameras and view modes of a frame in one tick with scene captures (instead of viewport screenshots)
+	bool bUseSceneCaptures = false;
+
+	// Max number of episode frames read ahead from the database while the current frame is rendered
+	int32 MaxReadAheadFrames = 32;
+
 	// Default ctor
 	FSLVisionLoggerParams() {};
 
@@ -52,12 +64,20 @@ struct FSLVisionLoggerParams
 		FIntPoint InResolution,
 		bool bInIncludeLocally,
 		bool InCalculateOverlaps,
-		uint8 InOverlapResolutionDivisor) :
+		uint8 InOverlapResolutionDivisor,
+		bool bInSinglePassOverlaps = false,
+		int32 InMaxImagesInFlight = 8,
+		bool bInUseSceneCaptures = false,
+		int32 InMaxReadAheadFrames = 32) :
 		UpdateRate(InUpdateRate),
 		Resolution(InResolution),
 		bIncludeLocally(bInIncludeLocally),
 		bCalculateOverlaps(InCalculateOverlaps),
-		OverlapResolutionDivisor(InOverlapResolutionDivisor)
+		OverlapResolutionDivisor(InOverlapResolutionDivisor),
+		bSinglePassOverlaps(bInSinglePassOverlaps),
+		MaxImagesInFlight(InMaxImagesInFlight),
+		bUseSceneCaptures(bInUseSceneCaptures),
+		MaxReadAheadFrames(InMaxReadAheadFrames)
 	{};
 };
 
@@ -122,69 +142,6 @@ struct FSLVisionFrame
 	void Clear() { Timestamp = -1.f; ActorPoses.Empty(); SkeletalPoses.Empty(); VisionCameraPoses.Empty(); };
 };
 
-/**
-* The whole episode data
-*/
-class FSLVisionEpisode
-{
-public:
-	// Default ctor
-	FSLVisionEpisode() : FrameIdx(INDEX_NONE) {};
-
-	// Add a new frame
-	int32 AddFrame(const FSLVisionFrame& Frame) { return Frames.Emplace(Frame); };
-	
-	// Get the active frame in the episode
-	int32 GetCurrIndex() const { return FrameIdx; };
-
-	// Get the total number of frames
-	int32 GetFramesNum() const { return Frames.Num(); };
-
-	// Move actors to the first frame
-	bool SetupFirstFrame(float& OutTimestamp,
-		bool bIncludeMasks,
-		TMap<AStaticMeshActor*, AStaticMeshActor*>& MaskClones,
-		TMap<ASLVisionPoseableMeshActor*, ASLVisionPoseableMeshActor*>& SkelMaskClones)
-	{
-		FrameIdx = 0;
-		if(Frames.IsValidIndex(FrameIdx))
-		{
-			OutTimestamp = Frames[FrameIdx].ApplyTransformations(bIncludeMasks, MaskClones, SkelMaskClones);
-			return true;
-		}
-		return false;
-	}
-
-	// Move actors to the next frame transformations, return false if no more frames are available
-	bool SetupNextFrame(float& OutTimestamp,
-		bool bIncludeMasks,
-		TMap<AStaticMeshActor*, AStaticMeshActor*>& MaskClones,
-		TMap<ASLVisionPoseableMeshActor*, ASLVisionPoseableMeshActor*>& SkelMaskClones)
-	{
-		FrameIdx++;
-		if(Frames.IsValidIndex(FrameIdx))
-		{
-			OutTimestamp = Frames[FrameIdx].ApplyTransformations(bIncludeMasks, MaskClones, SkelMaskClones);
-			return true;
-		}
-		FrameIdx = INDEX_NONE;
-		return false;
-	}
-
-	// Get first timestamp
-	FORCEINLINE float GetFirstTimestamp() const { return Frames.IsValidIndex(0) ? Frames[0].Timestamp : -1.f; };
-
-	// Get last timestamp
-	FORCEINLINE float GetLastTimestamp() const { return Frames.Num() > 0 ? Frames.Last().Timestamp : -1.f; };
-	
-private:
-	// All the frames from the episode
-	TArray<FSLVisionFrame> Frames;
-	
-	// Current frame index
-	int32 FrameIdx;
-};
-
 /**
 * Semantic entities data from the view
 */
@@ -0,0 +1,61 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Forward declarations
+class ASLIndividualManager;
+struct FSLVizEpisodeData;
+struct FSLVizEpisodeFrameData;
+
+/**
+ * Local cache file (.slvc) of a built replay episode, the logged episodes are immutable so it is written once
+ * and read instead of querying and rebuilding the episode in the following sessions
+ *	header	: uint32 magic, int32 version, int32 num_ids, [utf8 id] * num_ids,
+ *			  int32 keyframe_interval, int32 num_frames, int32 num_keyframes
+ *	data	: float32 timestamp * num_frames, keyframes, compact frames
+ *	frame	: int32 num_poses, [int32 id_idx, float32 x y z qx qy qz qw] * num_poses
+ *	end		: uint32 end_magic
+ * The poses are keyed by the individual id indexes (not the session dependent handles),
+ * they are mapped to the handles of the current world when the file is read
+ */
+struct USEMLOG_API FSLVizEpisodeCacheFile
+{
+	// Magic values
+	static constexpr uint32 HeaderMagic = 0x43564C53; // "SLVC"
+	static constexpr uint32 EndMagic = 0x45564C53; // "SLVE"
+
+	// File version, files with a different version are ignored (rebuilt)
+	static constexpr int32 Version = 1;
+
+	// File extension
+	static const TCHAR* GetExtension() { return TEXT(".slvc"); };
+
+	// Get the cache file path of the episode (<Saved>/SL/VizCache/<TaskId>/<EpisodeId>.slvc)
+	static FString GetFilePath(const FString& TaskId, const FString& EpisodeId);
+
+	// Check if a cache file exists for the episode
+	static bool Exists(const FString& TaskId, const FString& EpisodeId);
+
+	// Write the episode to its cache file (the handles are replaced by the individual ids)
+	static bool Write(const FString& TaskId, const FString& EpisodeId,
+		const FSLVizEpisodeData& InEpisodeData, ASLIndividualManager* IndividualManager);
+
+	// Write the episode to its cache file using the given handle to id mapping (does not access the world, any thread)
+	static bool Write(const FString& TaskId, const FString& EpisodeId,
+		const FSLVizEpisodeData& InEpisodeData, const TArray<FString>& HandleToId);
+
+	// Read the episode from its cache file (the file is memory mapped, the ids are mapped to the current handles)
+	static bool Read(const FString& TaskId, const FString& EpisodeId,
+		ASLIndividualManager* IndividualManager, FSLVizEpisodeData& OutEpisodeData);
+
+private:
+	// Append the frame poses with the handles replaced by the id indexes
+	static void WriteFrame(TArray<uint8>& OutData, const FSLVizEpisodeFrameData& Frame, const TArray<int32>& HandleToIdIdx);
+
+	// Read the frame poses with the id indexes replaced by the handles (the poses of unknown ids are skipped)
+	static bool ReadFrame(const uint8*& Data, const uint8* End, const TArray<int32>& IdIdxToHandle,
+		bool bIsKeyframe, FSLVizEpisodeFrameData& OutFrame);
+};
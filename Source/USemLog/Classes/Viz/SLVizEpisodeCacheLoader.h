@@ -0,0 +1,112 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Viz/SLVizEpisodeManager.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Async/Future.h"
+
+// Forward declarations
+class ASLIndividualManager;
+
+/*
+* Data shared by the loader and its background tasks, owned by whichever finishes last
+* so the loader can be dropped without waiting for the running fetches
+*/
+struct FSLVizEpisodeCacheLoaderState
+{
+	// Database connection parameters
+	FString ServerIp;
+	uint16 ServerPort = 0;
+	FString TaskId;
+
+	// Individual id to handle of the individuals in the world (read only while the tasks run)
+	TMap<FString, int32> IdToHandle;
+
+	// Replay targets indexed by the handles (read only while the tasks run)
+	TArray<FSLVizEpisodeTarget> Targets;
+
+	// Individual ids indexed by the handles, used for writing the cache files (read only while the tasks run)
+	TArray<FString> HandleToId;
+
+	// Write the built episodes to their local cache files in the tasks
+	bool bWriteCacheFiles = false;
+
+	// Number of finished tasks
+	FThreadSafeCounter NumFinished;
+
+	// Checked by the tasks between the fetch, build and write steps
+	FThreadSafeBool bCancelRequested;
+
+	// Holds a libmongoc reference for the worker connections
+	FSLVizEpisodeCacheLoaderState();
+
+	// Releases the libmongoc reference (after the last task finished)
+	~FSLVizEpisodeCacheLoaderState();
+};
+
+/*
+* Episode fetched and built by a background task
+*/
+struct FSLVizEpisodeCacheJob
+{
+	// Id of the episode
+	FString EpisodeId;
+
+	// Built episode (written by the task)
+	TSharedPtr<FSLVizEpisodeData, ESPMode::ThreadSafe> Result;
+
+	// Set when the task is done, true if the episode was built
+	TFuture<bool> Future;
+
+	// Set when the result was handed over to the game thread
+	bool bCollected = false;
+};
+
+/**
+ * Fetches and builds multiple episodes concurrently on the thread pool, every task uses its own database connection;
+ * the replay targets are resolved once on the game thread so the tasks do not access the world,
+ * the tasks also write the local cache files, only the registration of the built episodes is done on the game thread
+ */
+class FSLVizEpisodeCacheLoader
+{
+public:
+	// Dtor
+	~FSLVizEpisodeCacheLoader();
+
+	// Resolve the replay targets and start a background task for every episode, the tasks also write the local cache files if set (game thread)
+	bool Start(ASLIndividualManager* IndividualManager, const FString& ServerIp, uint16 ServerPort,
+		const FString& InTaskId, const TArray<FString>& EpisodeIds, bool bInWriteCacheFiles = false);
+
+	// Move the episodes built since the last call to the output array (game thread)
+	int32 CollectFinished(TArray<FSLVizEpisodeData>& OutEpisodes);
+
+	// Signal the tasks to stop without waiting for them, the episodes which are not collected yet are discarded
+	void Cancel();
+
+	// True while there are episodes which are not collected yet
+	bool IsRunning() const;
+
+	// Get the task id
+	FString GetTaskId() const { return State.IsValid() ? State->TaskId : FString(); };
+
+	// Number of episodes handled by the loader
+	int32 Num() const { return Jobs.Num(); };
+
+	// Number of finished tasks (built or failed)
+	int32 GetNumFinished() const { return State.IsValid() ? State->NumFinished.GetValue() : 0; };
+
+private:
+	// Fetch, build and write the episode with its own database connection (worker thread)
+	static bool LoadEpisode(const FSLVizEpisodeCacheLoaderState& InState, const FString& EpisodeId, FSLVizEpisodeData& OutEpisodeData);
+
+private:
+	// Shared with the running tasks
+	TSharedPtr<FSLVizEpisodeCacheLoaderState, ESPMode::ThreadSafe> State;
+
+	// One job per episode
+	TArray<FSLVizEpisodeCacheJob> Jobs;
+};
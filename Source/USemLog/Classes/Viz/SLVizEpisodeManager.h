@@ -11,63 +11,235 @@
 // Forward declaration
 class UPoseableMeshComponent;
 class APlayerController;
+class FSLVizEpisodeStreamer;
 
 /*
-* Holds the poses of all the individuals in the world
+* Replay target of an individual handle (see ASLIndividualManager::GetIndividualHandles)
+*/
+struct FSLVizEpisodeTarget
+{
+	// Actor of the rigid, skeletal or view individuals
+	AActor* Actor = nullptr;
+
+	// Poseable mesh component of the bone individuals
+	UPoseableMeshComponent* PMC = nullptr;
+
+	// Bone index of the bone individuals
+	int32 BoneIndex = INDEX_NONE;
+
+	// Bone name of the bone individuals (cached to avoid the index to name lookups when applying the poses)
+	FName BoneName = NAME_None;
+
+	// Index of the poseable mesh component in the replayed skeletons (set by the episode manager when loading)
+	int32 SkeletonIndex = INDEX_NONE;
+
+	// True if the individual can be replayed
+	bool IsValid() const { return Actor != nullptr || PMC != nullptr; };
+
+	// True if the poses of the target are applied (movable actor or bone of a replayed skeleton, set when loading)
+	bool IsReplayed() const { return Actor != nullptr || SkeletonIndex != INDEX_NONE; };
+};
+
+/*
+* Poseable mesh component updated in a single batch per frame, the recorded (world) bone poses are gathered in
+* component space and converted to bone space in parent to child order before one transform refresh
+*/
+struct FSLVizEpisodeSkeleton
+{
+	// Replayed poseable mesh component
+	UPoseableMeshComponent* PMC = nullptr;
+
+	// Parent bone index of every bone (INDEX_NONE for the root)
+	TArray<int32> ParentIndexes;
+
+	// Component space pose of every bone, valid while the skeleton is being updated
+	TArray<FTransform> ComponentSpaceTransforms;
+
+	// True if bone poses were set in the current frame
+	bool bDirty = false;
+};
+
+/*
+* Holds the poses of the individuals in the world keyed by their handles
 */
 struct FSLVizEpisodeFrameData
 {
-	// Array of the actors and their poses
-	TMap<AActor*, FTransform> ActorPoses;
+	// Array of the individual handles and their poses
+	TArray<TPair<int32, FTransform>> Poses;
+
+	// Handle to the index in the poses array (only used by the frames updated with Set, INDEX_NONE if not set)
+	TArray<int32> PoseIndexes;
+
+	// Append the pose (the handle is expected to be unique in the frame)
+	void Add(int32 Handle, const FTransform& Pose)
+	{
+		Poses.Emplace(Handle, Pose);
+	}
+
+	// Add or overwrite the pose of the handle
+	void Set(int32 Handle, const FTransform& Pose)
+	{
+		if (Handle >= PoseIndexes.Num())
+		{
+			const int32 PrevNum = PoseIndexes.Num();
+			PoseIndexes.SetNumUninitialized(Handle + 1);
+			for (int32 Idx = PrevNum; Idx < PoseIndexes.Num(); ++Idx)
+			{
+				PoseIndexes[Idx] = INDEX_NONE;
+			}
+		}
+
+		int32& PoseIndex = PoseIndexes[Handle];
+		if (PoseIndex == INDEX_NONE)
+		{
+			PoseIndex = Poses.Emplace(Handle, Pose);
+		}
+		else
+		{
+			Poses[PoseIndex].Value = Pose;
+		}
+	}
+
+	// Overwrite the poses with the ones from the given (compact) frame
+	void Merge(const FSLVizEpisodeFrameData& Other)
+	{
+		for (const auto& HandlePosePair : Other.Poses)
+		{
+			Set(HandlePosePair.Key, HandlePosePair.Value);
+		}
+	}
+
+	// Remove the poses of the handles matching the predicate, returns the number of removed poses
+	template<typename PredicateType>
+	int32 RemoveAll(PredicateType Predicate)
+	{
+		const int32 NumRemoved = Poses.RemoveAll([&Predicate](const TPair<int32, FTransform>& HandlePosePair)
+		{
+			return Predicate(HandlePosePair.Key);
+		});
+
+		// Rebuild the handle to pose index lookup if it was used
+		if (NumRemoved > 0 && PoseIndexes.Num() > 0)
+		{
+			for (int32& PoseIndex : PoseIndexes)
+			{
+				PoseIndex = INDEX_NONE;
+			}
+			for (int32 Idx = 0; Idx < Poses.Num(); ++Idx)
+			{
+				PoseIndexes[Poses[Idx].Key] = Idx;
+			}
+		}
+		return NumRemoved;
+	}
+
+	// Clear the poses but keep the allocations
+	void Reset()
+	{
+		Poses.Reset();
+		PoseIndexes.Reset();
+	}
 
-	// Array of the skeletal components and their bone poses (the actor locations are included above)
-	TMap<UPoseableMeshComponent*, TMap<int32, FTransform>> BonePoses;
+	// Number of poses in the frame
+	int32 Num() const { return Poses.Num(); };
+
+	// Heap memory used by the frame
+	SIZE_T GetAllocatedSize() const
+	{
+		return Poses.GetAllocatedSize() + PoseIndexes.GetAllocatedSize();
+	}
 };
 
 /*
-* Holds the frames from the recorded episode
+* Holds the frames from the recorded episode,
+* every frame is stored as a compact frame (only the changes from the previous frame),
+* every KeyframeInterval frames a full frame (keyframe) is stored as well, 
+* any frame is reconstructed from its nearest previous keyframe and the following compact frames
 */
 struct FSLVizEpisodeData
 {
+	// Default number of frames between the keyframes
+	static constexpr int32 DefaultKeyframeInterval = 100;
+
 	// Id of the episode
 	FString Id;
 
+	// Replay targets indexed by the individual handles used in the frames
+	TArray<FSLVizEpisodeTarget> Targets;
+
 	// Array of the timestamps
 	TArray<float> Timestamps;
 
-	// Array of the compact frames (used for fast gotos)
-	TArray<FSLVizEpisodeFrameData> FullFrames;
+	// Array of the full frames at every KeyframeInterval frames (used for fast gotos)
+	TArray<FSLVizEpisodeFrameData> Keyframes;
 
 	// Array of the compact frames (used for fast replays)
 	TArray<FSLVizEpisodeFrameData> CompactFrames;
 
+	// Number of frames between the keyframes
+	int32 KeyframeInterval = DefaultKeyframeInterval;
+
 	// Default ctor
 	FSLVizEpisodeData() {};
 
 	// Reserve array size ctor
-	FSLVizEpisodeData(int32 ArraySize)
+	FSLVizEpisodeData(int32 ArraySize, int32 InKeyframeInterval = DefaultKeyframeInterval)
 	{
+		KeyframeInterval = FMath::Max(InKeyframeInterval, 1);
 		Timestamps.Reserve(ArraySize);
-		FullFrames.Reserve(ArraySize);
+		Keyframes.Reserve(ArraySize / KeyframeInterval + 1);
 		CompactFrames.Reserve(ArraySize);
 	};
 
 	// Check if there is data in the episode and it is in sync
 	bool IsValid() const 
 	{
-		return Timestamps.Num() > 2 && Timestamps.Num() == FullFrames.Num();
+		return Timestamps.Num() > 2 && Timestamps.Num() == CompactFrames.Num()
+			&& Keyframes.Num() == (Timestamps.Num() - 1) / KeyframeInterval + 1;
 	};
 
+	// Index of the keyframe to start from when reconstructing the given frame
+	int32 GetKeyframeIndex(int32 FrameIndex) const { return FrameIndex / KeyframeInterval; };
+
+	// Frame index of the given keyframe
+	int32 GetKeyframeFrameIndex(int32 KeyframeIndex) const { return KeyframeIndex * KeyframeInterval; };
+
+	// Heap memory used by the episode frames
+	SIZE_T GetAllocatedSize() const
+	{
+		SIZE_T Size = Targets.GetAllocatedSize() + Timestamps.GetAllocatedSize() + Keyframes.GetAllocatedSize() + CompactFrames.GetAllocatedSize();
+		for (const auto& Frame : Keyframes)
+		{
+			Size += Frame.GetAllocatedSize();
+		}
+		for (const auto& Frame : CompactFrames)
+		{
+			Size += Frame.GetAllocatedSize();
+		}
+		return Size;
+	}
+
 	// Clear all the data in the episode
 	void Clear() 
 	{
 		Id = "";
+		Targets.Empty();
 		Timestamps.Empty(); 
-		FullFrames.Empty();
+		Keyframes.Empty();
 		CompactFrames.Empty();
 	};
 };
 
+/*
+* Load state of a window of frames of a streamed episode
+*/
+enum class ESLVizStreamWindowState : uint8
+{
+	Unloaded,
+	Requested,
+	Loaded
+};
+
 
 /**
  * Class to load and skim through episodes
@@ -85,6 +257,9 @@ protected:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	// Called when actor removed from game or game ended
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:
 	// Set world as visual only, remove unnecessary non-visual components/actors from world, create poseable skeletal mesh components etc.
 	void ConvertWorld();
@@ -95,6 +270,12 @@ public:
 	// Load episode data
 	void LoadEpisode(const FSLVizEpisodeData& InEpisodeData);
 
+	// Load the episode in windows from the initialized streamer, the frames are applied as soon as they are loaded
+	bool LoadEpisodeStreamed(TSharedPtr<FSLVizEpisodeStreamer> InStreamer);
+
+	// Check if the loaded episode is streamed
+	bool IsEpisodeStreamed() const { return Streamer.IsValid(); };
+
 	// Check if an episode is loaded
 	bool IsEpisodeLoaded() const { return bEpisodeLoaded; };
 
@@ -125,12 +306,19 @@ public:
 	// Set replay parameters (loop replay, frame update rate, number of steps per frame)
 	void SetReplayParams(bool bLoop, float UpdateRate = -1.f, int32 StepSize = 1);
 
+	// Set the clock replay (episode time follows the wall clock times the speed factor, the poses are interpolated)
+	void SetReplayClock(bool bUseClock, float Speed = 1.f);
+
 	// Set replay to pause or play
 	void SetPauseReplay(bool bPause);
 
 	// Stop replay, goto first frame
 	void StopReplay();
 
+	// Check that the sequential (compact changes) replay between the given frames ends in the same world state
+	// as applying the full last frame, the world is left in the last frame state (not available for streamed episodes)
+	bool CheckDeltaReplay(int32 FirstFrame, int32 LastFrame, float Tolerance = KINDA_SMALL_NUMBER);
+
 private:
 	// Start replay
 	void StartReplay();
@@ -138,12 +326,52 @@ private:
 	// Apply frame poses
 	void ApplyPoses(const FSLVizEpisodeFrameData& Frame);
 
+	// Precompute the replayed targets: ignore the static actors, collect the poseable mesh components of the bone targets
+	void SetReplayTargets();
+
+	// Remove the poses of the targets which are not replayed from the frame
+	int32 PruneFrame(FSLVizEpisodeFrameData& Frame) const;
+
+	// Get the world poses of all the replayed targets (indexed by the handles)
+	void GetReplayedPoses(TArray<FTransform>& OutPoses) const;
+
+	// Compute the current component space bone poses of the skeleton before setting the frame bone poses
+	void BeginSkeletonUpdate(FSLVizEpisodeSkeleton& Skeleton) const;
+
+	// Convert the component space bone poses to bone space and refresh the skeleton transforms once
+	void EndSkeletonUpdate(FSLVizEpisodeSkeleton& Skeleton) const;
+
+	// Apply the poses of the given frame reconstructed from the nearest keyframe (or from the active frame if closer)
+	void ApplyReconstructedFrame(int32 FrameIndex);
+
 	// Apply next frame changes (return false if there are no more frames)
 	bool ApplyNextFrameChanges();
 
+	// Advance the replay time and apply the interpolated poses (return false if the last frame is reached)
+	bool ApplyClockTime(float DeltaTime);
+
+	// Get the current world pose of the replayed target
+	FTransform GetReplayedPose(int32 Handle) const;
+
 	// Calculate an approximation of the update rate value to coincide with realtime
 	void CalcRealtimeAproxUpdateRateValue(int32 MaxNumSteps);
 
+	/* Streaming */
+	// Consume the loaded windows, apply pending gotos and evict the windows outside of the prefetch range
+	void UpdateStream();
+
+	// Check if the frame can be applied (its window and keyframe are loaded)
+	bool IsFrameStreamed(int32 FrameIndex) const;
+
+	// Request the window of the frame from the streamer (if not already requested)
+	void RequestStreamedFrame(int32 FrameIndex);
+
+	// Release the compact frames of the windows outside of the prefetch range
+	void EvictStreamedWindows();
+
+	// Stop the loader and clear the streaming state
+	void ClearStream();
+
 protected:
 	// True if the world is set as visual only
 	uint8 bWorldSetAsVisualOnly : 1;
@@ -157,6 +385,9 @@ protected:
 	// True if it currently in an active replay
 	uint8 bReplayRunning : 1;
 
+	// True if the replay follows the wall clock
+	uint8 bClockReplay : 1;
+
 	// Episode data
 	FSLVizEpisodeData EpisodeData;
 
@@ -174,6 +405,43 @@ protected:
 
 	// Default replay update rate
 	float EpisodeDefaultUpdateRate;
+
+	// Episode time speed factor of the clock replay
+	float ReplaySpeed;
+
+	// Current episode time of the clock replay
+	float ReplayTime;
+
+	// Frame whose changes are interpolated by the clock replay (the start poses are taken from the previous frame)
+	int32 InterpFrameIndex;
+
+	// Poses of the interpolated targets in the previous frame
+	FSLVizEpisodeFrameData InterpStartFrame;
+
+	// Reused buffer for the interpolated poses
+	FSLVizEpisodeFrameData InterpFrame;
+
+	// Reused buffer for reconstructing frames from keyframes
+	FSLVizEpisodeFrameData SeekFrame;
+
+	// Replayed skeletons (indexed by the target skeleton indexes)
+	TArray<FSLVizEpisodeSkeleton> Skeletons;
+
+	/* Streaming */
+	// Background loader of the streamed episode (invalid if the episode is fully loaded)
+	TSharedPtr<FSLVizEpisodeStreamer> Streamer;
+
+	// Load state of every window of the streamed episode
+	TArray<ESLVizStreamWindowState> StreamWindowStates;
+
+	// Frame to go to as soon as its window is loaded
+	int32 PendingGotoFrameIndex;
+
+	// Time when the streaming started (used for logging the time until the first frame)
+	double StreamStartTime;
+
+	// Consumes the loaded windows
+	FTimerHandle StreamTimerHandle;
 };
 
 
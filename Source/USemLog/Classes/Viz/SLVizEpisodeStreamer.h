@@ -0,0 +1,168 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Viz/SLVizEpisodeManager.h"
+#include "Mongo/SLMongoQueryDBHandler.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Containers/Queue.h"
+
+// Forward declarations
+class ASLIndividualManager;
+class FRunnableThread;
+class FEvent;
+
+/*
+* Loaded window of frames, a window holds the frames between two keyframes
+*/
+struct FSLVizEpisodeStreamWindow
+{
+	// Index of the window (first frame index is WindowIndex * WindowSize)
+	int32 WindowIndex = INDEX_NONE;
+
+	// True if the keyframe of the window is set (only for the windows loaded in order)
+	bool bHasKeyframe = false;
+
+	// Full frame at the beginning of the window
+	FSLVizEpisodeFrameData Keyframe;
+
+	// Compact frames of the window (empty if the window was loaded only to advance to a later keyframe)
+	TArray<FSLVizEpisodeFrameData> CompactFrames;
+};
+
+/**
+ * Loads an episode from the database in windows of frames on a background thread,
+ * the windows are converted to replay frames and prefetched ahead of the play head,
+ * windows behind the play head are evicted by the episode manager and reloaded on demand
+ */
+class USEMLOG_API FSLVizEpisodeStreamer : public FRunnable
+{
+public:
+	// Ctor
+	FSLVizEpisodeStreamer();
+
+	// Dtor
+	virtual ~FSLVizEpisodeStreamer();
+
+	// Connect to the episode, load the frame timestamps and resolve the replay targets (game thread)
+	bool Init(ASLIndividualManager* IndividualManager, const FString& ServerIp, uint16 ServerPort,
+		const FString& InTaskId, const FString& InEpisodeId,
+		int32 InWindowSize = FSLVizEpisodeData::DefaultKeyframeInterval, int32 InNumPrefetchWindows = 4);
+
+	// Start the loader thread
+	bool Start();
+
+	// Signal the loader thread to stop, blocks until done
+	void Finish();
+
+	// Timestamps of all the episode frames
+	const TArray<float>& GetTimestamps() const { return Timestamps; };
+
+	// Id of the streamed episode
+	FString GetEpisodeId() const { return EpisodeId; };
+
+	// Replay targets indexed by the individual handles used in the loaded frames
+	const TArray<FSLVizEpisodeTarget>& GetTargets() const { return Targets; };
+
+	// Number of frames in a window (same as the keyframe interval of the episode data)
+	int32 GetWindowSize() const { return WindowSize; };
+
+	// Number of windows loaded ahead of the play head
+	int32 GetNumPrefetchWindows() const { return NumPrefetchWindows; };
+
+	// Number of windows in the episode
+	int32 GetNumWindows() const { return NumWindows; };
+
+	// True if the loader stopped because of an error
+	bool HasFailed() const { return bFailed; };
+
+	/* Consumer (game thread) */
+	// Set the frame currently replayed, windows are prefetched ahead of it
+	void SetPlayHead(int32 FrameIndex);
+
+	// Request the window of the given frame (loaded in order if ahead of the loader, reloaded otherwise)
+	void RequestFrame(int32 FrameIndex);
+
+	// Get the next loaded window (false if none available)
+	bool DequeueWindow(TUniquePtr<FSLVizEpisodeStreamWindow>& OutWindow);
+
+	/* Begin FRunnable interface */
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	/* End FRunnable interface */
+
+private:
+	// Map the ids of the world individuals to handles and resolve their replay targets
+	void SetTargets(ASLIndividualManager* IndividualManager);
+
+	// Map the individual ids of the loaded window to handles (INDEX_NONE for the individuals which cannot be replayed)
+	void GetWindowHandles(const TArray<FString>& WindowIds, TArray<int32>& OutHandles);
+
+	// Load the window from the database, FullFrame is updated if the window is loaded in order
+	void LoadWindow(int32 WindowIndex, FSLVizEpisodeFrameData* FullFrame, bool bKeepFrames);
+
+	// Convert the database frame to a replay frame (the poses are keyed by the window individual id indexes)
+	void ConvertFrame(const FSLMongoEpisodeFrame& InFrame, const TArray<int32>& WindowHandles, FSLVizEpisodeFrameData& OutFrame);
+
+private:
+	// Database connection of the loader (mongo clients cannot be shared between threads)
+	FSLMongoQueryDBHandler DBHandler;
+
+	// Id of the streamed episode
+	FString EpisodeId;
+
+	// Individual id to handle, ids which cannot be replayed are added with INDEX_NONE when first loaded
+	TMap<FString, int32> IdToHandle;
+
+	// Replay targets indexed by the individual handles
+	TArray<FSLVizEpisodeTarget> Targets;
+
+	// Frame timestamps (as stored in the database, used for the window queries)
+	TArray<double> DBTimestamps;
+
+	// Frame timestamps
+	TArray<float> Timestamps;
+
+	// Number of frames in a window
+	int32 WindowSize;
+
+	// Number of windows loaded ahead of the play head
+	int32 NumPrefetchWindows;
+
+	// Number of windows in the episode
+	int32 NumWindows;
+
+	// Window of the frame currently replayed
+	FThreadSafeCounter PlayHeadWindow;
+
+	// Window the in order loading should reach (set by seeks ahead of the loader)
+	FThreadSafeCounter SeekWindow;
+
+	// Next window to load in order
+	FThreadSafeCounter NextWindow;
+
+	// Windows behind the loader requested to be reloaded
+	TQueue<int32, EQueueMode::Spsc> ReloadRequests;
+
+	// Loaded windows waiting to be consumed
+	TQueue<TUniquePtr<FSLVizEpisodeStreamWindow>, EQueueMode::Spsc> LoadedWindows;
+
+	// Wakes up the loader thread on new requests
+	FEvent* WorkEvent;
+
+	// The loader thread
+	FRunnableThread* Thread;
+
+	// Set when the loader thread should exit
+	FThreadSafeBool bStopRequested;
+
+	// Set if the loader stopped because of an error
+	FThreadSafeBool bFailed;
+
+	// Number of episode individuals without a replay target
+	int32 NumUnknownIndividuals;
+};
@@ -5,12 +5,16 @@
 
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
+#include "Mongo/SLMongoQueryStructs.h"
 
 // Forward declarations
 class UWorld;
 class AActor;
 class ASLIndividualManager;
+class USLBaseIndividual;
 struct FSLVizEpisodeData;
+struct FSLVizEpisodeFrameData;
+struct FSLVizEpisodeTarget;
 
 /**
  * Viz visual parameters (color and material type)
@@ -24,15 +28,37 @@ public:
 	// Add a poseable mesh component clone to the skeletal actors
 	static void AddPoseablMeshComponentsToSkeletalActors(UWorld* World);	
 
-	// Build the full replay episode data from the mongo compact form (returns true if no errors occured)
+	// Get the replay target (actor or poseable mesh bone) of the individual (invalid if the individual type cannot be replayed)
+	static FSLVizEpisodeTarget GetEpisodeTarget(USLBaseIndividual* Individual);
+
+	// Build the replay episode data (keyframes and compact frames) from the mongo compact form (returns true if no errors occured)
 	static bool BuildEpisodeData(ASLIndividualManager* IndividualManager, 
-		const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData,
+		const FSLMongoEpisodeData& InMongoEpisodeData,
+		FSLVizEpisodeData& OutVizEpisodeData);
+
+	// Build the replay episode data with already resolved replay targets, does not access the world (safe to call from worker threads)
+	static bool BuildEpisodeData(const TMap<FString, int32>& IdToHandle,
+		const TArray<FSLVizEpisodeTarget>& Targets,
+		const FSLMongoEpisodeData& InMongoEpisodeData,
 		FSLVizEpisodeData& OutVizEpisodeData);
 
+	// Reconstruct the full frame from the nearest previous keyframe and the following compact frames
+	static bool ReconstructFrame(const FSLVizEpisodeData& InVizEpisodeData, int32 FrameIndex, FSLVizEpisodeFrameData& OutFrame);
+
+	// Build the episode with the given keyframe intervals and log the memory usage and the random seek latencies
+	static void BenchmarkKeyframeIntervals(ASLIndividualManager* IndividualManager,
+		const FSLMongoEpisodeData& InMongoEpisodeData,
+		const TArray<int32>& KeyframeIntervals = { 1, 10, 50, 100, 250, 1000 }, int32 NumSeeks = 100);
+
 	// Executes a binary search for element Item in array Array using the <= operator (from ProfilerCommon::FBinaryFindIndex)
 	static int32 BinarySearchLessEqual(const TArray<float>& Array, float Value);
 
 private:
+	// Build the keyframes and compact frames using the meta index to handle mapping and the episode targets
+	static bool BuildFrames(const TArray<int32>& MetaToHandle,
+		const FSLMongoEpisodeData& InMongoEpisodeData,
+		FSLVizEpisodeData& OutVizEpisodeData);
+
 	// Check if actor requires any special attention when switching to visual only world (return true if the components should be left alone)
 	static bool IsSpecialCaseActor(AActor* Actor);
 
@@ -7,6 +7,7 @@
 #include "GameFramework/Info.h"
 #include "Viz/SLVizStructs.h"
 #include "Viz/SLVizEpisodeManager.h"
+#include "Mongo/SLMongoQueryStructs.h"
 #include "SLVizManager.generated.h"
 
 // Forward declarations
@@ -15,6 +16,7 @@ class ASLVizMarkerManager;
 //class ASLVizEpisodeManager;
 class ASLIndividualManager;
 class ASLVizCameraDirector;
+class FSLVizEpisodeCacheLoader;
 class USLVizBaseMarker;
 class UMeshComponent;
 
@@ -162,7 +164,7 @@ public:
 	bool IsWorldConvertedToVisualizationMode() const;
 
 	// Cache the mongo data into an episode format
-	bool CacheEpisodeData(const FString& Id, const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData);
+	bool CacheEpisodeData(const FString& Id, const FSLMongoEpisodeData& InMongoEpisodeData);
 
 	// Check if the episode is already cached
 	bool IsEpisodeCached(const FString& Id) const { return CachedEpisodeData.Contains(Id); };
@@ -170,6 +172,21 @@ public:
 	// Load cached episode data
 	bool LoadCachedEpisodeData(const FString& Id);
 
+	// Cache the episode from its local cache file (false if there is no valid file)
+	bool CacheEpisodeDataFromFile(const FString& TaskId, const FString& Id);
+
+	// Write the cached episode to its local cache file (read instead of querying the database in the next sessions)
+	bool WriteEpisodeCacheFile(const FString& TaskId, const FString& Id) const;
+
+	// Fetch and build the not yet cached episodes concurrently in the background, they are cached as soon as they are built
+	bool CacheEpisodesAsync(const FString& ServerIp, uint16 ServerPort, const FString& TaskId, const TArray<FString>& Ids);
+
+	// Cancel the background episode caching without blocking, the already cached episodes are kept
+	void CancelEpisodeCaching();
+
+	// True while episodes are cached in the background
+	bool IsCachingEpisodes() const;
+
 	// Replay cached episode 
 	bool ReplayCachedEpisode(const FString& Id, const FSLVizEpisodePlayParams& Params = FSLVizEpisodePlayParams());
 
@@ -177,7 +194,10 @@ public:
 	bool GotoCachedEpisodeFrame(const FString& Id, float Ts);
 
 	// Change the data into an episode format and load it to the episode replay manager
-	void LoadEpisodeData(const TArray<TPair<float, TMap<FString, FTransform>>>& InCompactEpisodeData);
+	void LoadEpisodeData(const FSLMongoEpisodeData& InCompactEpisodeData);
+
+	// Stream the episode from the database in windows, the replay can start as soon as the first window is loaded
+	bool LoadEpisodeDataStreamed(const FString& ServerIp, uint16 ServerPort, const FString& TaskId, const FString& EpisodeId, int32 NumPrefetchWindows = 4);
 
 	// Check if any episode is loaded (return the name of the episode)
 	bool IsEpisodeLoaded() const;
@@ -227,6 +247,9 @@ private:
 
 	// Get the vizualization camera director from the world (or spawn a new one)
 	bool SetCameraDirector();
+
+	// Cache the episodes built in the background and report the progress
+	void UpdateEpisodeCaching();
 	
 private:
 	// True if the manager is initialized
@@ -241,6 +264,10 @@ private:
 	UPROPERTY(VisibleAnywhere, Transient, Category = "Semantic Logger")
 	TMap<FString, FSLVizIndividualHighlightData> HighlightedIndividuals;
 
+	// Read and write the built episodes to local cache files (Saved/SL/VizCache)
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	bool bUseEpisodeCacheFiles;
+
 
 	/* Managers */
 	// Keeps access to all the individuals in the world
@@ -267,4 +294,10 @@ private:
 	/* Cached data */
 	// Episode id to viz episode data
 	TMap<FString, FSLVizEpisodeData> CachedEpisodeData;
+
+	// Fetches and builds the episodes in the background
+	TSharedPtr<FSLVizEpisodeCacheLoader> EpisodeCacheLoader;
+
+	// Collects the episodes built in the background
+	FTimerHandle EpisodeCacheTimerHandle;
 };
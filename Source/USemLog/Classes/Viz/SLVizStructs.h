@@ -148,6 +148,14 @@ struct FSLVizEpisodePlayParams
 	UPROPERTY(EditAnywhere, Category = "Properties")
 	int32 StepSize = 1;
 
+	// Map the wall clock time to the episode time and interpolate the poses between the frames (update rate and step size are ignored)
+	UPROPERTY(EditAnywhere, Category = "Properties")
+	bool bUseClock = false;
+
+	// Episode time speed factor of the clock replay
+	UPROPERTY(EditAnywhere, Category = "Properties", meta = (editcondition = "bUseClock", ClampMin = 0.1, ClampMax = 20))
+	float Speed = 1.f;
+
 	// Default ctor
 	FSLVizEpisodePlayParams() {};
 
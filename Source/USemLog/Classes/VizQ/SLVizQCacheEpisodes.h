@@ -19,6 +19,11 @@ class USLVizQCacheEpisodes : public USLVizQBase
 	GENERATED_BODY()
 
 protected:
+#if WITH_EDITOR
+	// Called when a property is changed in the editor
+	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif // WITH_EDITOR
+
 	// Virtual implementation of the execute function
 	virtual void ExecuteImpl(ASLKnowrobManager* KRManager) override;
 
@@ -28,4 +33,13 @@ protected:
 
 	UPROPERTY(EditAnywhere, Category = "Cache Episodes")
 	TArray<FString> Episodes;
+
+	// Fetch and build the episodes concurrently in the background (each with its own database connection)
+	UPROPERTY(EditAnywhere, Category = "Cache Episodes")
+	bool bAsync = true;
+
+
+	/* Manual interaction */
+	UPROPERTY(EditAnywhere, Category = "Manual Interaction|Cache Episodes", meta = (editcondition = "bAsync"))
+	bool bCancelButton = false;
 };
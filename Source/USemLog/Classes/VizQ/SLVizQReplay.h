@@ -45,6 +45,10 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Replay")
 	ESLVizQReplayType Type = ESLVizQReplayType::Goto;
 
+	// Load the episode in windows on a background thread instead of caching it whole (replay starts after the first window)
+	UPROPERTY(EditAnywhere, Category = "Replay")
+	bool bStream = false;
+
 	UPROPERTY(EditAnywhere, Category = "Replay")
 	float StartTime = 0.f;
 
@@ -60,6 +64,13 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Replay", meta = (editcondition = "Type==ESLVizQReplayType::Replay"))
 	int32 StepSize = 1;
 
+	// Synchronize the replay with the wall clock and interpolate between the frames
+	UPROPERTY(EditAnywhere, Category = "Replay", meta = (editcondition = "Type==ESLVizQReplayType::Replay"))
+	bool bUseClock = false;
+
+	UPROPERTY(EditAnywhere, Category = "Replay", meta = (editcondition = "Type==ESLVizQReplayType::Replay && bUseClock", ClampMin = 0.1, ClampMax = 20))
+	float Speed = 1.f;
+
 
 	/* Manual interaction */
 	UPROPERTY(EditAnywhere, Category = "Manual Interaction|Replay", meta = (editcondition = "Type==ESLVizQReplayType::Replay"))
@@ -0,0 +1,54 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "CV/SLCVMaskMaterialLibrary.h"
+#include "Materials/Material.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+// Ctor
+USLCVMaskMaterialLibrary::USLCVMaskMaterialLibrary()
+{
+	TemplateMaterial = nullptr;
+	NumRequests = 0;
+}
+
+// Load the template mask material
+bool USLCVMaskMaterialLibrary::Init(const TCHAR* MaterialPath)
+{
+	if (TemplateMaterial)
+	{
+		return true;
+	}
+
+	TemplateMaterial = LoadObject<UMaterial>(this, MaterialPath);
+	if (!TemplateMaterial)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not load the mask material %s.."),
+			*FString(__func__), __LINE__, MaterialPath);
+		return false;
+	}
+	TemplateMaterial->bUsedWithStaticLighting = true;
+	TemplateMaterial->bUsedWithSkeletalMesh = true;
+	return true;
+}
+
+// Get the mask material of the color (created on the first request)
+UMaterialInstanceDynamic* USLCVMaskMaterialLibrary::GetMaterial(const FColor& Color)
+{
+	if (!TemplateMaterial)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Mask material library is not initialized.."), *FString(__func__), __LINE__);
+		return nullptr;
+	}
+
+	NumRequests++;
+	if (UMaterialInstanceDynamic** CachedMaterial = Materials.Find(Color.DWColor()))
+	{
+		return *CachedMaterial;
+	}
+
+	UMaterialInstanceDynamic* MaskMaterial = UMaterialInstanceDynamic::Create(TemplateMaterial, this);
+	MaskMaterial->SetVectorParameterValue(FName(MaskColorParamName), FLinearColor::FromSRGBColor(Color));
+	Materials.Add(Color.DWColor(), MaskMaterial);
+	return MaskMaterial;
+}
@@ -2,6 +2,7 @@
 // Author: Andrei Haidu (http://haidu.eu)
 
 #include "CV/SLCVQScene.h"
+#include "CV/SLCVMaskMaterialLibrary.h"
 #include "Individuals/SLIndividualManager.h"
 #include "Individuals/Type/SLVisibleIndividual.h"
 #include "Individuals/Type/SLSkeletalIndividual.h"
@@ -92,25 +93,20 @@ void USLCVQScene::HideScene()
 }
 
 // Generate mask clones for the scene
-bool USLCVQScene::GenerateMaskClones(const TCHAR* MaterialPath, bool bUseIndividualMaskValue, FColor MaskColor)
+bool USLCVQScene::GenerateMaskClones(USLCVMaskMaterialLibrary* MaskMaterials, bool bUseIndividualMaskValue, FColor MaskColor)
 {
-	// Get the dynamic mask material
-	UMaterial* DefaultMaskMaterial = LoadObject<UMaterial>(this, MaterialPath);
-	if (!DefaultMaskMaterial)
+	if (!MaskMaterials || !MaskMaterials->IsInit())
 	{
-		UE_LOG(LogTemp, Error, TEXT("%s::%d %s could not load default mask material.."),
+		UE_LOG(LogTemp, Error, TEXT("%s::%d %s mask material library is not initialized.."),
 			*FString(__func__), __LINE__, *GetName());
 		return false;
 	}
-	DefaultMaskMaterial->bUsedWithStaticLighting = true;
-	DefaultMaskMaterial->bUsedWithSkeletalMesh = true;
 
-	// Create a common dynamic mask material and set its color
+	// Common dynamic mask material (shared with the other scenes using the same color)
 	UMaterialInstanceDynamic* DynamicMaskMaterial = nullptr;
 	if (!bUseIndividualMaskValue)
 	{
-		DynamicMaskMaterial = UMaterialInstanceDynamic::Create(DefaultMaskMaterial, GetTransientPackage());
-		DynamicMaskMaterial->SetVectorParameterValue(FName("MaskColorParam"), MaskColor);
+		DynamicMaskMaterial = MaskMaterials->GetMaterial(MaskColor);
 	}
 
 	// Clone static meshes
@@ -123,6 +119,7 @@ bool USLCVQScene::GenerateMaskClones(const TCHAR* MaterialPath, bool bUseIndivid
 			if (auto VI = Cast<USLVisibleIndividual>(BI))
 			{
 				// Check if the actor already has a clone
+				bool bHasClone = false;
 #if ENGINE_MINOR_VERSION > 23 || ENGINE_MAJOR_VERSION > 4
 				TArray<UActorComponent*> Components;
 				CurrSMA->GetComponents(UStaticMeshComponent::StaticClass(), Components);
@@ -132,7 +129,8 @@ bool USLCVQScene::GenerateMaskClones(const TCHAR* MaterialPath, bool bUseIndivid
 					{
 						// There is alrady a clone, add to array
 						StaticMaskClones.Add(CurrSMA, CastChecked<UStaticMeshComponent>(Comp));
-						continue;
+						bHasClone = true;
+						break;
 					}
 				}
 #else
@@ -142,10 +140,15 @@ bool USLCVQScene::GenerateMaskClones(const TCHAR* MaterialPath, bool bUseIndivid
 					{
 						// There is alrady a clone, add to array
 						StaticMaskClones.Add(CurrSMA, CastChecked<UStaticMeshComponent>(Comp));
-						continue;
+						bHasClone = true;
+						break;
 					}
 				}
 #endif
+				if (bHasClone)
+				{
+					continue;
+				}
 
 				// Duplicate/clone the static mesh component
 				UStaticMeshComponent* OrigSMC = CurrSMA->GetStaticMeshComponent();
@@ -164,8 +167,7 @@ bool USLCVQScene::GenerateMaskClones(const TCHAR* MaterialPath, bool bUseIndivid
 				if (bUseIndividualMaskValue)
 				{
 					// Use the individual unique visual mask value for the mask
-					DynamicMaskMaterial = UMaterialInstanceDynamic::Create(DefaultMaskMaterial, GetTransientPackage());
-					DynamicMaskMaterial->SetVectorParameterValue(FName("MaskColorParam"), FColor::FromHex(VI->GetVisualMaskValue()));
+					DynamicMaskMaterial = MaskMaterials->GetMaterial(FColor::FromHex(VI->GetVisualMaskValue()));
 				}
 
 				// Apply the dynamic mask material to the mesh
@@ -218,10 +220,8 @@ bool USLCVQScene::GenerateMaskClones(const TCHAR* MaterialPath, bool bUseIndivid
 						{
 							for (const auto& BoneI : SkelI->GetBoneIndividuals())
 							{
-								DynamicMaskMaterial = UMaterialInstanceDynamic::Create(DefaultMaskMaterial, GetTransientPackage());
-								DynamicMaskMaterial->SetVectorParameterValue(FName("MaskColorParam"),
-									FColor::FromHex(BoneI->GetVisualMaskValue()));
-								CurrPoseableClone->SetCustomMaterial(BoneI->GetMaterialIndex(), DynamicMaskMaterial);
+								CurrPoseableClone->SetCustomMaterial(BoneI->GetMaterialIndex(),
+									MaskMaterials->GetMaterial(FColor::FromHex(BoneI->GetVisualMaskValue())));
 							}
 						}
 						else
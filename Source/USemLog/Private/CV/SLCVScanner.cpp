@@ -4,6 +4,7 @@
 #include "CV/SLCVScanner.h"
 #include "CV/SLCVQScene.h"
 #include "CV/SLCVUtils.h"
+#include "CV/SLCVMaskMaterialLibrary.h"
 #include "Individuals/SLIndividualManager.h"
 #include "Individuals/SLIndividualUtils.h"
 #include "Individuals/Type/SLVisibleIndividual.h"
@@ -175,10 +176,15 @@ void ASLCVScanner::Init()
 		}
 	}
 
+	InitPhaseTimes.Empty();
+	double PhaseStartTime = FPlatformTime::Seconds();
+
 	// Disable physiscs and detach all actors
 	DetachAllActors();
+	AddInitPhaseTime(TEXT("DetachActors"), PhaseStartTime);
 
 	/* Set the individual manager */
+	PhaseStartTime = FPlatformTime::Seconds();
 	if (!SetIndividualManager())
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d %s could not set the individual manager.."),
@@ -191,8 +197,10 @@ void ASLCVScanner::Init()
 			*FString(__FUNCTION__), __LINE__, *GetName(), *IndividualManager->GetName());
 		return;
 	}
+	AddInitPhaseTime(TEXT("IndividualManager"), PhaseStartTime);
 
 	/* Set the individuals to be scanned */
+	PhaseStartTime = FPlatformTime::Seconds();
 	if (ScanMode == ESLCVScanMode::Individuals)
 	{
 		if (!SetScanIndividuals())
@@ -211,6 +219,7 @@ void ASLCVScanner::Init()
 			return;
 		}
 	}
+	AddInitPhaseTime(ScanMode == ESLCVScanMode::Individuals ? TEXT("ScanIndividuals") : TEXT("ScanScenes"), PhaseStartTime);
 
 	// If no view modes are available, add a default one
 	if (RenderModes.Num() == 0)
@@ -223,20 +232,24 @@ void ASLCVScanner::Init()
 	// Setup actor mask clones
 	if (RenderModes.Contains(ESLCVRenderMode::Mask))
 	{
+		PhaseStartTime = FPlatformTime::Seconds();
 		if (!SetMaskClones())
 		{
 			RenderModes.Remove(ESLCVRenderMode::Mask);
 			UE_LOG(LogTemp, Error, TEXT("%s::%d %s Could not setup mask clones .."),
 				*FString(__func__), __LINE__, *GetName());
 		}
+		AddInitPhaseTime(TEXT("MaskClones"), PhaseStartTime);
 	}
 
 	// Set camera sphere poses
+	PhaseStartTime = FPlatformTime::Seconds();
 	if (!SetScanPoses(MaxNumScanPoints))
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d %s could not setup camera scan points .."),
 			*FString(__func__), __LINE__, *GetName());
 	}
+	AddInitPhaseTime(TEXT("ScanPoses"), PhaseStartTime);
 
 	/* Set the camera pose dummy actor */
 	if (!SetCameraPoseAndLightActor())
@@ -1068,6 +1081,18 @@ bool ASLCVScanner::SetCameraPoseAndLightActor()
 // Create clones of the individuals with mask material
 bool ASLCVScanner::SetMaskClones()
 {
+	// The mask materials are shared by all the clones with the same mask color
+	if (!MaskMaterials)
+	{
+		MaskMaterials = NewObject<USLCVMaskMaterialLibrary>(this);
+	}
+	if (!MaskMaterials->Init(DynMaskMatAssetPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d %s could not load default mask material.."),
+			*FString(__func__), __LINE__, *GetName());
+		return false;
+	}
+
 	if (ScanMode == ESLCVScanMode::Individuals)
 	{
 		GenerateMaskClones(Individuals);
@@ -1077,14 +1102,7 @@ bool ASLCVScanner::SetMaskClones()
 	{
 		for (const auto& Scene : Scenes)
 		{
-			if (bUseIndividualMaskValue)
-			{
-				Scene->GenerateMaskClones(DynMaskMatAssetPath);
-			}
-			else
-			{
-				Scene->GenerateMaskClones(DynMaskMatAssetPath, false, MaskColor);
-			}
+			Scene->GenerateMaskClones(MaskMaterials, bUseIndividualMaskValue, MaskColor);
 		}
 		// todo
 		return true;
@@ -1095,25 +1113,11 @@ bool ASLCVScanner::SetMaskClones()
 // Generate mask clones from the ids
 void ASLCVScanner::GenerateMaskClones(const TArray<USLVisibleIndividual*>& VisibleIndividuals)
 {
-	// Get the dynamic mask material
-	UMaterial* DefaultMaskMaterial = LoadObject<UMaterial>(this, DynMaskMatAssetPath);
-	if (!DefaultMaskMaterial)
-	{
-		UE_LOG(LogTemp, Error, TEXT("%s::%d %s could not load default mask material.."),
-			*FString(__func__), __LINE__, *GetName());
-		return;
-	}
-	DefaultMaskMaterial->bUsedWithStaticLighting = true;
-	DefaultMaskMaterial->bUsedWithSkeletalMesh = true;
-
-	// Create a commong dynamic mask material and set its color
-	UMaterialInstanceDynamic* DynamicMaskMaterial = nullptr;
-	if (!bUseIndividualMaskValue)
-	{
-		DynamicMaskMaterial = UMaterialInstanceDynamic::Create(DefaultMaskMaterial, GetTransientPackage());
-		DynamicMaskMaterial->SetVectorParameterValue(FName("MaskColorParam"), MaskColor);
-	}
-
+	// Gather the templates and their (shared) mask materials first, the clones are then spawned in one pass
+	TArray<TPair<USLVisibleIndividual*, AStaticMeshActor*>> Templates;
+	TArray<UMaterialInstanceDynamic*> TemplatesMaskMaterial;
+	Templates.Reserve(VisibleIndividuals.Num());
+	TemplatesMaskMaterial.Reserve(VisibleIndividuals.Num());
 	for (const auto& VI : VisibleIndividuals)
 	{
 		// Avoid creating duplicates
@@ -1122,41 +1126,44 @@ void ASLCVScanner::GenerateMaskClones(const TArray<USLVisibleIndividual*>& Visib
 			continue;
 		}
 
-		// Use the individual unique visual mask value for the mask
-		if (bUseIndividualMaskValue)
-		{
-			DynamicMaskMaterial = UMaterialInstanceDynamic::Create(DefaultMaskMaterial, GetTransientPackage());
-			DynamicMaskMaterial->SetVectorParameterValue(FName("MaskColorParam"), FColor::FromHex(VI->GetVisualMaskValue()));
-		}
-
 		// Make sure parent is a static mesh actor
 		if (auto AsSMA = Cast<AStaticMeshActor>(VI->GetParentActor()))
 		{
-			FActorSpawnParameters Parameters;
-			Parameters.Template = AsSMA;
-			Parameters.Template->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
-			//Parameters.Instigator = SMA->GetInstigator();
-			Parameters.Name = FName(*(AsSMA->GetName() + TEXT("_MaskClone")));
-			AStaticMeshActor* SMAClone = GetWorld()->SpawnActor<AStaticMeshActor>(AsSMA->GetClass(), Parameters);
-#if WITH_EDITOR
-			SMAClone->SetActorLabel(Parameters.Name.ToString());
-#endif // WITH_EDITOR
-			if (UStaticMeshComponent* SMC = SMAClone->GetStaticMeshComponent())
-			{
-				for (int32 MatIdx = 0; MatIdx < SMC->GetNumMaterials(); ++MatIdx)
-				{
-					SMC->SetMaterial(MatIdx, DynamicMaskMaterial);
-				}
-			}
-			SMAClone->DisableComponentsSimulatePhysics();
-			SMAClone->SetActorHiddenInGame(true);
-			IndividualsMaskClones.Add(VI, SMAClone);
+			// Use the individual unique visual mask value for the mask, or the common mask color
+			const FColor CloneMaskColor = bUseIndividualMaskValue ? FColor::FromHex(VI->GetVisualMaskValue()) : MaskColor;
+			Templates.Emplace(VI, AsSMA);
+			TemplatesMaskMaterial.Add(MaskMaterials->GetMaterial(CloneMaskColor));
 		}
 		else if (auto AsSkelMA = Cast<ASkeletalMeshActor>(VI->GetParentActor()))
 		{
 			//todo
 		}
 	}
+
+	IndividualsMaskClones.Reserve(IndividualsMaskClones.Num() + Templates.Num());
+	for (int32 Idx = 0; Idx < Templates.Num(); ++Idx)
+	{
+		AStaticMeshActor* AsSMA = Templates[Idx].Value;
+		FActorSpawnParameters Parameters;
+		Parameters.Template = AsSMA;
+		Parameters.Template->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+		//Parameters.Instigator = SMA->GetInstigator();
+		Parameters.Name = FName(*(AsSMA->GetName() + TEXT("_MaskClone")));
+		AStaticMeshActor* SMAClone = GetWorld()->SpawnActor<AStaticMeshActor>(AsSMA->GetClass(), Parameters);
+#if WITH_EDITOR
+		SMAClone->SetActorLabel(Parameters.Name.ToString());
+#endif // WITH_EDITOR
+		if (UStaticMeshComponent* SMC = SMAClone->GetStaticMeshComponent())
+		{
+			for (int32 MatIdx = 0; MatIdx < SMC->GetNumMaterials(); ++MatIdx)
+			{
+				SMC->SetMaterial(MatIdx, TemplatesMaskMaterial[Idx]);
+			}
+		}
+		SMAClone->DisableComponentsSimulatePhysics();
+		SMAClone->SetActorHiddenInGame(true);
+		IndividualsMaskClones.Add(Templates[Idx].Key, SMAClone);
+	}
 }
 
 // Set the background static mesh actor and material
@@ -1327,6 +1334,19 @@ void ASLCVScanner::SetCameraPoseSphereRadius()
 // Print progress to terminal
 void ASLCVScanner::PrintProgress() const
 {
+	// Output the init phase durations with the first scan
+	if (IndividualOrSceneIdx == 0 && CameraPoseIdx == 0 && RenderModeIdx == 0)
+	{
+		FString InitTimesStr = FSLCVUtils::GetInitTimesString(InitPhaseTimes);
+		if (MaskMaterials)
+		{
+			InitTimesStr.Append(FString::Printf(TEXT("MaskMaterials=%d/%d;"),
+				MaskMaterials->GetNumMaterials(), MaskMaterials->GetNumRequests()));
+		}
+		UE_LOG(LogTemp, Log, TEXT("%s::%d::%f Init:\t%s"),
+			*FString(__func__), __LINE__, GetWorld()->GetTimeSeconds(), *InitTimesStr);
+	}
+
 	// Current scan
 	int32 CurrScan = IndividualOrSceneIdx * CameraScanUnitPoses.Num() * RenderModes.Num() 
 		+ CameraPoseIdx * RenderModes.Num() 
@@ -1343,6 +1363,12 @@ void ASLCVScanner::PrintProgress() const
 		CurrScan, TotalNumScans);
 }
 
+// Store the duration of the init phase started at the given time
+void ASLCVScanner::AddInitPhaseTime(const FString& PhaseName, double StartTime)
+{
+	InitPhaseTimes.Emplace(PhaseName, FPlatformTime::Seconds() - StartTime);
+}
+
 // Save image to file
 void ASLCVScanner::SaveToFile(const TArray<uint8>& CompressedBitmap) const
 {
@@ -33,3 +33,14 @@ TArray<FColor> FSLCVUtils::ReplacePixels(const TArray<FColor>& InBitmap, FColor
 
 	return NewImage;
 }
+
+// Get the init phase durations as a single line (e.g. "Phase=1.234s; ")
+FString FSLCVUtils::GetInitTimesString(const TArray<TPair<FString, double>>& InitPhaseTimes)
+{
+	FString InitTimesStr;
+	for (const auto& PhaseTimePair : InitPhaseTimes)
+	{
+		InitTimesStr.Append(FString::Printf(TEXT("%s=%.3fs; "), *PhaseTimePair.Key, PhaseTimePair.Value));
+	}
+	return InitTimesStr;
+}
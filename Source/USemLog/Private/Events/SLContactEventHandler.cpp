@@ -3,8 +3,6 @@
 
 #include "Events/SLContactEventHandler.h"
 #include "Monitors/SLContactMonitorInterface.h"
-#include "Events/SLContactEvent.h"
-#include "Events/SLSupportedByEvent.h"
 #include "Individuals/Type/SLBaseIndividual.h"
 #include "Utils/SLUuid.h"
 
@@ -76,33 +74,27 @@ void FSLContactEventHandler::AddNewContactEvent(const FSLContactResult& InResult
 		FSLUuid::PairEncodeCantor(InResult.Self->GetUniqueID(), InResult.Other->GetUniqueID()),
 		InResult.Self, InResult.Other));
 	Event->EpisodeId = EpisodeId;
-	// Add event to the pending contacts array
-	StartedContactEvents.Emplace(Event);
+	// Add event to the pending contacts
+	StartedContactEvents.Add(Event);
 }
 
 // Publish finished event
-bool FSLContactEventHandler::FinishContactEvent(USLBaseIndividual* InOther, float EndTime)
+bool FSLContactEventHandler::FinishContactEvent(USLBaseIndividual* InSelf, USLBaseIndividual* InOther, float EndTime)
 {
-	// Use iterator to be able to remove the entry from the array
-	for (auto EventItr(StartedContactEvents.CreateIterator()); EventItr; ++EventItr)
+	// Remove event from the pending events
+	TSharedPtr<FSLContactEvent> Event = StartedContactEvents.Remove(
+		FSLUuid::PairEncodeCantor(InSelf->GetUniqueID(), InOther->GetUniqueID()));
+	if (Event.IsValid())
 	{
-		// It is enough to compare against the other id when searching
-		if ((*EventItr)->Individual2 == InOther)
+		// Set the event end time
+		Event->EndTime = EndTime;
+
+		// Avoid publishing short events
+		if ((Event->EndTime - Event->StartTime) > ContactEventMin)
 		{
-			// Set the event end time
-			(*EventItr)->EndTime = EndTime;
-
-			// Avoid publishing short events
-			if (((*EventItr)->EndTime - (*EventItr)->StartTime) > ContactEventMin)
-			{
-				OnSemanticEvent.ExecuteIfBound(*EventItr);
-			}
-			
-			// Remove event from the pending list
-			EventItr.RemoveCurrent();
-
-			return true;
+			OnSemanticEvent.ExecuteIfBound(Event);
 		}
+		return true;
 	}
 	return false;
 }
@@ -114,30 +106,25 @@ void FSLContactEventHandler::AddNewSupportedByEvent(USLBaseIndividual* Supported
 	TSharedPtr<FSLSupportedByEvent> Event = MakeShareable(new FSLSupportedByEvent(
 		FSLUuid::NewGuidInBase64Url(), StartTime, EventPairId, Supported, Supporting));
 	Event->EpisodeId = EpisodeId;
-	// Add event to the pending array
-	StartedSupportedByEvents.Emplace(Event);
+	// Add event to the pending events
+	StartedSupportedByEvents.Add(Event);
 }
 
 // Finish then publish the event
 bool FSLContactEventHandler::FinishSupportedByEvent(const uint64 InPairId, float EndTime)
 {
-	// Use iterator to be able to remove the entry from the array
-	for (auto EventItr(StartedSupportedByEvents.CreateIterator()); EventItr; ++EventItr)
+	// Remove event from the pending events
+	TSharedPtr<FSLSupportedByEvent> Event = StartedSupportedByEvents.Remove(InPairId);
+	if (Event.IsValid())
 	{
-		// It is enough to compare against the other id when searching
-		if ((*EventItr)->PairId == InPairId)
+		// Ignore short events
+		if (EndTime - Event->StartTime > SupportedByEventMin)
 		{
-			// Ignore short events
-			if (EndTime - (*EventItr)->StartTime > SupportedByEventMin)
-			{
-				// Set end time and publish event
-				(*EventItr)->EndTime = EndTime;
-				OnSemanticEvent.ExecuteIfBound(*EventItr);
-			}
-			// Remove event from the pending list
-			EventItr.RemoveCurrent();
-			return true;
+			// Set end time and publish event
+			Event->EndTime = EndTime;
+			OnSemanticEvent.ExecuteIfBound(Event);
 		}
+		return true;
 	}
 	return false;
 }
@@ -146,7 +133,7 @@ bool FSLContactEventHandler::FinishSupportedByEvent(const uint64 InPairId, float
 void FSLContactEventHandler::FinishAllEvents(float EndTime)
 {
 	// Finish contact events
-	for (auto& Ev : StartedContactEvents)
+	for (auto& Ev : StartedContactEvents.RemoveAll())
 	{
 		// Ignore short events
 		if (EndTime - Ev->StartTime > ContactEventMin)
@@ -156,10 +143,9 @@ void FSLContactEventHandler::FinishAllEvents(float EndTime)
 			OnSemanticEvent.ExecuteIfBound(Ev);
 		}
 	}
-	StartedContactEvents.Empty();
 
 	// Finish supported by events
-	for (auto& Ev : StartedSupportedByEvents)
+	for (auto& Ev : StartedSupportedByEvents.RemoveAll())
 	{
 		// Ignore short events
 		if ((EndTime - Ev->StartTime) > SupportedByEventMin)
@@ -169,7 +155,6 @@ void FSLContactEventHandler::FinishAllEvents(float EndTime)
 			OnSemanticEvent.ExecuteIfBound(Ev);
 		}
 	}
-	StartedSupportedByEvents.Empty();
 }
 
 // Event called when a semantic overlap event begins
@@ -181,7 +166,7 @@ void FSLContactEventHandler::OnSLOverlapBegin(const FSLContactResult& InResult)
 // Event called when a semantic overlap event ends
 void FSLContactEventHandler::OnSLOverlapEnd(USLBaseIndividual* Self, USLBaseIndividual* Other, float Time)
 {
-	FinishContactEvent(Other, Time);
+	FinishContactEvent(Self, Other, Time);
 }
 
 // Event called when a supported by event begins
@@ -74,26 +74,22 @@ void FSLFixationGraspEventHandler::AddNewEvent(USLBaseIndividual* Self, USLBaseI
 		FSLUuid::PairEncodeCantor(Self->GetUniqueID(), Other->GetUniqueID()),
 		Self, Other));
 	Event->EpisodeId = EpisodeId;
-	// Add event to the pending array
-	StartedEvents.Emplace(Event);
+	// Add event to the pending events
+	StartedEvents.Add(Event);
 }
 
 // Publish finished event
-bool FSLFixationGraspEventHandler::FinishEvent(USLBaseIndividual* Other, float EndTime)
+bool FSLFixationGraspEventHandler::FinishEvent(USLBaseIndividual* Self, USLBaseIndividual* Other, float EndTime)
 {
-	// Use iterator to be able to remove the entry from the array
-	for (auto EventItr(StartedEvents.CreateIterator()); EventItr; ++EventItr)
+	// Remove event from the pending events
+	TSharedPtr<FSLGraspEvent> Event = StartedEvents.Remove(
+		FSLUuid::PairEncodeCantor(Self->GetUniqueID(), Other->GetUniqueID()));
+	if (Event.IsValid())
 	{
-		// It is enough to compare against the other id when searching
-		if ((*EventItr)->Individual == Other)
-		{
-			// Set end time and publish event
-			(*EventItr)->EndTime = EndTime;
-			OnSemanticEvent.ExecuteIfBound(*EventItr);
-			// Remove event from the pending list
-			EventItr.RemoveCurrent();
-			return true;
-		}
+		// Set end time and publish event
+		Event->EndTime = EndTime;
+		OnSemanticEvent.ExecuteIfBound(Event);
+		return true;
 	}
 	return false;
 }
@@ -102,13 +98,12 @@ bool FSLFixationGraspEventHandler::FinishEvent(USLBaseIndividual* Other, float E
 void FSLFixationGraspEventHandler::FinishAllEvents(float EndTime)
 {
 	// Finish events
-	for (auto& Ev : StartedEvents)
+	for (auto& Ev : StartedEvents.RemoveAll())
 	{
 		// Set end time and publish event
 		Ev->EndTime = EndTime;
 		OnSemanticEvent.ExecuteIfBound(Ev);
 	}
-	StartedEvents.Empty();
 }
 
 
@@ -128,8 +123,11 @@ void FSLFixationGraspEventHandler::OnSLGraspBegin(AActor* SelfActor, AActor* Oth
 // Event called when a semantic grasp event ends
 void FSLFixationGraspEventHandler::OnSLGraspEnd(AActor* SelfActor, AActor* OtherActor, float Time)
 {
-	if (USLBaseIndividual* OtherIndividual = FSLIndividualUtils::GetIndividualObject(OtherActor))
+	if (USLBaseIndividual* SelfIndividual = FSLIndividualUtils::GetIndividualObject(SelfActor))
 	{
-		FSLFixationGraspEventHandler::FinishEvent(OtherIndividual, Time);
+		if (USLBaseIndividual* OtherIndividual = FSLIndividualUtils::GetIndividualObject(OtherActor))
+		{
+			FSLFixationGraspEventHandler::FinishEvent(SelfIndividual, OtherIndividual, Time);
+		}
 	}
 }
@@ -68,30 +68,26 @@ void FSLGraspEventHandler::AddNewEvent(USLBaseIndividual* Self, USLBaseIndividua
 		FSLUuid::PairEncodeCantor(Self->GetUniqueID(), Other->GetUniqueID()),
 		Self, Other, InType));
 	Event->EpisodeId = EpisodeId;
-	// Add event to the pending array
-	StartedEvents.Emplace(Event);
+	// Add event to the pending events
+	StartedEvents.Add(Event);
 }
 
 // Publish finished event
-bool FSLGraspEventHandler::FinishEvent(USLBaseIndividual* Other, float EndTime)
+bool FSLGraspEventHandler::FinishEvent(USLBaseIndividual* Self, USLBaseIndividual* Other, float EndTime)
 {
-	// Use iterator to be able to remove the entry from the array
-	for (auto EventItr(StartedEvents.CreateIterator()); EventItr; ++EventItr)
+	// Remove event from the pending events
+	TSharedPtr<FSLGraspEvent> Event = StartedEvents.Remove(
+		FSLUuid::PairEncodeCantor(Self->GetUniqueID(), Other->GetUniqueID()));
+	if (Event.IsValid())
 	{
-		// It is enough to compare against the other id when searching
-		if ((*EventItr)->Individual == Other)
+		// Ignore short events
+		if ((EndTime - Event->StartTime) > GraspEventMin)
 		{
-			// Ignore short events
-			if ((EndTime - (*EventItr)->StartTime) > GraspEventMin)
-			{
-				// Set end time and publish event
-				(*EventItr)->EndTime = EndTime;
-				OnSemanticEvent.ExecuteIfBound(*EventItr);
-			}
-			// Remove event from the pending list
-			EventItr.RemoveCurrent();
-			return true;
+			// Set end time and publish event
+			Event->EndTime = EndTime;
+			OnSemanticEvent.ExecuteIfBound(Event);
 		}
+		return true;
 	}
 	return false;
 }
@@ -100,7 +96,7 @@ bool FSLGraspEventHandler::FinishEvent(USLBaseIndividual* Other, float EndTime)
 void FSLGraspEventHandler::FinishAllEvents(float EndTime)
 {
 	// Finish events
-	for (auto& Ev : StartedEvents)
+	for (auto& Ev : StartedEvents.RemoveAll())
 	{
 		// Ignore short events
 		if ((EndTime - Ev->StartTime) > GraspEventMin)
@@ -110,7 +106,6 @@ void FSLGraspEventHandler::FinishAllEvents(float EndTime)
 			OnSemanticEvent.ExecuteIfBound(Ev);
 		}
 	}
-	StartedEvents.Empty();
 }
 
 
@@ -123,5 +118,5 @@ void FSLGraspEventHandler::OnSLGraspBegin(USLBaseIndividual* Self, USLBaseIndivi
 // Event called when a semantic grasp event ends
 void FSLGraspEventHandler::OnSLGraspEnd(USLBaseIndividual* Self, USLBaseIndividual* Other, float Time)
 {
-	FinishEvent(Other, Time);
+	FinishEvent(Self, Other, Time);
 }
@@ -69,28 +69,22 @@ void FSLManipulatorContactEventHandler::AddNewEvent(const FSLContactResult& InRe
 		FSLUuid::PairEncodeCantor(InResult.Self->GetUniqueID(), InResult.Other->GetUniqueID()),
 		InResult.Self, InResult.Other));
 	Event->EpisodeId = EpisodeId;
-	// Add event to the pending contacts array
-	StartedEvents.Emplace(Event);
+	// Add event to the pending contacts
+	StartedEvents.Add(Event);
 }
 
 // Publish finished event
-bool FSLManipulatorContactEventHandler::FinishEvent(USLBaseIndividual* InOther, float EndTime)
+bool FSLManipulatorContactEventHandler::FinishEvent(USLBaseIndividual* InSelf, USLBaseIndividual* InOther, float EndTime)
 {
-	// Use iterator to be able to remove the entry from the array
-	for (auto EventItr(StartedEvents.CreateIterator()); EventItr; ++EventItr)
+	// Remove event from the pending events
+	TSharedPtr<FSLContactEvent> Event = StartedEvents.Remove(
+		FSLUuid::PairEncodeCantor(InSelf->GetUniqueID(), InOther->GetUniqueID()));
+	if (Event.IsValid())
 	{
-		// It is enough to compare against the other id when searching
-		if ((*EventItr)->Individual2 == InOther)
-		{
-			// Set the event end time
-			(*EventItr)->EndTime = EndTime;
-
-			OnSemanticEvent.ExecuteIfBound(*EventItr);
-
-			// Remove event from the pending list
-			EventItr.RemoveCurrent();
-			return true;
-		}
+		// Set the event end time
+		Event->EndTime = EndTime;
+		OnSemanticEvent.ExecuteIfBound(Event);
+		return true;
 	}
 	return false;
 }
@@ -99,13 +93,12 @@ bool FSLManipulatorContactEventHandler::FinishEvent(USLBaseIndividual* InOther,
 void FSLManipulatorContactEventHandler::FinishAllEvents(float EndTime)
 {
 	// Finish contact events
-	for (auto& Ev : StartedEvents)
+	for (auto& Ev : StartedEvents.RemoveAll())
 	{
 		// Set end time and publish event
 		Ev->EndTime = EndTime;
 		OnSemanticEvent.ExecuteIfBound(Ev);
 	}
-	StartedEvents.Empty();
 }
 
 
@@ -118,5 +111,5 @@ void FSLManipulatorContactEventHandler::OnSLOverlapBegin(const FSLContactResult&
 // Event called when a semantic overlap event ends
 void FSLManipulatorContactEventHandler::OnSLOverlapEnd(USLBaseIndividual* Self, USLBaseIndividual* Other, float Time)
 {
-	FinishEvent(Other, Time);
+	FinishEvent(Self, Other, Time);
 }
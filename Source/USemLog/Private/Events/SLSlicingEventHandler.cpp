@@ -75,30 +75,26 @@ void FSLSlicingEventHandler::AddNewEvent(USLBaseIndividual* PerformedBy, USLBase
 		FSLUuid::NewGuidInBase64Url(), StartTime, 
 		FSLUuid::PairEncodeCantor(PerformedBy->GetUniqueID(), ObjectActedOn->GetUniqueID()),
 		PerformedBy, DeviceUsed, ObjectActedOn));
-	// Add event to the pending array
-	StartedEvents.Emplace(Event);
+	// Add event to the pending events
+	StartedEvents.Add(Event);
 }
 
 // Publish finished event
-bool FSLSlicingEventHandler::FinishEvent(USLBaseIndividual* ObjectActedOn,
+bool FSLSlicingEventHandler::FinishEvent(USLBaseIndividual* PerformedBy, USLBaseIndividual* ObjectActedOn,
 	bool bInTaskSuccessful, float EndTime,
 	USLBaseIndividual* OutputsCreated)
 {
-	// Use iterator to be able to remove the entry from the array
-	for (auto EventItr(StartedEvents.CreateIterator()); EventItr; ++EventItr)
+	// Remove event from the pending events
+	TSharedPtr<FSLSlicingEvent> Event = StartedEvents.Remove(
+		FSLUuid::PairEncodeCantor(PerformedBy->GetUniqueID(), ObjectActedOn->GetUniqueID()));
+	if (Event.IsValid())
 	{
-		// It is enough to compare against the other id when searching
-		if ((*EventItr)->ObjectActedOn == ObjectActedOn)
-		{
-			// Set end time and publish event
-			(*EventItr)->EndTime = EndTime;
-			(*EventItr)->bTaskSuccessful = bInTaskSuccessful;
-			(*EventItr)->CreatedSlice = OutputsCreated;
-			OnSemanticEvent.ExecuteIfBound(*EventItr);
-			// Remove event from the pending list
-			EventItr.RemoveCurrent();
-			return true;
-		}
+		// Set end time and publish event
+		Event->EndTime = EndTime;
+		Event->bTaskSuccessful = bInTaskSuccessful;
+		Event->CreatedSlice = OutputsCreated;
+		OnSemanticEvent.ExecuteIfBound(Event);
+		return true;
 	}
 	return false;
 }
@@ -107,13 +103,12 @@ bool FSLSlicingEventHandler::FinishEvent(USLBaseIndividual* ObjectActedOn,
 void FSLSlicingEventHandler::FinishAllEvents(float EndTime)
 {
 	// Finish events
-	for (auto& Ev : StartedEvents)
+	for (auto& Ev : StartedEvents.RemoveAll())
 	{
 		// Set end time and publish event
 		Ev->EndTime = EndTime;
 		OnSemanticEvent.ExecuteIfBound(Ev);
 	}
-	StartedEvents.Empty();
 }
 
 
@@ -139,7 +134,7 @@ void FSLSlicingEventHandler::OnSLSlicingEndFail(AActor* PerformedBy, AActor* Obj
 	{
 		if (USLBaseIndividual* ObjectActedOnIndvidiual = FSLIndividualUtils::GetIndividualObject(ObjectActedOn))
 		{
-			FSLSlicingEventHandler::FinishEvent(ObjectActedOnIndvidiual, false, Time, nullptr);
+			FSLSlicingEventHandler::FinishEvent(PerformedByIndvidiual, ObjectActedOnIndvidiual, false, Time, nullptr);
 		}
 	}
 }
@@ -153,7 +148,7 @@ void FSLSlicingEventHandler::OnSLSlicingEndSuccess(AActor* PerformedBy, AActor*
 		{
 			if (USLBaseIndividual* ObjectCreatedIndividual = FSLIndividualUtils::GetIndividualObject(ObjectCreated))
 			{
-				FSLSlicingEventHandler::FinishEvent(ObjectActedOnIndividual, true, Time, ObjectCreatedIndividual);
+				FSLSlicingEventHandler::FinishEvent(PerformedByIndvidiual, ObjectActedOnIndividual, true, Time, ObjectCreatedIndividual);
 			}
 		}
 	}
@@ -196,6 +196,35 @@ AActor* ASLIndividualManager::GetIndividualActor(const FString& Id)
 	return nullptr;
 }
 
+// Get the dense handles of the ids, new ids are appended to the handle table
+TArray<int32> ASLIndividualManager::GetIndividualHandles(const TArray<FString>& Ids)
+{
+	TArray<int32> Handles;
+	Handles.Reserve(Ids.Num());
+	for (const auto& Id : Ids)
+	{
+		Handles.Add(GetIndividualHandle(Id));
+	}
+	return Handles;
+}
+
+// Get the dense handle of the id
+int32 ASLIndividualManager::GetIndividualHandle(const FString& Id)
+{
+	if (const int32* Handle = IdToHandle.Find(Id))
+	{
+		return *Handle;
+	}
+
+	if (auto Individual = GetIndividual(Id))
+	{
+		const int32 Handle = HandleToIndividuals.Add(Individual);
+		IdToHandle.Add(Id, Handle);
+		return Handle;
+	}
+	return INDEX_NONE;
+}
+
 // Spawn or get manager from the world
 ASLIndividualManager* ASLIndividualManager::GetExistingOrSpawnNew(UWorld* World)
 {
@@ -405,6 +434,10 @@ void ASLIndividualManager::ClearCache()
 	/* Quick acess id based mapping*/
 	IdToIndividuals.Empty();
 	IdToIndividualComponents.Empty();
+
+	/* Handle based quick access */
+	HandleToIndividuals.Empty();
+	IdToHandle.Empty();
 	if (HasCache())
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d Somethig went wrong on clearing the cache.."), *FString(__FUNCTION__), __LINE__);
@@ -504,6 +537,7 @@ bool ASLIndividualManager::RemoveFromCache(USLIndividualComponent* IC)
 		const FString Id = Individual->GetIdValue();
 		IdToIndividuals.Remove(Id);
 		IdToIndividualComponents.Remove(Id);
+		RemoveHandle(Id);
 
 		/* World state logger */
 		MovableIndividuals.Remove(Individual);
@@ -533,6 +567,7 @@ bool ASLIndividualManager::RemoveFromCache(USLIndividualComponent* IC)
 		const FString ChildId = Child->GetIdValue();
 		IdToIndividuals.Remove(ChildId);
 		IdToIndividualComponents.Remove(ChildId);
+		RemoveHandle(ChildId);
 	}
 
 	bThreadSafeToRead = true;
@@ -540,6 +575,16 @@ bool ASLIndividualManager::RemoveFromCache(USLIndividualComponent* IC)
 	return bAnyRemoved;
 }
 
+// Invalidate the handle of the id, the slot is kept to not shift the other handles
+void ASLIndividualManager::RemoveHandle(const FString& Id)
+{
+	int32 Handle;
+	if (IdToHandle.RemoveAndCopyValue(Id, Handle))
+	{
+		HandleToIndividuals[Handle] = nullptr;
+	}
+}
+
 // Remove destroyed individuals from array
 void ASLIndividualManager::OnIndividualComponentDestroyed(USLIndividualComponent* DestroyedComponent)
 {
@@ -0,0 +1,148 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Mongo/SLMongoQueryCache.h"
+
+// Ctor
+FSLMongoQueryCache::FSLMongoQueryCache(int64 InMaxSizeBytes)
+{
+	MaxSizeBytes = FMath::Max<int64>(InMaxSizeBytes, 0);
+	SizeBytes = 0;
+	NumHits = 0;
+	NumMisses = 0;
+}
+
+// Set the memory cap (evicts the least recently used entries if needed)
+void FSLMongoQueryCache::SetMaxSize(int64 InMaxSizeBytes)
+{
+	MaxSizeBytes = FMath::Max<int64>(InMaxSizeBytes, 0);
+	EvictToFit(0);
+}
+
+// Get the cached poses of the query (marks the entry as recently used)
+bool FSLMongoQueryCache::FindPoses(const FString& Key, TArray<FTransform>& OutPoses)
+{
+	if (const FSLMongoQueryCacheEntry* Entry = FindAndTouch(Key))
+	{
+		OutPoses = Entry->Poses;
+		return true;
+	}
+	return false;
+}
+
+// Get the cached skeletal poses of the query (marks the entry as recently used)
+bool FSLMongoQueryCache::FindSkeletalPoses(const FString& Key, TArray<TPair<FTransform, TMap<int32, FTransform>>>& OutSkeletalPoses)
+{
+	if (const FSLMongoQueryCacheEntry* Entry = FindAndTouch(Key))
+	{
+		OutSkeletalPoses = Entry->SkeletalPoses;
+		return true;
+	}
+	return false;
+}
+
+// Cache the poses of the query
+void FSLMongoQueryCache::AddPoses(const FString& Key, const TArray<FTransform>& Poses)
+{
+	FSLMongoQueryCacheEntry Entry;
+	Entry.Poses = Poses;
+	Entry.SizeBytes = Key.GetAllocatedSize() + Entry.Poses.GetAllocatedSize() + sizeof(FSLMongoQueryCacheEntry);
+	Add(Key, MoveTemp(Entry));
+}
+
+// Cache the skeletal poses of the query
+void FSLMongoQueryCache::AddSkeletalPoses(const FString& Key, const TArray<TPair<FTransform, TMap<int32, FTransform>>>& SkeletalPoses)
+{
+	FSLMongoQueryCacheEntry Entry;
+	Entry.SkeletalPoses = SkeletalPoses;
+	Entry.SizeBytes = Key.GetAllocatedSize() + Entry.SkeletalPoses.GetAllocatedSize() + sizeof(FSLMongoQueryCacheEntry);
+	for (const auto& SkeletalPose : Entry.SkeletalPoses)
+	{
+		Entry.SizeBytes += SkeletalPose.Value.GetAllocatedSize();
+	}
+	Add(Key, MoveTemp(Entry));
+}
+
+// Remove all entries (the hit and miss counters are kept)
+void FSLMongoQueryCache::Empty()
+{
+	Entries.Empty();
+	LruList.Empty();
+	SizeBytes = 0;
+}
+
+// Get the cache usage as string
+FString FSLMongoQueryCache::GetStatsString() const
+{
+	const int64 NumQueries = NumHits + NumMisses;
+	return FString::Printf(TEXT("Entries=%d; Size=%.2f/%.2f MB; Hits=%lld; Misses=%lld; HitRate=%.1f%%;"),
+		Entries.Num(), SizeBytes / (1024.0 * 1024.0), MaxSizeBytes / (1024.0 * 1024.0), NumHits, NumMisses,
+		NumQueries > 0 ? 100.0 * NumHits / NumQueries : 0.0);
+}
+
+// Key of the query in the given task and episode (the timestamps are kept with microsecond precision)
+FString FSLMongoQueryCache::MakeKey(const TCHAR* QueryType, const FString& TaskId, const FString& EpisodeId, const FString& IndividualId,
+	float StartTs, float EndTs, float DeltaT)
+{
+	return FString::Printf(TEXT("%s|%s.%s|%s|%.6f|%.6f|%.6f"),
+		QueryType, *TaskId, *EpisodeId, *IndividualId, StartTs, EndTs, DeltaT);
+}
+
+// Find the entry and move it to the front of the recently used list
+const FSLMongoQueryCacheEntry* FSLMongoQueryCache::FindAndTouch(const FString& Key)
+{
+	FSLMongoQueryCacheEntry* Entry = Entries.Find(Key);
+	if (!Entry)
+	{
+		NumMisses++;
+		return nullptr;
+	}
+
+	if (Entry->LruNode != LruList.GetHead())
+	{
+		LruList.RemoveNode(Entry->LruNode, false);
+		LruList.AddHead(Entry->LruNode);
+	}
+	NumHits++;
+	return Entry;
+}
+
+// Insert the entry as the most recently used one, evicts the least recently used entries to fit it
+void FSLMongoQueryCache::Add(const FString& Key, FSLMongoQueryCacheEntry&& Entry)
+{
+	// Results larger than the whole cache are not kept
+	if (Entry.SizeBytes > MaxSizeBytes)
+	{
+		return;
+	}
+
+	Remove(Key);
+	EvictToFit(Entry.SizeBytes);
+
+	LruList.AddHead(Key);
+	Entry.LruNode = LruList.GetHead();
+	SizeBytes += Entry.SizeBytes;
+	Entries.Add(Key, MoveTemp(Entry));
+}
+
+// Remove the least recently used entries until the given size fits in the memory cap
+void FSLMongoQueryCache::EvictToFit(int64 NewEntrySize)
+{
+	while (LruList.GetTail() && SizeBytes + NewEntrySize > MaxSizeBytes)
+	{
+		// Copy the key, the node is deleted with the entry
+		const FString LeastRecentKey = LruList.GetTail()->GetValue();
+		Remove(LeastRecentKey);
+	}
+}
+
+// Remove the entry
+void FSLMongoQueryCache::Remove(const FString& Key)
+{
+	if (FSLMongoQueryCacheEntry* Entry = Entries.Find(Key))
+	{
+		LruList.RemoveNode(Entry->LruNode);
+		SizeBytes -= Entry->SizeBytes;
+		Entries.Remove(Key);
+	}
+}
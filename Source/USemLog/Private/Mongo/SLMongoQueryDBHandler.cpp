@@ -2,17 +2,89 @@
 // Author: Andrei Haidu (http://haidu.eu)
 
 #include "Mongo/SLMongoQueryDBHandler.h"
+#include "Runtime/SLWorldStateBinaryFormat.h"
+#include "Mongo/SLMongoTrajectoryIndexer.h"
+#include "Async/Async.h"
 
 #if SL_WITH_ROS_CONVERSIONS
 #include "Conversions.h"
 #endif // SL_WITH_ROS_CONVERSIONS
 
+/*
+* Raw frame documents copied from the cursor and their decoded frames
+*/
+struct FSLMongoRawFrameBatch
+{
+	// Concatenated bson documents
+	TArray<uint8> Data;
+
+	// Offset and length of every document in the data
+	TArray<TPair<int32, int32>> Docs;
+
+	// Decoded frames (same order as the documents)
+	TArray<FSLMongoEpisodeFrame> Frames;
+
+	// Frame index, pose index and id of the poses whose individual is missing from the meta collection
+	TArray<TTuple<int32, int32, FString>> UnresolvedIds;
+
+	// Index of the frames whose document could not be decoded (kept as empty frames to preserve the frame order)
+	TArray<int32> InvalidFrames;
+};
+
+// Number of libmongoc users
+int32 FSLMongoQueryDBHandler::MongoLibNumUsers = 0;
+
+// Guards the libmongoc init and cleanup
+FCriticalSection FSLMongoQueryDBHandler::MongoLibCS;
+
 // Ctor
 FSLMongoQueryDBHandler::FSLMongoQueryDBHandler()
 {
+	bMongoLibAcquired = false;
 	bConnected = false;
 	bDatabaseSet = false;
 	bCollectionSet = false;
+	bCompactBinary = false;
+	bHasTrajCollection = false;
+#if SL_WITH_LIBMONGO_C
+	uri = nullptr;
+	client = nullptr;
+	database = nullptr;
+	collection = nullptr;
+	meta_collection = nullptr;
+	traj_collection = nullptr;
+#endif //SL_WITH_LIBMONGO_C
+}
+
+// Initialize libmongoc on the first use, the handlers can connect from multiple threads (thread safe)
+void FSLMongoQueryDBHandler::AcquireMongoLib()
+{
+	FScopeLock Lock(&MongoLibCS);
+#if SL_WITH_LIBMONGO_C
+	if (MongoLibNumUsers == 0)
+	{
+		mongoc_init();
+	}
+#endif //SL_WITH_LIBMONGO_C
+	MongoLibNumUsers++;
+}
+
+// Clean up libmongoc when the last user releases it (thread safe)
+void FSLMongoQueryDBHandler::ReleaseMongoLib()
+{
+	FScopeLock Lock(&MongoLibCS);
+	if (MongoLibNumUsers == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d libmongoc is not acquired, this should not happen.."), *FString(__func__), __LINE__);
+		return;
+	}
+	MongoLibNumUsers--;
+#if SL_WITH_LIBMONGO_C
+	if (MongoLibNumUsers == 0)
+	{
+		mongoc_cleanup();
+	}
+#endif //SL_WITH_LIBMONGO_C
 }
 
 // Dtor
@@ -34,8 +106,12 @@ bool FSLMongoQueryDBHandler::Connect(const FString& ServerIp, uint16 ServerPort)
 	const bool bCheckConnection = true;
 
 #if SL_WITH_LIBMONGO_C
-	// Required to initialize libmongoc's internals
-	mongoc_init();
+	// Required to initialize libmongoc's internals (shared with the other handlers, released on disconnect)
+	if (!bMongoLibAcquired)
+	{
+		AcquireMongoLib();
+		bMongoLibAcquired = true;
+	}
 
 	// Stores any error that might appear during the connection
 	bson_error_t error;
@@ -188,6 +264,30 @@ bool FSLMongoQueryDBHandler::SetCollection(const FString& InCollName)
 	// Set collection
 	collection = mongoc_database_get_collection(database, TCHAR_TO_UTF8(*InCollName));
 	bCollectionSet = true;
+
+	// Check the world state schema version, the compact one requires the meta collection ids,
+	// the documents one uses them to index the episode data poses
+	bCompactBinary = DetectCompactBinarySchema();
+	if (!LoadMetaIndividualIds() && bCompactBinary)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Collection %s uses the compact binary schema but the individual ids could not be loaded from the meta collection.."),
+			*FString(__func__), __LINE__, *InCollName);
+	}
+
+	// Use the trajectory buckets for the individual queries if the episode has been indexed
+	if (traj_collection)
+	{
+		mongoc_collection_destroy(traj_collection);
+		traj_collection = nullptr;
+	}
+	bHasTrajCollection = false;
+	bson_error_t traj_error;
+	const FString TrajCollName = FSLMongoTrajectoryIndexer::GetCollectionName(InCollName);
+	if (mongoc_database_has_collection(database, TCHAR_TO_UTF8(*TrajCollName), &traj_error))
+	{
+		traj_collection = mongoc_database_get_collection(database, TCHAR_TO_UTF8(*TrajCollName));
+		bHasTrajCollection = true;
+	}
 	return true;
 #else
 	UE_LOG(LogTemp, Error, TEXT("%s::%d Mongo module is missing.."), *FString(__func__), __LINE__);
@@ -202,44 +302,109 @@ void FSLMongoQueryDBHandler::Disconnect()
 	bConnected = false;
 	bDatabaseSet = false;
 	bCollectionSet = false;
+	bCompactBinary = false;
+	bHasTrajCollection = false;
+	MetaIndividualIds.Empty();
+	MetaIdToIdx.Empty();
 
 #if SL_WITH_LIBMONGO_C
 	// Release handles and clean up libmongoc
+	if (traj_collection)
+	{
+		mongoc_collection_destroy(traj_collection);
+		traj_collection = nullptr;
+	}
 	if (meta_collection)
 	{
 		mongoc_collection_destroy(meta_collection);
+		meta_collection = nullptr;
 	}
 	if (collection)
 	{
 		mongoc_collection_destroy(collection);
+		collection = nullptr;
 	}
 	if (database)
 	{
 		mongoc_database_destroy(database);
+		database = nullptr;
 	}
 	if (uri)
 	{
 		mongoc_uri_destroy(uri);
+		uri = nullptr;
 	}
 	if (client)
 	{
 		mongoc_client_destroy(client);
+		client = nullptr;
+	}
+#endif //SL_WITH_LIBMONGO_C
+
+	// libmongoc is cleaned up only after the last handler (on any thread) released its client
+	if (bMongoLibAcquired)
+	{
+		ReleaseMongoLib();
+		bMongoLibAcquired = false;
+	}
+}
+
+// Build (or rebuild) the trajectory collection of the current episode (offline indexing of already logged episodes)
+bool FSLMongoQueryDBHandler::BuildTrajectoryCollection(float BucketDuration)
+{
+	if (!IsReady())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+#if SL_WITH_LIBMONGO_C
+	if (traj_collection)
+	{
+		mongoc_collection_destroy(traj_collection);
+		traj_collection = nullptr;
+	}
+	bHasTrajCollection = false;
+
+	if (!FSLMongoTrajectoryIndexer::Build(database, collection, bCompactBinary, MetaIndividualIds, BucketDuration))
+	{
+		return false;
 	}
-	mongoc_cleanup();
+
+	const FString TrajCollName = FSLMongoTrajectoryIndexer::GetCollectionName(FString(UTF8_TO_TCHAR(mongoc_collection_get_name(collection))));
+	traj_collection = mongoc_database_get_collection(database, TCHAR_TO_UTF8(*TrajCollName));
+	bHasTrajCollection = true;
+	return true;
+#else
+	return false;
 #endif //SL_WITH_LIBMONGO_C
 }
 
 /* Queries */
-// Get the pose of the individual at the given time
-FTransform FSLMongoQueryDBHandler::GetIndividualPoseAt(const FString& Id, float Ts) const
+// Get the pose of the individual at the given time (bOutFound is set if the pose was read from the database)
+FTransform FSLMongoQueryDBHandler::GetIndividualPoseAt(const FString& Id, float Ts, bool* bOutFound) const
 {
 	FTransform Pose;
+	if (bOutFound)
+	{
+		*bOutFound = false;
+	}
 	if (!IsReady())
 	{
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
 		return Pose;
 	}
 
+	if (bHasTrajCollection)
+	{
+		return GetIndividualPoseAtTraj(Id, Ts, bOutFound);
+	}
+
+	if (bCompactBinary)
+	{
+		return GetIndividualPoseAtCompact(Id, Ts, bOutFound);
+	}
+
 #if SL_WITH_LIBMONGO_C	
 	double ExecBegin = FPlatformTime::Seconds();
 
@@ -296,6 +461,10 @@ FTransform FSLMongoQueryDBHandler::GetIndividualPoseAt(const FString& Id, float
 		if (mongoc_cursor_next(cursor, &doc))
 		{
 			Pose = GetPose(doc);
+			if (bOutFound)
+			{
+				*bOutFound = true;
+			}
 		}
 	}
 	else
@@ -314,15 +483,29 @@ FTransform FSLMongoQueryDBHandler::GetIndividualPoseAt(const FString& Id, float
 }
 
 // Get the poses of the individual between the given timestamps
-TArray<FTransform> FSLMongoQueryDBHandler::GetIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT) const
+TArray<FTransform> FSLMongoQueryDBHandler::GetIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT, bool* bOutFound) const
 {
 	TArray<FTransform> Trajectory;
+	if (bOutFound)
+	{
+		*bOutFound = false;
+	}
 	if (!IsReady())
 	{
 		UE_LOG(LogTemp, Log, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
 		return Trajectory;
 	}
 
+	if (bHasTrajCollection)
+	{
+		return GetIndividualTrajectoryTraj(Id, StartTs, EndTs, DeltaT, bOutFound);
+	}
+
+	if (bCompactBinary)
+	{
+		return GetIndividualTrajectoryCompact(Id, StartTs, EndTs, DeltaT, bOutFound);
+	}
+
 #if SL_WITH_LIBMONGO_C
 	double ExecBegin = FPlatformTime::Seconds();
 
@@ -369,33 +552,18 @@ TArray<FTransform> FSLMongoQueryDBHandler::GetIndividualTrajectory(const FString
 			"}",
 		"}",
 		"]");
+	pipeline = AppendSamplingStages(pipeline, "timestamp", StartTs, DeltaT);
 
 	cursor = mongoc_collection_aggregate(
 		collection, MONGOC_QUERY_NONE, pipeline, NULL, NULL);
 	double QueryDuration = FPlatformTime::Seconds() - ExecBegin;
 
-	// Read cursor if no errors occured
+	// Read cursor if no errors occured (the frames are already downsampled on the server)
 	if (!mongoc_cursor_error(cursor, &error))
 	{
-		if (DeltaT > 0.f)
-		{
-			double PrevTs = -BIG_NUMBER;
-			while (mongoc_cursor_next(cursor, &doc))
-			{
-				double CurrTs = GetTs(doc);
-				if (CurrTs - PrevTs > DeltaT)
-				{
-					Trajectory.Add(GetPose(doc));
-					PrevTs = CurrTs;
-				}
-			}
-		}
-		else
+		while (mongoc_cursor_next(cursor, &doc))
 		{
-			while (mongoc_cursor_next(cursor, &doc))
-			{
-				Trajectory.Add(GetPose(doc));
-			}
+			Trajectory.Add(GetPose(doc));
 		}
 	}
 	else
@@ -412,21 +580,34 @@ TArray<FTransform> FSLMongoQueryDBHandler::GetIndividualTrajectory(const FString
 #endif
 	if (Trajectory.Num() == 0)
 	{
-		Trajectory.Add(GetIndividualPoseAt(Id, StartTs));
+		Trajectory.Add(GetIndividualPoseAt(Id, StartTs, bOutFound));
+	}
+	else if (bOutFound)
+	{
+		*bOutFound = true;
 	}
 	return Trajectory;
 }
 
-// Get skeletal individual pose
-TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIndividualPoseAt(const FString& Id, float Ts) const
+// Get skeletal individual pose (bOutFound is set if the pose was read from the database)
+TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIndividualPoseAt(const FString& Id, float Ts, bool* bOutFound) const
 {
 	TPair<FTransform, TMap<int32, FTransform>> SkeletalPosePair;
+	if (bOutFound)
+	{
+		*bOutFound = false;
+	}
 	if (!IsReady())
 	{
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
 		return SkeletalPosePair;
 	}
 
+	if (bCompactBinary)
+	{
+		return GetSkeletalIndividualPoseAtCompact(Id, Ts, bOutFound);
+	}
+
 #if SL_WITH_LIBMONGO_C	
 	double ExecBegin = FPlatformTime::Seconds();
 
@@ -485,6 +666,10 @@ TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIn
 		if (mongoc_cursor_next(cursor, &doc))
 		{
 			SkeletalPosePair.Key = GetPose(doc);
+			if (bOutFound)
+			{
+				*bOutFound = true;
+			}
 
 			// Get bones data
 			bson_iter_t bones;
@@ -523,15 +708,24 @@ TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIn
 }
 
 // Get skeletal individual trajectory
-TArray<TPair<FTransform, TMap<int32, FTransform>>> FSLMongoQueryDBHandler::GetSkeletalIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT) const
+TArray<TPair<FTransform, TMap<int32, FTransform>>> FSLMongoQueryDBHandler::GetSkeletalIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT, const TArray<int32>& BoneIndexes, bool* bOutFound) const
 {
 	TArray<TPair<FTransform, TMap<int32, FTransform>>> SkeletalTrajectoryPair;
+	if (bOutFound)
+	{
+		*bOutFound = false;
+	}
 	if (!IsReady())
 	{
 		UE_LOG(LogTemp, Log, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
 		return SkeletalTrajectoryPair;
 	}
 
+	if (bCompactBinary)
+	{
+		return GetSkeletalIndividualTrajectoryCompact(Id, StartTs, EndTs, DeltaT, BoneIndexes, bOutFound);
+	}
+
 #if SL_WITH_LIBMONGO_C
 	double ExecBegin = FPlatformTime::Seconds();
 
@@ -580,77 +774,40 @@ TArray<TPair<FTransform, TMap<int32, FTransform>>> FSLMongoQueryDBHandler::GetSk
 			"}",
 		"}",
 		"]");
+	pipeline = AppendSamplingStages(pipeline, "timestamp", StartTs, DeltaT, &BoneIndexes);
 
 	cursor = mongoc_collection_aggregate(
 		collection, MONGOC_QUERY_NONE, pipeline, NULL, NULL);
 	double QueryDuration = FPlatformTime::Seconds() - ExecBegin;
 
-	// Read cursor if no errors occured
+	// Read cursor if no errors occured (the frames and bones are already filtered on the server)
 	if (!mongoc_cursor_error(cursor, &error))
 	{
-		if (DeltaT > 0.f)
+		while (mongoc_cursor_next(cursor, &doc))
 		{
-			double PrevTs = -BIG_NUMBER;
-			while (mongoc_cursor_next(cursor, &doc))
-			{
-				double CurrTs = GetTs(doc);
-				if (CurrTs - PrevTs > DeltaT)
-				{
-					TPair<FTransform, TMap<int32, FTransform>> SkeletalPosePair;
-					SkeletalPosePair.Key = GetPose(doc);
+			TPair<FTransform, TMap<int32, FTransform>> SkeletalPosePair;
+			SkeletalPosePair.Key = GetPose(doc);
 
-					// Get bones data
-					bson_iter_t bones;
-					if (bson_iter_init(&bones, doc) && bson_iter_find(&bones, "bones"))
-					{
-						bson_iter_t bone;
-						if (bson_iter_recurse(&bones, &bone))
-						{
-							int32 BoneIndex;
-							bson_iter_t value;
-							while (bson_iter_next(&bone))
-							{
-								if (bson_iter_recurse(&bone, &value) && bson_iter_find(&value, "idx"))
-								{
-									BoneIndex = bson_iter_int32(&value);
-								}
-								SkeletalPosePair.Value.Emplace(BoneIndex, GetPose(&bone));
-							}
-						}
-					}
-					SkeletalTrajectoryPair.Add(SkeletalPosePair);
-					PrevTs = CurrTs;
-				}
-			}
-		}
-		else
-		{
-			while (mongoc_cursor_next(cursor, &doc))
+			// Get bones data
+			bson_iter_t bones;
+			if (bson_iter_init(&bones, doc) && bson_iter_find(&bones, "bones"))
 			{
-				TPair<FTransform, TMap<int32, FTransform>> SkeletalPosePair;
-				SkeletalPosePair.Key = GetPose(doc);
-
-				// Get bones data
-				bson_iter_t bones;
-				if (bson_iter_init(&bones, doc) && bson_iter_find(&bones, "bones"))
+				bson_iter_t bone;
+				if (bson_iter_recurse(&bones, &bone))
 				{
-					bson_iter_t bone;
-					if (bson_iter_recurse(&bones, &bone))
+					int32 BoneIndex;
+					bson_iter_t value;
+					while (bson_iter_next(&bone))
 					{
-						int32 BoneIndex;
-						bson_iter_t value;
-						while (bson_iter_next(&bone))
+						if (bson_iter_recurse(&bone, &value) && bson_iter_find(&value, "idx"))
 						{
-							if (bson_iter_recurse(&bone, &value) && bson_iter_find(&value, "idx"))
-							{
-								BoneIndex = bson_iter_int32(&value);
-							}
-							SkeletalPosePair.Value.Emplace(BoneIndex, GetPose(&bone));
+							BoneIndex = bson_iter_int32(&value);
 						}
+						SkeletalPosePair.Value.Emplace(BoneIndex, GetPose(&bone));
 					}
 				}
-				SkeletalTrajectoryPair.Add(SkeletalPosePair);
 			}
+			SkeletalTrajectoryPair.Add(SkeletalPosePair);
 		}
 	}
 	else
@@ -667,15 +824,26 @@ TArray<TPair<FTransform, TMap<int32, FTransform>>> FSLMongoQueryDBHandler::GetSk
 #endif
 	if (SkeletalTrajectoryPair.Num() == 0)
 	{
-		SkeletalTrajectoryPair.Add(GetSkeletalIndividualPoseAt(Id, StartTs));
+		SkeletalTrajectoryPair.Add(GetSkeletalIndividualPoseAt(Id, StartTs, bOutFound));
+	}
+	else if (bOutFound)
+	{
+		*bOutFound = true;
 	}
 	return SkeletalTrajectoryPair;
 }
 
 // Get the whole episode data
-TArray<TPair<float, TMap<FString, FTransform>>> FSLMongoQueryDBHandler::GetEpisodeData() const
+FSLMongoEpisodeData FSLMongoQueryDBHandler::GetEpisodeData() const
+{
+	return GetEpisodeData(-BIG_NUMBER, BIG_NUMBER);
+}
+
+// Get the episode data between the given timestamps (inclusive)
+FSLMongoEpisodeData FSLMongoQueryDBHandler::GetEpisodeData(double StartTs, double EndTs) const
 {
-	TArray<TPair<float, TMap<FString, FTransform>>> EpisodeData;
+	FSLMongoEpisodeData EpisodeData;
+	EpisodeData.IndividualIds = MetaIndividualIds;
 	if (!IsReady())
 	{
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
@@ -697,7 +865,8 @@ TArray<TPair<float, TMap<FString, FTransform>>> FSLMongoQueryDBHandler::GetEpiso
 			"{",
 				"timestamp", 
 				"{",
-					"$exists", BCON_BOOL(true),
+					"$gte", BCON_DOUBLE(StartTs),
+					"$lte", BCON_DOUBLE(EndTs),
 				"}",
 			"}",
 		"}",
@@ -713,6 +882,7 @@ TArray<TPair<float, TMap<FString, FTransform>>> FSLMongoQueryDBHandler::GetEpiso
 				"_id", BCON_INT32(0),
 				"timestamp", BCON_INT32(1),
 				"individuals", BCON_UTF8("$individuals"),
+				FSLWorldStateBinaryFormat::IndividualsBinKey, BCON_INT32(1),
 			"}",
 		"}",
 		"]");
@@ -725,62 +895,210 @@ TArray<TPair<float, TMap<FString, FTransform>>> FSLMongoQueryDBHandler::GetEpiso
 
 	double QueryDuration = FPlatformTime::Seconds() - ExecBegin;
 
-	int32 FrameIdx = 0;
+	// The cursor is read on this thread, the raw documents are decoded in batches on the task graph
+	const int32 BatchSize = 256;
+	TArray<TUniquePtr<FSLMongoRawFrameBatch>> Batches;
+	TArray<TFuture<void>> DecodeTasks;
+	FSLMongoRawFrameBatch* CurrBatch = nullptr;
+	int32 NumDocs = 0;
+
 	// Read cursor if no errors occured
 	if (!mongoc_cursor_error(cursor, &error))
 	{
 		while (mongoc_cursor_next(cursor, &doc))
 		{
-			if (FrameIdx++ % 250 == 0) { UE_LOG(LogTemp, Log, TEXT(" mongo processing frame %d .."), FrameIdx++); }
-			bson_iter_t frame_iter;
-			if (bson_iter_init(&frame_iter, doc))
+			if (CurrBatch == nullptr)
 			{
-				TMap<FString, FTransform> CurrIndividualsData;
-				float CurrTs;
-				
-				if (bson_iter_find(&frame_iter, "timestamp"))
-				{
-					CurrTs = bson_iter_double(&frame_iter);
-				}
+				CurrBatch = Batches.Emplace_GetRef(MakeUnique<FSLMongoRawFrameBatch>()).Get();
+				CurrBatch->Docs.Reserve(BatchSize);
+			}
 
-				bson_iter_t individuals_iter;
-				if (bson_iter_find(&frame_iter, "individuals") && bson_iter_recurse(&frame_iter, &individuals_iter))
-				{
-					while (bson_iter_next(&individuals_iter))
-					{
-						FString Id;
-						bson_iter_t individual_val_iter;
-						if (bson_iter_recurse(&individuals_iter, &individual_val_iter) && bson_iter_find(&individual_val_iter, "id"))
-						{
-							Id = FString(bson_iter_utf8(&individual_val_iter, NULL));
-						}
-						CurrIndividualsData.Emplace(Id, GetPose(&individuals_iter));
-					}
-				}
-				EpisodeData.Emplace(CurrTs, CurrIndividualsData);
+			// The cursor document is only valid until the next call
+			CurrBatch->Docs.Emplace(CurrBatch->Data.Num(), doc->len);
+			CurrBatch->Data.Append(bson_get_data(doc), doc->len);
+			NumDocs++;
+
+			if (CurrBatch->Docs.Num() == BatchSize)
+			{
+				DecodeTasks.Emplace(Async(EAsyncExecution::TaskGraph, [this, CurrBatch]() { DecodeEpisodeBatch(*CurrBatch); }));
+				CurrBatch = nullptr;
 			}
 		}
+		if (CurrBatch)
+		{
+			DecodeTasks.Emplace(Async(EAsyncExecution::TaskGraph, [this, CurrBatch]() { DecodeEpisodeBatch(*CurrBatch); }));
+		}
 	}
 	else
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
 			*FString(__func__), __LINE__, *FString(error.message));
 	}
+
+	for (auto& DecodeTask : DecodeTasks)
+	{
+		DecodeTask.Wait();
+	}
+
+	// Ids missing from the meta collection (documents schema only), appended after the meta ids in the frame order
+	TMap<FString, int32> ExtraIdToIdx;
+	int32 NumInvalidFrames = 0;
+	EpisodeData.Frames.Reserve(NumDocs);
+	for (auto& Batch : Batches)
+	{
+		// The timestamp of an invalid frame is unknown, it is replayed as no change at the time of the previous frame
+		for (const int32 InvalidIdx : Batch->InvalidFrames)
+		{
+			Batch->Frames[InvalidIdx].Timestamp = InvalidIdx > 0 ? Batch->Frames[InvalidIdx - 1].Timestamp
+				: EpisodeData.Frames.Num() > 0 ? EpisodeData.Frames.Last().Timestamp : 0.f;
+		}
+		NumInvalidFrames += Batch->InvalidFrames.Num();
+
+		for (const auto& Unresolved : Batch->UnresolvedIds)
+		{
+			const FString& Id = Unresolved.Get<2>();
+			int32 MetaIdx;
+			if (const int32* ExtraIdx = ExtraIdToIdx.Find(Id))
+			{
+				MetaIdx = *ExtraIdx;
+			}
+			else
+			{
+				MetaIdx = EpisodeData.IndividualIds.Add(Id);
+				ExtraIdToIdx.Add(Id, MetaIdx);
+			}
+			Batch->Frames[Unresolved.Get<0>()].Poses[Unresolved.Get<1>()].Key = MetaIdx;
+		}
+		EpisodeData.Frames.Append(MoveTemp(Batch->Frames));
+		Batch.Reset();
+	}
+
 	double CursorReadDuration = FPlatformTime::Seconds() - ExecBegin - QueryDuration;
 
 	mongoc_cursor_destroy(cursor);
 	bson_destroy(pipeline);
-	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor(num=%d)=[%f], total=[%f] seconds..;"),
-		*FString(__func__), __LINE__, QueryDuration, EpisodeData.Num(), CursorReadDuration, FPlatformTime::Seconds() - ExecBegin);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor and decode(num=%d, batches=%d)=[%f], total=[%f] seconds..;"),
+		*FString(__func__), __LINE__, QueryDuration, EpisodeData.Num(), DecodeTasks.Num(), CursorReadDuration, FPlatformTime::Seconds() - ExecBegin);
+	if (ExtraIdToIdx.Num() > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %d individual ids are missing from the meta collection.."),
+			*FString(__func__), __LINE__, ExtraIdToIdx.Num());
+	}
+	if (NumInvalidFrames > 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d %d frame documents could not be decoded, they are kept as empty frames.."),
+			*FString(__func__), __LINE__, NumInvalidFrames);
+	}
 #endif
 	return EpisodeData;
 }
 
-// Get the whole episode data in an async thread
-TArray<TPair<float, TMap<FString, FTransform>>> FSLMongoQueryDBHandler::GetEpisodeDataAsync() const
+#if SL_WITH_LIBMONGO_C
+// Decode the raw frame documents of the batch (called from the task graph, only reads the handler data)
+void FSLMongoQueryDBHandler::DecodeEpisodeBatch(FSLMongoRawFrameBatch& Batch) const
+{
+	Batch.Frames.Reserve(Batch.Docs.Num());
+	int32 PrevNumPoses = 0;
+	for (const auto& DocEntry : Batch.Docs)
+	{
+		// Undecodable documents are kept as empty frames, otherwise every following frame index would be shifted
+		bson_t frame_doc;
+		bson_iter_t frame_iter;
+		if (!bson_init_static(&frame_doc, Batch.Data.GetData() + DocEntry.Key, DocEntry.Value)
+			|| !bson_iter_init(&frame_iter, &frame_doc))
+		{
+			Batch.InvalidFrames.Add(Batch.Frames.Num());
+			Batch.Frames.AddDefaulted();
+			continue;
+		}
+
+		float CurrTs = 0.f;
+		if (bson_iter_find(&frame_iter, "timestamp"))
+		{
+			CurrTs = bson_iter_double(&frame_iter);
+		}
+		const int32 CurrFrameIdx = Batch.Frames.Num();
+		FSLMongoEpisodeFrame& CurrFrame = Batch.Frames.Emplace_GetRef(CurrTs);
+
+		bson_iter_t individuals_iter;
+		if (bCompactBinary)
+		{
+			GetBinaryFrame(&frame_doc, CurrFrame.Poses);
+		}
+		else if (bson_iter_find(&frame_iter, "individuals") && bson_iter_recurse(&frame_iter, &individuals_iter))
+		{
+			// Consecutive frames usually have a similar number of individuals
+			CurrFrame.Poses.Reserve(PrevNumPoses);
+			while (bson_iter_next(&individuals_iter))
+			{
+				FString Id;
+				bson_iter_t individual_val_iter;
+				if (bson_iter_recurse(&individuals_iter, &individual_val_iter) && bson_iter_find(&individual_val_iter, "id"))
+				{
+					Id = FString(bson_iter_utf8(&individual_val_iter, NULL));
+				}
+
+				// Ids missing from the meta collection are resolved after all the batches are decoded
+				const int32 MetaIdx = GetMetaIdx(Id);
+				if (MetaIdx == INDEX_NONE)
+				{
+					Batch.UnresolvedIds.Emplace(CurrFrameIdx, CurrFrame.Poses.Num(), Id);
+				}
+				CurrFrame.Poses.Emplace(MetaIdx, GetPose(&individuals_iter));
+			}
+		}
+		PrevNumPoses = CurrFrame.Poses.Num();
+	}
+
+	// The raw documents are not needed anymore
+	Batch.Data.Empty();
+	Batch.Docs.Empty();
+}
+#endif // SL_WITH_LIBMONGO_C
+
+// Get the sorted timestamps of all the episode frames
+TArray<double> FSLMongoQueryDBHandler::GetEpisodeTimestamps() const
 {
-	// TODO
-	return TArray<TPair<float, TMap<FString, FTransform>>>();
+	TArray<double> Timestamps;
+	if (!IsReady())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
+		return Timestamps;
+	}
+
+#if SL_WITH_LIBMONGO_C
+	double ExecBegin = FPlatformTime::Seconds();
+
+	bson_error_t error;
+	const bson_t *doc;
+	mongoc_cursor_t *cursor;
+	bson_t *filter;
+	bson_t *opts;
+
+	// Only the (indexed) timestamps are returned, the query stays cheap for long episodes
+	filter = BCON_NEW("timestamp", "{", "$exists", BCON_BOOL(true), "}");
+	opts = BCON_NEW(
+		"projection", "{", "_id", BCON_INT32(0), "timestamp", BCON_INT32(1), "}",
+		"sort", "{", "timestamp", BCON_INT32(1), "}");
+
+	cursor = mongoc_collection_find_with_opts(collection, filter, opts, NULL);
+	while (mongoc_cursor_next(cursor, &doc))
+	{
+		Timestamps.Add(GetTs(doc));
+	}
+	if (mongoc_cursor_error(cursor, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+	}
+
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(filter);
+	bson_destroy(opts);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Duration: [%f] seconds, Num=[%d]..;"),
+		*FString(__func__), __LINE__, FPlatformTime::Seconds() - ExecBegin, Timestamps.Num());
+#endif // SL_WITH_LIBMONGO_C
+	return Timestamps;
 }
 
 // Get the episode data at the given timestamp (frame)
@@ -789,8 +1107,814 @@ TMap<FString, FTransform> FSLMongoQueryDBHandler::GetFrameData(float Ts)
 	return TMap<FString, FTransform>();
 }
 
-/* Helpers */
+
+/* Trajectory collection queries */
+// Get the pose of the individual at the given time from its trajectory bucket
+FTransform FSLMongoQueryDBHandler::GetIndividualPoseAtTraj(const FString& Id, float Ts, bool* bOutFound) const
+{
+	FTransform Pose;
+	if (bOutFound)
+	{
+		*bOutFound = false;
+	}
 #if SL_WITH_LIBMONGO_C
+	double ExecBegin = FPlatformTime::Seconds();
+
+	bson_error_t error;
+	const bson_t *doc;
+	mongoc_cursor_t *cursor;
+	bson_t *filter;
+	bson_t *opts;
+
+	// Last bucket starting before the timestamp ((id, start_ts) index lookup)
+	filter = BCON_NEW(
+		"id", BCON_UTF8(TCHAR_TO_UTF8(*Id)),
+		"start_ts", "{", "$lte", BCON_DOUBLE(Ts), "}");
+	opts = BCON_NEW(
+		"sort", "{", "start_ts", BCON_INT32(-1), "}",
+		"limit", BCON_INT64(1),
+		"projection", "{", "_id", BCON_INT32(0), "samples", BCON_INT32(1), "}");
+
+	cursor = mongoc_collection_find_with_opts(traj_collection, filter, opts, NULL);
+	double QueryDuration = FPlatformTime::Seconds() - ExecBegin;
+
+	if (mongoc_cursor_next(cursor, &doc))
+	{
+		// Last sample at or before the timestamp (the samples are time sorted)
+		bson_iter_t iter;
+		bson_iter_t samples_iter;
+		if (bson_iter_init_find(&iter, doc, "samples") && bson_iter_recurse(&iter, &samples_iter))
+		{
+			while (bson_iter_next(&samples_iter))
+			{
+				bson_iter_t ts_iter;
+				if (bson_iter_recurse(&samples_iter, &ts_iter) && bson_iter_find(&ts_iter, "ts"))
+				{
+					if (bson_iter_double(&ts_iter) > Ts)
+					{
+						break;
+					}
+					Pose = GetPose(&samples_iter);
+					if (bOutFound)
+					{
+						*bOutFound = true;
+					}
+				}
+			}
+		}
+	}
+	else if (mongoc_cursor_error(cursor, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+	}
+	double CursorReadDuration = FPlatformTime::Seconds() - ExecBegin - QueryDuration;
+
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(filter);
+	bson_destroy(opts);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor=[%f], total=[%f] seconds..;"),
+		*FString(__func__), __LINE__, QueryDuration, CursorReadDuration, FPlatformTime::Seconds() - ExecBegin);
+#endif
+	return Pose;
+}
+
+// Get the poses of the individual between the given timestamps from its trajectory buckets
+TArray<FTransform> FSLMongoQueryDBHandler::GetIndividualTrajectoryTraj(const FString& Id, float StartTs, float EndTs, float DeltaT, bool* bOutFound) const
+{
+	TArray<FTransform> Trajectory;
+	if (bOutFound)
+	{
+		*bOutFound = false;
+	}
+#if SL_WITH_LIBMONGO_C
+	double ExecBegin = FPlatformTime::Seconds();
+
+	bson_error_t error;
+	const bson_t *doc;
+	mongoc_cursor_t *cursor;
+	bson_t *pipeline;
+
+	// Unwind the samples of the buckets overlapping the time range, only the samples in the range are returned
+	pipeline = BCON_NEW("pipeline", "[",
+		"{",
+			"$match",
+			"{",
+				"id", BCON_UTF8(TCHAR_TO_UTF8(*Id)),
+				"start_ts", "{", "$lte", BCON_DOUBLE(EndTs), "}",
+				"end_ts", "{", "$gte", BCON_DOUBLE(StartTs), "}",
+			"}",
+		"}",
+		"{",
+			"$sort",
+			"{",
+				"start_ts", BCON_INT32(1),
+			"}",
+		"}",
+		"{",
+			"$unwind", BCON_UTF8("$samples"),
+		"}",
+		"{",
+			"$match",
+			"{",
+				"samples.ts",
+				"{",
+					"$gte", BCON_DOUBLE(StartTs),
+					"$lte", BCON_DOUBLE(EndTs),
+				"}",
+			"}",
+		"}",
+		"{",
+			"$replaceRoot", "{", "newRoot", BCON_UTF8("$samples"), "}",
+		"}",
+		"]");
+	pipeline = AppendSamplingStages(pipeline, "ts", StartTs, DeltaT);
+
+	cursor = mongoc_collection_aggregate(
+		traj_collection, MONGOC_QUERY_NONE, pipeline, NULL, NULL);
+	double QueryDuration = FPlatformTime::Seconds() - ExecBegin;
+
+	// Read cursor if no errors occured (the samples are already downsampled on the server)
+	if (!mongoc_cursor_error(cursor, &error))
+	{
+		while (mongoc_cursor_next(cursor, &doc))
+		{
+			Trajectory.Add(GetPose(doc));
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+	}
+	double CursorReadDuration = FPlatformTime::Seconds() - ExecBegin - QueryDuration;
+
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(pipeline);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor=[%f], total=[%f] seconds, Num=[%d]..;"),
+		*FString(__func__), __LINE__, QueryDuration, CursorReadDuration, FPlatformTime::Seconds() - ExecBegin, Trajectory.Num());
+#endif
+	if (Trajectory.Num() == 0)
+	{
+		Trajectory.Add(GetIndividualPoseAtTraj(Id, StartTs, bOutFound));
+	}
+	else if (bOutFound)
+	{
+		*bOutFound = true;
+	}
+	return Trajectory;
+}
+
+/* Compact binary schema queries */
+// Get the pose of the individual at the given time
+FTransform FSLMongoQueryDBHandler::GetIndividualPoseAtCompact(const FString& Id, float Ts, bool* bOutFound) const
+{
+	FTransform Pose;
+	if (bOutFound)
+	{
+		*bOutFound = false;
+	}
+	const int32 MetaIdx = GetMetaIdx(Id);
+	if (MetaIdx == INDEX_NONE)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not find %s in the meta collection.."), *FString(__FUNCTION__), __LINE__, *Id);
+		return Pose;
+	}
+
+#if SL_WITH_LIBMONGO_C	
+	double ExecBegin = FPlatformTime::Seconds();
+
+	bson_error_t error;
+	const bson_t *doc;
+	mongoc_cursor_t *cursor;
+	bson_t *pipeline;
+
+	pipeline = BCON_NEW("pipeline", "[",
+		"{",
+			"$match",
+			"{",
+				"timestamp", "{", "$lte", BCON_DOUBLE(Ts), "}",
+				FSLWorldStateBinaryFormat::IndividualsIdxKey, BCON_INT32(MetaIdx),
+			"}",
+		"}",
+		"{",
+			"$sort",
+			"{",
+				"timestamp", BCON_INT32(-1),
+			"}",
+		"}",
+		"{",
+			"$limit", BCON_INT32(1),
+		"}",
+		"{",
+			"$project",
+			"{",
+				"_id", BCON_INT32(0),
+				"timestamp", BCON_INT32(1),
+				FSLWorldStateBinaryFormat::IndividualsBinKey, BCON_INT32(1),
+			"}",
+		"}",
+		"]");
+
+	cursor = mongoc_collection_aggregate(
+		collection, MONGOC_QUERY_NONE, pipeline, NULL, NULL);
+	double QueryDuration = FPlatformTime::Seconds() - ExecBegin;
+
+	// Read cursor if no errors occured
+	if (!mongoc_cursor_error(cursor, &error))
+	{
+		if (mongoc_cursor_next(cursor, &doc))
+		{
+			const bool bFound = GetBinaryPose(doc, MetaIdx, Pose);
+			if (bOutFound)
+			{
+				*bOutFound = bFound;
+			}
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+	}
+	double CursorReadDuration = FPlatformTime::Seconds() - ExecBegin - QueryDuration;
+
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(pipeline);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor=[%f], total=[%f] seconds..;"),
+		*FString(__func__), __LINE__, QueryDuration, CursorReadDuration, FPlatformTime::Seconds() - ExecBegin);
+#endif
+	return Pose;
+}
+
+// Get the poses of the individual between the given timestamps
+TArray<FTransform> FSLMongoQueryDBHandler::GetIndividualTrajectoryCompact(const FString& Id, float StartTs, float EndTs, float DeltaT, bool* bOutFound) const
+{
+	TArray<FTransform> Trajectory;
+	if (bOutFound)
+	{
+		*bOutFound = false;
+	}
+	const int32 MetaIdx = GetMetaIdx(Id);
+	if (MetaIdx == INDEX_NONE)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not find %s in the meta collection.."), *FString(__FUNCTION__), __LINE__, *Id);
+		return Trajectory;
+	}
+
+#if SL_WITH_LIBMONGO_C
+	double ExecBegin = FPlatformTime::Seconds();
+
+	bson_error_t error;
+	const bson_t *doc;
+	mongoc_cursor_t *cursor;
+	bson_t *pipeline;
+
+	pipeline = BCON_NEW("pipeline", "[",
+		"{",
+			"$match",
+			"{",
+				"timestamp",
+				"{",
+					"$gte", BCON_DOUBLE(StartTs),
+					"$lte", BCON_DOUBLE(EndTs),
+				"}",
+				FSLWorldStateBinaryFormat::IndividualsIdxKey, BCON_INT32(MetaIdx),
+			"}",
+		"}",
+		"{",
+			"$sort",
+			"{",
+				"timestamp", BCON_INT32(1),
+			"}",
+		"}",
+		"{",
+			"$project",
+			"{",
+				"_id", BCON_INT32(0),
+				"timestamp", BCON_INT32(1),
+				FSLWorldStateBinaryFormat::IndividualsBinKey, BCON_INT32(1),
+			"}",
+		"}",
+		"]");
+	pipeline = AppendSamplingStages(pipeline, "timestamp", StartTs, DeltaT);
+
+	cursor = mongoc_collection_aggregate(
+		collection, MONGOC_QUERY_NONE, pipeline, NULL, NULL);
+	double QueryDuration = FPlatformTime::Seconds() - ExecBegin;
+
+	// Read cursor if no errors occured (the frames are already downsampled on the server)
+	if (!mongoc_cursor_error(cursor, &error))
+	{
+		while (mongoc_cursor_next(cursor, &doc))
+		{
+			FTransform Pose;
+			if (GetBinaryPose(doc, MetaIdx, Pose))
+			{
+				Trajectory.Add(Pose);
+			}
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+	}
+	double CursorReadDuration = FPlatformTime::Seconds() - ExecBegin - QueryDuration;
+
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(pipeline);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor=[%f], total=[%f] seconds, Num=[%d]..;"),
+		*FString(__func__), __LINE__, QueryDuration, CursorReadDuration, FPlatformTime::Seconds() - ExecBegin, Trajectory.Num());
+#endif
+	if (Trajectory.Num() == 0)
+	{
+		Trajectory.Add(GetIndividualPoseAtCompact(Id, StartTs, bOutFound));
+	}
+	else if (bOutFound)
+	{
+		*bOutFound = true;
+	}
+	return Trajectory;
+}
+
+// Get skeletal individual pose
+TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIndividualPoseAtCompact(const FString& Id, float Ts, bool* bOutFound) const
+{
+	TPair<FTransform, TMap<int32, FTransform>> SkeletalPosePair;
+	if (bOutFound)
+	{
+		*bOutFound = false;
+	}
+	const int32 MetaIdx = GetMetaIdx(Id);
+	if (MetaIdx == INDEX_NONE)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not find %s in the meta collection.."), *FString(__FUNCTION__), __LINE__, *Id);
+		return SkeletalPosePair;
+	}
+
+#if SL_WITH_LIBMONGO_C	
+	double ExecBegin = FPlatformTime::Seconds();
+
+	bson_error_t error;
+	const bson_t *doc;
+	mongoc_cursor_t *cursor;
+	bson_t *pipeline;
+
+	pipeline = BCON_NEW("pipeline", "[",
+		"{",
+			"$match",
+			"{",
+				"timestamp", "{", "$lte", BCON_DOUBLE(Ts), "}",
+				FSLWorldStateBinaryFormat::SkelIndividualsIdxKey, BCON_INT32(MetaIdx),
+			"}",
+		"}",
+		"{",
+			"$sort",
+			"{",
+				"timestamp", BCON_INT32(-1),
+			"}",
+		"}",
+		"{",
+			"$limit", BCON_INT32(1),
+		"}",
+		"{",
+			"$project",
+			"{",
+				"_id", BCON_INT32(0),
+				"timestamp", BCON_INT32(1),
+				FSLWorldStateBinaryFormat::SkelIndividualsBinKey, BCON_INT32(1),
+			"}",
+		"}",
+		"]");
+
+	cursor = mongoc_collection_aggregate(
+		collection, MONGOC_QUERY_NONE, pipeline, NULL, NULL);
+	double QueryDuration = FPlatformTime::Seconds() - ExecBegin;
+
+	// Read cursor if no errors occured
+	if (!mongoc_cursor_error(cursor, &error))
+	{
+		if (mongoc_cursor_next(cursor, &doc))
+		{
+			const bool bFound = GetBinarySkeletalPose(doc, MetaIdx, SkeletalPosePair);
+			if (bOutFound)
+			{
+				*bOutFound = bFound;
+			}
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+	}
+	double CursorReadDuration = FPlatformTime::Seconds() - ExecBegin - QueryDuration;
+
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(pipeline);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor=[%f], total=[%f] seconds..;"),
+		*FString(__func__), __LINE__, QueryDuration, CursorReadDuration, FPlatformTime::Seconds() - ExecBegin);
+#endif
+	return SkeletalPosePair;
+}
+
+// Get skeletal individual trajectory
+TArray<TPair<FTransform, TMap<int32, FTransform>>> FSLMongoQueryDBHandler::GetSkeletalIndividualTrajectoryCompact(const FString& Id, float StartTs, float EndTs, float DeltaT, const TArray<int32>& BoneIndexes, bool* bOutFound) const
+{
+	TArray<TPair<FTransform, TMap<int32, FTransform>>> SkeletalTrajectoryPair;
+	if (bOutFound)
+	{
+		*bOutFound = false;
+	}
+	const int32 MetaIdx = GetMetaIdx(Id);
+	if (MetaIdx == INDEX_NONE)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not find %s in the meta collection.."), *FString(__FUNCTION__), __LINE__, *Id);
+		return SkeletalTrajectoryPair;
+	}
+
+#if SL_WITH_LIBMONGO_C
+	double ExecBegin = FPlatformTime::Seconds();
+
+	bson_error_t error;
+	const bson_t *doc;
+	mongoc_cursor_t *cursor;
+	bson_t *pipeline;
+
+	pipeline = BCON_NEW("pipeline", "[",
+		"{",
+			"$match",
+			"{",
+				"timestamp",
+				"{",
+					"$gte", BCON_DOUBLE(StartTs),
+					"$lte", BCON_DOUBLE(EndTs),
+				"}",
+				FSLWorldStateBinaryFormat::SkelIndividualsIdxKey, BCON_INT32(MetaIdx),
+			"}",
+		"}",
+		"{",
+			"$sort",
+			"{",
+				"timestamp", BCON_INT32(1),
+			"}",
+		"}",
+		"{",
+			"$project",
+			"{",
+				"_id", BCON_INT32(0),
+				"timestamp", BCON_INT32(1),
+				FSLWorldStateBinaryFormat::SkelIndividualsBinKey, BCON_INT32(1),
+			"}",
+		"}",
+		"]");
+	pipeline = AppendSamplingStages(pipeline, "timestamp", StartTs, DeltaT);
+
+	cursor = mongoc_collection_aggregate(
+		collection, MONGOC_QUERY_NONE, pipeline, NULL, NULL);
+	double QueryDuration = FPlatformTime::Seconds() - ExecBegin;
+
+	// Read cursor if no errors occured (the frames are already downsampled on the server, the bones are filtered while decoding)
+	if (!mongoc_cursor_error(cursor, &error))
+	{
+		while (mongoc_cursor_next(cursor, &doc))
+		{
+			TPair<FTransform, TMap<int32, FTransform>> SkeletalPosePair;
+			if (GetBinarySkeletalPose(doc, MetaIdx, SkeletalPosePair, &BoneIndexes))
+			{
+				SkeletalTrajectoryPair.Add(SkeletalPosePair);
+			}
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+	}
+	double CursorReadDuration = FPlatformTime::Seconds() - ExecBegin - QueryDuration;
+
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(pipeline);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor=[%f], total=[%f] seconds, Num=[%d]..;"),
+		*FString(__func__), __LINE__, QueryDuration, CursorReadDuration, FPlatformTime::Seconds() - ExecBegin, SkeletalTrajectoryPair.Num());
+#endif
+	if (SkeletalTrajectoryPair.Num() == 0)
+	{
+		SkeletalTrajectoryPair.Add(GetSkeletalIndividualPoseAtCompact(Id, StartTs, bOutFound));
+	}
+	else if (bOutFound)
+	{
+		*bOutFound = true;
+	}
+	return SkeletalTrajectoryPair;
+}
+
+// Check if the collection frames are written with the compact binary schema
+bool FSLMongoQueryDBHandler::DetectCompactBinarySchema()
+{
+	bool bRetVal = false;
+#if SL_WITH_LIBMONGO_C
+	bson_t* filter;
+	bson_t* opts;
+	const bson_t* doc;
+	mongoc_cursor_t* cursor;
+
+	filter = BCON_NEW("schema", BCON_INT32(FSLWorldStateBinaryFormat::SchemaVersion));
+	opts = BCON_NEW("limit", BCON_INT64(1), "projection", "{", "_id", BCON_INT32(1), "}");
+	cursor = mongoc_collection_find_with_opts(collection, filter, opts, NULL);
+	bRetVal = mongoc_cursor_next(cursor, &doc);
+
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(opts);
+	bson_destroy(filter);
+#endif // SL_WITH_LIBMONGO_C
+	return bRetVal;
+}
+
+// Load the individual ids from the meta collection (the position in the array is the compact schema index)
+bool FSLMongoQueryDBHandler::LoadMetaIndividualIds()
+{
+	MetaIndividualIds.Empty();
+	MetaIdToIdx.Empty();
+#if SL_WITH_LIBMONGO_C
+	bson_t* filter;
+	const bson_t* doc;
+	mongoc_cursor_t* cursor;
+
+	filter = BCON_NEW("type_id", BCON_UTF8("individuals"));
+	cursor = mongoc_collection_find_with_opts(meta_collection, filter, NULL, NULL);
+	if (mongoc_cursor_next(cursor, &doc))
+	{
+		bson_iter_t iter;
+		bson_iter_t individuals_iter;
+		if (bson_iter_init_find(&iter, doc, "individuals") && bson_iter_recurse(&iter, &individuals_iter))
+		{
+			while (bson_iter_next(&individuals_iter))
+			{
+				FString Id;
+				bson_iter_t individual_iter;
+				if (bson_iter_recurse(&individuals_iter, &individual_iter) && bson_iter_find(&individual_iter, "id"))
+				{
+					Id = FString(UTF8_TO_TCHAR(bson_iter_utf8(&individual_iter, NULL)));
+				}
+				MetaIdToIdx.Add(Id, MetaIndividualIds.Num());
+				MetaIndividualIds.Add(Id);
+			}
+		}
+	}
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(filter);
+#endif // SL_WITH_LIBMONGO_C
+	return MetaIndividualIds.Num() > 0;
+}
+
+// Get the meta index of the individual (INDEX_NONE if not found)
+int32 FSLMongoQueryDBHandler::GetMetaIdx(const FString& Id) const
+{
+	if (const int32* MetaIdx = MetaIdToIdx.Find(Id))
+	{
+		return *MetaIdx;
+	}
+	return INDEX_NONE;
+}
+
+/* Helpers */
+#if SL_WITH_LIBMONGO_C
+// Get the binary blob data from the document
+bool FSLMongoQueryDBHandler::GetBinaryData(const bson_t* doc, const char* key, const uint8*& OutData, const uint8*& OutEnd) const
+{
+	bson_iter_t iter;
+	if (bson_iter_init_find(&iter, doc, key) && BSON_ITER_HOLDS_BINARY(&iter))
+	{
+		bson_subtype_t subtype;
+		uint32_t len = 0;
+		const uint8_t* data = NULL;
+		bson_iter_binary(&iter, &subtype, &len, &data);
+		OutData = data;
+		OutEnd = data + len;
+		return data != NULL;
+	}
+	return false;
+}
+
+// Get the pose of the individual with the given meta index from the binary blob
+bool FSLMongoQueryDBHandler::GetBinaryPose(const bson_t* doc, int32 MetaIdx, FTransform& OutPose) const
+{
+	const uint8* Data = nullptr;
+	const uint8* End = nullptr;
+	if (!GetBinaryData(doc, FSLWorldStateBinaryFormat::IndividualsBinKey, Data, End))
+	{
+		return false;
+	}
+
+	int32 CurrMetaIdx;
+	while (FSLWorldStateBinaryFormat::ReadInt(Data, End, CurrMetaIdx))
+	{
+		if (CurrMetaIdx == MetaIdx)
+		{
+			FTransform StoredPose;
+			if (FSLWorldStateBinaryFormat::ReadPose(Data, End, StoredPose))
+			{
+				OutPose = ToEnginePose(StoredPose);
+				return true;
+			}
+			return false;
+		}
+		if (!FSLWorldStateBinaryFormat::Skip(Data, End, FSLWorldStateBinaryFormat::PoseSize))
+		{
+			return false;
+		}
+	}
+	return false;
+}
+
+// Get the skeletal pose of the individual with the given meta index from the binary blob
+bool FSLMongoQueryDBHandler::GetBinarySkeletalPose(const bson_t* doc, int32 MetaIdx, TPair<FTransform, TMap<int32, FTransform>>& OutSkeletalPose,
+	const TArray<int32>* BoneIndexes) const
+{
+	const uint8* Data = nullptr;
+	const uint8* End = nullptr;
+	if (!GetBinaryData(doc, FSLWorldStateBinaryFormat::SkelIndividualsBinKey, Data, End))
+	{
+		return false;
+	}
+
+	int32 CurrMetaIdx;
+	int32 NumBones;
+	FTransform StoredPose;
+	while (FSLWorldStateBinaryFormat::ReadInt(Data, End, CurrMetaIdx))
+	{
+		if (!FSLWorldStateBinaryFormat::ReadPose(Data, End, StoredPose)
+			|| !FSLWorldStateBinaryFormat::ReadInt(Data, End, NumBones))
+		{
+			return false;
+		}
+
+		if (CurrMetaIdx != MetaIdx)
+		{
+			if (!FSLWorldStateBinaryFormat::Skip(Data, End, NumBones * FSLWorldStateBinaryFormat::IndividualRecordSize))
+			{
+				return false;
+			}
+			continue;
+		}
+
+		const bool bFilterBones = BoneIndexes && BoneIndexes->Num() > 0;
+		OutSkeletalPose.Key = ToEnginePose(StoredPose);
+		OutSkeletalPose.Value.Reserve(bFilterBones ? BoneIndexes->Num() : NumBones);
+		int32 BoneIndex;
+		for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+		{
+			if (!FSLWorldStateBinaryFormat::ReadInt(Data, End, BoneIndex)
+				|| !FSLWorldStateBinaryFormat::ReadPose(Data, End, StoredPose))
+			{
+				return false;
+			}
+			if (!bFilterBones || BoneIndexes->Contains(BoneIndex))
+			{
+				OutSkeletalPose.Value.Emplace(BoneIndex, ToEnginePose(StoredPose));
+			}
+		}
+		return true;
+	}
+	return false;
+}
+
+// Get all the individual poses (keyed by the meta index) from the binary blob
+void FSLMongoQueryDBHandler::GetBinaryFrame(const bson_t* doc, TArray<TPair<int32, FTransform>>& OutPoses) const
+{
+	const uint8* Data = nullptr;
+	const uint8* End = nullptr;
+	if (!GetBinaryData(doc, FSLWorldStateBinaryFormat::IndividualsBinKey, Data, End))
+	{
+		return;
+	}
+
+	OutPoses.Reserve(OutPoses.Num() + (End - Data) / FSLWorldStateBinaryFormat::IndividualRecordSize);
+	int32 MetaIdx;
+	FTransform StoredPose;
+	while (FSLWorldStateBinaryFormat::ReadInt(Data, End, MetaIdx)
+		&& FSLWorldStateBinaryFormat::ReadPose(Data, End, StoredPose))
+	{
+		if (MetaIndividualIds.IsValidIndex(MetaIdx))
+		{
+			OutPoses.Emplace(MetaIdx, ToEnginePose(StoredPose));
+		}
+	}
+}
+
+// Append the server side filtering stages to the aggregation pipeline (the input pipeline is destroyed):
+// keep only the given bones and the first sample of every DeltaT time bucket
+bson_t* FSLMongoQueryDBHandler::AppendSamplingStages(bson_t* pipeline, const char* TsKey, float StartTs, float DeltaT, const TArray<int32>* BoneIndexes) const
+{
+	const bool bFilterBones = BoneIndexes && BoneIndexes->Num() > 0;
+	if (DeltaT <= 0.f && !bFilterBones)
+	{
+		return pipeline;
+	}
+
+	bson_t* sampled_pipeline = bson_new();
+	bson_t stages_arr;
+	char idx_str[16];
+	const char* idx_key;
+	uint32_t NumStages = 0;
+	BSON_APPEND_ARRAY_BEGIN(sampled_pipeline, "pipeline", &stages_arr);
+
+	// Copy the query stages
+	bson_iter_t iter;
+	bson_iter_t stages_iter;
+	if (bson_iter_init_find(&iter, pipeline, "pipeline") && bson_iter_recurse(&iter, &stages_iter))
+	{
+		while (bson_iter_next(&stages_iter))
+		{
+			uint32_t len = 0;
+			const uint8_t* data = NULL;
+			bson_t stage;
+			bson_iter_document(&stages_iter, &len, &data);
+			if (data && bson_init_static(&stage, data, len))
+			{
+				bson_uint32_to_string(NumStages++, &idx_key, idx_str, sizeof idx_str);
+				bson_append_document(&stages_arr, idx_key, -1, &stage);
+			}
+		}
+	}
+
+	// Keep only the requested bones
+	if (bFilterBones)
+	{
+		bson_t* bone_idx_arr = bson_new();
+		for (int32 Idx = 0; Idx < BoneIndexes->Num(); ++Idx)
+		{
+			bson_uint32_to_string(Idx, &idx_key, idx_str, sizeof idx_str);
+			BSON_APPEND_INT32(bone_idx_arr, idx_key, (*BoneIndexes)[Idx]);
+		}
+
+		bson_t* bones_stage = BCON_NEW(
+			"$addFields",
+			"{",
+				"bones",
+				"{",
+					"$filter",
+					"{",
+						"input", BCON_UTF8("$bones"),
+						"as", BCON_UTF8("bone"),
+						"cond", "{", "$in", "[", BCON_UTF8("$$bone.idx"), BCON_ARRAY(bone_idx_arr), "]", "}",
+					"}",
+				"}",
+			"}");
+		bson_uint32_to_string(NumStages++, &idx_key, idx_str, sizeof idx_str);
+		bson_append_document(&stages_arr, idx_key, -1, bones_stage);
+		bson_destroy(bones_stage);
+		bson_destroy(bone_idx_arr);
+	}
+
+	// First sample of every time bucket (the query stages sort the samples by their timestamps)
+	if (DeltaT > 0.f)
+	{
+		const FString TsField = FString(TEXT("$")) + UTF8_TO_TCHAR(TsKey);
+		bson_t* group_stage = BCON_NEW(
+			"$group",
+			"{",
+				"_id",
+				"{",
+					"$floor",
+					"{",
+						"$divide", "[", "{", "$subtract", "[", BCON_UTF8(TCHAR_TO_UTF8(*TsField)), BCON_DOUBLE(StartTs), "]", "}", BCON_DOUBLE(DeltaT), "]",
+					"}",
+				"}",
+				"sample", "{", "$first", BCON_UTF8("$$ROOT"), "}",
+			"}");
+		bson_t* replace_stage = BCON_NEW("$replaceRoot", "{", "newRoot", BCON_UTF8("$sample"), "}");
+		bson_t* sort_stage = BCON_NEW("$sort", "{", TsKey, BCON_INT32(1), "}");
+
+		bson_uint32_to_string(NumStages++, &idx_key, idx_str, sizeof idx_str);
+		bson_append_document(&stages_arr, idx_key, -1, group_stage);
+		bson_uint32_to_string(NumStages++, &idx_key, idx_str, sizeof idx_str);
+		bson_append_document(&stages_arr, idx_key, -1, replace_stage);
+		bson_uint32_to_string(NumStages++, &idx_key, idx_str, sizeof idx_str);
+		bson_append_document(&stages_arr, idx_key, -1, sort_stage);
+
+		bson_destroy(group_stage);
+		bson_destroy(replace_stage);
+		bson_destroy(sort_stage);
+	}
+
+	bson_append_array_end(sampled_pipeline, &stages_arr);
+	bson_destroy(pipeline);
+	return sampled_pipeline;
+}
+
+// Convert the stored pose to the engine frame
+FTransform FSLMongoQueryDBHandler::ToEnginePose(const FTransform& StoredPose) const
+{
+#if SL_WITH_ROS_CONVERSIONS
+	return FConversions::ROSToU(StoredPose);
+#else
+	return StoredPose;
+#endif // SL_WITH_ROS_CONVERSIONS	
+}
+
 // Get the pose data from document
 FTransform FSLMongoQueryDBHandler::GetPose(const bson_t* doc) const
 {
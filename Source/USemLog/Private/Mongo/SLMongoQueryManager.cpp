@@ -14,6 +14,7 @@ ASLMongoQueryManager::ASLMongoQueryManager()
 	bConnected = false;
 	bTaskSet = false;
 	bEpisodeSet = false;
+	ServerPort = 0;
 
 #if WITH_EDITORONLY_DATA
 	// Make manager sprite smaller (used to easily find the actor in the world)
@@ -128,7 +129,7 @@ ASLMongoQueryManager::ASLMongoQueryManager()
 //#endif // WITH_EDITOR
 
 // Connect to the server
-bool ASLMongoQueryManager::Connect(const FString& ServerIp, uint16 ServerPort)
+bool ASLMongoQueryManager::Connect(const FString& InServerIp, uint16 InServerPort)
 {
 	if (bConnected)
 	{
@@ -136,8 +137,11 @@ bool ASLMongoQueryManager::Connect(const FString& ServerIp, uint16 ServerPort)
 			*FString(__FUNCTION__), __LINE__);
 		return true;
 	}
-	if (DBHandler.Connect(ServerIp, ServerPort))
+	if (DBHandler.Connect(InServerIp, InServerPort))
 	{
+		QueryCache.SetMaxSize(static_cast<int64>(QueryCacheMaxSizeMb) * 1024 * 1024);
+		ServerIp = InServerIp;
+		ServerPort = InServerPort;
 		bConnected = true;
 	}
 	else
@@ -153,8 +157,15 @@ void ASLMongoQueryManager::Disconnect()
 	if (bConnected)
 	{
 		DBHandler.Disconnect();
+		if (bUseQueryCache)
+		{
+			UE_LOG(LogTemp, Log, TEXT("%s::%d Query cache: %s"), *FString(__FUNCTION__), __LINE__, *QueryCache.GetStatsString());
+		}
+		QueryCache.Empty();
 		TaskId = "";
 		EpisodeId = "";
+		ServerIp = "";
+		ServerPort = 0;
 		
 		bConnected = false;
 		bTaskSet = false;
@@ -218,6 +229,17 @@ bool ASLMongoQueryManager::SetEpisode(const FString& InEpisodeId)
 	return bEpisodeSet;
 }
 
+// Build the trajectory collection of the active episode (offline indexing)
+bool ASLMongoQueryManager::BuildTrajectoryCollection(float BucketDuration)
+{
+	if (!bEpisodeSet)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Set episode first.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+	return DBHandler.BuildTrajectoryCollection(BucketDuration);
+}
+
 /* Queries */
 // Get the individual pose with task and episode init
 FTransform ASLMongoQueryManager::GetIndividualPoseAt(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts)
@@ -250,7 +272,24 @@ FTransform ASLMongoQueryManager::GetIndividualPoseAt(const FString& InEpisodeId,
 // Get the individual pose
 FTransform ASLMongoQueryManager::GetIndividualPoseAt(const FString& IndividualId, float Ts) const
 {
-	return DBHandler.GetIndividualPoseAt(IndividualId, Ts);
+	if (!bUseQueryCache || !bEpisodeSet)
+	{
+		return DBHandler.GetIndividualPoseAt(IndividualId, Ts);
+	}
+
+	const FString Key = FSLMongoQueryCache::MakeKey(TEXT("pose"), TaskId, EpisodeId, IndividualId, Ts);
+	TArray<FTransform> Poses;
+	if (!QueryCache.FindPoses(Key, Poses))
+	{
+		// Failed lookups are not cached, a transient database error would otherwise stick until disconnect
+		bool bFound = false;
+		Poses.Add(DBHandler.GetIndividualPoseAt(IndividualId, Ts, &bFound));
+		if (bFound)
+		{
+			QueryCache.AddPoses(Key, Poses);
+		}
+	}
+	return Poses[0];
 }
 
 // Get the individual trajectory with task and episode init
@@ -284,7 +323,23 @@ TArray<FTransform> ASLMongoQueryManager::GetIndividualTrajectory(const FString&
 // Get the individual trajectory 
 TArray<FTransform> ASLMongoQueryManager::GetIndividualTrajectory(const FString& IndividualId, float StartTs, float EndTs, float DeltaT) const
 {
-	return DBHandler.GetIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT);
+	if (!bUseQueryCache || !bEpisodeSet)
+	{
+		return DBHandler.GetIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT);
+	}
+
+	const FString Key = FSLMongoQueryCache::MakeKey(TEXT("traj"), TaskId, EpisodeId, IndividualId, StartTs, EndTs, DeltaT);
+	TArray<FTransform> Trajectory;
+	if (!QueryCache.FindPoses(Key, Trajectory))
+	{
+		bool bFound = false;
+		Trajectory = DBHandler.GetIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT, &bFound);
+		if (bFound)
+		{
+			QueryCache.AddPoses(Key, Trajectory);
+		}
+	}
+	return Trajectory;
 }
 
 
@@ -319,15 +374,31 @@ TPair<FTransform, TMap<int32, FTransform>> ASLMongoQueryManager::GetSkeletalIndi
 // Get skeletal individual pose
 TPair<FTransform, TMap<int32, FTransform>> ASLMongoQueryManager::GetSkeletalIndividualPoseAt(const FString& IndividualId, float Ts) const
 {
-	return DBHandler.GetSkeletalIndividualPoseAt(IndividualId, Ts);	
+	if (!bUseQueryCache || !bEpisodeSet)
+	{
+		return DBHandler.GetSkeletalIndividualPoseAt(IndividualId, Ts);
+	}
+
+	const FString Key = FSLMongoQueryCache::MakeKey(TEXT("skelpose"), TaskId, EpisodeId, IndividualId, Ts);
+	TArray<TPair<FTransform, TMap<int32, FTransform>>> SkeletalPoses;
+	if (!QueryCache.FindSkeletalPoses(Key, SkeletalPoses))
+	{
+		bool bFound = false;
+		SkeletalPoses.Add(DBHandler.GetSkeletalIndividualPoseAt(IndividualId, Ts, &bFound));
+		if (bFound)
+		{
+			QueryCache.AddSkeletalPoses(Key, SkeletalPoses);
+		}
+	}
+	return SkeletalPoses[0];
 }
 
 // Get skeletal individual trajectory with task and episode init
-TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkeletalIndividualTrajectory(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT)
+TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkeletalIndividualTrajectory(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT, const TArray<int32>& BoneIndexes)
 {
 	if (SetTask(InTaskId))
 	{
-		return GetSkeletalIndividualTrajectory(InEpisodeId, IndividualId, StartTs, EndTs, DeltaT);
+		return GetSkeletalIndividualTrajectory(InEpisodeId, IndividualId, StartTs, EndTs, DeltaT, BoneIndexes);
 	}
 	else
 	{
@@ -338,11 +409,11 @@ TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkel
 }
 
 // Get skeletal individual trajectoru with episode init
-TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkeletalIndividualTrajectory(const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT)
+TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkeletalIndividualTrajectory(const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT, const TArray<int32>& BoneIndexes)
 {
 	if (SetEpisode(InEpisodeId))
 	{
-		return GetSkeletalIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT);
+		return GetSkeletalIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT, BoneIndexes);
 	}
 	else
 	{
@@ -352,13 +423,33 @@ TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkel
 }
 
 // Get skeletal individual trajectory
-TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkeletalIndividualTrajectory(const FString& IndividualId, float StartTs, float EndTs, float DeltaT) const
+TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkeletalIndividualTrajectory(const FString& IndividualId, float StartTs, float EndTs, float DeltaT, const TArray<int32>& BoneIndexes) const
 {
-	return DBHandler.GetSkeletalIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT);
+	if (!bUseQueryCache || !bEpisodeSet)
+	{
+		return DBHandler.GetSkeletalIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT, BoneIndexes);
+	}
+
+	FString Key = FSLMongoQueryCache::MakeKey(TEXT("skeltraj"), TaskId, EpisodeId, IndividualId, StartTs, EndTs, DeltaT);
+	for (const int32 BoneIndex : BoneIndexes)
+	{
+		Key.Appendf(TEXT("|%d"), BoneIndex);
+	}
+	TArray<TPair<FTransform, TMap<int32, FTransform>>> SkeletalTrajectory;
+	if (!QueryCache.FindSkeletalPoses(Key, SkeletalTrajectory))
+	{
+		bool bFound = false;
+		SkeletalTrajectory = DBHandler.GetSkeletalIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT, BoneIndexes, &bFound);
+		if (bFound)
+		{
+			QueryCache.AddSkeletalPoses(Key, SkeletalTrajectory);
+		}
+	}
+	return SkeletalTrajectory;
 }
 
 // Get the episode data with task and episode init
-TArray<TPair<float, TMap<FString, FTransform>>> ASLMongoQueryManager::GetEpisodeData(const FString& InTaskId, const FString& InEpisodeId)
+FSLMongoEpisodeData ASLMongoQueryManager::GetEpisodeData(const FString& InTaskId, const FString& InEpisodeId)
 {
 	if (SetTask(InTaskId))
 	{
@@ -367,12 +458,12 @@ TArray<TPair<float, TMap<FString, FTransform>>> ASLMongoQueryManager::GetEpisode
 	else
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set task: %s .."), *FString(__FUNCTION__), __LINE__, *InTaskId);
-		return TArray<TPair<float, TMap<FString, FTransform>>>();
+		return FSLMongoEpisodeData();
 	}
 }
 
 // Get the episode data with episode init
-TArray<TPair<float, TMap<FString, FTransform>>> ASLMongoQueryManager::GetEpisodeData(const FString& InEpisodeId)
+FSLMongoEpisodeData ASLMongoQueryManager::GetEpisodeData(const FString& InEpisodeId)
 {
 	if (SetEpisode(InEpisodeId))
 	{
@@ -381,12 +472,12 @@ TArray<TPair<float, TMap<FString, FTransform>>> ASLMongoQueryManager::GetEpisode
 	else
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set episode: %s .."), *FString(__FUNCTION__), __LINE__, *InEpisodeId);
-		return TArray<TPair<float, TMap<FString, FTransform>>>();
+		return FSLMongoEpisodeData();
 	}
 }
 
 // Get the episode data
-TArray<TPair<float, TMap<FString, FTransform>>> ASLMongoQueryManager::GetEpisodeData() const
+FSLMongoEpisodeData ASLMongoQueryManager::GetEpisodeData() const
 {
 	return DBHandler.GetEpisodeData();
 }
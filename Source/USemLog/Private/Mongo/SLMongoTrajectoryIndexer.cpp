@@ -0,0 +1,349 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Mongo/SLMongoTrajectoryIndexer.h"
+#include "Runtime/SLWorldStateBinaryFormat.h"
+
+#if SL_WITH_LIBMONGO_C
+// Build (or rebuild) the trajectory collection of the world state collection
+bool FSLMongoTrajectoryIndexer::Build(mongoc_database_t* database, mongoc_collection_t* collection, bool bCompactBinary,
+	const TArray<FString>& MetaIndividualIds, float BucketDuration)
+{
+	if (!database || !collection)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Invalid database or collection.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+	if (BucketDuration <= 0.f)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Invalid bucket duration (%f).."), *FString(__FUNCTION__), __LINE__, BucketDuration);
+		return false;
+	}
+
+	double ExecBegin = FPlatformTime::Seconds();
+	const FString TrajCollName = GetCollectionName(FString(UTF8_TO_TCHAR(mongoc_collection_get_name(collection))));
+
+	const bool bBuilt = bCompactBinary
+		? BuildFromCompactBinary(database, collection, TrajCollName, MetaIndividualIds, BucketDuration)
+		: BuildFromDocuments(collection, TrajCollName, BucketDuration);
+	if (!bBuilt)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not build the trajectory collection %s.."),
+			*FString(__FUNCTION__), __LINE__, *TrajCollName);
+		return false;
+	}
+
+	mongoc_collection_t* traj_collection = mongoc_database_get_collection(database, TCHAR_TO_UTF8(*TrajCollName));
+	const bool bIndexed = CreateIndexes(traj_collection);
+	mongoc_collection_destroy(traj_collection);
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Built the trajectory collection %s in [%f] seconds..;"),
+		*FString(__FUNCTION__), __LINE__, *TrajCollName, FPlatformTime::Seconds() - ExecBegin);
+	return bIndexed;
+}
+
+// Group the documents schema individuals into buckets on the server ($unwind, $group, $out)
+bool FSLMongoTrajectoryIndexer::BuildFromDocuments(mongoc_collection_t* collection, const FString& TrajCollName, float BucketDuration)
+{
+	bson_error_t error;
+	const bson_t *doc;
+	mongoc_cursor_t *cursor;
+	bson_t *pipeline;
+	bson_t opts;
+
+	// The samples are pushed in the sorted input order, the output collection is replaced atomically
+	pipeline = BCON_NEW("pipeline", "[",
+		"{",
+			"$match",
+			"{",
+				"timestamp", "{", "$exists", BCON_BOOL(true), "}",
+				"individuals", "{", "$exists", BCON_BOOL(true), "}",
+			"}",
+		"}",
+		"{",
+			"$sort",
+			"{",
+				"timestamp", BCON_INT32(1),
+			"}",
+		"}",
+		"{",
+			"$unwind", BCON_UTF8("$individuals"),
+		"}",
+		"{",
+			"$group",
+			"{",
+				"_id",
+				"{",
+					"id", BCON_UTF8("$individuals.id"),
+					"bucket", "{", "$floor", "{", "$divide", "[", BCON_UTF8("$timestamp"), BCON_DOUBLE(BucketDuration), "]", "}", "}",
+				"}",
+				"start_ts", "{", "$min", BCON_UTF8("$timestamp"), "}",
+				"end_ts", "{", "$max", BCON_UTF8("$timestamp"), "}",
+				"samples",
+				"{",
+					"$push",
+					"{",
+						"ts", BCON_UTF8("$timestamp"),
+						"loc", BCON_UTF8("$individuals.loc"),
+						"quat", BCON_UTF8("$individuals.quat"),
+					"}",
+				"}",
+			"}",
+		"}",
+		"{",
+			"$project",
+			"{",
+				"_id", BCON_INT32(0),
+				"id", BCON_UTF8("$_id.id"),
+				"start_ts", BCON_INT32(1),
+				"end_ts", BCON_INT32(1),
+				"samples", BCON_INT32(1),
+			"}",
+		"}",
+		"{",
+			"$out", BCON_UTF8(TCHAR_TO_UTF8(*TrajCollName)),
+		"}",
+		"]");
+
+	bson_init(&opts);
+	BSON_APPEND_BOOL(&opts, "allowDiskUse", true);
+
+	cursor = mongoc_collection_aggregate(
+		collection, MONGOC_QUERY_NONE, pipeline, &opts, NULL);
+
+	// The pipeline is executed when the cursor is iterated ($out returns no documents)
+	while (mongoc_cursor_next(cursor, &doc)) {}
+
+	bool bSuccess = true;
+	if (mongoc_cursor_error(cursor, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		bSuccess = false;
+	}
+
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(pipeline);
+	bson_destroy(&opts);
+	return bSuccess;
+}
+
+// Decode the compact binary frames and upload the buckets (one open bucket per individual)
+bool FSLMongoTrajectoryIndexer::BuildFromCompactBinary(mongoc_database_t* database, mongoc_collection_t* collection, const FString& TrajCollName,
+	const TArray<FString>& MetaIndividualIds, float BucketDuration)
+{
+	if (MetaIndividualIds.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d The compact binary schema requires the meta individual ids.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	bson_error_t error;
+	const bson_t *doc;
+	mongoc_cursor_t *cursor;
+	bson_t *filter;
+	bson_t *opts;
+
+	// Remove any previous build
+	mongoc_collection_t* traj_collection = mongoc_database_get_collection(database, TCHAR_TO_UTF8(*TrajCollName));
+	if (!mongoc_collection_drop(traj_collection, &error) && error.code != 26 /*NamespaceNotFound*/)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not drop %s, err.:%s;"),
+			*FString(__func__), __LINE__, *TrajCollName, *FString(error.message));
+	}
+
+	filter = BCON_NEW("timestamp", "{", "$exists", BCON_BOOL(true), "}");
+	opts = BCON_NEW(
+		"sort", "{", "timestamp", BCON_INT32(1), "}",
+		"projection", "{",
+			"_id", BCON_INT32(0),
+			"timestamp", BCON_INT32(1),
+			FSLWorldStateBinaryFormat::IndividualsBinKey, BCON_INT32(1),
+		"}",
+		"allowDiskUse", BCON_BOOL(true));
+	cursor = mongoc_collection_find_with_opts(collection, filter, opts, NULL);
+
+	// Open bucket of every individual (meta index), flushed when a sample of a later bucket is read
+	TArray<int64> BucketIndexes;
+	TArray<TArray<TPair<double, FTransform>>> BucketSamples;
+	BucketIndexes.Init(INDEX_NONE, MetaIndividualIds.Num());
+	BucketSamples.SetNum(MetaIndividualIds.Num());
+
+	mongoc_bulk_operation_t* bulk = mongoc_collection_create_bulk_operation_with_opts(traj_collection, NULL);
+	int32 NumBuckets = 0;
+	while (mongoc_cursor_next(cursor, &doc))
+	{
+		bson_iter_t iter;
+		if (!bson_iter_init_find(&iter, doc, "timestamp"))
+		{
+			continue;
+		}
+		const double Ts = bson_iter_double(&iter);
+		const int64 BucketIdx = FMath::FloorToInt(Ts / BucketDuration);
+
+		if (!bson_iter_init_find(&iter, doc, FSLWorldStateBinaryFormat::IndividualsBinKey) || !BSON_ITER_HOLDS_BINARY(&iter))
+		{
+			continue;
+		}
+		bson_subtype_t subtype;
+		uint32_t len = 0;
+		const uint8_t* data = NULL;
+		bson_iter_binary(&iter, &subtype, &len, &data);
+
+		const uint8* Data = data;
+		const uint8* End = data + len;
+		int32 MetaIdx;
+		FTransform StoredPose;
+		while (FSLWorldStateBinaryFormat::ReadInt(Data, End, MetaIdx)
+			&& FSLWorldStateBinaryFormat::ReadPose(Data, End, StoredPose))
+		{
+			if (!MetaIndividualIds.IsValidIndex(MetaIdx) || MetaIndividualIds[MetaIdx].IsEmpty())
+			{
+				continue;
+			}
+			if (BucketIndexes[MetaIdx] != BucketIdx)
+			{
+				if (BucketSamples[MetaIdx].Num() > 0)
+				{
+					AddBucket(bulk, MetaIndividualIds[MetaIdx], BucketSamples[MetaIdx]);
+					BucketSamples[MetaIdx].Reset();
+					NumBuckets++;
+				}
+				BucketIndexes[MetaIdx] = BucketIdx;
+			}
+			BucketSamples[MetaIdx].Emplace(Ts, StoredPose);
+		}
+	}
+
+	bool bSuccess = true;
+	if (mongoc_cursor_error(cursor, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		bSuccess = false;
+	}
+
+	// Flush the remaining open buckets
+	for (int32 MetaIdx = 0; MetaIdx < BucketSamples.Num(); ++MetaIdx)
+	{
+		if (BucketSamples[MetaIdx].Num() > 0)
+		{
+			AddBucket(bulk, MetaIndividualIds[MetaIdx], BucketSamples[MetaIdx]);
+			NumBuckets++;
+		}
+	}
+
+	if (bSuccess && NumBuckets > 0)
+	{
+		bson_t reply;
+		if (!mongoc_bulk_operation_execute(bulk, &reply, &error))
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+				*FString(__func__), __LINE__, *FString(error.message));
+			bSuccess = false;
+		}
+		bson_destroy(&reply);
+	}
+
+	mongoc_bulk_operation_destroy(bulk);
+	mongoc_cursor_destroy(cursor);
+	mongoc_collection_destroy(traj_collection);
+	bson_destroy(filter);
+	bson_destroy(opts);
+	return bSuccess;
+}
+
+// Append the bucket document to the bulk operation
+void FSLMongoTrajectoryIndexer::AddBucket(mongoc_bulk_operation_t* bulk, const FString& Id, const TArray<TPair<double, FTransform>>& Samples)
+{
+	bson_t* doc = bson_new();
+	BSON_APPEND_UTF8(doc, "id", TCHAR_TO_UTF8(*Id));
+	BSON_APPEND_DOUBLE(doc, "start_ts", Samples[0].Key);
+	BSON_APPEND_DOUBLE(doc, "end_ts", Samples.Last().Key);
+
+	bson_t samples_arr;
+	char idx_str[16];
+	const char* idx_key;
+	BSON_APPEND_ARRAY_BEGIN(doc, "samples", &samples_arr);
+	for (int32 Idx = 0; Idx < Samples.Num(); ++Idx)
+	{
+		const FVector Loc = Samples[Idx].Value.GetLocation();
+		const FQuat Quat = Samples[Idx].Value.GetRotation();
+
+		bson_t sample_obj;
+		bson_t loc_obj;
+		bson_t quat_obj;
+		bson_uint32_to_string(Idx, &idx_key, idx_str, sizeof idx_str);
+		BSON_APPEND_DOCUMENT_BEGIN(&samples_arr, idx_key, &sample_obj);
+			BSON_APPEND_DOUBLE(&sample_obj, "ts", Samples[Idx].Key);
+			BSON_APPEND_DOCUMENT_BEGIN(&sample_obj, "loc", &loc_obj);
+				BSON_APPEND_DOUBLE(&loc_obj, "x", Loc.X);
+				BSON_APPEND_DOUBLE(&loc_obj, "y", Loc.Y);
+				BSON_APPEND_DOUBLE(&loc_obj, "z", Loc.Z);
+			bson_append_document_end(&sample_obj, &loc_obj);
+			BSON_APPEND_DOCUMENT_BEGIN(&sample_obj, "quat", &quat_obj);
+				BSON_APPEND_DOUBLE(&quat_obj, "x", Quat.X);
+				BSON_APPEND_DOUBLE(&quat_obj, "y", Quat.Y);
+				BSON_APPEND_DOUBLE(&quat_obj, "z", Quat.Z);
+				BSON_APPEND_DOUBLE(&quat_obj, "w", Quat.W);
+			bson_append_document_end(&sample_obj, &quat_obj);
+		bson_append_document_end(&samples_arr, &sample_obj);
+	}
+	bson_append_array_end(doc, &samples_arr);
+
+	mongoc_bulk_operation_insert(bulk, doc);
+	bson_destroy(doc);
+}
+
+// Create the compound indexes of the trajectory collection
+bool FSLMongoTrajectoryIndexer::CreateIndexes(mongoc_collection_t* traj_collection)
+{
+	bson_t* index_command;
+	bson_error_t error;
+
+	bson_t idx_id_start;
+	bson_init(&idx_id_start);
+	BSON_APPEND_INT32(&idx_id_start, "id", 1);
+	BSON_APPEND_INT32(&idx_id_start, "start_ts", 1);
+	char* idx_id_start_str = mongoc_collection_keys_to_index_string(&idx_id_start);
+
+	bson_t idx_id_end;
+	bson_init(&idx_id_end);
+	BSON_APPEND_INT32(&idx_id_end, "id", 1);
+	BSON_APPEND_INT32(&idx_id_end, "end_ts", 1);
+	char* idx_id_end_str = mongoc_collection_keys_to_index_string(&idx_id_end);
+
+	index_command = BCON_NEW("createIndexes",
+		BCON_UTF8(mongoc_collection_get_name(traj_collection)),
+		"indexes",
+		"[",
+			"{",
+				"key",
+				BCON_DOCUMENT(&idx_id_start),
+				"name",
+				BCON_UTF8(idx_id_start_str),
+			"}",
+			"{",
+				"key",
+				BCON_DOCUMENT(&idx_id_end),
+				"name",
+				BCON_UTF8(idx_id_end_str),
+			"}",
+		"]");
+
+	bool bSuccess = true;
+	if (!mongoc_collection_write_command_with_opts(traj_collection, index_command, NULL/*opts*/, NULL/*reply*/, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Create indexes err.: %s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		bSuccess = false;
+	}
+
+	bson_destroy(index_command);
+	bson_destroy(&idx_id_start);
+	bson_destroy(&idx_id_end);
+	bson_free(idx_id_start_str);
+	bson_free(idx_id_end_str);
+	return bSuccess;
+}
+#endif //SL_WITH_LIBMONGO_C
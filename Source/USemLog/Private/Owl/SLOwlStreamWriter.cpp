@@ -0,0 +1,95 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Owl/SLOwlStreamWriter.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+// Ctor
+FSLOwlStreamWriter::FSLOwlStreamWriter() : NumBytesWritten(0)
+{
+}
+
+// Dtor, closes the document if still open
+FSLOwlStreamWriter::~FSLOwlStreamWriter()
+{
+	Close();
+}
+
+// Create the file and write the beginning of the document (everything before the individuals)
+bool FSLOwlStreamWriter::Open(const FString& InFilePath, const FSLOwlDoc& Doc, bool bOverwrite)
+{
+	if (IsOpen())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is already open.."), *FString(__FUNCTION__), __LINE__, *FilePath);
+		return false;
+	}
+
+	FilePath = InFilePath;
+	FPaths::RemoveDuplicateSlashes(FilePath);
+	if (FPaths::FileExists(FilePath) && !bOverwrite)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s already exists and should not be overwritten.."),
+			*FString(__FUNCTION__), __LINE__, *FilePath);
+		return false;
+	}
+
+	Archive.Reset(IFileManager::Get().CreateFileWriter(*FilePath));
+	if (!IsOpen())
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not create %s.."), *FString(__FUNCTION__), __LINE__, *FilePath);
+		return false;
+	}
+
+	NumBytesWritten = 0;
+	Indent = INDENT_STEP;
+	Buffer.Reset(FlushThreshold);
+	Doc.AppendBeginningToString(Buffer);
+	Flush();
+	return true;
+}
+
+// Write the current individuals of the document, then remove them from it
+void FSLOwlStreamWriter::WriteIndividuals(FSLOwlDoc& Doc)
+{
+	for (const auto& Individual : Doc.Individuals)
+	{
+		WriteNode(Individual);
+	}
+	Doc.Individuals.Empty();
+}
+
+// Write a node as a child of the root node
+void FSLOwlStreamWriter::WriteNode(const FSLOwlNode& Node)
+{
+	if (IsOpen())
+	{
+		Node.AppendToString(Buffer, Indent);
+		Flush();
+	}
+}
+
+// Close the root node and the file
+void FSLOwlStreamWriter::Close()
+{
+	if (IsOpen())
+	{
+		FSLOwlDoc::AppendEndToString(Buffer);
+		Flush(true);
+		Archive->Close();
+		Archive.Reset();
+		UE_LOG(LogTemp, Log, TEXT("%s::%d Wrote %lld bytes to %s.."), *FString(__FUNCTION__), __LINE__, NumBytesWritten, *FilePath);
+	}
+}
+
+// Write the buffer to the file if it reached the threshold (or always if forced)
+void FSLOwlStreamWriter::Flush(bool bForce)
+{
+	if (Buffer.Len() > 0 && (bForce || Buffer.Len() >= FlushThreshold))
+	{
+		FTCHARToUTF8 Utf8Str(*Buffer, Buffer.Len());
+		Archive->Serialize(const_cast<ANSICHAR*>(Utf8Str.Get()), Utf8Str.Length());
+		NumBytesWritten += Utf8Str.Length();
+		Buffer.Reset(FlushThreshold);
+	}
+}
@@ -190,7 +190,7 @@ void ASLLoggerManager::Init()
 			return;
 		}
 
-		SymbolicLogger->Init(SymbolicLoggerParams, LocationParams);
+		SymbolicLogger->Init(SymbolicLoggerParams, LocationParams, DBServerParams);
 		if (!SymbolicLogger->IsInit())
 		{
 			UE_LOG(LogTemp, Error, TEXT("%s::%d Logger manager (%s) symbolic logger (%s) could not be init, aborting init.."),
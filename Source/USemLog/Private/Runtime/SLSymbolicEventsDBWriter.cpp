@@ -0,0 +1,518 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Runtime/SLSymbolicEventsDBWriter.h"
+#include "Events/ISLEvent.h"
+#include "Individuals/Type/SLBaseIndividual.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+
+// Ctor
+FSLSymbolicEventsDBWriter::FSLSymbolicEventsDBWriter() :
+	WorkEvent(nullptr),
+	Thread(nullptr)
+{
+	bIsInit = false;
+	bStopRequested = false;
+	BulkMaxNum = 100;
+	BulkMaxDuration = 1.0;
+	BulkNum = 0;
+	BulkStartTime = 0.0;
+#if SL_WITH_LIBMONGO_C
+	uri = nullptr;
+	client = nullptr;
+	database = nullptr;
+	collection = nullptr;
+	write_concern = nullptr;
+	bulk_op = nullptr;
+#endif //SL_WITH_LIBMONGO_C
+}
+
+// Dtor
+FSLSymbolicEventsDBWriter::~FSLSymbolicEventsDBWriter()
+{
+	Finish();
+}
+
+// Connect to the database and set the write options (called on the game thread before start)
+bool FSLSymbolicEventsDBWriter::Init(const FSLSymbolicLoggerParams& InLoggerParameters,
+	const FSLLoggerLocationParams& InLocationParameters,
+	const FSLLoggerDBServerParams& InDBServerParameters)
+{
+	if (bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Events writer is already initialized.."), *FString(__FUNCTION__), __LINE__);
+		return true;
+	}
+
+#if SL_WITH_LIBMONGO_C
+	BulkMaxNum = FMath::Max(InLoggerParameters.EventsBulkMaxNum, 1);
+	BulkMaxDuration = FMath::Max(InLoggerParameters.EventsBulkMaxDurationMs, 1) / 1000.0;
+	EpisodeId = InLocationParameters.EpisodeId;
+
+	if (!Connect(InLocationParameters.TaskId, InLocationParameters.EpisodeId + ".events",
+		InDBServerParameters.Ip, InDBServerParameters.Port, InLocationParameters.bOverwrite))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Events writer could not connect to the database.."), *FString(__FUNCTION__), __LINE__);
+		Disconnect();
+		return false;
+	}
+
+	write_concern = mongoc_write_concern_new();
+	mongoc_write_concern_set_w(write_concern, 1);
+
+	bIsInit = true;
+	return true;
+#else
+	UE_LOG(LogTemp, Error, TEXT("%s::%d SL_WITH_LIBMONGO_C flag is 0, aborting.."),
+		*FString(__func__), __LINE__);
+	return false;
+#endif //SL_WITH_LIBMONGO_C
+}
+
+// Start the writer thread
+bool FSLSymbolicEventsDBWriter::Start()
+{
+	if (Thread != nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Writer thread is already running.."), *FString(__FUNCTION__), __LINE__);
+		return true;
+	}
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Writer is not connected, call init first.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	bStopRequested = false;
+	WorkEvent = FPlatformProcess::GetSynchEventFromPool();
+	Thread = FRunnableThread::Create(this, TEXT("SL_SymbolicEventsDBWriter"), 0, TPri_BelowNormal);
+	if (Thread == nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not create the events writer thread.."), *FString(__FUNCTION__), __LINE__);
+		FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+		WorkEvent = nullptr;
+		return false;
+	}
+	return true;
+}
+
+// Signal the thread to write the remaining events and stop, blocks until done
+void FSLSymbolicEventsDBWriter::Stop()
+{
+	if (Thread == nullptr)
+	{
+		return;
+	}
+
+	bStopRequested = true;
+	WorkEvent->Trigger();
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
+
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	WorkEvent = nullptr;
+}
+
+// Stop the thread, create the indexes and disconnect
+void FSLSymbolicEventsDBWriter::Finish()
+{
+	if (!bIsInit)
+	{
+		return;
+	}
+
+	Stop();
+
+#if SL_WITH_LIBMONGO_C
+	// Events enqueued without a running thread
+	WriteQueuedEvents();
+	FlushBulk();
+#endif //SL_WITH_LIBMONGO_C
+
+	CreateIndexes();
+	Disconnect();
+	bIsInit = false;
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Events writer finished, %d events written, %d failed.."),
+		*FString(__FUNCTION__), __LINE__, NumWritten.GetValue(), NumFailed.GetValue());
+}
+
+// Copy the event and queue it for writing (game thread)
+void FSLSymbolicEventsDBWriter::Enqueue(const ISLEvent& Event)
+{
+	if (!bIsInit)
+	{
+		return;
+	}
+
+	FSLSymbolicEventRecord Record;
+	Record.Id = Event.Id;
+	Record.Type = Event.TypeName();
+	Record.StartTime = Event.StartTime;
+	Record.EndTime = Event.EndTime;
+	Record.PairId = Event.GetPairId();
+
+	TArray<TPair<FString, USLBaseIndividual*>> Participants;
+	Event.GetParticipants(Participants);
+	Record.Participants.Reserve(Participants.Num());
+	for (const auto& RoleIndividualPair : Participants)
+	{
+		if (RoleIndividualPair.Value)
+		{
+			FSLSymbolicEventParticipant Participant;
+			Participant.Role = RoleIndividualPair.Key;
+			Participant.Id = RoleIndividualPair.Value->GetIdValue();
+			Participant.Class = RoleIndividualPair.Value->GetClassValue();
+			Record.Participants.Emplace(MoveTemp(Participant));
+		}
+	}
+
+	EventQueue.Enqueue(MoveTemp(Record));
+	if (WorkEvent)
+	{
+		WorkEvent->Trigger();
+	}
+}
+
+// Writer thread loop
+uint32 FSLSymbolicEventsDBWriter::Run()
+{
+	// Wake up often enough to respect the bulk duration
+	const uint32 WaitMs = FMath::Clamp<uint32>(BulkMaxDuration * 1000.0, 1, 100);
+	while (!bStopRequested)
+	{
+		WriteQueuedEvents();
+
+#if SL_WITH_LIBMONGO_C
+		if (bulk_op != nullptr && FPlatformTime::Seconds() - BulkStartTime > BulkMaxDuration)
+		{
+			FlushBulk();
+		}
+#endif //SL_WITH_LIBMONGO_C
+
+		WorkEvent->Wait(WaitMs);
+	}
+
+	// Make sure nothing is lost at the end of the episode
+	WriteQueuedEvents();
+#if SL_WITH_LIBMONGO_C
+	FlushBulk();
+#endif //SL_WITH_LIBMONGO_C
+	return 0;
+}
+
+// Write all the queued events
+void FSLSymbolicEventsDBWriter::WriteQueuedEvents()
+{
+#if SL_WITH_LIBMONGO_C
+	FSLSymbolicEventRecord Record;
+	while (EventQueue.Dequeue(Record))
+	{
+		// The failed events are counted where they fail (insert or bulk execute)
+		AddToBulk(Record);
+	}
+#endif //SL_WITH_LIBMONGO_C
+}
+
+// Connect to the db
+bool FSLSymbolicEventsDBWriter::Connect(const FString& DBName, const FString& CollName, const FString& ServerIp,
+	uint16 ServerPort, bool bOverwrite)
+{
+#if SL_WITH_LIBMONGO_C
+	// Required to initialize libmongoc's internals
+	mongoc_init();
+
+	// Stores any error that might appear during the connection
+	bson_error_t error;
+
+	// Safely create a MongoDB URI object from the given string
+	FString Uri = TEXT("mongodb://") + ServerIp + TEXT(":") + FString::FromInt(ServerPort);
+	uri = mongoc_uri_new_with_error(TCHAR_TO_UTF8(*Uri), &error);
+	if (!uri)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s; [Uri=%s]"),
+			*FString(__func__), __LINE__, *FString(error.message), *Uri);
+		return false;
+	}
+
+	// Create a new client instance
+	client = mongoc_client_new_from_uri(uri);
+	if (!client)
+	{
+		return false;
+	}
+
+	// Register the application name so we can track it in the profile logs on the server
+	mongoc_client_set_appname(client, TCHAR_TO_UTF8(*("SL_SymbolicEventsWriter_" + CollName)));
+
+	// Get a handle on the database
+	database = mongoc_client_get_database(client, TCHAR_TO_UTF8(*DBName));
+
+	// Check if the collection already exists
+	if (mongoc_database_has_collection(database, TCHAR_TO_UTF8(*CollName), &error))
+	{
+		if (bOverwrite)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Events collection %s already exists, will be removed and overwritten.."),
+				*FString(__func__), __LINE__, *CollName);
+			mongoc_collection_t* existing_coll = mongoc_database_get_collection(database, TCHAR_TO_UTF8(*CollName));
+			const bool bDropped = mongoc_collection_drop(existing_coll, &error);
+			mongoc_collection_destroy(existing_coll);
+			if (!bDropped)
+			{
+				UE_LOG(LogTemp, Error, TEXT("%s::%d Could not drop collection, err.:%s;"),
+					*FString(__func__), __LINE__, *FString(error.message));
+				return false;
+			}
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Events collection %s already exists and should not be overwritten, skipping events logging.."),
+				*FString(__func__), __LINE__, *CollName);
+			return false;
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Creating collection %s.%s .."),
+			*FString(__func__), __LINE__, *DBName, *CollName);
+	}
+
+	collection = mongoc_client_get_collection(client, TCHAR_TO_UTF8(*DBName), TCHAR_TO_UTF8(*CollName));
+
+	// Check server. Ping the "admin" database
+	bson_t* server_ping_cmd;
+	server_ping_cmd = BCON_NEW("ping", BCON_INT32(1));
+	if (!mongoc_client_command_simple(client, "admin", server_ping_cmd, NULL, NULL, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Check server err.: %s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		bson_destroy(server_ping_cmd);
+		return false;
+	}
+
+	bson_destroy(server_ping_cmd);
+	return true;
+#else
+	UE_LOG(LogTemp, Error, TEXT("%s::%d SL_WITH_LIBMONGO_C flag is 0, aborting.."),
+		*FString(__func__), __LINE__);
+	return false;
+#endif //SL_WITH_LIBMONGO_C
+}
+
+// Disconnect and clean db connection
+void FSLSymbolicEventsDBWriter::Disconnect()
+{
+#if SL_WITH_LIBMONGO_C
+	if (bulk_op)
+	{
+		mongoc_bulk_operation_destroy(bulk_op);
+		bulk_op = nullptr;
+	}
+	if (write_concern)
+	{
+		mongoc_write_concern_destroy(write_concern);
+		write_concern = nullptr;
+	}
+	if (collection)
+	{
+		mongoc_collection_destroy(collection);
+		collection = nullptr;
+	}
+	if (database)
+	{
+		mongoc_database_destroy(database);
+		database = nullptr;
+	}
+	if (client)
+	{
+		mongoc_client_destroy(client);
+		client = nullptr;
+	}
+	if (uri)
+	{
+		mongoc_uri_destroy(uri);
+		uri = nullptr;
+	}
+	mongoc_cleanup();
+#endif //SL_WITH_LIBMONGO_C
+}
+
+// Create indexes on the inserted events
+bool FSLSymbolicEventsDBWriter::CreateIndexes() const
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d Not connected to the db, could not create indexes.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+#if SL_WITH_LIBMONGO_C
+	bson_t* index_command;
+	bson_error_t error;
+
+	bson_t idx_start;
+	bson_init(&idx_start);
+	BSON_APPEND_INT32(&idx_start, "start_time", 1);
+	char* idx_start_chr = mongoc_collection_keys_to_index_string(&idx_start);
+
+	bson_t idx_end;
+	bson_init(&idx_end);
+	BSON_APPEND_INT32(&idx_end, "end_time", 1);
+	char* idx_end_chr = mongoc_collection_keys_to_index_string(&idx_end);
+
+	bson_t idx_participants_id;
+	bson_init(&idx_participants_id);
+	BSON_APPEND_INT32(&idx_participants_id, "participants.id", 1);
+	char* idx_participants_id_chr = mongoc_collection_keys_to_index_string(&idx_participants_id);
+
+	bson_t idx_pair_id;
+	bson_init(&idx_pair_id);
+	BSON_APPEND_INT32(&idx_pair_id, "pair_id", 1);
+	char* idx_pair_id_chr = mongoc_collection_keys_to_index_string(&idx_pair_id);
+
+	index_command = BCON_NEW("createIndexes",
+			BCON_UTF8(mongoc_collection_get_name(collection)),
+			"indexes",
+			"[",
+				"{",
+					"key", BCON_DOCUMENT(&idx_start),
+					"name", BCON_UTF8(idx_start_chr),
+				"}",
+				"{",
+					"key", BCON_DOCUMENT(&idx_end),
+					"name", BCON_UTF8(idx_end_chr),
+				"}",
+				"{",
+					"key", BCON_DOCUMENT(&idx_participants_id),
+					"name", BCON_UTF8(idx_participants_id_chr),
+				"}",
+				"{",
+					"key", BCON_DOCUMENT(&idx_pair_id),
+					"name", BCON_UTF8(idx_pair_id_chr),
+				"}",
+			"]");
+
+	bool bRetVal = true;
+	if (!mongoc_collection_write_command_with_opts(collection, index_command, NULL/*opts*/, NULL/*reply*/, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Create indexes err.: %s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		bRetVal = false;
+	}
+
+	// Clean up
+	bson_destroy(index_command);
+	bson_destroy(&idx_start);
+	bson_destroy(&idx_end);
+	bson_destroy(&idx_participants_id);
+	bson_destroy(&idx_pair_id);
+	bson_free(idx_start_chr);
+	bson_free(idx_end_chr);
+	bson_free(idx_participants_id_chr);
+	bson_free(idx_pair_id_chr);
+	return bRetVal;
+#endif //SL_WITH_LIBMONGO_C
+
+	return false;
+}
+
+#if SL_WITH_LIBMONGO_C
+// Add the event to the current bulk operation
+bool FSLSymbolicEventsDBWriter::AddToBulk(const FSLSymbolicEventRecord& Record)
+{
+	// Start a new bulk operation
+	if (bulk_op == nullptr)
+	{
+		bson_t bulk_opts;
+		bson_init(&bulk_opts);
+		BSON_APPEND_BOOL(&bulk_opts, "ordered", false);
+		mongoc_write_concern_append(write_concern, &bulk_opts);
+		bulk_op = mongoc_collection_create_bulk_operation_with_opts(collection, &bulk_opts);
+		bson_destroy(&bulk_opts);
+		BulkNum = 0;
+		BulkStartTime = FPlatformTime::Seconds();
+	}
+
+	bson_t* event_doc;
+	event_doc = bson_new();
+
+	BSON_APPEND_UTF8(event_doc, "id", TCHAR_TO_UTF8(*Record.Id));
+	BSON_APPEND_UTF8(event_doc, "type", TCHAR_TO_UTF8(*Record.Type));
+	BSON_APPEND_UTF8(event_doc, "episode_id", TCHAR_TO_UTF8(*EpisodeId));
+	BSON_APPEND_DOUBLE(event_doc, "start_time", Record.StartTime);
+	BSON_APPEND_DOUBLE(event_doc, "end_time", Record.EndTime);
+	BSON_APPEND_INT64(event_doc, "pair_id", static_cast<int64_t>(Record.PairId));
+
+	bson_t participants_arr;
+	uint32_t arr_idx = 0;
+	BSON_APPEND_ARRAY_BEGIN(event_doc, "participants", &participants_arr);
+	for (const auto& Participant : Record.Participants)
+	{
+		bson_t participant_obj;
+		char idx_str[16];
+		const char* idx_key;
+
+		bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
+		BSON_APPEND_DOCUMENT_BEGIN(&participants_arr, idx_key, &participant_obj);
+			BSON_APPEND_UTF8(&participant_obj, "role", TCHAR_TO_UTF8(*Participant.Role));
+			BSON_APPEND_UTF8(&participant_obj, "id", TCHAR_TO_UTF8(*Participant.Id));
+			BSON_APPEND_UTF8(&participant_obj, "class", TCHAR_TO_UTF8(*Participant.Class));
+		bson_append_document_end(&participants_arr, &participant_obj);
+		arr_idx++;
+	}
+	bson_append_array_end(event_doc, &participants_arr);
+
+	// The document is copied into the bulk operation
+	bson_error_t error;
+	const bool bInserted = mongoc_bulk_operation_insert_with_opts(bulk_op, event_doc, NULL, &error);
+	bson_destroy(event_doc);
+	if (!bInserted)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.: %s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		NumFailed.Increment();
+		return false;
+	}
+	BulkNum++;
+
+	if (BulkNum >= BulkMaxNum)
+	{
+		return FlushBulk();
+	}
+	return true;
+}
+
+// Execute and clear the current bulk operation
+bool FSLSymbolicEventsDBWriter::FlushBulk()
+{
+	if (bulk_op == nullptr)
+	{
+		return true;
+	}
+
+	bool bRetVal = true;
+	bson_t reply;
+	bson_error_t error;
+	if (!mongoc_bulk_operation_execute(bulk_op, &reply, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Bulk insert of %d events err.: %s"),
+			*FString(__func__), __LINE__, BulkNum, *FString(error.message));
+		NumFailed.Add(BulkNum);
+		bRetVal = false;
+	}
+	else
+	{
+		NumWritten.Add(BulkNum);
+	}
+
+	// Clean up
+	bson_destroy(&reply);
+	mongoc_bulk_operation_destroy(bulk_op);
+	bulk_op = nullptr;
+	BulkNum = 0;
+	return bRetVal;
+}
+#endif //SL_WITH_LIBMONGO_C
@@ -128,7 +128,8 @@ void ASLSymbolicLogger::EndPlay(const EEndPlayReason::Type EndPlayReason)
 
 // Init logger (called when the logger is synced externally)
 void ASLSymbolicLogger::Init(const FSLSymbolicLoggerParams& InLoggerParameters,
-	const FSLLoggerLocationParams& InLocationParameters)
+	const FSLLoggerLocationParams& InLocationParameters,
+	const FSLLoggerDBServerParams& InDBServerParameters)
 {
 	if (bUseIndependently)
 	{
@@ -139,6 +140,7 @@ void ASLSymbolicLogger::Init(const FSLSymbolicLoggerParams& InLoggerParameters,
 
 	LoggerParameters = InLoggerParameters;
 	LocationParameters = InLocationParameters;
+	DBServerParameters = InDBServerParameters;
 	InitImpl();
 }
 
@@ -286,6 +288,15 @@ void ASLSymbolicLogger::StartImpl()
 		return;
 	}
 
+	// Events are written to the experiment file as they finish
+	OpenExperimentWriter();
+
+	// Events are streamed to the database as they finish
+	if (LoggerParameters.bWriteEventsToDB)
+	{
+		StartEventsDBWriter();
+	}
+
 	// Start handlers
 	for (auto& EvHandler : EventHandlers)
 	{
@@ -402,16 +413,9 @@ void ASLSymbolicLogger::FinishImpl(bool bForced)
 	//}
 	//ContainerMonitors.Empty();
 
-	// Create the experiment owl doc	
+	// Finish the experiment owl doc (the events are already written)
 	if (ExperimentDoc.IsValid())
 	{
-		TArray<FString> SubActionIds;		
-		for (const auto& Ev : FinishedEvents)
-		{
-			Ev->AddToOwlDoc(ExperimentDoc.Get());
-			SubActionIds.Add(Ev->Id);
-		}
-
 		// Add stored unique timepoints to doc
 		ExperimentDoc->AddTimepointIndividuals();
 
@@ -419,7 +423,21 @@ void ASLSymbolicLogger::FinishImpl(bool bForced)
 		//ExperimentDoc->AddObjectIndividuals();
 
 		// Add experiment individual to doc	(metadata)	
-		ExperimentDoc->AddExperimentIndividual(SubActionIds, LocationParameters.SemanticMapId, LocationParameters.TaskId);
+		ExperimentDoc->AddExperimentIndividual(FinishedEventIds, LocationParameters.SemanticMapId, LocationParameters.TaskId);
+
+		if (ExperimentWriter.IsValid())
+		{
+			ExperimentWriter->WriteIndividuals(*ExperimentDoc);
+			ExperimentWriter->Close();
+		}
+		ExperimentDoc->Individuals.Empty();
+	}
+
+	// Write the remaining events to the database and create the indexes
+	if (EventsDBWriter.IsValid())
+	{
+		EventsDBWriter->Finish();
+		EventsDBWriter.Reset();
 	}
 
 	// Write events to file
@@ -473,7 +491,28 @@ void ASLSymbolicLogger::SemanticEventFinishedCallback(TSharedPtr<ISLEvent> Event
 {
 	//GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Yellow, FString::Printf(TEXT("%s::%d %s"), *FString(__func__), __LINE__, *Event->ToString()));
 	//UE_LOG(LogTemp, Error, TEXT(">> %s::%d %s"), *FString(__func__), __LINE__, *Event->ToString());
-	FinishedEvents.Add(Event);
+	if (LoggerParameters.bWriteTimelines)
+	{
+		FinishedEvents.Add(Event);
+	}
+	FinishedEventIds.Add(Event->Id);
+
+	// Write the event individual to the experiment file
+	if (ExperimentDoc.IsValid())
+	{
+		Event->AddToOwlDoc(ExperimentDoc.Get());
+		if (ExperimentWriter.IsValid())
+		{
+			ExperimentWriter->WriteIndividuals(*ExperimentDoc);
+		}
+		ExperimentDoc->Individuals.Empty();
+	}
+
+	// Queue the event for the database writer
+	if (EventsDBWriter.IsValid())
+	{
+		EventsDBWriter->Enqueue(*Event);
+	}
 
 #if SL_WITH_ROSBRIDGE
 	if (LoggerParameters.bPublishToROS)
@@ -486,7 +525,7 @@ void ASLSymbolicLogger::SemanticEventFinishedCallback(TSharedPtr<ISLEvent> Event
 // Write data to file
 void ASLSymbolicLogger::WriteToFile()
 {
-	const FString DirPath = FPaths::ProjectDir() + "/SL/Tasks/" + LocationParameters.TaskId /*+ TEXT("/Episodes/")*/ + "/";
+	const FString DirPath = GetTaskDirPath();
 
 	// Write events timelines to file
 	if (LoggerParameters.bWriteTimelines)
@@ -503,8 +542,7 @@ void ASLSymbolicLogger::WriteToFile()
 	}
 
 
-	// Write experiment owl to file
-	FSLOwlExperimentStatics::WriteToFile(ExperimentDoc, DirPath, LocationParameters.bOverwrite);
+	// The experiment owl is written as the events finish (see ExperimentWriter)
 
 	//// Write owl data to file
 	//if (ExperimentDoc.IsValid())
@@ -519,6 +557,47 @@ void ASLSymbolicLogger::WriteToFile()
 	//}
 }
 
+// Create the experiment file and write the beginning of the document, the events are written as they finish
+void ASLSymbolicLogger::OpenExperimentWriter()
+{
+	if (!ExperimentDoc.IsValid() || (ExperimentWriter.IsValid() && ExperimentWriter->IsOpen()))
+	{
+		return;
+	}
+
+	ExperimentWriter = MakeShareable(new FSLOwlStreamWriter());
+	const FString FilePath = GetTaskDirPath() + "/" + ExperimentDoc->Id + TEXT("_ED.owl");
+	if (!ExperimentWriter->Open(FilePath, *ExperimentDoc, LocationParameters.bOverwrite))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Symbolic logger (%s) will not write the experiment owl file.."),
+			*FString(__FUNCTION__), __LINE__, *GetName());
+		ExperimentWriter.Reset();
+	}
+}
+
+// Connect and start the writer streaming the finished events to the database
+void ASLSymbolicLogger::StartEventsDBWriter()
+{
+	if (EventsDBWriter.IsValid())
+	{
+		return;
+	}
+
+	EventsDBWriter = MakeShareable(new FSLSymbolicEventsDBWriter());
+	if (!EventsDBWriter->Init(LoggerParameters, LocationParameters, DBServerParameters) || !EventsDBWriter->Start())
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Symbolic logger (%s) will not write the events to the database.."),
+			*FString(__FUNCTION__), __LINE__, *GetName());
+		EventsDBWriter.Reset();
+	}
+}
+
+// Directory of the task files
+FString ASLSymbolicLogger::GetTaskDirPath() const
+{
+	return FPaths::ProjectDir() + "/SL/Tasks/" + LocationParameters.TaskId /*+ TEXT("/Episodes/")*/ + "/";
+}
+
 // Create events doc template
 TSharedPtr<FSLOwlExperiment> ASLSymbolicLogger::CreateEventsDocTemplate(ESLOwlExperimentTemplate TemplateType, const FString& InDocId)
 {
@@ -2,6 +2,8 @@
 // Author: Andrei Haidu (http://haidu.eu)
 
 #include "Runtime/SLWorldStateDBHandler.h"
+#include "Runtime/SLWorldStateMongoSink.h"
+#include "Runtime/SLWorldStateFileSink.h"
 #include "Individuals/SLIndividualManager.h"
 
 #include "Individuals/Type/SLBaseIndividual.h"
@@ -10,411 +12,203 @@
 #include "Individuals/Type/SLVirtualBoneIndividual.h"
 #include "Individuals/Type/SLRobotIndividual.h"
 
-// UUtils
-#if SL_WITH_ROS_CONVERSIONS
-#include "Conversions.h"
-#endif // SL_WITH_ROS_CONVERSIONS
-
-/* DB Write Async Task */
-// Init task
-#if SL_WITH_LIBMONGO_C
-bool FSLWorldStateDBWriterAsyncTask::Init(mongoc_collection_t* in_collection, ASLIndividualManager* Manager, float PoseTolerance, bool bInWriteSparse)
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+
+/* DB Writer */
+// Ctor (the circular queues hold one item less than their capacity)
+FSLWorldStateDBWriter::FSLWorldStateDBWriter(int32 InQueueSize) :
+	SnapshotQueue(FMath::Max(InQueueSize, 1) + 1),
+	FreeQueue(FMath::Max(InQueueSize, 1) + 1),
+	SpareSnapshot(nullptr),
+	WorkEvent(nullptr),
+	Thread(nullptr)
 {
-	IndividualManager = Manager;
-	mongo_collection = in_collection;
-	MinPoseDiff = PoseTolerance;
-	bWriteSparse = bInWriteSparse;
-
-	// Set the write function pointer (first write is without optimization, write all individuals)
-	WriteFunctionPtr = &FSLWorldStateDBWriterAsyncTask::FirstWrite;
-
-	return true;
+	bStopRequested = false;
+	bKeyframeRequested = false;
 }
-#endif //SL_WITH_LIBMONGO_C	
-
-// Do the db writing here
-void FSLWorldStateDBWriterAsyncTask::DoWork()
-{
-	const double StartTime = FPlatformTime::Seconds();
 
-	// Call the write function pointer
-	int32 NumEntries = (this->*WriteFunctionPtr)();
-
-	//double Duration = FPlatformTime::Seconds() - StartTime;
-	//UE_LOG(LogTemp, Warning, TEXT("%s::%d \t\t\t Async work (written %ld entries) duration:\t%f (s)"),
-	//	*FString(__FUNCTION__), __LINE__, NumEntries, Duration);
-}
-
-// First write where all the individuals are written irregardresly of their previous position
-int32 FSLWorldStateDBWriterAsyncTask::FirstWrite()
+// Dtor
+FSLWorldStateDBWriter::~FSLWorldStateDBWriter()
 {
-	// Count the number of entries written to the document (if 0, skip upload)
-	int32 Num = 0;
-
-#if SL_WITH_LIBMONGO_C
-	bson_t* ws_doc;
-	ws_doc = bson_new();
-
-	AddTimestamp(ws_doc);
+	Finish();
 
-	Num += AddAllIndividuals(ws_doc);
-	Num += AddSkeletalIndividals(ws_doc);
-	//Num += AddRobotIndividuals(ws_doc);
-
-	// Write only if there are any entries in the document
-	if (Num > 0)
+	// Clean up any remaining snapshots
+	FSLWorldStateSnapshot* Snapshot = nullptr;
+	while (SnapshotQueue.Dequeue(Snapshot))
 	{
-		UploadDoc(ws_doc);
+		delete Snapshot;
 	}
+	while (FreeQueue.Dequeue(Snapshot))
+	{
+		delete Snapshot;
+	}
+	delete SpareSnapshot;
+	SpareSnapshot = nullptr;
+}
 
-	// Clean up
-	bson_destroy(ws_doc);
-#endif //SL_WITH_LIBMONGO_C	
-
-	// Change the write function pointer to write only individuals that are moving
-	if (bWriteSparse)
+// Set the sink the snapshots are written to (called on the game thread before start)
+bool FSLWorldStateDBWriter::Init(TUniquePtr<ISLWorldStateSink> InSink)
+{
+	if (Thread != nullptr)
 	{
-		WriteFunctionPtr = &FSLWorldStateDBWriterAsyncTask::WriteSparse;
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Writer thread is already running, cannot re-init.."), *FString(__FUNCTION__), __LINE__);
+		return false;
 	}
-	else
+	if (!InSink.IsValid())
 	{
-		WriteFunctionPtr = &FSLWorldStateDBWriterAsyncTask::WriteAll;
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Invalid sink.."), *FString(__FUNCTION__), __LINE__);
+		return false;
 	}
-
-	return Num;
+	Sink = MoveTemp(InSink);
+	return true;
 }
 
-// Write only the indviduals that changed pose
-int32 FSLWorldStateDBWriterAsyncTask::WriteSparse()
+// Start the writer thread
+bool FSLWorldStateDBWriter::Start()
 {
-	// Count the number of entries written to the document (if 0, skip upload)
-	int32 Num = 0;
-
-#if SL_WITH_LIBMONGO_C
-	bson_t* ws_doc;
-	ws_doc = bson_new();
-
-	AddTimestamp(ws_doc);
-
-	Num += AddIndividualsThatMoved(ws_doc);
-	Num += AddSkeletalIndividals(ws_doc);
-	//Num += AddRobotIndividuals(ws_doc);
-
-	// Write only if there are any entries in the document
-	if (Num > 0)
+	if (Thread != nullptr)
 	{
-		UploadDoc(ws_doc);
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Writer thread is already running.."), *FString(__FUNCTION__), __LINE__);
+		return true;
+	}
+	if (!Sink.IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Writer has no sink, call init first.."), *FString(__FUNCTION__), __LINE__);
+		return false;
 	}
 
-	// Clean up
-	bson_destroy(ws_doc);
-#endif //SL_WITH_LIBMONGO_C
-
-	return Num;
+	bStopRequested = false;
+	WorkEvent = FPlatformProcess::GetSynchEventFromPool();
+	Thread = FRunnableThread::Create(this, TEXT("SL_WorldStateDBWriter"), 0, TPri_Normal);
+	if (Thread == nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not create the world state writer thread.."), *FString(__FUNCTION__), __LINE__);
+		FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+		WorkEvent = nullptr;
+		return false;
+	}
+	return true;
 }
 
-// Write all individuals
-int32 FSLWorldStateDBWriterAsyncTask::WriteAll()
+// Signal the thread to write the remaining snapshots and stop, blocks until done
+void FSLWorldStateDBWriter::Stop()
 {
-	// Count the number of entries written to the document (if 0, skip upload)
-	int32 Num = 0;
-
-#if SL_WITH_LIBMONGO_C
-	bson_t* ws_doc;
-	ws_doc = bson_new();
-
-	AddTimestamp(ws_doc);
-
-	Num += AddAllIndividuals(ws_doc);
-	Num += AddSkeletalIndividals(ws_doc);
-	//Num += AddRobotIndividuals(ws_doc);
-
-	// Write only if there are any entries in the document
-	if (Num > 0)
+	if (Thread == nullptr)
 	{
-		UploadDoc(ws_doc);
+		return;
 	}
 
-	// Clean up
-	bson_destroy(ws_doc);
-#endif //SL_WITH_LIBMONGO_C
+	bStopRequested = true;
+	WorkEvent->Trigger();
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
 
-	return Num;
-}
-
-#if SL_WITH_LIBMONGO_C
-// Add timestamp to the bson doc
-void FSLWorldStateDBWriterAsyncTask::AddTimestamp(bson_t* doc)
-{
-	BSON_APPEND_DOUBLE(doc, "timestamp", Timestamp);
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	WorkEvent = nullptr;
 }
 
-// Add all individuals (return the number of individuals added)
-int32 FSLWorldStateDBWriterAsyncTask::AddAllIndividuals(bson_t* doc)
+// Stop the thread and close the sink
+void FSLWorldStateDBWriter::Finish()
 {
-	int32 Num = 0;
-	bson_t arr_obj;
-	uint32_t arr_idx = 0;
-
-	BSON_APPEND_ARRAY_BEGIN(doc, "individuals", &arr_obj);
-	for (const auto& Individual : IndividualManager->GetIndividuals())
+	Stop();
+	if (Sink.IsValid())
 	{
-		Individual->UpdateCachedPose(0.0);
-
-		//// TODO workaround
-		//Individual->SetHasMovedFlag(true);
-
-		bson_t individual_obj;
-		char idx_str[16];
-		const char* idx_key;
-
-		bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
-		BSON_APPEND_DOCUMENT_BEGIN(&arr_obj, idx_key, &individual_obj);
-			// Id
-			BSON_APPEND_UTF8(&individual_obj, "id", TCHAR_TO_UTF8(*Individual->GetIdValue()));			
-			// Pose
-			AddPose(Individual->GetCachedPose(), &individual_obj);
-		bson_append_document_end(&arr_obj, &individual_obj);
-
-		arr_idx++;
-		Num++;
+		Sink->Finish();
+		Sink.Reset();
 	}
-	bson_append_array_end(doc, &arr_obj);
-	return Num;
 }
 
-// Add only the individuals that moved (return the number of individuals added)
-int32 FSLWorldStateDBWriterAsyncTask::AddIndividualsThatMoved(bson_t* doc)
+// Get an empty snapshot (reused from the written ones if available)
+FSLWorldStateSnapshot* FSLWorldStateDBWriter::GetFreeSnapshot()
 {
-	int32 Num = 0;
-
-	bson_t individuals_arr;
-	uint32_t arr_idx = 0;
-
-	BSON_APPEND_ARRAY_BEGIN(doc, "individuals", &individuals_arr);
-	for (const auto& Individual : IndividualManager->GetIndividuals())
+	FSLWorldStateSnapshot* Snapshot = SpareSnapshot;
+	if (Snapshot != nullptr)
 	{
-		if (Individual->UpdateCachedPose(MinPoseDiff))
-		{
-			//// TODO workaround
-			//Individual->SetHasMovedFlag(true);
-
-			bson_t individual_obj;
-			char idx_str[16];
-			const char* idx_key;
-
-			bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
-			BSON_APPEND_DOCUMENT_BEGIN(&individuals_arr, idx_key, &individual_obj);
-				// Id
-				BSON_APPEND_UTF8(&individual_obj, "id", TCHAR_TO_UTF8(*Individual->GetIdValue()));
-				// Pose
-				AddPose(Individual->GetCachedPose(), &individual_obj);
-			bson_append_document_end(&individuals_arr, &individual_obj);
-
-			arr_idx++;
-			Num++;
-		}
+		SpareSnapshot = nullptr;
+		Snapshot->Reset();
+		return Snapshot;
 	}
-	bson_append_array_end(doc, &individuals_arr);
-	return Num;
-}
-
-// Add skeletal individuals (return the number of individuals added)
-int32 FSLWorldStateDBWriterAsyncTask::AddSkeletalIndividals(bson_t* doc)
-{
-	int32 Num = 0;
-	bson_t arr_obj;
-	uint32_t arr_idx = 0;
-
-	BSON_APPEND_ARRAY_BEGIN(doc, "skel_individuals", &arr_obj);
-	for (const auto& SkelIndividual : IndividualManager->GetSkeletalIndividuals())
+	if (FreeQueue.Dequeue(Snapshot))
 	{
-		//// Check if it was marked as "moved" by the previous iterator function
-		//if (SkelIndividual->HasMovedFlagSet())
-		//{
-		//	SkelIndividual->SetHasMovedFlag(false);
-
-			bson_t individual_obj;
-			char idx_str[16];
-			const char* idx_key;
-
-			bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
-			BSON_APPEND_DOCUMENT_BEGIN(&arr_obj, idx_key, &individual_obj);
-				// Id
-				BSON_APPEND_UTF8(&individual_obj, "id", TCHAR_TO_UTF8(*SkelIndividual->GetIdValue()));
-				// Pose
-				AddPose(SkelIndividual->GetCachedPose(), &individual_obj);
-				// Bones
-				AddSkeletalBoneIndividuals(SkelIndividual->GetBoneIndividuals(), SkelIndividual->GetVirtualBoneIndividuals(),
-					&individual_obj);
-				// Constraints
-				//AddSkeletalConstraintIndividuals(SkelIndividual->GetBoneConstraintIndividuals(), &individual_obj);
-			bson_append_document_end(&arr_obj, &individual_obj);
-
-			arr_idx++;
-			Num++;
-		//}
-	}
-	bson_append_array_end(doc, &arr_obj);
-	return Num;
+		Snapshot->Reset();
+		return Snapshot;
+	}
+	return new FSLWorldStateSnapshot();
 }
 
-// Add skeletal bones to the document
-void FSLWorldStateDBWriterAsyncTask::AddSkeletalBoneIndividuals(
-	const TArray<USLBoneIndividual*>& BoneIndividuals,
-	const TArray<USLVirtualBoneIndividual*>& VirtualBoneIndividuals,
-	bson_t* doc)
+// Push the snapshot to the writing queue, returns false and keeps the snapshot for reuse if the queue is full
+bool FSLWorldStateDBWriter::Enqueue(FSLWorldStateSnapshot* Snapshot)
 {
-	bson_t bones_arr;
-	bson_t arr_obj;
-	char idx_str[16];
-	const char* idx_key;
-	uint32_t arr_idx = 0;
-
-	BSON_APPEND_ARRAY_BEGIN(doc, "bones", &bones_arr);
-
-	for (const auto& BI : BoneIndividuals)
+	if (!SnapshotQueue.Enqueue(Snapshot))
 	{
-		bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
-		BSON_APPEND_DOCUMENT_BEGIN(&bones_arr, idx_key, &arr_obj);
-			// Bone index
-			BSON_APPEND_INT32(&arr_obj, "idx", BI->GetBoneIndex());
-			// Bone world pose
-			AddPose(BI->GetCachedPose(), &arr_obj);
-		bson_append_document_end(&bones_arr, &arr_obj);
-		arr_idx++;
-	}
+		Stats.NumDropped.Increment();
 
-	for (const auto& VBI : VirtualBoneIndividuals)
+		// The free queue is only produced by the writer thread, the dropped snapshot is kept on the game thread side
+		if (SpareSnapshot == nullptr)
+		{
+			SpareSnapshot = Snapshot;
+		}
+		else
+		{
+			delete Snapshot;
+		}
+		return false;
+	}
+	Stats.OnEnqueued();
+	if (WorkEvent)
 	{
-		bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
-		BSON_APPEND_DOCUMENT_BEGIN(&bones_arr, idx_key, &arr_obj);
-			// Bone index
-			BSON_APPEND_INT32(&arr_obj, "idx", VBI->GetBoneIndex());
-			// Bone world pose
-			AddPose(VBI->GetCachedPose(), &arr_obj);
-		bson_append_document_end(&bones_arr, &arr_obj);
-		arr_idx++;
+		WorkEvent->Trigger();
 	}
-
-
-	bson_append_array_end(doc, &bones_arr);
-}
-
-// Add skeletal bone constraints to the document
-void FSLWorldStateDBWriterAsyncTask::AddSkeletalConstraintIndividuals(const TArray<USLBoneConstraintIndividual*>& ConstraintIndividuals,
-	bson_t* doc)
-{
+	return true;
 }
 
-// Add robot individuals (return the number of individuals added)
-int32 FSLWorldStateDBWriterAsyncTask::AddRobotIndividuals(bson_t* doc)
+// Writer thread loop
+uint32 FSLWorldStateDBWriter::Run()
 {
-	int32 Num = 0;
-	bson_t arr_obj;
-	uint32_t arr_idx = 0;
-
-	BSON_APPEND_ARRAY_BEGIN(doc, "robo_individuals", &arr_obj);
-	for (const auto& RoboIndividual : IndividualManager->GetRobotIndividuals())
+	while (!bStopRequested)
 	{
-		//// Check if it was marked as "moved" by the previous iterator function
-		//if (RoboIndividual->HasMovedFlagSet())
-		//{
-		//	RoboIndividual->SetHasMovedFlag(false);
-
-			bson_t individual_obj;
-			char idx_str[16];
-			const char* idx_key;
-
-			bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
-			BSON_APPEND_DOCUMENT_BEGIN(&arr_obj, idx_key, &individual_obj);
-				// Id
-				BSON_APPEND_UTF8(&individual_obj, "id", TCHAR_TO_UTF8(*RoboIndividual->GetIdValue()));
-				// Pose
-				AddPose(RoboIndividual->GetCachedPose(), &individual_obj);
-
-				// Links				
+		WriteQueuedSnapshots();
 
-				// Joints
+		Sink->Tick(Stats);
 
-			bson_append_document_end(&arr_obj, &individual_obj);
-
-			arr_idx++;
-			Num++;
-		//}
+		// Sleep until new snapshots are available (timeout as a safety net for missed triggers and time based flushes)
+		WorkEvent->Wait(Sink->GetTickIntervalMs());
 	}
-	bson_append_array_end(doc, &arr_obj);
-	return Num;
+
+	// Make sure nothing is lost at the end of the episode
+	WriteQueuedSnapshots();
+	Sink->Flush(Stats);
+	return 0;
 }
 
-// Add pose document
-void FSLWorldStateDBWriterAsyncTask::AddPose(FTransform Pose, bson_t* doc)
+// Write all the queued snapshots
+void FSLWorldStateDBWriter::WriteQueuedSnapshots()
 {
-#if SL_WITH_ROS_CONVERSIONS
-	FConversions::UToROS(Pose);
-#endif // SL_WITH_ROS_CONVERSIONS
-
-	bson_t child_obj_loc;
-	bson_t child_obj_rot;
-
-	BSON_APPEND_DOCUMENT_BEGIN(doc, "loc", &child_obj_loc);
-	BSON_APPEND_DOUBLE(&child_obj_loc, "x", Pose.GetLocation().X);
-	BSON_APPEND_DOUBLE(&child_obj_loc, "y", Pose.GetLocation().Y);
-	BSON_APPEND_DOUBLE(&child_obj_loc, "z", Pose.GetLocation().Z);
-	bson_append_document_end(doc, &child_obj_loc);
-
-	BSON_APPEND_DOCUMENT_BEGIN(doc, "quat", &child_obj_rot);
-	BSON_APPEND_DOUBLE(&child_obj_rot, "x", Pose.GetRotation().X);
-	BSON_APPEND_DOUBLE(&child_obj_rot, "y", Pose.GetRotation().Y);
-	BSON_APPEND_DOUBLE(&child_obj_rot, "z", Pose.GetRotation().Z);
-	BSON_APPEND_DOUBLE(&child_obj_rot, "w", Pose.GetRotation().W);
-	bson_append_document_end(doc, &child_obj_rot);
-
-	bson_t child_pose;
-	char buf[16];
-	const char* key;
-	size_t keylen;
-
-	// Write pose as array of [x y z qx qy qz qw]
-	BSON_APPEND_ARRAY_BEGIN(doc, "pose", &child_pose);
-		// x
-		keylen = bson_uint32_to_string(0, &key, buf, sizeof buf);
-		bson_append_double(&child_pose, key, (int)keylen, Pose.GetLocation().X);
-		// y
-		keylen = bson_uint32_to_string(1, &key, buf, sizeof buf);
-		bson_append_double(&child_pose, key, (int)keylen, Pose.GetLocation().Y);
-		// z
-		keylen = bson_uint32_to_string(2, &key, buf, sizeof buf);
-		bson_append_double(&child_pose, key, (int)keylen, Pose.GetLocation().Z);
-		// qx
-		keylen = bson_uint32_to_string(3, &key, buf, sizeof buf);
-		bson_append_double(&child_pose, key, (int)keylen, Pose.GetRotation().X);
-		// qy
-		keylen = bson_uint32_to_string(4, &key, buf, sizeof buf);
-		bson_append_double(&child_pose, key, (int)keylen, Pose.GetRotation().Y);
-		// qz
-		keylen = bson_uint32_to_string(5, &key, buf, sizeof buf);
-		bson_append_double(&child_pose, key, (int)keylen, Pose.GetRotation().Z);
-		// qw
-		keylen = bson_uint32_to_string(6, &key, buf, sizeof buf);
-		bson_append_double(&child_pose, key, (int)keylen, Pose.GetRotation().W);
-	bson_append_array_end(doc, &child_pose);
+	FSLWorldStateSnapshot* Snapshot = nullptr;
+	while (SnapshotQueue.Dequeue(Snapshot))
+	{
+		Stats.QueueDepth.Decrement();
+		FSLWorldStateWriterStats::AddDuration(Stats.QueueLatencyUs, FPlatformTime::Seconds() - Snapshot->CaptureTime);
+		Sink->Write(*Snapshot, Stats);
+		Stats.NumWritten.Increment();
+		if (Sink->ConsumeKeyframeRequest())
+		{
+			bKeyframeRequested = true;
+		}
+		RecycleSnapshot(Snapshot);
+	}
 }
 
-// Write the bson doc to the meta_coll
-bool FSLWorldStateDBWriterAsyncTask::UploadDoc(bson_t* doc)
+// Give back the snapshot to be reused by the game thread (writer thread only)
+void FSLWorldStateDBWriter::RecycleSnapshot(FSLWorldStateSnapshot* Snapshot)
 {
-	bson_error_t error;
-	if (!mongoc_collection_insert_one(mongo_collection, doc, NULL, NULL, &error))
+	if (!FreeQueue.Enqueue(Snapshot))
 	{
-		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.: %s"),
-			*FString(__func__), __LINE__, *FString(error.message));
-		return false;
+		delete Snapshot;
 	}
-	return true;
 }
-#endif //SL_WITH_LIBMONGO_C	
-
 
 
 /* DB Handler */
@@ -423,7 +217,15 @@ FSLWorldStateDBHandler::FSLWorldStateDBHandler()
 {
 	bIsFinished = false;
 	bIsInit = false;
-	DBWriterTask = nullptr;
+	bWriteSparse = true;
+	KeyframeInterval = 0;
+	FramesSinceKeyframe = 0;
+	bForceKeyframe = false;
+	MinPoseDiff = 0.1f;
+	StatsLogInterval = 0.f;
+	PrevStatsLogTime = 0.0;
+	IndividualManager = nullptr;
+	DBWriter = nullptr;
 }
 
 // Dtor
@@ -435,88 +237,128 @@ FSLWorldStateDBHandler::~FSLWorldStateDBHandler()
 	}
 }
 
-// Connect to the db and set up the async writer
-bool FSLWorldStateDBHandler::Init(ASLIndividualManager* IndividualManager,
+// Set up the sink and the async writer
+bool FSLWorldStateDBHandler::Init(ASLIndividualManager* InIndividualManager,
 	const FSLWorldStateLoggerParams& InLoggerParameters,
 	const FSLLoggerLocationParams& InLocationParameters,
 	const FSLLoggerDBServerParams& InDBServerParameters)
 {
-	// Connect to the database
-	if (!Connect(InLocationParameters.TaskId, InLocationParameters.EpisodeId, 
-		InDBServerParameters.Ip, InDBServerParameters.Port,
-		InLocationParameters.bOverwrite))
-	{
-		UE_LOG(LogTemp, Error, TEXT("%s::%d World state writer DB handler could not connect to the database.."), *FString(__FUNCTION__), __LINE__);
-		return false;
-	}
+	IndividualManager = InIndividualManager;
+	bWriteSparse = InLoggerParameters.bWriteSparse;
+	MinPoseDiff = InLoggerParameters.PoseTolerance;
+	StatsLogInterval = InLoggerParameters.StatsLogInterval;
+
+	// Local files are chunked at keyframes, this way they can be read (and recovered) chunk by chunk
+	KeyframeInterval = InLoggerParameters.SinkType == ESLWorldStateSinkType::LocalFile
+		? FMath::Max(InLoggerParameters.KeyframeInterval, 1) : 0;
+	FramesSinceKeyframe = 0;
+	bForceKeyframe = false;
 
-	// Write metadata if needed
-	if (InLoggerParameters.bIncludeMetadata)
+	// The writer thread only accesses the cached ids and classes
+	SetIndividualsTable();
+
+	// Create and initialize the sink (database connection, file etc.)
+	TUniquePtr<ISLWorldStateSink> Sink = CreateSink(InLoggerParameters.SinkType);
+	if (!Sink.IsValid() || !Sink->Init(IndividualsTable, InLoggerParameters, InLocationParameters, InDBServerParameters))
 	{
-		WriteMetadata(IndividualManager, InLocationParameters.TaskId + ".meta", InLoggerParameters.bOverwriteMetadata);
+		UE_LOG(LogTemp, Error, TEXT("%s::%d World state sink could not be initialized.."), *FString(__FUNCTION__), __LINE__);
+		return false;
 	}
 
-	// Create the async worker
-	if (DBWriterTask == nullptr)
+	// Create the writer
+	if (DBWriter == nullptr)
 	{
-		DBWriterTask = new FAsyncTask<FSLWorldStateDBWriterAsyncTask>();
+		DBWriter = new FSLWorldStateDBWriter(InLoggerParameters.WriteQueueSize);
 	}
 	else
 	{
-		UE_LOG(LogTemp, Warning, TEXT("%s::%d World state async writer should be nullptr here.."),
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d World state writer should be nullptr here.."),
 			*FString(__FUNCTION__), __LINE__);
 	}
 
-#if SL_WITH_LIBMONGO_C
-	// Set worker parameters
-	if (!DBWriterTask->GetTask().Init(collection, IndividualManager, InLoggerParameters.PoseTolerance, InLoggerParameters.bWriteSparse))
+	// Start the writer thread
+	if (!DBWriter->Init(MoveTemp(Sink)) || !DBWriter->Start())
 	{
-		UE_LOG(LogTemp, Error, TEXT("%s::%d World state async writer could not be initialized.."),
+		UE_LOG(LogTemp, Error, TEXT("%s::%d World state writer could not be initialized.."),
 			*FString(__FUNCTION__), __LINE__);
-		Disconnect();
+		delete DBWriter;
+		DBWriter = nullptr;
 		return false;
 	}
-#else
-	UE_LOG(LogTemp, Error, TEXT("%s::%d SL_WITH_LIBMONGO_C flag is 0, aborting.."),
-		*FString(__func__), __LINE__);
-	return false;
-#endif //SL_WITH_LIBMONGO_C
 
 	bIsInit = true;
 	return true;
 }
 
-// Delegate first job to the async task
+// Capture all the individual poses and queue them for writing
 void FSLWorldStateDBHandler::FirstWrite(float Timestamp)
 {
-	PrevWriteCallTime = FPlatformTime::Seconds();
-	DBWriterTask->GetTask().SetTimestamp(Timestamp);
-	DBWriterTask->StartBackgroundTask();
+	if (!bIsInit)
+	{
+		return;
+	}
+
+	PrevStatsLogTime = FPlatformTime::Seconds();
+	FramesSinceKeyframe = 0;
+	FSLWorldStateSnapshot* Snapshot = DBWriter->GetFreeSnapshot();
+	Snapshot->Timestamp = Timestamp;
+	Snapshot->bIsKeyframe = true;
+	CaptureSnapshot(*Snapshot, true);
+	DBWriter->Enqueue(Snapshot);
 }
 
-// Delegate job to the async task (true if the previous job was done)
+// Capture the individual poses and queue them for writing (false if the snapshot was dropped)
 bool FSLWorldStateDBHandler::Write(float Timestamp)
 {
-	//double CurrentTime = FPlatformTime::Seconds();
-	//const double DurationSincePrevCall = CurrentTime - PrevWriteCallTime;
-	//PrevWriteCallTime = CurrentTime;
-	//UE_LOG(LogTemp, Warning, TEXT("%s::%d \t\t Duration since previous call:\t%f (s)"),
-	//	*FString(__func__), __LINE__, DurationSincePrevCall);
+	if (!bIsInit)
+	{
+		return false;
+	}
 
-	if (DBWriterTask->IsDone())
+	// Periodically write all the individuals (if required by the sink), after a dropped snapshot, or if the sink requests it
+	FramesSinceKeyframe++;
+	const bool bIsKeyframe = (KeyframeInterval > 0 && FramesSinceKeyframe >= KeyframeInterval)
+		|| bForceKeyframe || DBWriter->ConsumeKeyframeRequest();
+	if (bIsKeyframe)
 	{
-		DBWriterTask->GetTask().SetTimestamp(Timestamp);
-		DBWriterTask->StartBackgroundTask();
-		return true;
+		FramesSinceKeyframe = 0;
+		bForceKeyframe = false;
 	}
-	else
+
+	FSLWorldStateSnapshot* Snapshot = DBWriter->GetFreeSnapshot();
+	Snapshot->Timestamp = Timestamp;
+	Snapshot->bIsKeyframe = bIsKeyframe || !bWriteSparse;
+	CaptureSnapshot(*Snapshot, Snapshot->bIsKeyframe);
+
+	bool bRetVal = true;
+	if (!DBWriter->Enqueue(Snapshot))
 	{
-		UE_LOG(LogTemp, Warning, TEXT("%s::%d [%f] Current db write async task is not finished yet, trying again next update call.."), *FString(__func__), __LINE__, Timestamp);
-		return false;
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d [%f] World state writer queue is full, snapshot dropped (%s).."),
+			*FString(__func__), __LINE__, Timestamp, *DBWriter->GetStats().ToString());
+		bForceKeyframe = true;
+		bRetVal = false;
 	}
+
+	if (StatsLogInterval > 0.f)
+	{
+		const double CurrTime = FPlatformTime::Seconds();
+		if (CurrTime - PrevStatsLogTime > StatsLogInterval)
+		{
+			PrevStatsLogTime = CurrTime;
+			UE_LOG(LogTemp, Log, TEXT("%s::%d [%f] World state writer stats: %s"),
+				*FString(__func__), __LINE__, Timestamp, *DBWriter->GetStats().ToString());
+		}
+	}
+	return bRetVal;
+}
+
+// Get the writer counters and timings (nullptr if there is no writer)
+const FSLWorldStateWriterStats* FSLWorldStateDBHandler::GetWriterStats() const
+{
+	return DBWriter != nullptr ? &DBWriter->GetStats() : nullptr;
 }
 
-// Disconnect from db, clear task
+// Write the remaining snapshots and close the sink
 void FSLWorldStateDBHandler::Finish()
 {
 	if (bIsFinished)
@@ -525,323 +367,103 @@ void FSLWorldStateDBHandler::Finish()
 		return;
 	}
 	
-	// Wait for writer to finish
-	if (DBWriterTask != nullptr)
+	// Wait for the writer to write the remaining snapshots and close the sink
+	if (DBWriter != nullptr)
 	{
-		if (DBWriterTask->IsDone())
-		{
-			delete DBWriterTask;
-			DBWriterTask = nullptr;
-		}
-		else
-		{
-			if (DBWriterTask->WaitCompletionWithTimeout(0.5f))
-			{
-				delete DBWriterTask;
-				DBWriterTask = nullptr;
-			}
-			else
-			{
-				UE_LOG(LogTemp, Error, TEXT("%s::%d Task not completed, and writer was killed.."), *FString(__FUNCTION__), __LINE__);
-				delete DBWriterTask;
-				DBWriterTask = nullptr;
-			}
-		}
+		DBWriter->Finish();
+		UE_LOG(LogTemp, Log, TEXT("%s::%d World state writer stats: %s"),
+			*FString(__FUNCTION__), __LINE__, *DBWriter->GetStats().ToString());
+		delete DBWriter;
+		DBWriter = nullptr;
 	}
 
-	// Finish up handler
-	CreateIndexes();
-	Disconnect();
-
 	bIsInit = false;
 	bIsFinished = true;
 }
 
-// Connect to the db
-bool FSLWorldStateDBHandler::Connect(const FString& DBName, const FString& CollName, const FString& ServerIp,
-		uint16 ServerPort, bool bOverwrite)
+// Cache the ids and classes of the individuals, and the individual indexes of the skeletal individuals
+void FSLWorldStateDBHandler::SetIndividualsTable()
 {
-#if SL_WITH_LIBMONGO_C
-	// Required to initialize libmongoc's internals	
-	mongoc_init();
-
-	// Stores any error that might appear during the connection
-	bson_error_t error;
-
-	// Safely create a MongoDB URI object from the given string
-	FString Uri = TEXT("mongodb://") + ServerIp + TEXT(":") + FString::FromInt(ServerPort);
-	uri = mongoc_uri_new_with_error(TCHAR_TO_UTF8(*Uri), &error);
-	if (!uri)
+	IndividualsTable = FSLWorldStateIndividualsTable();
+	const TArray<USLBaseIndividual*>& Individuals = IndividualManager->GetIndividuals();
+	for (const auto& Individual : Individuals)
 	{
-		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s; [Uri=%s]"),
-			*FString(__func__), __LINE__, *FString(error.message), *Uri);
-		return false;
+		IndividualsTable.Add(Individual->GetIdValue(), Individual->GetClassValue());
 	}
 
-	// Create a new client instance
-	client = mongoc_client_new_from_uri(uri);
-	if (!client)
-	{
-		return false;
-	}
-
-	// Register the application name so we can track it in the profile logs on the server
-	mongoc_client_set_appname(client, TCHAR_TO_UTF8(*("SL_WorldStateWriter_" + CollName)));
-
-	// Get a handle on the database "db_name" and meta_coll "coll_name"
-	database = mongoc_client_get_database(client, TCHAR_TO_UTF8(*DBName));
-
-	// Check if the meta_coll already exists
-	if (mongoc_database_has_collection(database, TCHAR_TO_UTF8(*CollName), &error))
-	{
-		if (bOverwrite)
-		{
-			UE_LOG(LogTemp, Warning, TEXT("%s::%d World state collection %s already exists, will be removed and overwritten.."),
-				*FString(__func__), __LINE__, *CollName);
-			if (!mongoc_collection_drop(mongoc_database_get_collection(database, TCHAR_TO_UTF8(*CollName)), &error))
-			{
-				UE_LOG(LogTemp, Error, TEXT("%s::%d Could not drop collection, err.:%s;"),
-					*FString(__func__), __LINE__, *FString(error.message));
-				return false;
-			}
-		}
-		else
-		{
-			UE_LOG(LogTemp, Warning, TEXT("%s::%d World state collection %s already exists and should not be overwritten, skipping metadata logging.."),
-				*FString(__func__), __LINE__, *CollName);
-			return false;
-		}
-	}
-	else
+	// Skeletal individuals are also part of the individuals array
+	SkeletalIndividualIndexes.Reset();
+	for (const auto& SkelIndividual : IndividualManager->GetSkeletalIndividuals())
 	{
-		UE_LOG(LogTemp, Warning, TEXT("%s::%d Creating collection %s.%s .."),
-			*FString(__func__), __LINE__, *DBName, *CollName);
+		SkeletalIndividualIndexes.Add(Individuals.IndexOfByKey(SkelIndividual));
 	}
+}
 
-	collection = mongoc_client_get_collection(client, TCHAR_TO_UTF8(*DBName), TCHAR_TO_UTF8(*CollName));
-
-	// Check server. Ping the "admin" database
-	bson_t* server_ping_cmd;
-	server_ping_cmd = BCON_NEW("ping", BCON_INT32(1));
-	if (!mongoc_client_command_simple(client, "admin", server_ping_cmd, NULL, NULL, &error))
+// Create the sink of the given type
+TUniquePtr<ISLWorldStateSink> FSLWorldStateDBHandler::CreateSink(ESLWorldStateSinkType SinkType) const
+{
+	switch (SinkType)
 	{
-		UE_LOG(LogTemp, Error, TEXT("%s::%d Check server err.: %s"),
-			*FString(__func__), __LINE__, *FString(error.message));
-		bson_destroy(server_ping_cmd);
-		return false;
+	case ESLWorldStateSinkType::Mongo:
+		return MakeUnique<FSLWorldStateMongoSink>();
+	case ESLWorldStateSinkType::LocalFile:
+		return MakeUnique<FSLWorldStateFileSink>();
+	default:
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Unknown world state sink type.."), *FString(__FUNCTION__), __LINE__);
+		return nullptr;
 	}
-
-	bson_destroy(server_ping_cmd);
-	return true;
-#else
-	UE_LOG(LogTemp, Error, TEXT("%s::%d SL_WITH_LIBMONGO_C flag is 0, aborting.."),
-		*FString(__func__), __LINE__);
-	return false;
-#endif //SL_WITH_LIBMONGO_C
 }
 
-// Write metadata (collname + .meta)
-bool FSLWorldStateDBHandler::WriteMetadata(ASLIndividualManager* IndividualManager, const FString& MetaCollName, bool bOverwrite)
+// Copy the poses into the snapshot (game thread)
+void FSLWorldStateDBHandler::CaptureSnapshot(FSLWorldStateSnapshot& OutSnapshot, bool bCaptureAll)
 {
-#if SL_WITH_LIBMONGO_C
-	bson_error_t error;
-	mongoc_collection_t* meta_coll;
-	meta_coll = mongoc_database_get_collection(database, TCHAR_TO_UTF8(*MetaCollName));
-	bson_t* query;
-
-	// Query for any previous individuals metadata
-	query = bson_new();
-	BSON_APPEND_UTF8(query, "type_id", "individuals");
+	const double StartTime = FPlatformTime::Seconds();
 
-	// Check if there is any previous metadata logged
-	int64_t count = mongoc_collection_count_documents(meta_coll, query, NULL, NULL, NULL, &error);
-	if (count < 0)
+	const TArray<USLBaseIndividual*>& Individuals = IndividualManager->GetIndividuals();
+	OutSnapshot.IndividualIndexes.Reserve(Individuals.Num());
+	OutSnapshot.IndividualPoses.Reserve(Individuals.Num() * FSLWorldStateSnapshot::PoseStride);
+	for (int32 Idx = 0; Idx < Individuals.Num(); ++Idx)
 	{
-		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.: %s"),
-			*FString(__func__), __LINE__, *FString(error.message));
-	}
-	else if (count > 0)
-	{
-		// Remove any previously written document with the type_id:individuals
-		if (bOverwrite)
+		USLBaseIndividual* Individual = Individuals[Idx];
+		if (bCaptureAll)
 		{
-			UE_LOG(LogTemp, Log, TEXT("%s::%d Individuals metadata is already logged, removing previous data.."),
-				*FString(__FUNCTION__), __LINE__);
-			if (!mongoc_collection_delete_many(meta_coll, query, NULL, NULL, &error))
-			{
-				UE_LOG(LogTemp, Error, TEXT("%s::%d Err.: %s"),
-					*FString(__func__), __LINE__, *FString(error.message));
-			}
+			Individual->UpdateCachedPose(0.0);
 		}
-		else
+		else if (!Individual->UpdateCachedPose(MinPoseDiff))
 		{
-			UE_LOG(LogTemp, Log, TEXT("%s::%d Individuals metadata is already logged, skipping.."),
-				*FString(__FUNCTION__), __LINE__);
-			return true;
+			continue;
 		}
+		OutSnapshot.IndividualIndexes.Add(Idx);
+		FSLWorldStateSnapshot::AddPose(OutSnapshot.IndividualPoses, Individual->GetCachedPose());
 	}
 
-
-	// No previous metadata found, writing new one
-	bson_t* meta_doc;
-	meta_doc = bson_new();
-
-	// Add type
-	BSON_APPEND_UTF8(meta_doc, "type_id", "individuals");
-
-	// Add individuals data
-	int32 Num = AddIndividualsMetadata(IndividualManager, meta_doc);
-
-	bool RetVal = true;
-	if(Num > 0)
+	const TArray<USLSkeletalIndividual*>& SkelIndividuals = IndividualManager->GetSkeletalIndividuals();
+	for (int32 Idx = 0; Idx < SkelIndividuals.Num(); ++Idx)
 	{
-		
-		if (!mongoc_collection_insert_one(meta_coll, meta_doc, NULL, NULL, &error))
+		USLSkeletalIndividual* SkelIndividual = SkelIndividuals[Idx];
+		OutSnapshot.SkeletalIndexes.Add(SkeletalIndividualIndexes[Idx]);
+		FSLWorldStateSnapshot::AddPose(OutSnapshot.SkeletalPoses, SkelIndividual->GetCachedPose());
+
+		const TArray<USLBoneIndividual*>& BoneIndividuals = SkelIndividual->GetBoneIndividuals();
+		const TArray<USLVirtualBoneIndividual*>& VirtualBoneIndividuals = SkelIndividual->GetVirtualBoneIndividuals();
+		OutSnapshot.SkeletalBoneNums.Add(BoneIndividuals.Num() + VirtualBoneIndividuals.Num());
+		for (const auto& BI : BoneIndividuals)
 		{
-			UE_LOG(LogTemp, Error, TEXT("%s::%d Err.: %s"),
-				*FString(__func__), __LINE__, *FString(error.message));
-			RetVal = false;
+			BI->UpdateCachedPose(0.0);
+			OutSnapshot.BoneIndexes.Add(BI->GetBoneIndex());
+			FSLWorldStateSnapshot::AddPose(OutSnapshot.BonePoses, BI->GetCachedPose());
+		}
+		for (const auto& VBI : VirtualBoneIndividuals)
+		{
+			VBI->UpdateCachedPose(0.0);
+			OutSnapshot.BoneIndexes.Add(VBI->GetBoneIndex());
+			FSLWorldStateSnapshot::AddPose(OutSnapshot.BonePoses, VBI->GetCachedPose());
 		}
 	}
-	else
-	{
-		RetVal = false;
-	}
-
-	UE_LOG(LogTemp, Log, TEXT("%s::%d Wrote %d number of individuals to the meta collection %s.."),
-		*FString(__FUNCTION__), __LINE__, Num, *MetaCollName);
-
-	// Clean up
-	bson_destroy(meta_doc);
-	mongoc_collection_destroy(meta_coll);
-	return RetVal;
-#else
-	UE_LOG(LogTemp, Error, TEXT("%s::%d SL_WITH_LIBMONGO_C flag is 0, aborting.."),
-		*FString(__func__), __LINE__);
-	return false;
-#endif //SL_WITH_LIBMONGO_C
-}
-
-#if SL_WITH_LIBMONGO_C
-int32 FSLWorldStateDBHandler::AddIndividualsMetadata(ASLIndividualManager* IndividualManager, bson_t* doc)
-{
-	int32 Num = 0;
-	bson_t arr_obj;
-	uint32_t arr_idx = 0;
-
-	BSON_APPEND_ARRAY_BEGIN(doc, "individuals", &arr_obj);
-	for (const auto& Individual : IndividualManager->GetIndividuals())
-	{
-		bson_t individual_obj;
-		char idx_str[16];
-		const char* idx_key;
-
-		bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
-		BSON_APPEND_DOCUMENT_BEGIN(&arr_obj, idx_key, &individual_obj);
-
-			// Id
-			BSON_APPEND_UTF8(&individual_obj, "id", TCHAR_TO_UTF8(*Individual->GetIdValue()));
-			// Class
-			BSON_APPEND_UTF8(&individual_obj, "class", TCHAR_TO_UTF8(*Individual->GetClassValue()));
-		
-		bson_append_document_end(&arr_obj, &individual_obj);
-
-		arr_idx++;
-		Num++;
-	}
-	bson_append_array_end(doc, &arr_obj);
-	return Num;
-}
-#endif //SL_WITH_LIBMONGO_C	
-	
-void FSLWorldStateDBHandler::Disconnect() const
-{
-#if SL_WITH_LIBMONGO_C
-	// Release handles and clean up mongoc
-	if (uri)
-	{
-		mongoc_uri_destroy(uri);
-	}
-	if (client)
-	{
-		mongoc_client_destroy(client);
-	}
-	if (database)
-	{
-		mongoc_database_destroy(database);
-	}
-	if (collection)
-	{
-		mongoc_collection_destroy(collection);
-	}
-	mongoc_cleanup();
-#endif //SL_WITH_LIBMONGO_C
-}
-
-// Create indexes on the inserted data
-bool FSLWorldStateDBHandler::CreateIndexes() const
-{
-	if (!bIsInit)
-	{
-		UE_LOG(LogTemp, Log, TEXT("%s::%d Not connected to the db, could not create indexes.."), *FString(__FUNCTION__), __LINE__);
-		return false;
-	}
-
-#if SL_WITH_LIBMONGO_C
-	bson_t* index_command;
-	bson_error_t error;
-	
-	bson_t idx_ts;
-	bson_init(&idx_ts);
-	BSON_APPEND_INT32(&idx_ts, "timestamp", 1);
-	char* idx_ts_chr = mongoc_collection_keys_to_index_string(&idx_ts);
-
-	bson_t idx_individuals_id;
-	bson_init(&idx_individuals_id);
-	BSON_APPEND_INT32(&idx_individuals_id, "individuals.id", 1);
-	char* idx_individuals_id_chr = mongoc_collection_keys_to_index_string(&idx_individuals_id);
-
-	bson_t idx_skel_individuals_id;
-	bson_init(&idx_skel_individuals_id);
-	BSON_APPEND_INT32(&idx_skel_individuals_id, "skel_individuals.id", 1);
-	char* idx_skel_individuals_id_chr = mongoc_collection_keys_to_index_string(&idx_skel_individuals_id);
-
-	index_command = BCON_NEW("createIndexes",
-			BCON_UTF8(mongoc_collection_get_name(collection)),
-			"indexes",
-			"[",
-				"{",
-					"key", BCON_DOCUMENT(&idx_ts),
-					"name", BCON_UTF8(idx_ts_chr),
-					"unique", BCON_BOOL(true),
-				"}",
-				"{",
-					"key", BCON_DOCUMENT(&idx_individuals_id),
-					"name",	BCON_UTF8(idx_individuals_id_chr),
-					//"unique", //BCON_BOOL(false),
-				"}",
-				"{",
-					"key", BCON_DOCUMENT(&idx_skel_individuals_id),
-					"name", BCON_UTF8(idx_skel_individuals_id_chr),
-					//"unique", //BCON_BOOL(false),
-				"}",
-			"]");
 
-	bool bRetVal = true;
-	if (!mongoc_collection_write_command_with_opts(collection, index_command, NULL/*opts*/, NULL/*reply*/, &error))
+	OutSnapshot.CaptureTime = FPlatformTime::Seconds();
+	if (DBWriter)
 	{
-		UE_LOG(LogTemp, Error, TEXT("%s::%d Create indexes err.: %s"),
-			*FString(__func__), __LINE__, *FString(error.message));
-		bRetVal = false;
+		FSLWorldStateWriterStats::AddDuration(DBWriter->GetStatsMutable().CaptureTimeUs, OutSnapshot.CaptureTime - StartTime);
 	}
-
-	// Clean up
-	bson_destroy(index_command);
-	bson_free(idx_ts_chr);
-	bson_free(idx_individuals_id_chr);
-	return bRetVal;
-#endif //SL_WITH_LIBMONGO_C
-
-	return false;
 }
-
@@ -0,0 +1,151 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Runtime/SLWorldStateFileImporter.h"
+#include "Runtime/SLWorldStateFileFormat.h"
+#include "Runtime/SLWorldStateFileSink.h"
+#include "Runtime/SLWorldStateMongoSink.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Crc.h"
+
+// Import the episode file of the given task and episode (returns the number of imported frames, INDEX_NONE on failure)
+int32 FSLWorldStateFileImporter::Import(const FSLWorldStateLoggerParams& InLoggerParameters,
+	const FSLLoggerLocationParams& InLocationParameters,
+	const FSLLoggerDBServerParams& InDBServerParameters)
+{
+	return ImportFile(FSLWorldStateFileSink::GetEpisodeFilePath(InLoggerParameters.LocalFileDirectory,
+		InLocationParameters.TaskId, InLocationParameters.EpisodeId),
+		InLoggerParameters, InLocationParameters, InDBServerParameters);
+}
+
+// Import the given episode file (returns the number of imported frames, INDEX_NONE on failure)
+int32 FSLWorldStateFileImporter::ImportFile(const FString& FilePath,
+	const FSLWorldStateLoggerParams& InLoggerParameters,
+	const FSLLoggerLocationParams& InLocationParameters,
+	const FSLLoggerDBServerParams& InDBServerParameters)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Map the file into memory, fall back to loading it if mapping is not supported
+	TUniquePtr<IMappedFileHandle> MappedHandle(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FilePath));
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	TArray<uint8> LoadedData;
+	const uint8* Data = nullptr;
+	const uint8* End = nullptr;
+	if (MappedHandle.IsValid() && MappedHandle->GetFileSize() > 0)
+	{
+		MappedRegion.Reset(MappedHandle->MapRegion(0, MappedHandle->GetFileSize()));
+	}
+	if (MappedRegion.IsValid())
+	{
+		Data = MappedRegion->GetMappedPtr();
+		End = Data + MappedRegion->GetMappedSize();
+	}
+	else if (FFileHelper::LoadFileToArray(LoadedData, *FilePath))
+	{
+		Data = LoadedData.GetData();
+		End = Data + LoadedData.Num();
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not read %s.."), *FString(__FUNCTION__), __LINE__, *FilePath);
+		return INDEX_NONE;
+	}
+
+	const uint8* FileStart = Data;
+	FSLWorldStateIndividualsTable IndividualsTable;
+	if (!FSLWorldStateFileFormat::ReadHeader(Data, End, IndividualsTable))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d %s is not a valid world state episode file.."), *FString(__FUNCTION__), __LINE__, *FilePath);
+		return INDEX_NONE;
+	}
+
+	// Importing is not time critical, bulk insert the frames and wait for the acknowledgements
+	FSLWorldStateLoggerParams ImportParameters = InLoggerParameters;
+	ImportParameters.bBulkWrite = true;
+	ImportParameters.bBulkOrdered = false;
+	if (ImportParameters.WriteConcern == ESLWorldStateWriteConcern::Unacknowledged)
+	{
+		ImportParameters.WriteConcern = ESLWorldStateWriteConcern::Acknowledged;
+	}
+
+	FSLWorldStateMongoSink MongoSink;
+	if (!MongoSink.Init(IndividualsTable, ImportParameters, InLocationParameters, InDBServerParameters))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not import %s, the mongo sink could not be initialized.."),
+			*FString(__FUNCTION__), __LINE__, *FilePath);
+		return INDEX_NONE;
+	}
+
+	// Read the chunks sequentially, stop at the index or at the first incomplete or corrupted chunk
+	FSLWorldStateWriterStats Stats;
+	FSLWorldStateSnapshot Snapshot;
+	int32 NumFrames = 0;
+	int32 NumChunks = 0;
+	bool bHasIndex = false;
+	while (Data < End)
+	{
+		const uint8* ChunkStart = Data;
+		uint32 Magic = 0;
+		int32 ChunkNumFrames = 0;
+		int32 PayloadSize = 0;
+		uint32 PayloadCrc = 0;
+		if (!FSLWorldStateFileFormat::ReadValue(Data, End, Magic))
+		{
+			break;
+		}
+		if (Magic == FSLWorldStateFileFormat::IndexMagic)
+		{
+			bHasIndex = true;
+			break;
+		}
+		if (Magic != FSLWorldStateFileFormat::ChunkMagic
+			|| !FSLWorldStateFileFormat::ReadValue(Data, End, ChunkNumFrames)
+			|| !FSLWorldStateFileFormat::ReadValue(Data, End, PayloadSize)
+			|| !FSLWorldStateFileFormat::ReadValue(Data, End, PayloadCrc)
+			|| PayloadSize < 0 || Data + PayloadSize > End)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Incomplete chunk at offset %lld, ignoring the rest of the file.."),
+				*FString(__FUNCTION__), __LINE__, (int64)(ChunkStart - FileStart));
+			break;
+		}
+		if (FCrc::MemCrc32(Data, PayloadSize) != PayloadCrc)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Chunk %d checksum mismatch, ignoring the rest of the file.."),
+				*FString(__FUNCTION__), __LINE__, NumChunks);
+			break;
+		}
+
+		const uint8* PayloadEnd = Data + PayloadSize;
+		for (int32 FrameIdx = 0; FrameIdx < ChunkNumFrames; ++FrameIdx)
+		{
+			Snapshot.Reset();
+			if (!FSLWorldStateFileFormat::ReadFrame(Data, PayloadEnd, IndividualsTable.Num(), Snapshot))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not read frame %d of chunk %d, skipping the rest of the chunk.."),
+					*FString(__FUNCTION__), __LINE__, FrameIdx, NumChunks);
+				break;
+			}
+			MongoSink.Write(Snapshot, Stats);
+			Stats.NumWritten.Increment();
+			NumFrames++;
+		}
+		Data = PayloadEnd;
+		NumChunks++;
+	}
+
+	MongoSink.Flush(Stats);
+	MongoSink.Finish();
+
+	if (!bHasIndex)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s has no chunk index (the episode was not finished properly), imported the recovered data.."),
+			*FString(__FUNCTION__), __LINE__, *FilePath);
+	}
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Imported %d frames (%d chunks) from %s in %.3fs (%s).."),
+		*FString(__FUNCTION__), __LINE__, NumFrames, NumChunks, *FilePath,
+		FPlatformTime::Seconds() - StartTime, *Stats.ToString());
+	return NumFrames;
+}
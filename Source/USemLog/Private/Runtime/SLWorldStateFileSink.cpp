@@ -0,0 +1,230 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Runtime/SLWorldStateFileSink.h"
+#include "Runtime/SLWorldStateFileFormat.h"
+#include "HAL/PlatformFilemanager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Misc/Crc.h"
+#include "Misc/Paths.h"
+
+// Ctor
+FSLWorldStateFileSink::FSLWorldStateFileSink()
+{
+	FileHandle = nullptr;
+	FileOffset = 0;
+	ChunkNumFrames = 0;
+	ChunkFirstTimestamp = 0.f;
+	ChunkMaxSize = 1024 * 1024;
+	bKeyframeRequested = false;
+	bWriteFailed = false;
+}
+
+// Dtor
+FSLWorldStateFileSink::~FSLWorldStateFileSink()
+{
+	Finish();
+}
+
+// Get the episode file path (<Dir>/<TaskId>/<EpisodeId>.slws)
+FString FSLWorldStateFileSink::GetEpisodeFilePath(const FString& Directory, const FString& TaskId, const FString& EpisodeId)
+{
+	const FString BaseDir = Directory.IsEmpty() ? FPaths::ProjectSavedDir() / TEXT("SL") : Directory;
+	return BaseDir / TaskId / EpisodeId + FSLWorldStateFileFormat::GetExtension();
+}
+
+// Create the episode file and write the header
+bool FSLWorldStateFileSink::Init(const FSLWorldStateIndividualsTable& InIndividualsTable,
+	const FSLWorldStateLoggerParams& InLoggerParameters,
+	const FSLLoggerLocationParams& InLocationParameters,
+	const FSLLoggerDBServerParams& InDBServerParameters)
+{
+	if (FileHandle != nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d File sink is already initialized.."), *FString(__FUNCTION__), __LINE__);
+		return true;
+	}
+
+	ChunkMaxSize = FMath::Max(InLoggerParameters.FileChunkSizeKb, 1) * 1024;
+	FilePath = GetEpisodeFilePath(InLoggerParameters.LocalFileDirectory,
+		InLocationParameters.TaskId, InLocationParameters.EpisodeId);
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (PlatformFile.FileExists(*FilePath))
+	{
+		if (!InLocationParameters.bOverwrite)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Episode file %s already exists and should not be overwritten.."),
+				*FString(__FUNCTION__), __LINE__, *FilePath);
+			return false;
+		}
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Episode file %s already exists, will be overwritten.."),
+			*FString(__FUNCTION__), __LINE__, *FilePath);
+	}
+
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FilePath));
+	FileHandle = PlatformFile.OpenWrite(*FilePath);
+	if (FileHandle == nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not open %s for writing.."), *FString(__FUNCTION__), __LINE__, *FilePath);
+		return false;
+	}
+
+	FileOffset = 0;
+	ChunkIndex.Reset();
+	ChunkBuffer.Reset(ChunkMaxSize);
+	ChunkNumFrames = 0;
+	bKeyframeRequested = false;
+	bWriteFailed = false;
+
+	HeaderBuffer.Reset();
+	FSLWorldStateFileFormat::WriteHeader(HeaderBuffer, InIndividualsTable);
+	if (!WriteBuffer(HeaderBuffer))
+	{
+		delete FileHandle;
+		FileHandle = nullptr;
+		return false;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Writing the world state of %d individuals to %s.."),
+		*FString(__FUNCTION__), __LINE__, InIndividualsTable.Num(), *FilePath);
+	return true;
+}
+
+// Append the snapshot to the current chunk
+int32 FSLWorldStateFileSink::Write(const FSLWorldStateSnapshot& Snapshot, FSLWorldStateWriterStats& Stats)
+{
+	const int32 Num = Snapshot.Num();
+	if (Num == 0 && !Snapshot.bIsKeyframe)
+	{
+		return 0;
+	}
+
+	// Chunks start at keyframes, this way any chunk can be replayed on its own
+	if (Snapshot.bIsKeyframe && ChunkNumFrames > 0)
+	{
+		WriteChunk(Stats);
+	}
+
+	const double SerializeStartTime = FPlatformTime::Seconds();
+	if (ChunkNumFrames == 0)
+	{
+		ChunkFirstTimestamp = Snapshot.Timestamp;
+	}
+	FSLWorldStateFileFormat::WriteFrame(ChunkBuffer, Snapshot);
+	ChunkNumFrames++;
+	FSLWorldStateWriterStats::AddDuration(Stats.SerializeTimeUs, FPlatformTime::Seconds() - SerializeStartTime);
+
+	// Splitting here could start the next chunk with a delta frame, the chunk is written when the requested keyframe arrives
+	if (ChunkBuffer.Num() >= ChunkMaxSize)
+	{
+		bKeyframeRequested = true;
+	}
+	return Num;
+}
+
+// True if the current chunk is full and the next chunk needs to start with a keyframe
+bool FSLWorldStateFileSink::ConsumeKeyframeRequest()
+{
+	const bool bRetVal = bKeyframeRequested;
+	bKeyframeRequested = false;
+	return bRetVal;
+}
+
+// Write the current chunk to disk
+void FSLWorldStateFileSink::Flush(FSLWorldStateWriterStats& Stats)
+{
+	WriteChunk(Stats);
+}
+
+// Write the chunk index and close the file
+void FSLWorldStateFileSink::Finish()
+{
+	if (FileHandle == nullptr)
+	{
+		return;
+	}
+
+	// Any remaining frames (the writer flushes before exiting, this is a safety net)
+	if (ChunkNumFrames > 0)
+	{
+		FSLWorldStateWriterStats UnusedStats;
+		WriteChunk(UnusedStats);
+	}
+
+	// Write the index
+	const int64 IndexOffset = FileOffset;
+	HeaderBuffer.Reset();
+	FSLWorldStateFileFormat::WriteValue<uint32>(HeaderBuffer, FSLWorldStateFileFormat::IndexMagic);
+	FSLWorldStateFileFormat::WriteValue<int32>(HeaderBuffer, ChunkIndex.Num());
+	for (const auto& Entry : ChunkIndex)
+	{
+		FSLWorldStateFileFormat::WriteValue<int64>(HeaderBuffer, Entry.Offset);
+		FSLWorldStateFileFormat::WriteValue<float>(HeaderBuffer, Entry.FirstTimestamp);
+		FSLWorldStateFileFormat::WriteValue<int32>(HeaderBuffer, Entry.NumFrames);
+	}
+	FSLWorldStateFileFormat::WriteValue<int64>(HeaderBuffer, IndexOffset);
+	FSLWorldStateFileFormat::WriteValue<uint32>(HeaderBuffer, FSLWorldStateFileFormat::EndMagic);
+	WriteBuffer(HeaderBuffer);
+	FileHandle->Flush();
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Wrote %d chunks (%lld bytes) to %s%s"),
+		*FString(__FUNCTION__), __LINE__, ChunkIndex.Num(), FileOffset, *FilePath,
+		bWriteFailed ? TEXT(" (with write errors)..") : TEXT(".."));
+
+	// Closes the file
+	delete FileHandle;
+	FileHandle = nullptr;
+}
+
+// Write the current chunk to disk and add it to the index
+bool FSLWorldStateFileSink::WriteChunk(FSLWorldStateWriterStats& Stats)
+{
+	if (ChunkNumFrames == 0 || FileHandle == nullptr)
+	{
+		return true;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	FChunkEntry Entry;
+	Entry.Offset = FileOffset;
+	Entry.FirstTimestamp = ChunkFirstTimestamp;
+	Entry.NumFrames = ChunkNumFrames;
+
+	HeaderBuffer.Reset();
+	FSLWorldStateFileFormat::WriteValue<uint32>(HeaderBuffer, FSLWorldStateFileFormat::ChunkMagic);
+	FSLWorldStateFileFormat::WriteValue<int32>(HeaderBuffer, ChunkNumFrames);
+	FSLWorldStateFileFormat::WriteValue<int32>(HeaderBuffer, ChunkBuffer.Num());
+	FSLWorldStateFileFormat::WriteValue<uint32>(HeaderBuffer, FCrc::MemCrc32(ChunkBuffer.GetData(), ChunkBuffer.Num()));
+
+	// Flush after every chunk, a crash loses at most the current chunk
+	const bool bRetVal = WriteBuffer(HeaderBuffer) && WriteBuffer(ChunkBuffer) && FileHandle->Flush();
+	if (bRetVal)
+	{
+		ChunkIndex.Add(Entry);
+	}
+
+	ChunkBuffer.Reset();
+	ChunkNumFrames = 0;
+	FSLWorldStateWriterStats::AddDuration(Stats.UploadTimeUs, FPlatformTime::Seconds() - StartTime);
+	return bRetVal;
+}
+
+// Write the buffer to the file (false on failure)
+bool FSLWorldStateFileSink::WriteBuffer(const TArray<uint8>& Buffer)
+{
+	if (bWriteFailed)
+	{
+		return false;
+	}
+	if (!FileHandle->Write(Buffer.GetData(), Buffer.Num()))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not write %d bytes to %s, stopping the file output.."),
+			*FString(__FUNCTION__), __LINE__, Buffer.Num(), *FilePath);
+		bWriteFailed = true;
+		return false;
+	}
+	FileOffset += Buffer.Num();
+	return true;
+}
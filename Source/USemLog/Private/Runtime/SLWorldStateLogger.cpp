@@ -2,6 +2,7 @@
 // Author: Andrei Haidu (http://haidu.eu)
 
 #include "Runtime/SLWorldStateLogger.h"
+#include "Runtime/SLWorldStateFileImporter.h"
 #include "Individuals/SLIndividualManager.h"
 #include "Utils/SLUuid.h"
 #include "EngineUtils.h"
@@ -106,6 +107,25 @@ void ASLWorldStateLogger::EndPlay(const EEndPlayReason::Type EndPlayReason)
 	}
 }
 
+#if WITH_EDITOR
+// Called when a property is changed in the editor
+void ASLWorldStateLogger::PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// Get the changed property name
+	FName PropertyName = (PropertyChangedEvent.Property != NULL) ?
+		PropertyChangedEvent.Property->GetFName() : NAME_None;
+
+	/* Button hacks */
+	if (PropertyName == GET_MEMBER_NAME_CHECKED(ASLWorldStateLogger, bImportLocalFileButton))
+	{
+		bImportLocalFileButton = false;
+		FSLWorldStateFileImporter::Import(LoggerParameters, LocationParameters, DBServerParameters);
+	}
+}
+#endif // WITH_EDITOR
+
 // Init logger (called when the logger is synced externally)
 void ASLWorldStateLogger::Init(const FSLWorldStateLoggerParams& InLoggerParameters,
 	const FSLLoggerLocationParams& InLocationParameters,
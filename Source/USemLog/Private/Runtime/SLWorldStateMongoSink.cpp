@@ -0,0 +1,907 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Runtime/SLWorldStateMongoSink.h"
+#include "Runtime/SLWorldStateBinaryFormat.h"
+#include "Mongo/SLMongoTrajectoryIndexer.h"
+
+// UUtils
+#if SL_WITH_ROS_CONVERSIONS
+#include "Conversions.h"
+#endif // SL_WITH_ROS_CONVERSIONS
+
+// Ctor
+FSLWorldStateMongoSink::FSLWorldStateMongoSink()
+{
+	bIsInit = false;
+	Schema = ESLWorldStateSchema::Documents;
+	bBulkWrite = false;
+	bBulkOrdered = false;
+	BulkMaxFrames = 50;
+	BulkMaxDuration = 0.5;
+	BulkNumFrames = 0;
+	BulkStartTime = 0.0;
+	bIndexTrajectories = false;
+	TrajectoryBucketDuration = 10.f;
+#if SL_WITH_LIBMONGO_C
+	uri = nullptr;
+	client = nullptr;
+	database = nullptr;
+	collection = nullptr;
+	write_concern = nullptr;
+	insert_opts = nullptr;
+	bulk_op = nullptr;
+#endif //SL_WITH_LIBMONGO_C
+}
+
+// Dtor
+FSLWorldStateMongoSink::~FSLWorldStateMongoSink()
+{
+	if (bIsInit)
+	{
+		Finish();
+	}
+
+#if SL_WITH_LIBMONGO_C
+	if (bulk_op)
+	{
+		mongoc_bulk_operation_destroy(bulk_op);
+	}
+	if (insert_opts)
+	{
+		bson_destroy(insert_opts);
+	}
+	if (write_concern)
+	{
+		mongoc_write_concern_destroy(write_concern);
+	}
+#endif //SL_WITH_LIBMONGO_C
+}
+
+// Connect to the db, write the metadata and set the write options
+bool FSLWorldStateMongoSink::Init(const FSLWorldStateIndividualsTable& InIndividualsTable,
+	const FSLWorldStateLoggerParams& InLoggerParameters,
+	const FSLLoggerLocationParams& InLocationParameters,
+	const FSLLoggerDBServerParams& InDBServerParameters)
+{
+	if (bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Mongo sink is already initialized.."), *FString(__FUNCTION__), __LINE__);
+		return true;
+	}
+
+#if SL_WITH_LIBMONGO_C
+	IndividualsTable = InIndividualsTable;
+	Schema = InLoggerParameters.Schema;
+
+	// Bulk write parameters
+	bBulkWrite = InLoggerParameters.bBulkWrite;
+	bBulkOrdered = InLoggerParameters.bBulkOrdered;
+	BulkMaxFrames = FMath::Max(InLoggerParameters.BulkMaxFrames, 1);
+	BulkMaxDuration = FMath::Max(InLoggerParameters.BulkMaxDurationMs, 1) / 1000.0;
+
+	// Post-episode trajectory indexing
+	bIndexTrajectories = InLoggerParameters.bIndexTrajectories;
+	TrajectoryBucketDuration = FMath::Max(InLoggerParameters.TrajectoryBucketDuration, 0.1f);
+
+	// Connect to the database
+	if (!Connect(InLocationParameters.TaskId, InLocationParameters.EpisodeId,
+		InDBServerParameters.Ip, InDBServerParameters.Port,
+		InLocationParameters.bOverwrite))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d World state mongo sink could not connect to the database.."), *FString(__FUNCTION__), __LINE__);
+		Disconnect();
+		return false;
+	}
+
+	// Write metadata if needed
+	const FString MetaCollName = InLocationParameters.TaskId + ".meta";
+	if (InLoggerParameters.bIncludeMetadata)
+	{
+		WriteMetadata(MetaCollName, InLoggerParameters.bOverwriteMetadata);
+	}
+
+	// The compact binary schema references the individuals by their metadata indexes
+	if (Schema == ESLWorldStateSchema::CompactBinary)
+	{
+		TMap<FString, int32> IdToMetaIdx;
+		if (!ReadMetadataIndexes(MetaCollName, IdToMetaIdx) || !SetMetadataIndexes(IdToMetaIdx))
+		{
+			Disconnect();
+			return false;
+		}
+	}
+
+	// Write acknowledgement (journaling is only valid with acknowledged writes)
+	write_concern = mongoc_write_concern_new();
+	if (InLoggerParameters.WriteConcern == ESLWorldStateWriteConcern::Unacknowledged)
+	{
+		mongoc_write_concern_set_w(write_concern, MONGOC_WRITE_CONCERN_W_UNACKNOWLEDGED);
+	}
+	else
+	{
+		mongoc_write_concern_set_w(write_concern, 1);
+		mongoc_write_concern_set_journal(write_concern,
+			InLoggerParameters.WriteConcern == ESLWorldStateWriteConcern::Journaled);
+	}
+
+	insert_opts = bson_new();
+	if (!mongoc_write_concern_append(write_concern, insert_opts))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set the write concern.."), *FString(__FUNCTION__), __LINE__);
+		Disconnect();
+		return false;
+	}
+
+	bIsInit = true;
+	return true;
+#else
+	UE_LOG(LogTemp, Error, TEXT("%s::%d SL_WITH_LIBMONGO_C flag is 0, aborting.."),
+		*FString(__func__), __LINE__);
+	return false;
+#endif //SL_WITH_LIBMONGO_C
+}
+
+// Serialize and upload (or append to the bulk) the snapshot
+int32 FSLWorldStateMongoSink::Write(const FSLWorldStateSnapshot& Snapshot, FSLWorldStateWriterStats& Stats)
+{
+	// Count the number of entries written to the document (if 0, skip upload)
+	int32 Num = 0;
+
+#if SL_WITH_LIBMONGO_C
+	const double SerializeStartTime = FPlatformTime::Seconds();
+
+	bson_t* ws_doc;
+	ws_doc = bson_new();
+
+	AddTimestamp(Snapshot.Timestamp, ws_doc);
+
+	if (Schema == ESLWorldStateSchema::CompactBinary)
+	{
+		BSON_APPEND_INT32(ws_doc, "schema", FSLWorldStateBinaryFormat::SchemaVersion);
+		Num += AddIndividualsBinary(Snapshot, ws_doc);
+		Num += AddSkeletalIndividualsBinary(Snapshot, ws_doc);
+	}
+	else
+	{
+		Num += AddIndividuals(Snapshot, ws_doc);
+		Num += AddSkeletalIndividals(Snapshot, ws_doc);
+	}
+
+	const double UploadStartTime = FPlatformTime::Seconds();
+	FSLWorldStateWriterStats::AddDuration(Stats.SerializeTimeUs, UploadStartTime - SerializeStartTime);
+
+	// Write only if there are any entries in the document
+	if (Num > 0)
+	{
+		UploadDoc(ws_doc, Stats);
+		if (!bBulkWrite)
+		{
+			FSLWorldStateWriterStats::AddDuration(Stats.UploadTimeUs, FPlatformTime::Seconds() - UploadStartTime);
+		}
+	}
+
+	// Clean up
+	bson_destroy(ws_doc);
+#endif //SL_WITH_LIBMONGO_C
+
+	return Num;
+}
+
+// Flush the bulk operation if it is older than the max duration
+void FSLWorldStateMongoSink::Tick(FSLWorldStateWriterStats& Stats)
+{
+#if SL_WITH_LIBMONGO_C
+	if (bulk_op != nullptr && FPlatformTime::Seconds() - BulkStartTime > BulkMaxDuration)
+	{
+		FlushBulk(Stats);
+	}
+#endif //SL_WITH_LIBMONGO_C
+}
+
+// Flush the bulk operation
+void FSLWorldStateMongoSink::Flush(FSLWorldStateWriterStats& Stats)
+{
+#if SL_WITH_LIBMONGO_C
+	FlushBulk(Stats);
+#endif //SL_WITH_LIBMONGO_C
+}
+
+// Create indexes, build the trajectory collection (if requested) and disconnect
+void FSLWorldStateMongoSink::Finish()
+{
+	if (!bIsInit)
+	{
+		return;
+	}
+	CreateIndexes();
+#if SL_WITH_LIBMONGO_C
+	if (bIndexTrajectories)
+	{
+		// The compact binary records reference the individuals by their metadata indexes
+		TArray<FString> MetaIndividualIds;
+		if (Schema == ESLWorldStateSchema::CompactBinary)
+		{
+			for (int32 Idx = 0; Idx < MetaIndexes.Num(); ++Idx)
+			{
+				if (MetaIndexes[Idx] >= MetaIndividualIds.Num())
+				{
+					MetaIndividualIds.SetNum(MetaIndexes[Idx] + 1);
+				}
+				MetaIndividualIds[MetaIndexes[Idx]] = IndividualsTable.Ids[Idx];
+			}
+		}
+		FSLMongoTrajectoryIndexer::Build(database, collection, Schema == ESLWorldStateSchema::CompactBinary,
+			MetaIndividualIds, TrajectoryBucketDuration);
+	}
+#endif //SL_WITH_LIBMONGO_C
+	Disconnect();
+	bIsInit = false;
+}
+
+// Wake up often enough to respect the bulk duration
+uint32 FSLWorldStateMongoSink::GetTickIntervalMs() const
+{
+	return bBulkWrite ? FMath::Clamp<uint32>(BulkMaxDuration * 1000.0, 1, 100) : 100;
+}
+
+// Map the individuals table to the metadata collection indexes
+bool FSLWorldStateMongoSink::SetMetadataIndexes(const TMap<FString, int32>& IdToMetaIdx)
+{
+	MetaIndexes.Reset(IndividualsTable.Num());
+	for (const auto& Id : IndividualsTable.Ids)
+	{
+		if (const int32* MetaIdx = IdToMetaIdx.Find(Id))
+		{
+			MetaIndexes.Add(*MetaIdx);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Individual %s is missing from the metadata collection (overwrite the metadata).."),
+				*FString(__FUNCTION__), __LINE__, *Id);
+			return false;
+		}
+	}
+	return true;
+}
+
+// Connect to the db
+bool FSLWorldStateMongoSink::Connect(const FString& DBName, const FString& CollName, const FString& ServerIp,
+		uint16 ServerPort, bool bOverwrite)
+{
+#if SL_WITH_LIBMONGO_C
+	// Required to initialize libmongoc's internals	
+	mongoc_init();
+
+	// Stores any error that might appear during the connection
+	bson_error_t error;
+
+	// Safely create a MongoDB URI object from the given string
+	FString Uri = TEXT("mongodb://") + ServerIp + TEXT(":") + FString::FromInt(ServerPort);
+	uri = mongoc_uri_new_with_error(TCHAR_TO_UTF8(*Uri), &error);
+	if (!uri)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s; [Uri=%s]"),
+			*FString(__func__), __LINE__, *FString(error.message), *Uri);
+		return false;
+	}
+
+	// Create a new client instance
+	client = mongoc_client_new_from_uri(uri);
+	if (!client)
+	{
+		return false;
+	}
+
+	// Register the application name so we can track it in the profile logs on the server
+	mongoc_client_set_appname(client, TCHAR_TO_UTF8(*("SL_WorldStateWriter_" + CollName)));
+
+	// Get a handle on the database "db_name" and meta_coll "coll_name"
+	database = mongoc_client_get_database(client, TCHAR_TO_UTF8(*DBName));
+
+	// Check if the meta_coll already exists
+	if (mongoc_database_has_collection(database, TCHAR_TO_UTF8(*CollName), &error))
+	{
+		if (bOverwrite)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d World state collection %s already exists, will be removed and overwritten.."),
+				*FString(__func__), __LINE__, *CollName);
+			if (!mongoc_collection_drop(mongoc_database_get_collection(database, TCHAR_TO_UTF8(*CollName)), &error))
+			{
+				UE_LOG(LogTemp, Error, TEXT("%s::%d Could not drop collection, err.:%s;"),
+					*FString(__func__), __LINE__, *FString(error.message));
+				return false;
+			}
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d World state collection %s already exists and should not be overwritten, skipping metadata logging.."),
+				*FString(__func__), __LINE__, *CollName);
+			return false;
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Creating collection %s.%s .."),
+			*FString(__func__), __LINE__, *DBName, *CollName);
+	}
+
+	collection = mongoc_client_get_collection(client, TCHAR_TO_UTF8(*DBName), TCHAR_TO_UTF8(*CollName));
+
+	// Check server. Ping the "admin" database
+	bson_t* server_ping_cmd;
+	server_ping_cmd = BCON_NEW("ping", BCON_INT32(1));
+	if (!mongoc_client_command_simple(client, "admin", server_ping_cmd, NULL, NULL, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Check server err.: %s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		bson_destroy(server_ping_cmd);
+		return false;
+	}
+
+	bson_destroy(server_ping_cmd);
+	return true;
+#else
+	UE_LOG(LogTemp, Error, TEXT("%s::%d SL_WITH_LIBMONGO_C flag is 0, aborting.."),
+		*FString(__func__), __LINE__);
+	return false;
+#endif //SL_WITH_LIBMONGO_C
+}
+
+// Write metadata (collname + .meta)
+bool FSLWorldStateMongoSink::WriteMetadata(const FString& MetaCollName, bool bOverwrite)
+{
+#if SL_WITH_LIBMONGO_C
+	bson_error_t error;
+	mongoc_collection_t* meta_coll;
+	meta_coll = mongoc_database_get_collection(database, TCHAR_TO_UTF8(*MetaCollName));
+	bson_t* query;
+
+	// Query for any previous individuals metadata
+	query = bson_new();
+	BSON_APPEND_UTF8(query, "type_id", "individuals");
+
+	// Check if there is any previous metadata logged
+	int64_t count = mongoc_collection_count_documents(meta_coll, query, NULL, NULL, NULL, &error);
+	if (count < 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.: %s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+	}
+	else if (count > 0)
+	{
+		// Remove any previously written document with the type_id:individuals
+		if (bOverwrite)
+		{
+			UE_LOG(LogTemp, Log, TEXT("%s::%d Individuals metadata is already logged, removing previous data.."),
+				*FString(__FUNCTION__), __LINE__);
+			if (!mongoc_collection_delete_many(meta_coll, query, NULL, NULL, &error))
+			{
+				UE_LOG(LogTemp, Error, TEXT("%s::%d Err.: %s"),
+					*FString(__func__), __LINE__, *FString(error.message));
+			}
+		}
+		else
+		{
+			UE_LOG(LogTemp, Log, TEXT("%s::%d Individuals metadata is already logged, skipping.."),
+				*FString(__FUNCTION__), __LINE__);
+			return true;
+		}
+	}
+
+
+	// No previous metadata found, writing new one
+	bson_t* meta_doc;
+	meta_doc = bson_new();
+
+	// Add type
+	BSON_APPEND_UTF8(meta_doc, "type_id", "individuals");
+
+	// Add individuals data
+	int32 Num = AddIndividualsMetadata(meta_doc);
+
+	bool RetVal = true;
+	if(Num > 0)
+	{
+		
+		if (!mongoc_collection_insert_one(meta_coll, meta_doc, NULL, NULL, &error))
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Err.: %s"),
+				*FString(__func__), __LINE__, *FString(error.message));
+			RetVal = false;
+		}
+	}
+	else
+	{
+		RetVal = false;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Wrote %d number of individuals to the meta collection %s.."),
+		*FString(__FUNCTION__), __LINE__, Num, *MetaCollName);
+
+	// Clean up
+	bson_destroy(meta_doc);
+	mongoc_collection_destroy(meta_coll);
+	return RetVal;
+#else
+	UE_LOG(LogTemp, Error, TEXT("%s::%d SL_WITH_LIBMONGO_C flag is 0, aborting.."),
+		*FString(__func__), __LINE__);
+	return false;
+#endif //SL_WITH_LIBMONGO_C
+}
+
+// Read the individual id to index mapping from the metadata collection
+bool FSLWorldStateMongoSink::ReadMetadataIndexes(const FString& MetaCollName, TMap<FString, int32>& OutIdToMetaIdx)
+{
+#if SL_WITH_LIBMONGO_C
+	mongoc_collection_t* meta_coll;
+	meta_coll = mongoc_database_get_collection(database, TCHAR_TO_UTF8(*MetaCollName));
+	bson_t* filter;
+	const bson_t* doc;
+	mongoc_cursor_t* cursor;
+	bson_error_t error;
+
+	filter = BCON_NEW("type_id", BCON_UTF8("individuals"));
+	cursor = mongoc_collection_find_with_opts(meta_coll, filter, NULL, NULL);
+
+	// The index is the position of the individual in the metadata array
+	if (mongoc_cursor_next(cursor, &doc))
+	{
+		bson_iter_t iter;
+		bson_iter_t individuals_iter;
+		if (bson_iter_init_find(&iter, doc, "individuals") && bson_iter_recurse(&iter, &individuals_iter))
+		{
+			int32 MetaIdx = 0;
+			while (bson_iter_next(&individuals_iter))
+			{
+				bson_iter_t individual_iter;
+				if (bson_iter_recurse(&individuals_iter, &individual_iter) && bson_iter_find(&individual_iter, "id"))
+				{
+					OutIdToMetaIdx.Add(FString(UTF8_TO_TCHAR(bson_iter_utf8(&individual_iter, NULL))), MetaIdx);
+				}
+				MetaIdx++;
+			}
+		}
+	}
+	
+	if (mongoc_cursor_error(cursor, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.: %s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+	}
+
+	// Clean up
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(filter);
+	mongoc_collection_destroy(meta_coll);
+
+	if (OutIdToMetaIdx.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d No individuals metadata found in %s, the compact binary schema requires it.."),
+			*FString(__FUNCTION__), __LINE__, *MetaCollName);
+		return false;
+	}
+	return true;
+#else
+	return false;
+#endif //SL_WITH_LIBMONGO_C
+}
+
+#if SL_WITH_LIBMONGO_C
+// Add individuals metadata
+int32 FSLWorldStateMongoSink::AddIndividualsMetadata(bson_t* doc)
+{
+	int32 Num = 0;
+	bson_t arr_obj;
+	uint32_t arr_idx = 0;
+
+	BSON_APPEND_ARRAY_BEGIN(doc, "individuals", &arr_obj);
+	for (int32 Idx = 0; Idx < IndividualsTable.Num(); ++Idx)
+	{
+		bson_t individual_obj;
+		char idx_str[16];
+		const char* idx_key;
+
+		bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
+		BSON_APPEND_DOCUMENT_BEGIN(&arr_obj, idx_key, &individual_obj);
+
+			// Id
+			BSON_APPEND_UTF8(&individual_obj, "id", TCHAR_TO_UTF8(*IndividualsTable.Ids[Idx]));
+			// Class
+			BSON_APPEND_UTF8(&individual_obj, "class", TCHAR_TO_UTF8(*IndividualsTable.Classes[Idx]));
+		
+		bson_append_document_end(&arr_obj, &individual_obj);
+
+		arr_idx++;
+		Num++;
+	}
+	bson_append_array_end(doc, &arr_obj);
+	return Num;
+}
+#endif //SL_WITH_LIBMONGO_C	
+
+// Disconnect and clean db connection
+void FSLWorldStateMongoSink::Disconnect()
+{
+#if SL_WITH_LIBMONGO_C
+	// Release handles and clean up mongoc
+	if (collection)
+	{
+		mongoc_collection_destroy(collection);
+		collection = nullptr;
+	}
+	if (database)
+	{
+		mongoc_database_destroy(database);
+		database = nullptr;
+	}
+	if (client)
+	{
+		mongoc_client_destroy(client);
+		client = nullptr;
+	}
+	if (uri)
+	{
+		mongoc_uri_destroy(uri);
+		uri = nullptr;
+	}
+	mongoc_cleanup();
+#endif //SL_WITH_LIBMONGO_C
+}
+
+// Create indexes on the inserted data
+bool FSLWorldStateMongoSink::CreateIndexes() const
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d Not connected to the db, could not create indexes.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+#if SL_WITH_LIBMONGO_C
+	bson_t* index_command;
+	bson_error_t error;
+	
+	bson_t idx_ts;
+	bson_init(&idx_ts);
+	BSON_APPEND_INT32(&idx_ts, "timestamp", 1);
+	char* idx_ts_chr = mongoc_collection_keys_to_index_string(&idx_ts);
+
+	bson_t idx_individuals_id;
+	bson_init(&idx_individuals_id);
+	// The compact binary schema is matched by the metadata indexes instead of the ids
+	const bool bCompactBinary = Schema == ESLWorldStateSchema::CompactBinary;
+	BSON_APPEND_INT32(&idx_individuals_id, bCompactBinary ? FSLWorldStateBinaryFormat::IndividualsIdxKey : "individuals.id", 1);
+	char* idx_individuals_id_chr = mongoc_collection_keys_to_index_string(&idx_individuals_id);
+
+	bson_t idx_skel_individuals_id;
+	bson_init(&idx_skel_individuals_id);
+	BSON_APPEND_INT32(&idx_skel_individuals_id, bCompactBinary ? FSLWorldStateBinaryFormat::SkelIndividualsIdxKey : "skel_individuals.id", 1);
+	char* idx_skel_individuals_id_chr = mongoc_collection_keys_to_index_string(&idx_skel_individuals_id);
+
+	index_command = BCON_NEW("createIndexes",
+			BCON_UTF8(mongoc_collection_get_name(collection)),
+			"indexes",
+			"[",
+				"{",
+					"key", BCON_DOCUMENT(&idx_ts),
+					"name", BCON_UTF8(idx_ts_chr),
+					"unique", BCON_BOOL(true),
+				"}",
+				"{",
+					"key", BCON_DOCUMENT(&idx_individuals_id),
+					"name",	BCON_UTF8(idx_individuals_id_chr),
+					//"unique", //BCON_BOOL(false),
+				"}",
+				"{",
+					"key", BCON_DOCUMENT(&idx_skel_individuals_id),
+					"name", BCON_UTF8(idx_skel_individuals_id_chr),
+					//"unique", //BCON_BOOL(false),
+				"}",
+			"]");
+
+	bool bRetVal = true;
+	if (!mongoc_collection_write_command_with_opts(collection, index_command, NULL/*opts*/, NULL/*reply*/, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Create indexes err.: %s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		bRetVal = false;
+	}
+
+	// Clean up
+	bson_destroy(index_command);
+	bson_free(idx_ts_chr);
+	bson_free(idx_individuals_id_chr);
+	return bRetVal;
+#endif //SL_WITH_LIBMONGO_C
+
+	return false;
+}
+
+#if SL_WITH_LIBMONGO_C
+// Add timestamp to the bson doc
+void FSLWorldStateMongoSink::AddTimestamp(float Timestamp, bson_t* doc)
+{
+	BSON_APPEND_DOUBLE(doc, "timestamp", Timestamp);
+}
+
+// Add the individuals of the snapshot (return the number of individuals added)
+int32 FSLWorldStateMongoSink::AddIndividuals(const FSLWorldStateSnapshot& Snapshot, bson_t* doc)
+{
+	int32 Num = 0;
+	bson_t individuals_arr;
+	uint32_t arr_idx = 0;
+
+	BSON_APPEND_ARRAY_BEGIN(doc, "individuals", &individuals_arr);
+	for (int32 EntryIdx = 0; EntryIdx < Snapshot.IndividualIndexes.Num(); ++EntryIdx)
+	{
+		bson_t individual_obj;
+		char idx_str[16];
+		const char* idx_key;
+
+		bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
+		BSON_APPEND_DOCUMENT_BEGIN(&individuals_arr, idx_key, &individual_obj);
+			// Id
+			BSON_APPEND_UTF8(&individual_obj, "id", TCHAR_TO_UTF8(*IndividualsTable.Ids[Snapshot.IndividualIndexes[EntryIdx]]));
+			// Pose
+			AddPose(FSLWorldStateSnapshot::GetPose(Snapshot.IndividualPoses, EntryIdx), &individual_obj);
+		bson_append_document_end(&individuals_arr, &individual_obj);
+
+		arr_idx++;
+		Num++;
+	}
+	bson_append_array_end(doc, &individuals_arr);
+	return Num;
+}
+
+// Add skeletal individuals of the snapshot (return the number of individuals added)
+int32 FSLWorldStateMongoSink::AddSkeletalIndividals(const FSLWorldStateSnapshot& Snapshot, bson_t* doc)
+{
+	int32 Num = 0;
+	bson_t arr_obj;
+	uint32_t arr_idx = 0;
+
+	// Bones are stored consecutively for each skeletal individual
+	int32 BoneEntryIdx = 0;
+
+	BSON_APPEND_ARRAY_BEGIN(doc, "skel_individuals", &arr_obj);
+	for (int32 EntryIdx = 0; EntryIdx < Snapshot.SkeletalIndexes.Num(); ++EntryIdx)
+	{
+		bson_t individual_obj;
+		char idx_str[16];
+		const char* idx_key;
+
+		bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
+		BSON_APPEND_DOCUMENT_BEGIN(&arr_obj, idx_key, &individual_obj);
+			// Id
+			BSON_APPEND_UTF8(&individual_obj, "id", TCHAR_TO_UTF8(*IndividualsTable.Ids[Snapshot.SkeletalIndexes[EntryIdx]]));
+			// Pose
+			AddPose(FSLWorldStateSnapshot::GetPose(Snapshot.SkeletalPoses, EntryIdx), &individual_obj);
+			
+			// Bones
+			bson_t bones_arr;
+			uint32_t bone_arr_idx = 0;
+			BSON_APPEND_ARRAY_BEGIN(&individual_obj, "bones", &bones_arr);
+			const int32 BoneEntryEndIdx = BoneEntryIdx + Snapshot.SkeletalBoneNums[EntryIdx];
+			for (; BoneEntryIdx < BoneEntryEndIdx; ++BoneEntryIdx)
+			{
+				bson_t bone_obj;
+				bson_uint32_to_string(bone_arr_idx, &idx_key, idx_str, sizeof idx_str);
+				BSON_APPEND_DOCUMENT_BEGIN(&bones_arr, idx_key, &bone_obj);
+					// Bone index
+					BSON_APPEND_INT32(&bone_obj, "idx", Snapshot.BoneIndexes[BoneEntryIdx]);
+					// Bone world pose
+					AddPose(FSLWorldStateSnapshot::GetPose(Snapshot.BonePoses, BoneEntryIdx), &bone_obj);
+				bson_append_document_end(&bones_arr, &bone_obj);
+				bone_arr_idx++;
+			}
+			bson_append_array_end(&individual_obj, &bones_arr);
+		bson_append_document_end(&arr_obj, &individual_obj);
+
+		arr_idx++;
+		Num++;
+	}
+	bson_append_array_end(doc, &arr_obj);
+	return Num;
+}
+
+// Add the individuals of the snapshot as a binary blob (return the number of individuals added)
+int32 FSLWorldStateMongoSink::AddIndividualsBinary(const FSLWorldStateSnapshot& Snapshot, bson_t* doc)
+{
+	const int32 Num = Snapshot.IndividualIndexes.Num();
+
+	BinBuffer.Reset(Num * FSLWorldStateBinaryFormat::IndividualRecordSize);
+	for (int32 EntryIdx = 0; EntryIdx < Num; ++EntryIdx)
+	{
+		FTransform Pose = FSLWorldStateSnapshot::GetPose(Snapshot.IndividualPoses, EntryIdx);
+#if SL_WITH_ROS_CONVERSIONS
+		FConversions::UToROS(Pose);
+#endif // SL_WITH_ROS_CONVERSIONS
+		FSLWorldStateBinaryFormat::WriteInt(BinBuffer, MetaIndexes[Snapshot.IndividualIndexes[EntryIdx]]);
+		FSLWorldStateBinaryFormat::WritePose(BinBuffer, Pose);
+	}
+
+	AddMetaIndexes(FSLWorldStateBinaryFormat::IndividualsIdxKey, Snapshot.IndividualIndexes, doc);
+	BSON_APPEND_BINARY(doc, FSLWorldStateBinaryFormat::IndividualsBinKey, BSON_SUBTYPE_BINARY, BinBuffer.GetData(), BinBuffer.Num());
+	return Num;
+}
+
+// Add the skeletal individuals of the snapshot as a binary blob (return the number of individuals added)
+int32 FSLWorldStateMongoSink::AddSkeletalIndividualsBinary(const FSLWorldStateSnapshot& Snapshot, bson_t* doc)
+{
+	const int32 Num = Snapshot.SkeletalIndexes.Num();
+
+	BinBuffer.Reset();
+	int32 BoneEntryIdx = 0;
+	for (int32 EntryIdx = 0; EntryIdx < Num; ++EntryIdx)
+	{
+		FTransform Pose = FSLWorldStateSnapshot::GetPose(Snapshot.SkeletalPoses, EntryIdx);
+#if SL_WITH_ROS_CONVERSIONS
+		FConversions::UToROS(Pose);
+#endif // SL_WITH_ROS_CONVERSIONS
+		FSLWorldStateBinaryFormat::WriteInt(BinBuffer, MetaIndexes[Snapshot.SkeletalIndexes[EntryIdx]]);
+		FSLWorldStateBinaryFormat::WritePose(BinBuffer, Pose);
+
+		const int32 NumBones = Snapshot.SkeletalBoneNums[EntryIdx];
+		FSLWorldStateBinaryFormat::WriteInt(BinBuffer, NumBones);
+		for (const int32 BoneEntryEndIdx = BoneEntryIdx + NumBones; BoneEntryIdx < BoneEntryEndIdx; ++BoneEntryIdx)
+		{
+			FTransform BonePose = FSLWorldStateSnapshot::GetPose(Snapshot.BonePoses, BoneEntryIdx);
+#if SL_WITH_ROS_CONVERSIONS
+			FConversions::UToROS(BonePose);
+#endif // SL_WITH_ROS_CONVERSIONS
+			FSLWorldStateBinaryFormat::WriteInt(BinBuffer, Snapshot.BoneIndexes[BoneEntryIdx]);
+			FSLWorldStateBinaryFormat::WritePose(BinBuffer, BonePose);
+		}
+	}
+
+	AddMetaIndexes(FSLWorldStateBinaryFormat::SkelIndividualsIdxKey, Snapshot.SkeletalIndexes, doc);
+	BSON_APPEND_BINARY(doc, FSLWorldStateBinaryFormat::SkelIndividualsBinKey, BSON_SUBTYPE_BINARY, BinBuffer.GetData(), BinBuffer.Num());
+	return Num;
+}
+
+// Add int32 array with the metadata indexes of the entries
+void FSLWorldStateMongoSink::AddMetaIndexes(const char* key, const TArray<int32>& EntryIndexes, bson_t* doc)
+{
+	bson_t idx_arr;
+	char idx_str[16];
+	const char* idx_key;
+	size_t keylen;
+
+	BSON_APPEND_ARRAY_BEGIN(doc, key, &idx_arr);
+	for (int32 EntryIdx = 0; EntryIdx < EntryIndexes.Num(); ++EntryIdx)
+	{
+		keylen = bson_uint32_to_string(EntryIdx, &idx_key, idx_str, sizeof idx_str);
+		bson_append_int32(&idx_arr, idx_key, (int)keylen, MetaIndexes[EntryIndexes[EntryIdx]]);
+	}
+	bson_append_array_end(doc, &idx_arr);
+}
+
+// Add pose document
+void FSLWorldStateMongoSink::AddPose(FTransform Pose, bson_t* doc)
+{
+#if SL_WITH_ROS_CONVERSIONS
+	FConversions::UToROS(Pose);
+#endif // SL_WITH_ROS_CONVERSIONS
+
+	bson_t child_obj_loc;
+	bson_t child_obj_rot;
+
+	BSON_APPEND_DOCUMENT_BEGIN(doc, "loc", &child_obj_loc);
+	BSON_APPEND_DOUBLE(&child_obj_loc, "x", Pose.GetLocation().X);
+	BSON_APPEND_DOUBLE(&child_obj_loc, "y", Pose.GetLocation().Y);
+	BSON_APPEND_DOUBLE(&child_obj_loc, "z", Pose.GetLocation().Z);
+	bson_append_document_end(doc, &child_obj_loc);
+
+	BSON_APPEND_DOCUMENT_BEGIN(doc, "quat", &child_obj_rot);
+	BSON_APPEND_DOUBLE(&child_obj_rot, "x", Pose.GetRotation().X);
+	BSON_APPEND_DOUBLE(&child_obj_rot, "y", Pose.GetRotation().Y);
+	BSON_APPEND_DOUBLE(&child_obj_rot, "z", Pose.GetRotation().Z);
+	BSON_APPEND_DOUBLE(&child_obj_rot, "w", Pose.GetRotation().W);
+	bson_append_document_end(doc, &child_obj_rot);
+
+	bson_t child_pose;
+	char buf[16];
+	const char* key;
+	size_t keylen;
+
+	// Write pose as array of [x y z qx qy qz qw]
+	BSON_APPEND_ARRAY_BEGIN(doc, "pose", &child_pose);
+		// x
+		keylen = bson_uint32_to_string(0, &key, buf, sizeof buf);
+		bson_append_double(&child_pose, key, (int)keylen, Pose.GetLocation().X);
+		// y
+		keylen = bson_uint32_to_string(1, &key, buf, sizeof buf);
+		bson_append_double(&child_pose, key, (int)keylen, Pose.GetLocation().Y);
+		// z
+		keylen = bson_uint32_to_string(2, &key, buf, sizeof buf);
+		bson_append_double(&child_pose, key, (int)keylen, Pose.GetLocation().Z);
+		// qx
+		keylen = bson_uint32_to_string(3, &key, buf, sizeof buf);
+		bson_append_double(&child_pose, key, (int)keylen, Pose.GetRotation().X);
+		// qy
+		keylen = bson_uint32_to_string(4, &key, buf, sizeof buf);
+		bson_append_double(&child_pose, key, (int)keylen, Pose.GetRotation().Y);
+		// qz
+		keylen = bson_uint32_to_string(5, &key, buf, sizeof buf);
+		bson_append_double(&child_pose, key, (int)keylen, Pose.GetRotation().Z);
+		// qw
+		keylen = bson_uint32_to_string(6, &key, buf, sizeof buf);
+		bson_append_double(&child_pose, key, (int)keylen, Pose.GetRotation().W);
+	bson_append_array_end(doc, &child_pose);
+}
+
+// Write the bson doc to the collection (or append it to the bulk operation)
+bool FSLWorldStateMongoSink::UploadDoc(bson_t* doc, FSLWorldStateWriterStats& Stats)
+{
+	bson_error_t error;
+	if (!bBulkWrite)
+	{
+		if (!mongoc_collection_insert_one(collection, doc, insert_opts, NULL, &error))
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Err.: %s"),
+				*FString(__func__), __LINE__, *FString(error.message));
+			return false;
+		}
+		return true;
+	}
+
+	// Start a new bulk operation
+	if (bulk_op == nullptr)
+	{
+		bson_t bulk_opts;
+		bson_init(&bulk_opts);
+		BSON_APPEND_BOOL(&bulk_opts, "ordered", bBulkOrdered);
+		mongoc_write_concern_append(write_concern, &bulk_opts);
+		bulk_op = mongoc_collection_create_bulk_operation_with_opts(collection, &bulk_opts);
+		bson_destroy(&bulk_opts);
+		BulkNumFrames = 0;
+		BulkStartTime = FPlatformTime::Seconds();
+	}
+
+	// The document is copied into the bulk operation
+	if (!mongoc_bulk_operation_insert_with_opts(bulk_op, doc, NULL, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.: %s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		return false;
+	}
+	BulkNumFrames++;
+
+	if (BulkNumFrames >= BulkMaxFrames)
+	{
+		return FlushBulk(Stats);
+	}
+	return true;
+}
+
+// Execute and clear the current bulk operation
+bool FSLWorldStateMongoSink::FlushBulk(FSLWorldStateWriterStats& Stats)
+{
+	if (bulk_op == nullptr)
+	{
+		return true;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	bool bRetVal = true;
+	bson_t reply;
+	bson_error_t error;
+	if (!mongoc_bulk_operation_execute(bulk_op, &reply, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Bulk insert of %d frames err.: %s"),
+			*FString(__func__), __LINE__, BulkNumFrames, *FString(error.message));
+		bRetVal = false;
+	}
+
+	// Clean up
+	bson_destroy(&reply);
+	mongoc_bulk_operation_destroy(bulk_op);
+	bulk_op = nullptr;
+	BulkNumFrames = 0;
+
+	Stats.NumBulkFlushes.Increment();
+	FSLWorldStateWriterStats::AddDuration(Stats.UploadTimeUs, FPlatformTime::Seconds() - StartTime);
+	return bRetVal;
+}
+#endif //SL_WITH_LIBMONGO_C
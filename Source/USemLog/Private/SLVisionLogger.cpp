@@ -3,6 +3,8 @@
 
 #include "SLVisionLogger.h"
 #include "Vision/SLVisionPoseableMeshActor.h"
+#include "CV/SLCVMaskMaterialLibrary.h"
+#include "CV/SLCVUtils.h"
 
 #include "EngineUtils.h"
 #include "GameFramework/PlayerController.h"
@@ -24,6 +26,9 @@ USLVisionLogger::USLVisionLogger() : bIsInit(false), bIsStarted(false), bIsFinis
 	CurrVirtualCameraIdx = INDEX_NONE;
 	CurrTimestamp = -1.f;
 	PrevViewMode = ESLVisionViewMode::NONE;
+	OverlapCalc = nullptr;
+	SceneCaptureRenderer = nullptr;
+	MaskMaterials = nullptr;
 
 	ViewModes.Add(ESLVisionViewMode::Color);
 	ViewModes.Add(ESLVisionViewMode::Unlit);
@@ -64,25 +69,32 @@ void USLVisionLogger::Init(const FString& InTaskId, const FString& InEpisodeId,
 		// Set rendering parameters
 		InitRenderParameters();
 
+		InitPhaseTimes.Empty();
+		double PhaseStartTime = FPlatformTime::Seconds();
+
 		// Disable physics on all entities and make sure they are movable
 		InitWorldEntities();
 
 		// Create movable clones of the skeletal meshes, hide originals (call before loading the episode data)
 		CreatePoseableMeshesClones();
+		AddInitPhaseTime(TEXT("WorldEntities"), PhaseStartTime);
 
 		// Connect to the database for writing the image data
+		PhaseStartTime = FPlatformTime::Seconds();
 		if (!DBHandler.Connect(InTaskId, InEpisodeId, InServerIp, InServerPort, bOverwriteVisionData))
 		{
 			UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not connect to the DB.."), *FString(__func__), __LINE__);
 			return;
 		}
 
-		// Download the whole episode data (make sure the poseable mesh clones are created before this)
-		if (!DBHandler.GetEpisodeData(Params.UpdateRate, SkelToPoseableMap, Episode))
+		// Stream the episode data in the background (make sure the poseable mesh clones are created before this)
+		if (!Episode.Init(InTaskId, InEpisodeId, InServerIp, InServerPort, Params.UpdateRate, SkelToPoseableMap, Params.MaxReadAheadFrames)
+			|| !Episode.Start())
 		{
-			UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not download the episode data.."), *FString(__func__), __LINE__);
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not start reading the episode data.."), *FString(__func__), __LINE__);
 			return;
 		}
+		AddInitPhaseTime(TEXT("EpisodeData"), PhaseStartTime);
 
 		// Make sure rendering modes are selected
 		if(ViewModes.Num() == 0)
@@ -111,6 +123,7 @@ void USLVisionLogger::Init(const FString& InTaskId, const FString& InEpisodeId,
 		// Create clones of every visible entity with a mask color
 		if(ViewModes.Contains(ESLVisionViewMode::Mask))
 		{
+			PhaseStartTime = FPlatformTime::Seconds();
 			if(CreateMaskClones())
 			{
 				// Create color to semantic data mappings on the image handler, setup the rendered to original mask mapping
@@ -128,7 +141,7 @@ void USLVisionLogger::Init(const FString& InTaskId, const FString& InEpisodeId,
 					// Create the overlap calc object
 					OverlapCalc = NewObject<USLVisionOverlapCalc>(this);
 					// Give control to the overlap calc to pause and start the vision logger
-					OverlapCalc->Init(this, Resolution/Params.OverlapResolutionDivisor, SaveLocallyFolderName);
+					OverlapCalc->Init(this, Resolution/Params.OverlapResolutionDivisor, SaveLocallyFolderName, Params.bSinglePassOverlaps);
 				}
 			}
 			else
@@ -136,8 +149,58 @@ void USLVisionLogger::Init(const FString& InTaskId, const FString& InEpisodeId,
 				UE_LOG(LogTemp, Error, TEXT("%s::%d Could not create mask clones, removing mask view type.."), *FString(__func__), __LINE__);
 				ViewModes.Remove(ESLVisionViewMode::Mask);
 			}
+			AddInitPhaseTime(TEXT("MaskClones"), PhaseStartTime);
+		}
 
+		// Compress and write the images in the background while the next views are rendered
+		if (Params.MaxImagesInFlight > 0)
+		{
+			if (!ImagePipeline.Init(&DBHandler, &MaskImgHandler, Params.MaxImagesInFlight) || !ImagePipeline.Start())
+			{
+				UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not start the image pipeline, the images will be processed on the game thread.."),
+					*FString(__func__), __LINE__);
+			}
+		}
 
+		// Render all the views of a frame in one tick (the overlap calculation relies on the viewport screenshots)
+		if (Params.bUseSceneCaptures)
+		{
+			PhaseStartTime = FPlatformTime::Seconds();
+			if (OverlapCalc)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("%s::%d Scene captures are not used when calculating overlaps, rendering through the viewport.."),
+					*FString(__func__), __LINE__);
+			}
+			else
+			{
+				TArray<AActor*> MaskClones;
+				for (const auto& Pair : OrigToMaskClones)
+				{
+					MaskClones.Add(Pair.Value);
+				}
+				for (const auto& Pair : PoseableOrigToMaskClones)
+				{
+					MaskClones.Add(Pair.Value);
+				}
+
+				SceneCaptureRenderer = NewObject<USLVisionSceneCaptureRenderer>(this);
+				if (SceneCaptureRenderer->Init(VirtualCameras, ViewModes, Resolution, MaskClones))
+				{
+					SceneCaptureRenderer->OnCapturesReady.BindUObject(this, &USLVisionLogger::SceneCapturesCB);
+
+					// The mask clones are filtered by the scene captures, the viewport is not needed anymore
+					SetMaskClonesHiddenInGame(false);
+					ViewportClient->OnScreenshotCaptured().Remove(ScreenshotCallbackHandle);
+					ViewportClient->bDisableWorldRendering = true;
+				}
+				else
+				{
+					UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not init the scene capture renderer, rendering through the viewport.."),
+						*FString(__func__), __LINE__);
+					SceneCaptureRenderer = nullptr;
+				}
+			}
+			AddInitPhaseTime(TEXT("SceneCaptures"), PhaseStartTime);
 		}
 		bIsInit = true;
 	}
@@ -151,8 +214,18 @@ void USLVisionLogger::Start(const FString& EpisodeId)
 		// Hide default pawn from scene
 		GetWorld()->GetFirstPlayerController()->GetPawnOrSpectator()->SetActorHiddenInGame(true);		
 		
+		// Render all the views of the first frame with the scene captures
+		if (SceneCaptureRenderer)
+		{
+			if (SetupFirstEpisodeFrame())
+			{
+				CurrFrameData.Init(CurrTimestamp, Resolution);
+				SceneCaptureRenderer->Capture();
+				bIsStarted = true;
+			}
+		}
 		// Setup the first frame, camera and view mode
-		if (FirstStep())
+		else if (FirstStep())
 		{
 			// Init data
 			CurrFrameData.Init(CurrTimestamp, Resolution);
@@ -170,6 +243,18 @@ void USLVisionLogger::Finish(bool bForced)
 {
 	if (!bIsFinished && (bIsInit || bIsStarted))
 	{
+		// Stop rendering the scene captures
+		if (SceneCaptureRenderer)
+		{
+			SceneCaptureRenderer->Finish();
+		}
+
+		// Stop reading the episode frames
+		Episode.Finish();
+
+		// Wait for the images in flight and the frames to be written
+		ImagePipeline.Finish();
+
 		// Index the entries in the db
 		DBHandler.CreateIndexes();
 
@@ -255,6 +340,19 @@ ASLVisionPoseableMeshActor* USLVisionLogger::GetPoseableSkeletalMaskCloneFromId(
 	return nullptr;
 }
 
+// Hide or show all the mask clones (used by the overlap calculation to render only a subset of the clones)
+void USLVisionLogger::SetMaskClonesHiddenInGame(bool bHidden)
+{
+	for (const auto& Pair : OrigToMaskClones)
+	{
+		Pair.Value->SetActorHiddenInGame(bHidden);
+	}
+	for (const auto& Pair : PoseableOrigToMaskClones)
+	{
+		Pair.Value->SetActorHiddenInGame(bHidden);
+	}
+}
+
 // Trigger the screenshot on the game thread
 void USLVisionLogger::RequestScreenshot()
 {
@@ -272,8 +370,7 @@ void USLVisionLogger::RequestScreenshot()
 	//	FString::FromInt(CurrVirtualCameraIdx) + "_" + CurrViewModePostfix;
 
 	// Sec-Ms_FrameNum_Viewmode
-	CurrImageFilename = FString::Printf(TEXT("%.2f"), CurrTimestamp).Replace(TEXT("."), TEXT("-")) + "_" +
-		FString::FromInt(Episode.GetCurrIndex()) + "_" + CurrViewModePostfix;
+	SetCurrImageFilename();
 
 	GetHighResScreenshotConfig().FilenameOverride = CurrImageFilename;
 	//GetHighResScreenshotConfig().SetForce128BitRendering(true);
@@ -291,6 +388,122 @@ void USLVisionLogger::ScreenshotCB(int32 SizeX, int32 SizeY, const TArray<FColor
 	// Terminal output with the log progress
 	PrintProgress();
 
+	// The overlap calculation needs the mask data of the view right away
+	const bool bIsMask = ViewModes[CurrViewModeIdx] == ESLVisionViewMode::Mask;
+	AddImage(SizeX, SizeY, Bitmap, bIsMask && OverlapCalc);
+
+	if (bIsMask && OverlapCalc)
+	{
+		// Bind the screenshot callback for calculating overlaps
+		OverlapCalc->Start(&CurrViewData, CurrTimestamp, Episode.GetCurrIndex());
+
+		// Wait for next step until the overlaps were calculated
+		return;
+	}
+
+	// Go to next frame/camera/view mode
+	if (NextStep())
+	{
+		RequestScreenshot();
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d [%f] Finished visual logger.."),
+			*FString(__func__), __LINE__, GetWorld()->GetTimeSeconds());
+		QuitEditor();
+	}
+}
+
+// Called when the scene captures of all the views of the frame are read back
+void USLVisionLogger::SceneCapturesCB(TArray<FSLVisionCapturedImage>& Images)
+{
+	// The images are sorted by camera, then by view mode
+	for (const auto& Image : Images)
+	{
+		if (Image.CameraIdx != CurrVirtualCameraIdx)
+		{
+			// Previous view is processed, cache the data
+			if (CurrVirtualCameraIdx != INDEX_NONE)
+			{
+				CurrFrameData.Views.Emplace(CurrViewData);
+			}
+
+			// Start a new view data
+			CurrVirtualCameraIdx = Image.CameraIdx;
+			CurrViewData.Clear();
+			CurrViewData.Init(VirtualCameras[CurrVirtualCameraIdx]->GetId(), VirtualCameras[CurrVirtualCameraIdx]->GetClassName());
+		}
+
+		CurrViewModeIdx = Image.ViewModeIdx;
+		CurrViewModePostfix = GetViewModePostfix(ViewModes[CurrViewModeIdx]);
+		SetCurrImageFilename();
+
+		// Terminal output with the log progress
+		PrintProgress();
+
+		// Failed read backs are skipped, the processing expects the full image size
+		if (!Image.bIsValid)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Skipping the image %s, it could not be read back.."),
+				*FString(__func__), __LINE__, *CurrImageFilename);
+			continue;
+		}
+		AddImage(Image.Size.X, Image.Size.Y, Image.Bitmap, false);
+	}
+
+	// Last view of the frame
+	if (CurrVirtualCameraIdx != INDEX_NONE)
+	{
+		CurrFrameData.Views.Emplace(CurrViewData);
+		CurrViewData.Clear();
+	}
+	CurrVirtualCameraIdx = INDEX_NONE;
+	CurrViewModeIdx = INDEX_NONE;
+
+	// Write vision frame data to the database
+	WriteCurrFrame();
+
+	if (SetupNextEpisodeFrame())
+	{
+		CurrFrameData.Clear();
+		CurrFrameData.Init(CurrTimestamp, Resolution);
+		SceneCaptureRenderer->Capture();
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d [%f] Finished visual logger.."),
+			*FString(__func__), __LINE__, GetWorld()->GetTimeSeconds());
+		QuitEditor();
+	}
+}
+
+// Add the image of the current view and view mode (processed in the background if the pipeline is running)
+void USLVisionLogger::AddImage(int32 SizeX, int32 SizeY, const TArray<FColor>& Bitmap, bool bRestoreMaskOnGameThread)
+{
+	if (!ImagePipeline.IsStarted())
+	{
+		ProcessImage(SizeX, SizeY, Bitmap);
+		return;
+	}
+
+	const bool bIsMask = ViewModes[CurrViewModeIdx] == ESLVisionViewMode::Mask;
+	if (bIsMask && bRestoreMaskOnGameThread)
+	{
+		TArray<FColor>& BitmapRef = const_cast<TArray<FColor>&>(Bitmap);
+		MaskImgHandler.GetDataAndRestoreImage(BitmapRef, SizeX, SizeY, CurrViewData);
+	}
+
+	// Compress (and restore) the image in the background while the next view is rendered,
+	// the image data is filled in by the pipeline before the frame is written
+	const FString LocalPath = SaveLocallyFolderName.IsEmpty() ? FString() : GetLocalImagePath();
+	ImagePipeline.AddImage(CurrFrameData.Views.Num(), CurrViewData.Images.Num(), SizeX, SizeY, Bitmap,
+		bIsMask && !bRestoreMaskOnGameThread, LocalPath);
+	CurrViewData.Images.Emplace(FSLVisionImageData(GetViewModeName(ViewModes[CurrViewModeIdx]), TArray<uint8>()));
+}
+
+// Restore (mask), compress and cache the image on the game thread
+void USLVisionLogger::ProcessImage(int32 SizeX, int32 SizeY, const TArray<FColor>& Bitmap)
+{
 	// Compress image
 	TArray<uint8> CompressedBitmap;
 
@@ -305,24 +518,6 @@ void USLVisionLogger::ScreenshotCB(int32 SizeX, int32 SizeY, const TArray<FColor
 
 		// Compress the restored bitmap image
 		FImageUtils::CompressImageArray(SizeX, SizeY, BitmapRef, CompressedBitmap);
-	
-		if (OverlapCalc)
-		{
-			// Check if the image should be saved locally as well
-			if (!SaveLocallyFolderName.IsEmpty())
-			{
-				SaveImageLocally(CompressedBitmap);
-			}
-
-			// Cache the image binary
-			CurrViewData.Images.Emplace(FSLVisionImageData(GetViewModeName(ViewModes[CurrViewModeIdx]), CompressedBitmap));
-
-			// Bind the screenshot callback for calculating overlaps
-			OverlapCalc->Start(&CurrViewData, CurrTimestamp, Episode.GetCurrIndex());
-
-			// Wait for next step until the overlaps were calculated
-			return;
-		}
 	}
 	else
 	{
@@ -338,17 +533,19 @@ void USLVisionLogger::ScreenshotCB(int32 SizeX, int32 SizeY, const TArray<FColor
 
 	// Cache the image binary
 	CurrViewData.Images.Emplace(FSLVisionImageData(GetViewModeName(ViewModes[CurrViewModeIdx]), CompressedBitmap));
+}
 
-	// Go to next frame/camera/view mode
-	if (NextStep())
+// Write the current frame data to the database
+void USLVisionLogger::WriteCurrFrame()
+{
+	// Written once its images are processed if the pipeline is running
+	if (ImagePipeline.IsStarted())
 	{
-		RequestScreenshot();
+		ImagePipeline.AddFrame(CurrFrameData);
 	}
 	else
 	{
-		UE_LOG(LogTemp, Warning, TEXT("%s::%d [%f] Finished visual logger.."),
-			*FString(__func__), __LINE__, GetWorld()->GetTimeSeconds());
-		QuitEditor();
+		DBHandler.WriteFrame(CurrFrameData);
 	}
 }
 
@@ -404,7 +601,7 @@ bool USLVisionLogger::NextStep()
 		else
 		{
 			// Write vision frame data to the database
-			DBHandler.WriteFrame(CurrFrameData);
+			WriteCurrFrame();
 
 			if (SetupNextEpisodeFrame())
 			{
@@ -564,18 +761,14 @@ void USLVisionLogger::InitWorldEntities()
 bool USLVisionLogger::CreateMaskClones()
 {
 	// Load the default mask material
-	// this will be used as a template to create the colored mask materials to add to the clones
-	UMaterial* DefaultMaskMaterial = LoadObject<UMaterial>(this,
-		TEXT("/USemLog/CV/M_SLDefaultMask.M_SLDefaultMask"));
-	if (!DefaultMaskMaterial)
+	// this will be used as a template to create the colored mask materials (shared by the clones with the same color)
+	MaskMaterials = NewObject<USLCVMaskMaterialLibrary>(this);
+	if (!MaskMaterials->Init(TEXT("/USemLog/CV/M_SLDefaultMask.M_SLDefaultMask")))
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not load default mask material.."), *FString(__func__), __LINE__);
 		return false;
 	}
 
-	DefaultMaskMaterial->bUsedWithStaticLighting = true;
-	DefaultMaskMaterial->bUsedWithSkeletalMesh = true;
-
 	/* Static meshes */
 	TArray<AStaticMeshActor*> SMActors;
 	//FSLEntitiesManager::GetInstance()->GetStaticMeshActors(SMActors);
@@ -590,9 +783,8 @@ bool USLVisionLogger::CreateMaskClones()
 			//	UE_LOG(LogTemp, Error, TEXT("%s::%d %s has no visual mask, setting to black.."), *FString(__func__), __LINE__, *SMA->GetName());
 			//}
 			//
-			//// Create the mask material with the color
-			//UMaterialInstanceDynamic* DynamicMaskMaterial = UMaterialInstanceDynamic::Create(DefaultMaskMaterial, GetTransientPackage());
-			//DynamicMaskMaterial->SetVectorParameterValue(FName("MaskColorParam"), FLinearColor::FromSRGBColor(SemColor));
+			//// Get the (shared) mask material of the color
+			//UMaterialInstanceDynamic* DynamicMaskMaterial = MaskMaterials->GetMaterial(SemColor);
 
 			//// Create the mask clone 
 			//FActorSpawnParameters Parameters;
@@ -655,12 +847,8 @@ bool USLVisionLogger::CreateMaskClones()
 	//						*FString(__func__), __LINE__, *SkMA->GetName(), *Pair.Value.Class);
 	//				}
 
-	//				// Create the mask material with the color
-	//				UMaterialInstanceDynamic* DynamicMaskMaterial = UMaterialInstanceDynamic::Create(DefaultMaskMaterial, GetTransientPackage());
-	//				DynamicMaskMaterial->SetVectorParameterValue(FName("MaskColorParam"),
-	//					FLinearColor::FromSRGBColor(FColor::FromHex(Pair.Value.VisualMask)));
-
-	//				PMAClone->SetCustomMaterial(Pair.Value.MaterialIndex, DynamicMaskMaterial);
+	//				// Get the (shared) mask material of the color
+	//				PMAClone->SetCustomMaterial(Pair.Value.MaterialIndex, MaskMaterials->GetMaterial(SemColor));
 	//			}
 	//		}
 
@@ -759,7 +947,6 @@ void USLVisionLogger::ApplyViewMode(ESLVisionViewMode Mode)
 			ViewportClient->GetEngineShowFlags()->SetVisualizeBuffer(false);
 			GetWorld()->GetFirstPlayerController()->ConsoleCommand("viewmode lit");
 		}
-		CurrViewModePostfix = "C";
 	}
 	else if(Mode == ESLVisionViewMode::Unlit) // viewmode=unlit, buffer=false, materials=original;
 	{
@@ -781,7 +968,6 @@ void USLVisionLogger::ApplyViewMode(ESLVisionViewMode Mode)
 			ViewportClient->GetEngineShowFlags()->SetVisualizeBuffer(false);
 			GetWorld()->GetFirstPlayerController()->ConsoleCommand("viewmode unlit");
 		}
-		CurrViewModePostfix = "U";
 	}
 	else if(Mode == ESLVisionViewMode::Mask) // viewmode=unlit, buffer=false, materials=mask;
 	{
@@ -806,7 +992,6 @@ void USLVisionLogger::ApplyViewMode(ESLVisionViewMode Mode)
 			ViewportClient->GetEngineShowFlags()->SetVisualizeBuffer(false);
 			GetWorld()->GetFirstPlayerController()->ConsoleCommand("viewmode unlit");
 		}
-		CurrViewModePostfix = "M";
 	}
 	else if(Mode == ESLVisionViewMode::Depth) // viewmode=unlit, buffer=false, materials=original;
 	{
@@ -839,7 +1024,6 @@ void USLVisionLogger::ApplyViewMode(ESLVisionViewMode Mode)
 			ViewportClient->GetEngineShowFlags()->SetVisualizeBuffer(true);
 			BufferVisTargetCV->Set(*FString("SLSceneDepthToCameraPlane"));
 		}
-		CurrViewModePostfix = "D";
 	}
 	else if(Mode == ESLVisionViewMode::Normal) // viewmode=lit, buffer=true, materials=original;
 	{
@@ -872,9 +1056,10 @@ void USLVisionLogger::ApplyViewMode(ESLVisionViewMode Mode)
 			ViewportClient->GetEngineShowFlags()->SetVisualizeBuffer(true);
 			BufferVisTargetCV->Set(*FString("WorldNormal"));
 		}
-		CurrViewModePostfix = "N";
 	}
 
+	CurrViewModePostfix = GetViewModePostfix(Mode);
+
 	// Cache as previous view mode
 	PrevViewMode = Mode;
 }
@@ -936,11 +1121,17 @@ void USLVisionLogger::QuitEditor()
 
 // Save the compressed screenshot image locally
 void USLVisionLogger::SaveImageLocally(const TArray<uint8>& CompressedBitmap)
+{
+	FFileHelper::SaveArrayToFile(CompressedBitmap, *GetLocalImagePath());
+}
+
+// Path of the current image if it is saved locally
+FString USLVisionLogger::GetLocalImagePath() const
 {
 	const FString FolderName = VirtualCameras[CurrVirtualCameraIdx]->GetClassName() + "_" + CurrViewModePostfix;
 	FString Path = FPaths::ProjectDir() + "/SemLog/" + SaveLocallyFolderName + "/" + FolderName + "/" + CurrImageFilename + ".png";
 	FPaths::RemoveDuplicateSlashes(Path);
-	FFileHelper::SaveArrayToFile(CompressedBitmap, *Path);
+	return Path;
 }
 
 // Output progress to terminal
@@ -956,6 +1147,18 @@ void USLVisionLogger::PrintProgress() const
 	const int32 CurrImgNr = Episode.GetCurrIndex() * TotalCameras * TotalViewModes + CurrVirtualCameraIdx * TotalViewModes + CurrViewModeNr;
 	const int32 TotalImgs = TotalFrames * TotalCameras * TotalViewModes;
 
+	// Output the init phase durations with the first image
+	if (CurrImgNr == 1)
+	{
+		FString InitTimesStr = FSLCVUtils::GetInitTimesString(InitPhaseTimes);
+		if (MaskMaterials)
+		{
+			InitTimesStr.Append(FString::Printf(TEXT("MaskMaterials=%d/%d;"),
+				MaskMaterials->GetNumMaterials(), MaskMaterials->GetNumRequests()));
+		}
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d \t Init: %s"), *FString(__func__), __LINE__, *InitTimesStr);
+	}
+
 	UE_LOG(LogTemp, Warning, TEXT("%s::%d \t Camera=%ld/%ld; \t\t ViewMode=%ld/%ld; \t\t Image=%ld/%ld; \t\t Ts=%.2f/%.2f; \t\t Frame=%ld/%ld;"),
 		*FString(__func__), __LINE__,		
 		CurrCameraNr, TotalCameras,
@@ -965,6 +1168,12 @@ void USLVisionLogger::PrintProgress() const
 		CurrFrameNr, TotalFrames);
 }
 
+// Store the duration of the init phase started at the given time
+void USLVisionLogger::AddInitPhaseTime(const FString& PhaseName, double StartTime)
+{
+	InitPhaseTimes.Emplace(PhaseName, FPlatformTime::Seconds() - StartTime);
+}
+
 // Get view mode as string
 FString USLVisionLogger::GetViewModeName(ESLVisionViewMode Mode) const
 {
@@ -994,3 +1203,38 @@ FString USLVisionLogger::GetViewModeName(ESLVisionViewMode Mode) const
 	}
 }
 
+// Get view mode filename postfix
+FString USLVisionLogger::GetViewModePostfix(ESLVisionViewMode Mode) const
+{
+	if (Mode == ESLVisionViewMode::Color)
+	{
+		return FString("C");
+	}
+	else if (Mode == ESLVisionViewMode::Unlit)
+	{
+		return FString("U");
+	}
+	else if (Mode == ESLVisionViewMode::Mask)
+	{
+		return FString("M");
+	}
+	else if (Mode == ESLVisionViewMode::Depth)
+	{
+		return FString("D");
+	}
+	else if (Mode == ESLVisionViewMode::Normal)
+	{
+		return FString("N");
+	}
+	else
+	{
+		return FString("O");
+	}
+}
+
+// Set the filename of the current image (Sec-Ms_FrameNum_Viewmode)
+void USLVisionLogger::SetCurrImageFilename()
+{
+	CurrImageFilename = FString::Printf(TEXT("%.2f"), CurrTimestamp).Replace(TEXT("."), TEXT("-")) + "_" +
+		FString::FromInt(Episode.GetCurrIndex()) + "_" + CurrViewModePostfix;
+}
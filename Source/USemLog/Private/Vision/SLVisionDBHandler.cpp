@@ -3,12 +3,6 @@
 
 #include "Vision/SLVisionDBHandler.h"
 
-// UUtils
-#if SL_WITH_ROS_CONVERSIONS
-#include "Conversions.h"
-#endif // SL_WITH_ROS_CONVERSIONS
-
-
 // Ctor
 FSLVisionDBHandler::FSLVisionDBHandler() {}
 
@@ -293,108 +287,6 @@ void FSLVisionDBHandler::CreateIndexes() const
 #endif //SL_WITH_LIBMONGO_C
 }
 
-// Get episode data from the database (UpdateRate = 0 means all the data)
-bool FSLVisionDBHandler::GetEpisodeData(float UpdateRate, const TMap<ASkeletalMeshActor*,
-	ASLVisionPoseableMeshActor*>& InSkelToPoseableMap,
-	FSLVisionEpisode& OutEpisode)
-{
-	float CurrTs = 0.f;
-	float PrevTs = -BIG_NUMBER; // this to make sure the first entry is loaded every time
-
-#if SL_WITH_LIBMONGO_C
-	bson_error_t error;
-	bson_t opts;
-	const bson_t *doc;
-	mongoc_cursor_t *cursor;
-	bson_t *pipeline;
-
-	pipeline = BCON_NEW("pipeline", "[",
-		"{",
-			"$match",
-			"{",
-				"timestamp",
-				"{",
-					"$exists", BCON_BOOL(true),
-				"}",
-			"}",
-		"}",
-		"{",
-			"$sort",
-			"{",
-				"timestamp", BCON_INT32(1),
-			"}",
-		"}",
-		"{",
-			"$project",
-			"{",
-				"_id", BCON_INT32(0),
-				"timestamp", BCON_INT32(1),
-				"entities", BCON_UTF8("$entities"),
-				"skel_entities", BCON_UTF8("$skel_entities"),
-			"}",
-		"}",
-	"]");
-
-	bson_init(&opts);
-	BSON_APPEND_BOOL(&opts, "allowDiskUse", true);
-
-	cursor = mongoc_collection_aggregate(
-		collection, MONGOC_QUERY_NONE, pipeline, &opts, NULL);
-
-	while (mongoc_cursor_next(cursor, &doc))
-	{
-		// Store the changes from the previous frame until this one
-		FSLVisionFrame Frame;
-
-		bson_iter_t doc_iter;
-		if (bson_iter_init(&doc_iter, doc))
-		{
-			// Get the current timestamp
-			if (bson_iter_find(&doc_iter, "timestamp"))
-			{
-				CurrTs = bson_iter_double(&doc_iter);
-			}
-
-			// Accumulate entity changes in the frame until the desired update rate is reached
-			GetEntitiesData(&doc_iter, Frame.ActorPoses, Frame.VisionCameraPoses);
-
-			// Accumulate skeletal entity changes in the frame until the desired update rate is reached
-			GetSkeletalEntitiesData(&doc_iter, InSkelToPoseableMap, Frame.SkeletalPoses);
-
-			// Check if the desired update rate is reached
-			if (CurrTs - PrevTs >= UpdateRate)
-			{
-				// Update the previous timestamp
-				PrevTs = CurrTs;
-
-				// Add frame to episode and clear it for new data
-				if (Frame.ActorPoses.Num() != 0 || Frame.SkeletalPoses.Num() != 0)
-				{
-					Frame.Timestamp = CurrTs;
-					OutEpisode.AddFrame(Frame);
-					Frame.Clear();
-				}
-			}
-		}
-	}
-
-	// Check if any errors appeared while iterating the cursor
-	if (mongoc_cursor_error(cursor, &error))
-	{
-		UE_LOG(LogTemp, Error, TEXT("%s::%d Failed to iterate all documents.. Err. %s"),
-			*FString(__func__), __LINE__, *FString(error.message));
-		return false;
-	}
-
-	mongoc_cursor_destroy(cursor);
-	bson_destroy(pipeline);
-
-	return true;
-#else
-	return false;
-#endif //SL_WITH_LIBMONGO_C
-}
-
 // Write current frame
 void FSLVisionDBHandler::WriteFrame(const FSLVisionFrameData& Frame) const
 {
@@ -624,186 +516,6 @@ void FSLVisionDBHandler::DropPreviousEntries(const FString& DBName, const FStrin
 }
 
 #if SL_WITH_LIBMONGO_C
-// Get the entities data out of the bson iterator
-bool FSLVisionDBHandler::GetEntitiesData(bson_iter_t* doc,
-	TMap<AStaticMeshActor*, FTransform>& OutEntityPoses,
-	TMap<ASLVirtualCameraView*, FTransform>& OutVirtualCameraPoses) const
-{
-	// Iterate entities
-	if (bson_iter_find(doc, "entities"))
-	{
-		bson_iter_t child_iter;				// entities,
-		bson_iter_t sub_child_iter;			// id, loc, rot
-		bson_iter_t sub_sub_child_iter;		// x,y,z,w (entity)
-
-		// Check if there are any entities
-		if (bson_iter_recurse(doc, &child_iter))
-		{
-			FString Id;
-			FVector Loc;
-			FQuat Quat;
-
-			while (bson_iter_next(&child_iter))
-			{
-				if (bson_iter_recurse(&child_iter, &sub_child_iter) && bson_iter_find(&sub_child_iter, "id"))
-				{
-					Id = FString(bson_iter_utf8(&sub_child_iter, NULL));
-				}
-				if (bson_iter_recurse(&child_iter, &sub_child_iter) && bson_iter_find_descendant(&sub_child_iter, "loc.x", &sub_sub_child_iter))
-				{
-					Loc.X = bson_iter_double(&sub_sub_child_iter);
-				}
-				if (bson_iter_recurse(&child_iter, &sub_child_iter) && bson_iter_find_descendant(&sub_child_iter, "loc.y", &sub_sub_child_iter))
-				{
-					Loc.Y = bson_iter_double(&sub_sub_child_iter);
-				}
-				if (bson_iter_recurse(&child_iter, &sub_child_iter) && bson_iter_find_descendant(&sub_child_iter, "loc.z", &sub_sub_child_iter))
-				{
-					Loc.Z = bson_iter_double(&sub_sub_child_iter);
-				}
-				if (bson_iter_recurse(&child_iter, &sub_child_iter) && bson_iter_find_descendant(&sub_child_iter, "rot.x", &sub_sub_child_iter))
-				{
-					Quat.X = bson_iter_double(&sub_sub_child_iter);
-				}
-				if (bson_iter_recurse(&child_iter, &sub_child_iter) && bson_iter_find_descendant(&sub_child_iter, "rot.y", &sub_sub_child_iter))
-				{
-					Quat.Y = bson_iter_double(&sub_sub_child_iter);
-				}
-				if (bson_iter_recurse(&child_iter, &sub_child_iter) && bson_iter_find_descendant(&sub_child_iter, "rot.z", &sub_sub_child_iter))
-				{
-					Quat.Z = bson_iter_double(&sub_sub_child_iter);
-				}
-				if (bson_iter_recurse(&child_iter, &sub_child_iter) && bson_iter_find_descendant(&sub_child_iter, "rot.w", &sub_sub_child_iter))
-				{
-					Quat.W = bson_iter_double(&sub_sub_child_iter);
-				}
-
-//				// Add entity
-//				if (AStaticMeshActor* SMA = FSLEntitiesManager::GetInstance()->GetStaticMeshActor(Id))
-//				{
-//#if SL_WITH_ROS_CONVERSIONS
-//					OutEntityPoses.Emplace(SMA, FConversions::ROSToU(FTransform(Quat, Loc)));
-//#else
-//					OutEntityPoses.Emplace(SMA, FTransform(Quat, Loc));
-//#endif // SL_WITH_ROS_CONVERSIONS
-//				}
-//				else if (ASLVirtualCameraView* VCA = FSLEntitiesManager::GetInstance()->GetVisionCameraActor(Id))
-//				{					
-//#if SL_WITH_ROS_CONVERSIONS
-//					OutVirtualCameraPoses.Emplace(VCA, FConversions::ROSToU(FTransform(Quat, Loc)));
-//#else
-//					OutVirtualCameraPoses.Emplace(VCA, FTransform(Quat, Loc));
-//#endif // SL_WITH_ROS_CONVERSIONS
-//				}
-			}
-		}
-		return OutEntityPoses.Num() > 0;
-	}
-	else
-	{
-		return false;
-	}
-}
-
-// Get the entities data out of the bson iterator, returns false if there are no entities
-bool FSLVisionDBHandler::GetSkeletalEntitiesData(bson_iter_t* doc, 
-	const TMap<ASkeletalMeshActor*, ASLVisionPoseableMeshActor*>& InSkelToPoseableMap,
-	TMap<ASLVisionPoseableMeshActor*, TMap<FName, FTransform>>& OutSkeletalPoses) const
-{
-	// Iterate skeletal entities
-	if (bson_iter_find(doc, "skel_entities"))
-	{
-		bson_iter_t child_iter;				// skel_entities
-		bson_iter_t sub_child_iter;			// bones
-		bson_iter_t sub_sub_child_iter;		// bones (array)
-
-		if (bson_iter_recurse(doc, &child_iter))
-		{
-			FString Id;
-			TMap<FName, FTransform> BonesMap;
-
-			while (bson_iter_next(&child_iter))
-			{
-				if (bson_iter_recurse(&child_iter, &sub_child_iter) && bson_iter_find(&sub_child_iter, "id"))
-				{
-					Id = FString(bson_iter_utf8(&sub_child_iter, NULL));
-				}
-
-				if (bson_iter_recurse(&child_iter, &sub_sub_child_iter) && bson_iter_find(&sub_sub_child_iter, "bones"))
-				{
-					bson_iter_t bones_child;			// array  obj
-					bson_iter_t bones_sub_child;		// name, loc, rot
-					bson_iter_t bones_sub_sub_child;	// x, y , z, w
-
-					FName BoneName;
-					FVector Loc;
-					FQuat Quat;
-
-					if (bson_iter_recurse(&sub_sub_child_iter, &bones_child))
-					{
-						while (bson_iter_next(&bones_child))
-						{
-							if (bson_iter_recurse(&bones_child, &bones_sub_child) && bson_iter_find(&bones_sub_child, "name"))
-							{
-								BoneName = FName(bson_iter_utf8(&bones_sub_child, NULL));
-							}
-							if (bson_iter_recurse(&bones_child, &bones_sub_child) && bson_iter_find_descendant(&bones_sub_child, "loc.x", &bones_sub_sub_child))
-							{
-								Loc.X = bson_iter_double(&bones_sub_sub_child);
-							}
-							if (bson_iter_recurse(&bones_child, &bones_sub_child) && bson_iter_find_descendant(&bones_sub_child, "loc.y", &bones_sub_sub_child))
-							{
-								Loc.Y = bson_iter_double(&bones_sub_sub_child);
-							}
-							if (bson_iter_recurse(&bones_child, &bones_sub_child) && bson_iter_find_descendant(&bones_sub_child, "loc.z", &bones_sub_sub_child))
-							{
-								Loc.Z = bson_iter_double(&bones_sub_sub_child);
-							}
-							if (bson_iter_recurse(&bones_child, &bones_sub_child) && bson_iter_find_descendant(&bones_sub_child, "rot.x", &bones_sub_sub_child))
-							{
-								Quat.X = bson_iter_double(&bones_sub_sub_child);
-							}
-							if (bson_iter_recurse(&bones_child, &bones_sub_child) && bson_iter_find_descendant(&bones_sub_child, "rot.y", &bones_sub_sub_child))
-							{
-								Quat.Y = bson_iter_double(&bones_sub_sub_child);
-							}
-							if (bson_iter_recurse(&bones_child, &bones_sub_child) && bson_iter_find_descendant(&bones_sub_child, "rot.z", &bones_sub_sub_child))
-							{
-								Quat.Z = bson_iter_double(&bones_sub_sub_child);
-							}
-							if (bson_iter_recurse(&bones_child, &bones_sub_child) && bson_iter_find_descendant(&bones_sub_child, "rot.w", &bones_sub_sub_child))
-							{
-								Quat.W = bson_iter_double(&bones_sub_sub_child);
-							}
-#if SL_WITH_ROS_CONVERSIONS
-							BonesMap.Add(BoneName, FConversions::ROSToU(FTransform(Quat, Loc)));
-#else
-							BonesMap.Add(BoneName, FTransform(Quat, Loc));
-#endif // SL_WITH_ROS_CONVERSIONS
-						}
-					}
-				}
-
-				//// Add skeletal entity
-				//if (ASkeletalMeshActor* SkMA = FSLEntitiesManager::GetInstance()->GetSkeletalMeshActor((Id)))
-				//{
-				//	if (ASLVisionPoseableMeshActor* const* PMA = InSkelToPoseableMap.Find(SkMA))
-				//	{
-				//		OutSkeletalPoses.Emplace(*PMA, BonesMap);
-				//	}
-				//	else
-				//	{
-				//		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not find poseable mesh clone actor for %s, did you run the setup before?"),
-				//			*FString(__func__), __LINE__, *SkMA->GetName());
-				//	}
-				//}
-			}
-		}
-		return OutSkeletalPoses.Num() > 0;
-	}
-	return false;
-}
-
 // Save image to gridfs, get the file oid and return true if succeeded
 bool FSLVisionDBHandler::AddToGridFs(const TArray<uint8>& InData, bson_oid_t* out_oid) const
 {
@@ -0,0 +1,615 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Vision/SLVisionEpisodeReader.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+
+// UUtils
+#if SL_WITH_ROS_CONVERSIONS
+#include "Conversions.h"
+#endif // SL_WITH_ROS_CONVERSIONS
+
+// Ctor
+FSLVisionEpisodeReader::FSLVisionEpisodeReader() :
+	UpdateRate(0.f),
+	MaxReadAheadFrames(32),
+	FrameIdx(INDEX_NONE),
+	FirstTimestamp(-1.f),
+	LastTimestamp(-1.f),
+	NumFramesEstimate(0),
+	SlotEvent(nullptr),
+	FrameEvent(nullptr),
+	Thread(nullptr)
+{
+	bReadDone = false;
+	bStopRequested = false;
+#if SL_WITH_LIBMONGO_C
+	uri = nullptr;
+	client = nullptr;
+	collection = nullptr;
+#endif //SL_WITH_LIBMONGO_C
+}
+
+// Dtor
+FSLVisionEpisodeReader::~FSLVisionEpisodeReader()
+{
+	Finish();
+}
+
+// Connect to the episode collection and read its time range (UpdateRate = 0 means all the data)
+bool FSLVisionEpisodeReader::Init(const FString& DBName, const FString& CollName, const FString& ServerIp, uint16 ServerPort,
+	float InUpdateRate, const TMap<ASkeletalMeshActor*, ASLVisionPoseableMeshActor*>& InSkelToPoseableMap,
+	int32 InMaxReadAheadFrames)
+{
+	if (Thread != nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Episode reader is already running, cannot re-init.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	UpdateRate = InUpdateRate;
+	SkelToPoseableMap = InSkelToPoseableMap;
+	MaxReadAheadFrames = FMath::Max(InMaxReadAheadFrames, 1);
+
+#if SL_WITH_LIBMONGO_C
+	// Required to initialize libmongoc's internals
+	mongoc_init();
+
+	// Stores any error that might appear during the connection
+	bson_error_t error;
+
+	// Safely create a MongoDB URI object from the given string
+	FString Uri = TEXT("mongodb://") + ServerIp + TEXT(":") + FString::FromInt(ServerPort);
+	uri = mongoc_uri_new_with_error(TCHAR_TO_UTF8(*Uri), &error);
+	if (!uri)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s; [Uri=%s]"),
+			*FString(__func__), __LINE__, *FString(error.message), *Uri);
+		return false;
+	}
+
+	// The reader has its own client, the vision data is written from other threads
+	client = mongoc_client_new_from_uri(uri);
+	if (!client)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not create a mongo client.."), *FString(__func__), __LINE__);
+		return false;
+	}
+
+	// Register the application name so we can track it in the profile logs on the server
+	mongoc_client_set_appname(client, TCHAR_TO_UTF8(*("SLVIS_READ_" + CollName)));
+
+	collection = mongoc_client_get_collection(client, TCHAR_TO_UTF8(*DBName), TCHAR_TO_UTF8(*CollName));
+
+	return ReadTimeRange();
+#else
+	return false;
+#endif //SL_WITH_LIBMONGO_C
+}
+
+// Start reading the frames in the background
+bool FSLVisionEpisodeReader::Start()
+{
+	if (Thread != nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Reader thread is already running.."), *FString(__FUNCTION__), __LINE__);
+		return true;
+	}
+
+#if SL_WITH_LIBMONGO_C
+	if (!collection)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Episode reader is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+#endif //SL_WITH_LIBMONGO_C
+
+	bReadDone = false;
+	bStopRequested = false;
+	FrameIdx = INDEX_NONE;
+	SlotEvent = FPlatformProcess::GetSynchEventFromPool();
+	FrameEvent = FPlatformProcess::GetSynchEventFromPool();
+	Thread = FRunnableThread::Create(this, TEXT("SL_VisionEpisodeReader"), 0, TPri_Normal);
+	if (Thread == nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not create the vision episode reader thread.."), *FString(__FUNCTION__), __LINE__);
+		FPlatformProcess::ReturnSynchEventToPool(SlotEvent);
+		FPlatformProcess::ReturnSynchEventToPool(FrameEvent);
+		SlotEvent = nullptr;
+		FrameEvent = nullptr;
+		return false;
+	}
+	return true;
+}
+
+// Signal the reader thread to stop, blocks until done
+void FSLVisionEpisodeReader::Stop()
+{
+	if (Thread == nullptr)
+	{
+		return;
+	}
+
+	bStopRequested = true;
+	SlotEvent->Trigger();
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
+}
+
+// Stop reading, free the buffered frames and disconnect
+void FSLVisionEpisodeReader::Finish()
+{
+	Stop();
+
+	FSLVisionFrame* Frame = nullptr;
+	while (FrameQueue.Dequeue(Frame))
+	{
+		delete Frame;
+	}
+	NumQueuedFrames.Reset();
+	CurrFrame.Clear();
+
+	if (SlotEvent)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(SlotEvent);
+		SlotEvent = nullptr;
+	}
+	if (FrameEvent)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(FrameEvent);
+		FrameEvent = nullptr;
+	}
+
+	Disconnect();
+}
+
+// Move actors to the first frame (the stream cannot be rewound)
+bool FSLVisionEpisodeReader::SetupFirstFrame(float& OutTimestamp,
+	bool bIncludeMasks,
+	TMap<AStaticMeshActor*, AStaticMeshActor*>& MaskClones,
+	TMap<ASLVisionPoseableMeshActor*, ASLVisionPoseableMeshActor*>& SkelMaskClones)
+{
+	if (FrameIdx != INDEX_NONE)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d The episode is already being replayed, the frames cannot be rewound.."),
+			*FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+	return SetupNextFrame(OutTimestamp, bIncludeMasks, MaskClones, SkelMaskClones);
+}
+
+// Move actors to the next frame transformations, return false if no more frames are available
+bool FSLVisionEpisodeReader::SetupNextFrame(float& OutTimestamp,
+	bool bIncludeMasks,
+	TMap<AStaticMeshActor*, AStaticMeshActor*>& MaskClones,
+	TMap<ASLVisionPoseableMeshActor*, ASLVisionPoseableMeshActor*>& SkelMaskClones)
+{
+	if (PopFrame())
+	{
+		FrameIdx++;
+		OutTimestamp = CurrFrame.ApplyTransformations(bIncludeMasks, MaskClones, SkelMaskClones);
+		return true;
+	}
+	FrameIdx = INDEX_NONE;
+	return false;
+}
+
+// Reader thread loop
+uint32 FSLVisionEpisodeReader::Run()
+{
+#if SL_WITH_LIBMONGO_C
+	bson_error_t error;
+	bson_t opts;
+	const bson_t *doc;
+	mongoc_cursor_t *cursor;
+	bson_t *pipeline;
+
+	pipeline = BCON_NEW("pipeline", "[",
+		"{",
+			"$match",
+			"{",
+				"timestamp",
+				"{",
+					"$exists", BCON_BOOL(true),
+				"}",
+			"}",
+		"}",
+		"{",
+			"$sort",
+			"{",
+				"timestamp", BCON_INT32(1),
+			"}",
+		"}",
+		"{",
+			"$project",
+			"{",
+				"_id", BCON_INT32(0),
+				"timestamp", BCON_INT32(1),
+				"entities", BCON_UTF8("$entities"),
+				"skel_entities", BCON_UTF8("$skel_entities"),
+			"}",
+		"}",
+	"]");
+
+	bson_init(&opts);
+	BSON_APPEND_BOOL(&opts, "allowDiskUse", true);
+
+	cursor = mongoc_collection_aggregate(
+		collection, MONGOC_QUERY_NONE, pipeline, &opts, NULL);
+
+	float CurrTs = 0.f;
+	float PrevTs = -BIG_NUMBER; // this to make sure the first entry is loaded every time
+
+	// Store the changes from the previous frame until the desired update rate is reached
+	FSLVisionFrame* Frame = new FSLVisionFrame();
+	while (!bStopRequested && mongoc_cursor_next(cursor, &doc))
+	{
+		bson_iter_t doc_iter;
+		if (bson_iter_init(&doc_iter, doc))
+		{
+			// Get the current timestamp
+			if (bson_iter_find(&doc_iter, "timestamp"))
+			{
+				CurrTs = bson_iter_double(&doc_iter);
+			}
+
+			// Accumulate entity changes in the frame until the desired update rate is reached
+			GetEntitiesData(&doc_iter, Frame->ActorPoses, Frame->VisionCameraPoses);
+
+			// Accumulate skeletal entity changes in the frame until the desired update rate is reached
+			GetSkeletalEntitiesData(&doc_iter, SkelToPoseableMap, Frame->SkeletalPoses);
+
+			// Check if the desired update rate is reached
+			if (CurrTs - PrevTs >= UpdateRate)
+			{
+				// Update the previous timestamp
+				PrevTs = CurrTs;
+
+				// Queue the frame and start a new one
+				if (Frame->ActorPoses.Num() != 0 || Frame->SkeletalPoses.Num() != 0)
+				{
+					// Wait until the read ahead buffer has a free slot
+					while (NumQueuedFrames.GetValue() >= MaxReadAheadFrames && !bStopRequested)
+					{
+						// Timeout as a safety net for missed triggers
+						SlotEvent->Wait(10);
+					}
+					if (bStopRequested)
+					{
+						break;
+					}
+
+					Frame->Timestamp = CurrTs;
+					NumQueuedFrames.Increment();
+					FrameQueue.Enqueue(Frame);
+					FrameEvent->Trigger();
+					Frame = new FSLVisionFrame();
+				}
+			}
+		}
+	}
+	delete Frame;
+
+	// Check if any errors appeared while iterating the cursor
+	if (mongoc_cursor_error(cursor, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Failed to iterate all documents.. Err. %s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+	}
+
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(pipeline);
+	bson_destroy(&opts);
+#endif //SL_WITH_LIBMONGO_C
+
+	bReadDone = true;
+	FrameEvent->Trigger();
+	return 0;
+}
+
+// Wait for the next frame from the reader thread, returns false if there are no more frames
+bool FSLVisionEpisodeReader::PopFrame()
+{
+	if (FrameEvent == nullptr)
+	{
+		return false;
+	}
+
+	FSLVisionFrame* Frame = nullptr;
+	while (!FrameQueue.Dequeue(Frame))
+	{
+		// The queue is checked once more since the last frames could have been added before the done flag was set
+		if (bReadDone)
+		{
+			if (!FrameQueue.Dequeue(Frame))
+			{
+				return false;
+			}
+			break;
+		}
+		// Timeout as a safety net for missed triggers
+		FrameEvent->Wait(10);
+	}
+
+	CurrFrame = MoveTemp(*Frame);
+	delete Frame;
+	NumQueuedFrames.Decrement();
+	SlotEvent->Trigger();
+	return true;
+}
+
+// Read the first and last timestamp of the episode and estimate the number of frames
+bool FSLVisionEpisodeReader::ReadTimeRange()
+{
+#if SL_WITH_LIBMONGO_C
+	if (!ReadBoundaryTimestamp(true, FirstTimestamp) || !ReadBoundaryTimestamp(false, LastTimestamp))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not read the time range of the episode (no entries?).."),
+			*FString(__func__), __LINE__);
+		return false;
+	}
+
+	// Number of world state entries
+	bson_error_t error;
+	bson_t* filter = BCON_NEW("timestamp", "{", "$exists", BCON_BOOL(true), "}");
+	int64_t count = mongoc_collection_count_documents(collection, filter, NULL, NULL, NULL, &error);
+	bson_destroy(filter);
+	if (count < 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.: %s"), *FString(__func__), __LINE__, *FString(error.message));
+		count = 0;
+	}
+
+	// There is at most one frame per update rate interval
+	NumFramesEstimate = static_cast<int32>(count);
+	if (UpdateRate > 0.f)
+	{
+		const int32 NumIntervals = FMath::FloorToInt((LastTimestamp - FirstTimestamp) / UpdateRate) + 1;
+		NumFramesEstimate = FMath::Min(NumFramesEstimate, NumIntervals);
+	}
+	return true;
+#else
+	return false;
+#endif //SL_WITH_LIBMONGO_C
+}
+
+// Release the db handles
+void FSLVisionEpisodeReader::Disconnect()
+{
+#if SL_WITH_LIBMONGO_C
+	if (collection)
+	{
+		mongoc_collection_destroy(collection);
+		collection = nullptr;
+	}
+	if (client)
+	{
+		mongoc_client_destroy(client);
+		client = nullptr;
+	}
+	if (uri)
+	{
+		mongoc_uri_destroy(uri);
+		uri = nullptr;
+	}
+#endif //SL_WITH_LIBMONGO_C
+}
+
+#if SL_WITH_LIBMONGO_C
+// Get the value of the first or last (sorted) timestamp, returns false if there are no entries
+bool FSLVisionEpisodeReader::ReadBoundaryTimestamp(bool bFirst, float& OutTimestamp) const
+{
+	bson_error_t error;
+	const bson_t* doc;
+	bool bFound = false;
+
+	bson_t* filter = BCON_NEW("timestamp", "{", "$exists", BCON_BOOL(true), "}");
+	bson_t* opts = BCON_NEW(
+		"sort", "{", "timestamp", BCON_INT32(bFirst ? 1 : -1), "}",
+		"limit", BCON_INT64(1),
+		"projection", "{", "_id", BCON_INT32(0), "timestamp", BCON_INT32(1), "}");
+
+	mongoc_cursor_t* cursor = mongoc_collection_find_with_opts(collection, filter, opts, NULL);
+	if (mongoc_cursor_next(cursor, &doc))
+	{
+		bson_iter_t iter;
+		if (bson_iter_init_find(&iter, doc, "timestamp"))
+		{
+			OutTimestamp = bson_iter_double(&iter);
+			bFound = true;
+		}
+	}
+
+	if (mongoc_cursor_error(cursor, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.: %s"), *FString(__func__), __LINE__, *FString(error.message));
+	}
+
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(filter);
+	bson_destroy(opts);
+	return bFound;
+}
+
+// Get the entities data out of the bson iterator
+bool FSLVisionEpisodeReader::GetEntitiesData(bson_iter_t* doc,
+	TMap<AStaticMeshActor*, FTransform>& OutEntityPoses,
+	TMap<ASLVirtualCameraView*, FTransform>& OutVirtualCameraPoses) const
+{
+	// Iterate entities
+	if (bson_iter_find(doc, "entities"))
+	{
+		bson_iter_t child_iter;				// entities,
+		bson_iter_t sub_child_iter;			// id, loc, rot
+		bson_iter_t sub_sub_child_iter;		// x,y,z,w (entity)
+
+		// Check if there are any entities
+		if (bson_iter_recurse(doc, &child_iter))
+		{
+			FString Id;
+			FVector Loc;
+			FQuat Quat;
+
+			while (bson_iter_next(&child_iter))
+			{
+				if (bson_iter_recurse(&child_iter, &sub_child_iter) && bson_iter_find(&sub_child_iter, "id"))
+				{
+					Id = FString(bson_iter_utf8(&sub_child_iter, NULL));
+				}
+				if (bson_iter_recurse(&child_iter, &sub_child_iter) && bson_iter_find_descendant(&sub_child_iter, "loc.x", &sub_sub_child_iter))
+				{
+					Loc.X = bson_iter_double(&sub_sub_child_iter);
+				}
+				if (bson_iter_recurse(&child_iter, &sub_child_iter) && bson_iter_find_descendant(&sub_child_iter, "loc.y", &sub_sub_child_iter))
+				{
+					Loc.Y = bson_iter_double(&sub_sub_child_iter);
+				}
+				if (bson_iter_recurse(&child_iter, &sub_child_iter) && bson_iter_find_descendant(&sub_child_iter, "loc.z", &sub_sub_child_iter))
+				{
+					Loc.Z = bson_iter_double(&sub_sub_child_iter);
+				}
+				if (bson_iter_recurse(&child_iter, &sub_child_iter) && bson_iter_find_descendant(&sub_child_iter, "rot.x", &sub_sub_child_iter))
+				{
+					Quat.X = bson_iter_double(&sub_sub_child_iter);
+				}
+				if (bson_iter_recurse(&child_iter, &sub_child_iter) && bson_iter_find_descendant(&sub_child_iter, "rot.y", &sub_sub_child_iter))
+				{
+					Quat.Y = bson_iter_double(&sub_sub_child_iter);
+				}
+				if (bson_iter_recurse(&child_iter, &sub_child_iter) && bson_iter_find_descendant(&sub_child_iter, "rot.z", &sub_sub_child_iter))
+				{
+					Quat.Z = bson_iter_double(&sub_sub_child_iter);
+				}
+				if (bson_iter_recurse(&child_iter, &sub_child_iter) && bson_iter_find_descendant(&sub_child_iter, "rot.w", &sub_sub_child_iter))
+				{
+					Quat.W = bson_iter_double(&sub_sub_child_iter);
+				}
+
+//				// Add entity
+//				if (AStaticMeshActor* SMA = FSLEntitiesManager::GetInstance()->GetStaticMeshActor(Id))
+//				{
+//#if SL_WITH_ROS_CONVERSIONS
+//					OutEntityPoses.Emplace(SMA, FConversions::ROSToU(FTransform(Quat, Loc)));
+//#else
+//					OutEntityPoses.Emplace(SMA, FTransform(Quat, Loc));
+//#endif // SL_WITH_ROS_CONVERSIONS
+//				}
+//				else if (ASLVirtualCameraView* VCA = FSLEntitiesManager::GetInstance()->GetVisionCameraActor(Id))
+//				{					
+//#if SL_WITH_ROS_CONVERSIONS
+//					OutVirtualCameraPoses.Emplace(VCA, FConversions::ROSToU(FTransform(Quat, Loc)));
+//#else
+//					OutVirtualCameraPoses.Emplace(VCA, FTransform(Quat, Loc));
+//#endif // SL_WITH_ROS_CONVERSIONS
+//				}
+			}
+		}
+		return OutEntityPoses.Num() > 0;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+// Get the entities data out of the bson iterator, returns false if there are no entities
+bool FSLVisionEpisodeReader::GetSkeletalEntitiesData(bson_iter_t* doc, 
+	const TMap<ASkeletalMeshActor*, ASLVisionPoseableMeshActor*>& InSkelToPoseableMap,
+	TMap<ASLVisionPoseableMeshActor*, TMap<FName, FTransform>>& OutSkeletalPoses) const
+{
+	// Iterate skeletal entities
+	if (bson_iter_find(doc, "skel_entities"))
+	{
+		bson_iter_t child_iter;				// skel_entities
+		bson_iter_t sub_child_iter;			// bones
+		bson_iter_t sub_sub_child_iter;		// bones (array)
+
+		if (bson_iter_recurse(doc, &child_iter))
+		{
+			FString Id;
+			TMap<FName, FTransform> BonesMap;
+
+			while (bson_iter_next(&child_iter))
+			{
+				if (bson_iter_recurse(&child_iter, &sub_child_iter) && bson_iter_find(&sub_child_iter, "id"))
+				{
+					Id = FString(bson_iter_utf8(&sub_child_iter, NULL));
+				}
+
+				if (bson_iter_recurse(&child_iter, &sub_sub_child_iter) && bson_iter_find(&sub_sub_child_iter, "bones"))
+				{
+					bson_iter_t bones_child;			// array  obj
+					bson_iter_t bones_sub_child;		// name, loc, rot
+					bson_iter_t bones_sub_sub_child;	// x, y , z, w
+
+					FName BoneName;
+					FVector Loc;
+					FQuat Quat;
+
+					if (bson_iter_recurse(&sub_sub_child_iter, &bones_child))
+					{
+						while (bson_iter_next(&bones_child))
+						{
+							if (bson_iter_recurse(&bones_child, &bones_sub_child) && bson_iter_find(&bones_sub_child, "name"))
+							{
+								BoneName = FName(bson_iter_utf8(&bones_sub_child, NULL));
+							}
+							if (bson_iter_recurse(&bones_child, &bones_sub_child) && bson_iter_find_descendant(&bones_sub_child, "loc.x", &bones_sub_sub_child))
+							{
+								Loc.X = bson_iter_double(&bones_sub_sub_child);
+							}
+							if (bson_iter_recurse(&bones_child, &bones_sub_child) && bson_iter_find_descendant(&bones_sub_child, "loc.y", &bones_sub_sub_child))
+							{
+								Loc.Y = bson_iter_double(&bones_sub_sub_child);
+							}
+							if (bson_iter_recurse(&bones_child, &bones_sub_child) && bson_iter_find_descendant(&bones_sub_child, "loc.z", &bones_sub_sub_child))
+							{
+								Loc.Z = bson_iter_double(&bones_sub_sub_child);
+							}
+							if (bson_iter_recurse(&bones_child, &bones_sub_child) && bson_iter_find_descendant(&bones_sub_child, "rot.x", &bones_sub_sub_child))
+							{
+								Quat.X = bson_iter_double(&bones_sub_sub_child);
+							}
+							if (bson_iter_recurse(&bones_child, &bones_sub_child) && bson_iter_find_descendant(&bones_sub_child, "rot.y", &bones_sub_sub_child))
+							{
+								Quat.Y = bson_iter_double(&bones_sub_sub_child);
+							}
+							if (bson_iter_recurse(&bones_child, &bones_sub_child) && bson_iter_find_descendant(&bones_sub_child, "rot.z", &bones_sub_sub_child))
+							{
+								Quat.Z = bson_iter_double(&bones_sub_sub_child);
+							}
+							if (bson_iter_recurse(&bones_child, &bones_sub_child) && bson_iter_find_descendant(&bones_sub_child, "rot.w", &bones_sub_sub_child))
+							{
+								Quat.W = bson_iter_double(&bones_sub_sub_child);
+							}
+#if SL_WITH_ROS_CONVERSIONS
+							BonesMap.Add(BoneName, FConversions::ROSToU(FTransform(Quat, Loc)));
+#else
+							BonesMap.Add(BoneName, FTransform(Quat, Loc));
+#endif // SL_WITH_ROS_CONVERSIONS
+						}
+					}
+				}
+
+				//// Add skeletal entity
+				//if (ASkeletalMeshActor* SkMA = FSLEntitiesManager::GetInstance()->GetSkeletalMeshActor((Id)))
+				//{
+				//	if (ASLVisionPoseableMeshActor* const* PMA = InSkelToPoseableMap.Find(SkMA))
+				//	{
+				//		OutSkeletalPoses.Emplace(*PMA, BonesMap);
+				//	}
+				//	else
+				//	{
+				//		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not find poseable mesh clone actor for %s, did you run the setup before?"),
+				//			*FString(__func__), __LINE__, *SkMA->GetName());
+				//	}
+				//}
+			}
+		}
+		return OutSkeletalPoses.Num() > 0;
+	}
+	return false;
+}
+#endif //SL_WITH_LIBMONGO_C
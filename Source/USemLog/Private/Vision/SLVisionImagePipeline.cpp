@@ -0,0 +1,252 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Vision/SLVisionImagePipeline.h"
+#include "Vision/SLVisionDBHandler.h"
+#include "Vision/SLVisionMaskImageHandler.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+#include "Async/Async.h"
+#include "Modules/ModuleManager.h"
+#include "ImageUtils.h"
+#include "Misc/FileHelper.h"
+
+// Ctor
+FSLVisionImagePipeline::FSLVisionImagePipeline() :
+	DBHandler(nullptr),
+	MaskImgHandler(nullptr),
+	MaxImagesInFlight(8),
+	MaxPendingFrames(4),
+	SlotEvent(nullptr),
+	WorkEvent(nullptr),
+	Thread(nullptr)
+{
+	bStopRequested = false;
+}
+
+// Dtor
+FSLVisionImagePipeline::~FSLVisionImagePipeline()
+{
+	Finish();
+}
+
+// Set the frame writer, the mask restorer and the max number of images processed at the same time
+bool FSLVisionImagePipeline::Init(FSLVisionDBHandler* InDBHandler, const FSLVisionMaskImageHandler* InMaskImgHandler, int32 InMaxImagesInFlight)
+{
+	if (Thread != nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Image pipeline is already running, cannot re-init.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+	if (InDBHandler == nullptr || InMaskImgHandler == nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Invalid db or mask image handler.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	DBHandler = InDBHandler;
+	MaskImgHandler = InMaskImgHandler;
+	MaxImagesInFlight = FMath::Max(InMaxImagesInFlight, 1);
+
+	// The image compression modules cannot be loaded from the worker threads
+	FModuleManager::Get().LoadModule(TEXT("ImageWrapper"));
+	return true;
+}
+
+// Start the frame writer thread
+bool FSLVisionImagePipeline::Start()
+{
+	if (Thread != nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Writer thread is already running.."), *FString(__FUNCTION__), __LINE__);
+		return true;
+	}
+	if (DBHandler == nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Image pipeline is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	bStopRequested = false;
+	SlotEvent = FPlatformProcess::GetSynchEventFromPool();
+	WorkEvent = FPlatformProcess::GetSynchEventFromPool();
+	Thread = FRunnableThread::Create(this, TEXT("SL_VisionFrameWriter"), 0, TPri_Normal);
+	if (Thread == nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not create the vision frame writer thread.."), *FString(__FUNCTION__), __LINE__);
+		FPlatformProcess::ReturnSynchEventToPool(SlotEvent);
+		FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+		SlotEvent = nullptr;
+		WorkEvent = nullptr;
+		return false;
+	}
+	return true;
+}
+
+// Signal the writer thread to write the remaining frames and stop, blocks until done
+void FSLVisionImagePipeline::Stop()
+{
+	if (Thread == nullptr)
+	{
+		return;
+	}
+
+	bStopRequested = true;
+	WorkEvent->Trigger();
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
+
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	WorkEvent = nullptr;
+}
+
+// Wait for the images and frames in flight and stop the writer thread
+void FSLVisionImagePipeline::Finish()
+{
+	// Images of an unfinished frame are not written
+	for (auto& Job : CurrFrameJobs)
+	{
+		Job.Future.Wait();
+	}
+	if (CurrFrameJobs.Num() > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %d images of an unfinished frame are not written.."),
+			*FString(__FUNCTION__), __LINE__, CurrFrameJobs.Num());
+		CurrFrameJobs.Empty();
+	}
+
+	Stop();
+
+	// Frames left in the queue if the writer thread was never started
+	FSLVisionPendingFrame* PendingFrame = nullptr;
+	while (FrameQueue.Dequeue(PendingFrame))
+	{
+		for (auto& Job : PendingFrame->Jobs)
+		{
+			Job.Future.Wait();
+		}
+		delete PendingFrame;
+	}
+
+	if (SlotEvent)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(SlotEvent);
+		SlotEvent = nullptr;
+	}
+}
+
+// Copy the bitmap and queue it for processing, blocks if too many images are in flight
+void FSLVisionImagePipeline::AddImage(int32 ViewIdx, int32 ImageIdx, int32 SizeX, int32 SizeY, const TArray<FColor>& Bitmap,
+	bool bRestoreMask, const FString& LocalPath)
+{
+	WaitForSlot();
+
+	FSLVisionImageJob& Job = CurrFrameJobs.AddDefaulted_GetRef();
+	Job.ViewIdx = ViewIdx;
+	Job.ImageIdx = ImageIdx;
+	Job.Result = MakeShared<FSLVisionImageJobResult, ESPMode::ThreadSafe>();
+
+	NumImagesInFlight.Increment();
+
+	// The bitmap is owned by the viewport, a copy is processed on the thread pool
+	TSharedPtr<FSLVisionImageJobResult, ESPMode::ThreadSafe> Result = Job.Result;
+	const FSLVisionMaskImageHandler* MaskRestorer = bRestoreMask ? MaskImgHandler : nullptr;
+	Job.Future = Async(EAsyncExecution::ThreadPool, [this, Result, MaskRestorer, SizeX, SizeY, ImageBitmap = Bitmap, LocalPath]() mutable
+	{
+		if (MaskRestorer)
+		{
+			// Get information from the mask image and restore any rendering artefacts to the original mask colors
+			FSLVisionViewData MaskData;
+			MaskRestorer->GetDataAndRestoreImage(ImageBitmap, SizeX, SizeY, MaskData);
+			Result->Entities = MoveTemp(MaskData.Entities);
+			Result->SkelEntities = MoveTemp(MaskData.SkelEntities);
+		}
+
+		FImageUtils::CompressImageArray(SizeX, SizeY, ImageBitmap, Result->CompressedBitmap);
+
+		if (!LocalPath.IsEmpty())
+		{
+			FFileHelper::SaveArrayToFile(Result->CompressedBitmap, *LocalPath);
+		}
+
+		NumImagesInFlight.Decrement();
+		SlotEvent->Trigger();
+	});
+}
+
+// Queue the frame for writing once all its images are processed (the frame data is moved)
+void FSLVisionImagePipeline::AddFrame(FSLVisionFrameData& Frame)
+{
+	FSLVisionPendingFrame* PendingFrame = new FSLVisionPendingFrame();
+	PendingFrame->Frame = MoveTemp(Frame);
+	PendingFrame->Jobs = MoveTemp(CurrFrameJobs);
+	CurrFrameJobs.Reset();
+
+	NumPendingFrames.Increment();
+	FrameQueue.Enqueue(PendingFrame);
+	if (WorkEvent)
+	{
+		WorkEvent->Trigger();
+	}
+}
+
+// Writer thread loop
+uint32 FSLVisionImagePipeline::Run()
+{
+	while (!bStopRequested)
+	{
+		WriteQueuedFrames();
+		WorkEvent->Wait(100);
+	}
+
+	// Make sure nothing is lost at the end of the episode
+	WriteQueuedFrames();
+	return 0;
+}
+
+// Block until the number of images in flight and frames waiting to be written are below their limits
+void FSLVisionImagePipeline::WaitForSlot()
+{
+	while (NumImagesInFlight.GetValue() >= MaxImagesInFlight || NumPendingFrames.GetValue() >= MaxPendingFrames)
+	{
+		// Timeout as a safety net for missed triggers
+		SlotEvent->Wait(10);
+	}
+}
+
+// Wait for the frame images, fill them in and write the frame to the database
+void FSLVisionImagePipeline::WriteFrame(FSLVisionPendingFrame& PendingFrame)
+{
+	for (auto& Job : PendingFrame.Jobs)
+	{
+		Job.Future.Wait();
+		if (!PendingFrame.Frame.Views.IsValidIndex(Job.ViewIdx) ||
+			!PendingFrame.Frame.Views[Job.ViewIdx].Images.IsValidIndex(Job.ImageIdx))
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Image %d of view %d is not in the frame, skipping.."),
+				*FString(__FUNCTION__), __LINE__, Job.ImageIdx, Job.ViewIdx);
+			continue;
+		}
+
+		FSLVisionViewData& ViewData = PendingFrame.Frame.Views[Job.ViewIdx];
+		ViewData.Images[Job.ImageIdx].Data = MoveTemp(Job.Result->CompressedBitmap);
+		ViewData.Entities.Append(MoveTemp(Job.Result->Entities));
+		ViewData.SkelEntities.Append(MoveTemp(Job.Result->SkelEntities));
+	}
+
+	DBHandler->WriteFrame(PendingFrame.Frame);
+}
+
+// Write all the queued frames
+void FSLVisionImagePipeline::WriteQueuedFrames()
+{
+	FSLVisionPendingFrame* PendingFrame = nullptr;
+	while (FrameQueue.Dequeue(PendingFrame))
+	{
+		WriteFrame(*PendingFrame);
+		delete PendingFrame;
+		NumPendingFrames.Decrement();
+		SlotEvent->Trigger();
+	}
+}
@@ -2,6 +2,7 @@
 // Author: Andrei Haidu (http://haidu.eu)
 
 #include "Vision/SLVisionMaskImageHandler.h"
+#include "Async/ParallelFor.h"
 
 
 // Ctor
@@ -76,6 +77,9 @@ bool FSLVisionMaskImageHandler::Init()
 		//		*FColor::FromHex(Pair.Value.OrigMaskColor).ToString());
 		//}
 
+		// Direct access to the semantic data of the rendered colors
+		BuildColorLookupTable();
+
 		bIsInit = true;
 		return true;
 	}
@@ -88,6 +92,9 @@ void FSLVisionMaskImageHandler::Reset()
 	bIsInit = false;
 	RenderedColorToEntityInfo.Empty();
 	RenderedColorToSkelInfo.Empty();
+	ColorSlots.Empty();
+	RGToColorPage.Empty();
+	ColorPages.Empty();
 }
 
 // Restore image (the screenshot image pixel colors are a bit offseted from the supposed mask value) and get the entities from mask image
@@ -95,131 +102,124 @@ void FSLVisionMaskImageHandler::GetDataAndRestoreImage(TArray<FColor>& MaskBitma
 	FSLVisionViewData& OutViewData) const
 {
 	// Used to calculate the percentage of an entity in the image
-	const int64 ImgTotalPixels = ImgWidth * ImgHeight;
-
-	// Index position of the image matrix in rows and columns (used for storing the bounding box of the entities)
-	int32 RowIdx = 0;
-	int32 ColIdx = 0;
+	const int64 ImgTotalPixels = (int64)ImgWidth * ImgHeight;
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Not initialized, no color mappings loaded.."), *FString(__func__), __LINE__);
+		return;
+	}
+	if (ImgTotalPixels == 0 || MaskBitmapToRestore.Num() < ImgTotalPixels)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Mask image size does not match %dx%d.."), *FString(__func__), __LINE__, ImgWidth, ImgHeight);
+		return;
+	}
 
-	// Store the occurance of every color in the image to its data
-	TMap<FColor, FSLVisionImageColorInfo> TempRenderedColorsData;
+	// Split the image in tiles of rows, a few tiles per worker for balancing the load
+	const int32 NumTiles = FMath::Clamp((FTaskGraphInterface::Get().GetNumWorkerThreads() + 1) * 4, 1, ImgHeight);
+	const int32 RowsPerTile = FMath::DivideAndRoundUp(ImgHeight, NumTiles);
+	const int32 NumSlots = ColorSlots.Num();
 
-	// Array of rendered colors without a semantic match (store in array to avoid smapping the logger everytime the color appears)
-	TSet<FColor> UnknownColors;
+	// Per tile color slot data (the pixel number and the bounding box) and the rendered colors without a semantic match
+	TArray<TArray<FSLVisionImageColorInfo>> TilesColorsData;
+	TArray<TSet<FColor>> TilesUnknownColors;
+	TilesColorsData.SetNum(NumTiles);
+	TilesUnknownColors.SetNum(NumTiles);
 
-	// Restore image colors and create a mapping of all the rendered pixel colors to its data
-	for (auto& PixelColor : MaskBitmapToRestore)
+	// Restore image colors and count the pixels of every rendered color
+	FColor* Pixels = MaskBitmapToRestore.GetData();
+	ParallelFor(NumTiles, [&](int32 TileIdx)
 	{
-		// Ignore color black (represents semantically unknown areas, normally there should not be any
-		if (PixelColor != FColor::Black)
+		TArray<FSLVisionImageColorInfo>& ColorsData = TilesColorsData[TileIdx];
+		ColorsData.Init(FSLVisionImageColorInfo(0, FIntPoint(ImgWidth, ImgHeight), FIntPoint(0, 0)), NumSlots);
+		TSet<FColor>& UnknownColors = TilesUnknownColors[TileIdx];
+
+		const int32 FirstRow = TileIdx * RowsPerTile;
+		const int32 LastRow = FMath::Min(FirstRow + RowsPerTile, ImgHeight);
+		for (int32 RowIdx = FirstRow; RowIdx < LastRow; ++RowIdx)
 		{
-			// Check if the color is new
-			if (FSLVisionImageColorInfo* ColorData = TempRenderedColorsData.Find(PixelColor))
+			FColor* Row = Pixels + (int64)RowIdx * ImgWidth;
+			for (int32 ColIdx = 0; ColIdx < ImgWidth; ++ColIdx)
 			{
-				// Color already stored, update its data
-				(*ColorData).Num++;
+				FColor& PixelColor = Row[ColIdx];
 
-				// Update the bounding box in the image
-				if (RowIdx < (*ColorData).MinBB.Y)
+				// Ignore color black (represents semantically unknown areas, normally there should not be any
+				if (PixelColor == FColor::Black)
 				{
-					(*ColorData).MinBB.Y = RowIdx;
-				}
-				if (RowIdx > (*ColorData).MaxBB.Y)
-				{
-					(*ColorData).MaxBB.Y = RowIdx;
-				}
-				if (ColIdx < (*ColorData).MinBB.X)
-				{
-					(*ColorData).MinBB.X = ColIdx;
-				}
-				if (ColIdx > (*ColorData).MaxBB.X)
-				{
-					(*ColorData).MaxBB.X = ColIdx;
+					continue;
 				}
 
-				// Fix image by changing the rendered color to the original value
-				PixelColor = (*ColorData).OriginalMaskColor;
-			}
-			else
-			{
-				// Cache rendered color, since the pixel color will be restored to the original mask (if found)
-				const FColor RenderedColor = PixelColor;
-
-				// New color, cache its info
-				FSLVisionImageColorInfo ColorInfo(1, FIntPoint(ImgWidth, ImgHeight), FIntPoint(0, 0));
-
-				// Get the original mask color value
-				if (const FSLVisionMaskEntityInfo* EntityInfo = RenderedColorToEntityInfo.Find(RenderedColor))
+				const int32 SlotIdx = GetColorSlotIndex(PixelColor);
+				if (SlotIdx == INDEX_NONE)
 				{
-					// Color found as an entity visual mask
-					ColorInfo.OriginalMaskColor = FColor::FromHex((*EntityInfo).OrigMaskColor);
-
-					// Cache the color info in the local map
-					TempRenderedColorsData.Emplace(RenderedColor, ColorInfo);
-
-					// Fix image by changing the rendered color to the original value
-					PixelColor = ColorInfo.OriginalMaskColor;
+					UnknownColors.Add(PixelColor);
+					continue;
 				}
-				else if (const FSLVisionMaskSkelInfo* SkelInfo = RenderedColorToSkelInfo.Find(RenderedColor))
-				{
-					// Color found as a skeletal visual mask
-					ColorInfo.OriginalMaskColor = FColor::FromHex((*SkelInfo).OrigMaskColor);
 
-					// Cache the color info in the local map
-					TempRenderedColorsData.Emplace(RenderedColor, ColorInfo);
+				FSLVisionImageColorInfo& ColorData = ColorsData[SlotIdx];
+				ColorData.Num++;
 
-					// Fix image by changing the rendered color to the original value
-					PixelColor = ColorInfo.OriginalMaskColor;
-				}
-				else if(!UnknownColors.Contains(PixelColor))
-				{
-					UnknownColors.Add(PixelColor);
-					UE_LOG(LogTemp, Error, TEXT("%s::%d Rendered color %s - %s has no mapping to any entity.. this should not happen.."),
-						*FString(__func__), __LINE__, *RenderedColor.ToString(), *RenderedColor.ToHex());
-				}
+				// Update the bounding box in the image
+				ColorData.MinBB.X = FMath::Min(ColorData.MinBB.X, ColIdx);
+				ColorData.MaxBB.X = FMath::Max(ColorData.MaxBB.X, ColIdx);
+				ColorData.MinBB.Y = FMath::Min(ColorData.MinBB.Y, RowIdx);
+				ColorData.MaxBB.Y = FMath::Max(ColorData.MaxBB.Y, RowIdx);
+
+				// Fix image by changing the rendered color to the original value
+				PixelColor = ColorSlots[SlotIdx].OriginalMaskColor;
 			}
 		}
+	});
 
-		// Update current pixel index position
-		ColIdx++;
-
-		// Check for row change
-		if (ColIdx > ImgWidth - 1)
+	// Merge the tiles data
+	TArray<FSLVisionImageColorInfo> ColorsData = MoveTemp(TilesColorsData[0]);
+	TSet<FColor> UnknownColors = MoveTemp(TilesUnknownColors[0]);
+	for (int32 TileIdx = 1; TileIdx < NumTiles; ++TileIdx)
+	{
+		for (int32 SlotIdx = 0; SlotIdx < NumSlots; ++SlotIdx)
 		{
-			ColIdx = 0;
-			RowIdx++;
+			const FSLVisionImageColorInfo& TileColorData = TilesColorsData[TileIdx][SlotIdx];
+			if (TileColorData.Num > 0)
+			{
+				FSLVisionImageColorInfo& ColorData = ColorsData[SlotIdx];
+				ColorData.Num += TileColorData.Num;
+				ColorData.MinBB = ColorData.MinBB.ComponentMin(TileColorData.MinBB);
+				ColorData.MaxBB = ColorData.MaxBB.ComponentMax(TileColorData.MaxBB);
+			}
 		}
+		UnknownColors.Append(TilesUnknownColors[TileIdx]);
+	}
+
+	for (const auto& RenderedColor : UnknownColors)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Rendered color %s - %s has no mapping to any entity.. this should not happen.."),
+			*FString(__func__), __LINE__, *RenderedColor.ToString(), *RenderedColor.ToHex());
 	}
 
 	// Store skeletal related data in a temp map, this will need an extra processing to calculcate the data as a whole skeleton (from bones)
 	TMap<FString, FSLVisionViewSkelData> TempIdToSkelData;
 
 	// Iterate the collected data from the image
-	for (const auto& Pair : TempRenderedColorsData)
+	for (int32 SlotIdx = 0; SlotIdx < NumSlots; ++SlotIdx)
 	{
-		const FColor RenderedColor = Pair.Key;
-		
+		const FSLVisionImageColorInfo& ColorData = ColorsData[SlotIdx];
+		if (ColorData.Num == 0)
+		{
+			continue;
+		}
+
 		// Check semantically annotated entity that belongs to the mask color
-		if (const FSLVisionMaskEntityInfo* EntityInfo = RenderedColorToEntityInfo.Find(RenderedColor))
+		const FSLVisionMaskColorSlot& Slot = ColorSlots[SlotIdx];
+		if (const FSLVisionMaskEntityInfo* EntityInfo = Slot.EntityInfo)
 		{
-			FSLVisionViewEntityData EntityData(EntityInfo->Id, EntityInfo->Class, Pair.Value.MinBB, Pair.Value.MaxBB);
-			EntityData.ImagePercentage = (float) Pair.Value.Num / ImgTotalPixels;
+			FSLVisionViewEntityData EntityData(EntityInfo->Id, EntityInfo->Class, ColorData.MinBB, ColorData.MaxBB);
+			EntityData.ImagePercentage = (float) ColorData.Num / ImgTotalPixels;
 			OutViewData.Entities.Emplace(EntityData);
-
-			//// DEBUG
-			//UE_LOG(LogTemp, Warning, TEXT("%s::%d Color: [%s] -> %s : %s -> %d -> %f"),
-			//	*FString(__func__), __LINE__,
-			//	*RenderedColor.ToString(),
-			//	*EntityData.Class,
-			//	*EntityData.Id,
-			//	Pair.Value.Num,
-			//	EntityData.ImagePercentage);
 		}
-		else if(const FSLVisionMaskSkelInfo* SkelInfo = RenderedColorToSkelInfo.Find(RenderedColor))
+		else if (const FSLVisionMaskSkelInfo* SkelInfo = Slot.SkelInfo)
 		{
 			// Collect bone data
-			FSLVisionViewSkelBoneData BoneData(SkelInfo->BoneClass, Pair.Value.MinBB, Pair.Value.MaxBB);
-			BoneData.ImagePercentage = (float) Pair.Value.Num / ImgTotalPixels;
+			FSLVisionViewSkelBoneData BoneData(SkelInfo->BoneClass, ColorData.MinBB, ColorData.MaxBB);
+			BoneData.ImagePercentage = (float) ColorData.Num / ImgTotalPixels;
 
 			// Update existing or create a new skeletal data
 			if(FSLVisionViewSkelData* SkelData = TempIdToSkelData.Find(SkelInfo->Id))
@@ -232,16 +232,6 @@ void FSLVisionMaskImageHandler::GetDataAndRestoreImage(TArray<FColor>& MaskBitma
 				NewSkelData.Bones.Emplace(BoneData);
 				TempIdToSkelData.Emplace(SkelInfo->Id, NewSkelData);
 			}
-
-			// DEBUG
-			//UE_LOG(LogTemp, Warning, TEXT("%s::%d Color: %s -> %s : %s : %s -> %d"),
-			//	*FString(__func__), __LINE__, *Pair.Key.ToString(),
-			//	*SkelInfo->Class, *SkelInfo->Id, *SkelInfo->BoneClass, Pair.Value.Num);
-		}
-		else
-		{
-			UE_LOG(LogTemp, Error, TEXT("%s::%d Rendered color %s - %s has no mapping to any entity.. this should not happen.."),
-				*FString(__func__), __LINE__, *RenderedColor.ToString(), *RenderedColor.ToHex());
 		}
 	}
 
@@ -254,6 +244,50 @@ void FSLVisionMaskImageHandler::GetDataAndRestoreImage(TArray<FColor>& MaskBitma
 	}
 }
 
+// Build the color slots and their lookup table from the mappings
+void FSLVisionMaskImageHandler::BuildColorLookupTable()
+{
+	ColorSlots.Empty(RenderedColorToEntityInfo.Num() + RenderedColorToSkelInfo.Num());
+	RGToColorPage.Init(INDEX_NONE, 256 * 256);
+	ColorPages.Empty();
+
+	auto AddSlot = [this](const FColor& RenderedColor, const FSLVisionMaskColorSlot& Slot)
+	{
+		int32& PageIdx = RGToColorPage[(RenderedColor.R << 8) | RenderedColor.G];
+		if (PageIdx == INDEX_NONE)
+		{
+			PageIdx = ColorPages.Num() / 256;
+			ColorPages.AddUninitialized(256);
+			for (int32 Idx = PageIdx * 256; Idx < ColorPages.Num(); ++Idx)
+			{
+				ColorPages[Idx] = INDEX_NONE;
+			}
+		}
+		int32& SlotIdx = ColorPages[(PageIdx << 8) | RenderedColor.B];
+		if (SlotIdx == INDEX_NONE)
+		{
+			SlotIdx = ColorSlots.Add(Slot);
+		}
+	};
+
+	for (const auto& Pair : RenderedColorToEntityInfo)
+	{
+		FSLVisionMaskColorSlot Slot;
+		Slot.RenderedColor = Pair.Key;
+		Slot.OriginalMaskColor = FColor::FromHex(Pair.Value.OrigMaskColor);
+		Slot.EntityInfo = &Pair.Value;
+		AddSlot(Pair.Key, Slot);
+	}
+	for (const auto& Pair : RenderedColorToSkelInfo)
+	{
+		FSLVisionMaskColorSlot Slot;
+		Slot.RenderedColor = Pair.Key;
+		Slot.OriginalMaskColor = FColor::FromHex(Pair.Value.OrigMaskColor);
+		Slot.SkelInfo = &Pair.Value;
+		AddSlot(Pair.Key, Slot);
+	}
+}
+
 // Restore the color of the pixel to its original mask value (offseted by screenshot rendering artifacts), returns true if restoration happened
 bool FSLVisionMaskImageHandler::RestoreColorValueFromArray(FColor& RenderedPixelColor, const TArray<FColor>& InOriginalMaskColors, uint8 Tolerance) const
 {
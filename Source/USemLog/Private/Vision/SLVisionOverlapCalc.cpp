@@ -9,6 +9,8 @@
 #include "Materials/Material.h"
 #include "Materials/MaterialInstanceDynamic.h"
 #include "Engine/GameViewportClient.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/GameplayStatics.h"
 #include "HighResScreenshot.h"
 #include "ImageUtils.h"
 #include "Async.h"
@@ -17,7 +19,16 @@
 #include "Vision/SLVisionStructs.h"
 //#include "Skeletal/SLSkeletalDataComponent.h"
 #include "SLVisionLogger.h"
+#include "Vision/SLVisionPoseableMeshActor.h"
 
+// Two bits per color channel, black is the background
+static constexpr int32 SLMaxGroupItems = 63;
+
+// Max offset of the rendered color channels from the palette
+static constexpr int32 SLGroupColorTolerance = 24;
+
+// Screen space margin (in normalized coordinates) added to the projected bounds when grouping
+static constexpr float SLGroupBoundsMargin = 0.01f;
 
 // Constructor
 USLVisionOverlapCalc::USLVisionOverlapCalc() : bIsInit(false), bIsStarted(false), bIsFinished(false)
@@ -31,6 +42,8 @@ USLVisionOverlapCalc::USLVisionOverlapCalc() : bIsInit(false), bIsStarted(false)
 	CurrPMAClone = nullptr;
 	bSkelArrayActive = false;
 	bSkelBoneActive = false;
+	bSinglePass = false;
+	GroupIndex = INDEX_NONE;
 }
 
 // Destructor
@@ -39,7 +52,7 @@ USLVisionOverlapCalc::~USLVisionOverlapCalc()
 }
 
 // Give control to the overlap calc to pause and start its parent (vision logger)
-void USLVisionOverlapCalc::Init(USLVisionLogger* InParent, FIntPoint InResolution, const FString& InSaveLocallyPath)
+void USLVisionOverlapCalc::Init(USLVisionLogger* InParent, FIntPoint InResolution, const FString& InSaveLocallyPath, bool bInSinglePass)
 {
 	if (!bIsInit)
 	{
@@ -62,6 +75,19 @@ void USLVisionOverlapCalc::Init(USLVisionLogger* InParent, FIntPoint InResolutio
 		DefaultNonOccludingMaterial->bUsedWithSkeletalMesh = true;
 		DefaultNonOccludingMaterial->bDisableDepthTest = true;
 
+		// Create the uniquely colored non occluding materials of the group items
+		bSinglePass = bInSinglePass;
+		if (bSinglePass)
+		{
+			GroupMaterials.Empty(SLMaxGroupItems);
+			for (int32 ItemIdx = 0; ItemIdx < SLMaxGroupItems; ++ItemIdx)
+			{
+				UMaterialInstanceDynamic* GroupMaterial = UMaterialInstanceDynamic::Create(DefaultNonOccludingMaterial, this);
+				GroupMaterial->SetVectorParameterValue(FName("MaskColorParam"), FLinearColor::FromSRGBColor(GetGroupItemColor(ItemIdx)));
+				GroupMaterials.Add(GroupMaterial);
+			}
+		}
+
 		if (Parent && ViewportClient)
 		{
 			bIsInit = true;
@@ -81,7 +107,30 @@ void USLVisionOverlapCalc::Start(FSLVisionViewData* CurrViewData, float Timestam
 		Entities = &CurrViewData->Entities;
 		SkelEntities = &CurrViewData->SkelEntities;
 
-		CurrOverlapCalcIdx = 0;		
+		CurrOverlapCalcIdx = 0;
+
+		if (bSinglePass)
+		{
+			if (!BuildSinglePassGroups())
+			{
+				UE_LOG(LogTemp, Error, TEXT("%s::%d No items found in the scene.."), *FString(__func__), __LINE__);
+				return;
+			}
+			TotalOverlapCalcNum = Groups.Num();
+			GroupIndex = 0;
+			ApplyGroupNonOccludingMaterials(GroupIndex);
+
+			// Switch callback functions and pause parent
+			Parent->Pause(true);
+			ScreenshotCallbackHandle = ViewportClient->OnScreenshotCaptured().AddUObject(this, &USLVisionOverlapCalc::ScreenshotCB);
+			InitScreenshotResolution(Resolution);
+			RequestScreenshot();
+
+			bIsFinished = false;
+			bIsStarted = true;
+			return;
+		}
+
 		int32 NumBones = 0;
 		for (const auto& SkE : *SkelEntities)
 		{
@@ -120,6 +169,8 @@ void USLVisionOverlapCalc::Finish()
 		CurrOverlapCalcIdx = INDEX_NONE;
 		EntityIndex = INDEX_NONE;
 		SkelIndex = INDEX_NONE;
+		GroupIndex = INDEX_NONE;
+		Groups.Empty();
 		
 		bSkelArrayActive = false;
 		
@@ -160,8 +211,15 @@ void USLVisionOverlapCalc::ScreenshotCB(int32 SizeX, int32 SizeY, const TArray<F
 	// Terminal output with the log progress
 	PrintProgress();
 
-	// Calcuate overlap for the currently selected item
-	CalculateOverlap(Bitmap, SizeX, SizeY);
+	// Calcuate overlap for the currently selected item (or group)
+	if (bSinglePass)
+	{
+		CalculateGroupOverlaps(Bitmap, SizeX, SizeY);
+	}
+	else
+	{
+		CalculateOverlap(Bitmap, SizeX, SizeY);
+	}
 
 	// Save the png locally
 	if (!SaveLocallyFolderName.IsEmpty())
@@ -174,6 +232,23 @@ void USLVisionOverlapCalc::ScreenshotCB(int32 SizeX, int32 SizeY, const TArray<F
 		FFileHelper::SaveArrayToFile(CompressedBitmap, *Path);
 	}
 
+	if (bSinglePass)
+	{
+		ReApplyGroupOriginalMaterials();
+		if (Groups.IsValidIndex(GroupIndex + 1))
+		{
+			GroupIndex++;
+			CurrOverlapCalcIdx++;
+			ApplyGroupNonOccludingMaterials(GroupIndex);
+			RequestScreenshot();
+		}
+		else
+		{
+			Finish();
+		}
+		return;
+	}
+
 	// Re-apply original material before selecting the next item
 	ReApplyOriginalMaterial();
 
@@ -586,10 +661,7 @@ void USLVisionOverlapCalc::CalculateOverlap(const TArray<FColor>& NonOccludedIma
 	
 	if (!bSkelArrayActive)
 	{
-		// Set percentage  (non occ image perc - occ image perc / non occ image perc)
-		const float ImgPercDiff = (NonOccImgPerc - (*Entities)[EntityIndex].ImagePercentage);
-		const float OccPerc = ImgPercDiff / NonOccImgPerc;
-		(*Entities)[EntityIndex].OcclusionPercentage = OccPerc < 0.01f ? 0.f : OccPerc;
+		(*Entities)[EntityIndex].OcclusionPercentage = CalcOcclusionPercentage(NonOccImgPerc, (*Entities)[EntityIndex].ImagePercentage);
 
 		// Set flag showing if the entity is clipped (touches the edge of the image)
 		(*Entities)[EntityIndex].bIsClipped = bIsClipped;
@@ -604,10 +676,7 @@ void USLVisionOverlapCalc::CalculateOverlap(const TArray<FColor>& NonOccludedIma
 	{
 		if (!bSkelBoneActive)
 		{
-			// Set percentage  (non occ image perc - occ image perc / non occ image perc)
-			const float ImgPercDiff = NonOccImgPerc - (*SkelEntities)[SkelIndex].ImagePercentage;
-			const float OccPerc = ImgPercDiff / NonOccImgPerc;
-			(*SkelEntities)[SkelIndex].OcclusionPercentage = OccPerc < 0.01f ? 0.f : OccPerc;
+			(*SkelEntities)[SkelIndex].OcclusionPercentage = CalcOcclusionPercentage(NonOccImgPerc, (*SkelEntities)[SkelIndex].ImagePercentage);
 
 			// Set flag showing if the entity is clipped (touches the edge of the image)
 			(*SkelEntities)[SkelIndex].bIsClipped = bIsClipped;
@@ -620,10 +689,7 @@ void USLVisionOverlapCalc::CalculateOverlap(const TArray<FColor>& NonOccludedIma
 		}
 		else
 		{
-			// Set percentage  (non occ image perc - occ image perc / non occ image perc)
-			const float ImgPercDiff = NonOccImgPerc - (*SkelEntities)[SkelIndex].Bones[BoneIndex].ImagePercentage;
-			const float OccPerc = ImgPercDiff / NonOccImgPerc;
-			(*SkelEntities)[SkelIndex].Bones[BoneIndex].OcclusionPercentage = OccPerc < 0.01f ? 0.f : OccPerc;
+			(*SkelEntities)[SkelIndex].Bones[BoneIndex].OcclusionPercentage = CalcOcclusionPercentage(NonOccImgPerc, (*SkelEntities)[SkelIndex].Bones[BoneIndex].ImagePercentage);
 
 			// Set flag showing if the entity is clipped (touches the edge of the image)
 			(*SkelEntities)[SkelIndex].Bones[BoneIndex].bIsClipped = bIsClipped;
@@ -637,6 +703,236 @@ void USLVisionOverlapCalc::CalculateOverlap(const TArray<FColor>& NonOccludedIma
 	}	
 }
 
+/* Single pass */
+// Group the items in the view, items of a group do not overlap in screen space and are rendered with one screenshot
+bool USLVisionOverlapCalc::BuildSinglePassGroups()
+{
+	Groups.Empty();
+
+	// Screen space bounds of the items in every group
+	TArray<TArray<FBox2D>> GroupBounds;
+
+	auto AddToGroups = [this, &GroupBounds](const FSLVisionOverlapGroupItem& Item)
+	{
+		const FBox2D Bounds = GetScreenBounds(Item.Clone);
+
+		// Add to the first group without overlaps
+		for (int32 GroupIdx = 0; GroupIdx < Groups.Num(); ++GroupIdx)
+		{
+			if (Groups[GroupIdx].Num() >= SLMaxGroupItems)
+			{
+				continue;
+			}
+
+			bool bOverlaps = false;
+			for (const auto& OtherBounds : GroupBounds[GroupIdx])
+			{
+				if (Bounds.Intersect(OtherBounds))
+				{
+					bOverlaps = true;
+					break;
+				}
+			}
+			if (!bOverlaps)
+			{
+				Groups[GroupIdx].Add(Item);
+				GroupBounds[GroupIdx].Add(Bounds);
+				return;
+			}
+		}
+
+		// Start a new group
+		Groups.AddDefaulted_GetRef().Add(Item);
+		GroupBounds.AddDefaulted_GetRef().Add(Bounds);
+	};
+
+	for (int32 Idx = 0; Idx < Entities->Num(); ++Idx)
+	{
+		AStaticMeshActor* SMAClone = Parent->GetStaticMeshMaskCloneFromId((*Entities)[Idx].Id);
+		if (!SMAClone || !SMAClone->GetStaticMeshComponent())
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Could not find pointer to entity %s - %s, continuing.."),
+				*FString(__func__), __LINE__, *(*Entities)[Idx].Class, *(*Entities)[Idx].Id);
+			continue;
+		}
+		FSLVisionOverlapGroupItem Item;
+		Item.Index = Idx;
+		Item.bIsSkel = false;
+		Item.Clone = SMAClone;
+		Item.MC = SMAClone->GetStaticMeshComponent();
+		AddToGroups(Item);
+	}
+
+	for (int32 Idx = 0; Idx < SkelEntities->Num(); ++Idx)
+	{
+		ASLVisionPoseableMeshActor* PMAClone = Parent->GetPoseableSkeletalMaskCloneFromId((*SkelEntities)[Idx].Id);
+		if (!PMAClone || !PMAClone->GetPoseableMeshComponent())
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Could not find pointer to skel entity %s - %s, continuing.."),
+				*FString(__func__), __LINE__, *(*SkelEntities)[Idx].Class, *(*SkelEntities)[Idx].Id);
+			continue;
+		}
+		FSLVisionOverlapGroupItem Item;
+		Item.Index = Idx;
+		Item.bIsSkel = true;
+		Item.Clone = PMAClone;
+		Item.MC = PMAClone->GetPoseableMeshComponent();
+		AddToGroups(Item);
+	}
+
+	return Groups.Num() > 0;
+}
+
+// Show only the clones of the group with a uniquely colored non occluding material
+void USLVisionOverlapCalc::ApplyGroupNonOccludingMaterials(int32 GroupIdx)
+{
+	// Other clones would be visible in the image with their mask colors
+	Parent->SetMaskClonesHiddenInGame(true);
+
+	GroupCachedMaterials.Reset();
+	for (int32 ItemIdx = 0; ItemIdx < Groups[GroupIdx].Num(); ++ItemIdx)
+	{
+		const FSLVisionOverlapGroupItem& Item = Groups[GroupIdx][ItemIdx];
+		Item.Clone->SetActorHiddenInGame(false);
+		for (int32 MaterialIndex = 0; MaterialIndex < Item.MC->GetNumMaterials(); ++MaterialIndex)
+		{
+			// Cache original material
+			GroupCachedMaterials.Add(Item.MC->GetMaterial(MaterialIndex));
+
+			// Switch to the non occluding material of the item
+			Item.MC->SetMaterial(MaterialIndex, GroupMaterials[ItemIdx]);
+		}
+	}
+}
+
+// Re-apply the original materials of the group and show all the clones
+void USLVisionOverlapCalc::ReApplyGroupOriginalMaterials()
+{
+	int32 CachedIdx = 0;
+	for (const auto& Item : Groups[GroupIndex])
+	{
+		for (int32 MaterialIndex = 0; MaterialIndex < Item.MC->GetNumMaterials(); ++MaterialIndex)
+		{
+			Item.MC->SetMaterial(MaterialIndex, GroupCachedMaterials[CachedIdx++]);
+		}
+	}
+	GroupCachedMaterials.Reset();
+	Parent->SetMaskClonesHiddenInGame(false);
+}
+
+// Calculate the overlaps of all the items of the group from one image
+void USLVisionOverlapCalc::CalculateGroupOverlaps(const TArray<FColor>& NonOccludedImage, int32 ImgWidth, int32 ImgHeight)
+{
+	const TArray<FSLVisionOverlapGroupItem>& Group = Groups[GroupIndex];
+	TArray<int64> NumPixels;
+	NumPixels.AddZeroed(Group.Num());
+	TArray<bool> ClippedFlags;
+	ClippedFlags.AddZeroed(Group.Num());
+
+	// Count the pixels of every item in one sweep
+	for (int32 RowIdx = 0; RowIdx < ImgHeight; ++RowIdx)
+	{
+		const bool bIsBorderRow = RowIdx == 0 || RowIdx == ImgHeight - 1;
+		const FColor* Row = NonOccludedImage.GetData() + RowIdx * ImgWidth;
+		for (int32 ColIdx = 0; ColIdx < ImgWidth; ++ColIdx)
+		{
+			const int32 ItemIdx = GetGroupItemIndex(Row[ColIdx]);
+			if (ItemIdx != INDEX_NONE && ItemIdx < Group.Num())
+			{
+				NumPixels[ItemIdx]++;
+				if (bIsBorderRow || ColIdx == 0 || ColIdx == ImgWidth - 1)
+				{
+					ClippedFlags[ItemIdx] = true;
+				}
+			}
+		}
+	}
+
+	const int64 ImgTotalPixels = (int64)ImgWidth * ImgHeight;
+	for (int32 ItemIdx = 0; ItemIdx < Group.Num(); ++ItemIdx)
+	{
+		const FSLVisionOverlapGroupItem& Item = Group[ItemIdx];
+		if (NumPixels[ItemIdx] == 0)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Item %d of group %d is not visible in the non occluded image, skipping.."),
+				*FString(__func__), __LINE__, ItemIdx, GroupIndex);
+			continue;
+		}
+
+		// Percentage of the image with the non occluded item pixels
+		const float NonOccImgPerc = (float)NumPixels[ItemIdx] / ImgTotalPixels;
+		if (Item.bIsSkel)
+		{
+			(*SkelEntities)[Item.Index].OcclusionPercentage = CalcOcclusionPercentage(NonOccImgPerc, (*SkelEntities)[Item.Index].ImagePercentage);
+			(*SkelEntities)[Item.Index].bIsClipped = ClippedFlags[ItemIdx];
+		}
+		else
+		{
+			(*Entities)[Item.Index].OcclusionPercentage = CalcOcclusionPercentage(NonOccImgPerc, (*Entities)[Item.Index].ImagePercentage);
+			(*Entities)[Item.Index].bIsClipped = ClippedFlags[ItemIdx];
+		}
+	}
+}
+
+// Get the screen space bounds of the actor in normalized viewport coordinates (the whole screen if it cannot be projected)
+FBox2D USLVisionOverlapCalc::GetScreenBounds(AActor* Actor) const
+{
+	const FBox2D ScreenBox(FVector2D(0.f, 0.f), FVector2D(1.f, 1.f));
+
+	APlayerController* PC = GetWorld()->GetFirstPlayerController();
+	FVector2D ViewportSize;
+	ViewportClient->GetViewportSize(ViewportSize);
+	if (!PC || ViewportSize.X <= 0.f || ViewportSize.Y <= 0.f)
+	{
+		return ScreenBox;
+	}
+
+	FVector Origin;
+	FVector Extent;
+	Actor->GetActorBounds(false, Origin, Extent);
+
+	FBox2D Bounds(ForceInit);
+	for (int32 CornerIdx = 0; CornerIdx < 8; ++CornerIdx)
+	{
+		const FVector Corner = Origin + Extent * FVector(
+			(CornerIdx & 1) ? 1.f : -1.f,
+			(CornerIdx & 2) ? 1.f : -1.f,
+			(CornerIdx & 4) ? 1.f : -1.f);
+
+		// Corners behind the camera cannot be projected
+		FVector2D ScreenPos;
+		if (!UGameplayStatics::ProjectWorldToScreen(PC, Corner, ScreenPos))
+		{
+			return ScreenBox;
+		}
+		Bounds += ScreenPos / ViewportSize;
+	}
+	return Bounds.ExpandBy(SLGroupBoundsMargin);
+}
+
+// Color of the group item index (two bits per channel)
+FColor USLVisionOverlapCalc::GetGroupItemColor(int32 ItemIdx)
+{
+	const int32 Code = ItemIdx + 1;
+	return FColor((Code & 3) * 85, ((Code >> 2) & 3) * 85, ((Code >> 4) & 3) * 85);
+}
+
+// Group item index of the rendered color, INDEX_NONE if it is the background or too far off from the palette
+int32 USLVisionOverlapCalc::GetGroupItemIndex(const FColor& Color)
+{
+	const int32 R = (Color.R + 42) / 85;
+	const int32 G = (Color.G + 42) / 85;
+	const int32 B = (Color.B + 42) / 85;
+	if (FMath::Abs(Color.R - R * 85) > SLGroupColorTolerance
+		|| FMath::Abs(Color.G - G * 85) > SLGroupColorTolerance
+		|| FMath::Abs(Color.B - B * 85) > SLGroupColorTolerance)
+	{
+		return INDEX_NONE;
+	}
+	const int32 Code = R | (G << 2) | (B << 4);
+	return Code - 1;
+}
+
 // Output progress to terminal
 void USLVisionOverlapCalc::PrintProgress() const
 {
@@ -668,4 +964,12 @@ int32 USLVisionOverlapCalc::GetMaterialIndexOfCurrentlySelectedBone()
 			*FString(__func__), __LINE__, *(*SkelEntities)[SkelIndex].Bones[BoneIndex].Class);
 		return INDEX_NONE;
 	//}
-}
\ No newline at end of file
+}
+
+// Occlusion percentage from the non occluded and the occluded image percentages
+float USLVisionOverlapCalc::CalcOcclusionPercentage(float NonOccImgPerc, float ImgPerc)
+{
+	// (non occ image perc - occ image perc) / non occ image perc
+	const float OccPerc = (NonOccImgPerc - ImgPerc) / NonOccImgPerc;
+	return OccPerc < 0.01f ? 0.f : OccPerc;
+}
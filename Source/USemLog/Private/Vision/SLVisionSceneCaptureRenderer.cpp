@@ -0,0 +1,265 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Vision/SLVisionSceneCaptureRenderer.h"
+#include "Vision/SLVirtualCameraView.h"
+#include "Components/SceneCaptureComponent2D.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Camera/CameraComponent.h"
+#include "Materials/MaterialInterface.h"
+#include "BufferVisualizationData.h"
+#include "ShowFlags.h"
+#include "TextureResource.h"
+#include "RenderingThread.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+
+// Ctor
+USLVisionSceneCaptureRenderer::USLVisionSceneCaptureRenderer()
+{
+	bIsInit = false;
+	bIsReadbackPending = false;
+	bIsLockPending = false;
+	World = nullptr;
+}
+
+// Create the capture components and render targets, the mask clones are only rendered by the mask captures
+bool USLVisionSceneCaptureRenderer::Init(const TArray<ASLVirtualCameraView*>& InCameras, const TArray<ESLVisionViewMode>& InViewModes,
+	FIntPoint InResolution, const TArray<AActor*>& InMaskClones)
+{
+	if (bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Scene capture renderer is already initialized.."), *FString(__func__), __LINE__);
+		return true;
+	}
+
+	if (InCameras.Num() == 0 || InViewModes.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d No cameras or view modes to render.."), *FString(__func__), __LINE__);
+		return false;
+	}
+
+	World = InCameras[0]->GetWorld();
+	Resolution = InResolution;
+
+	for (int32 CameraIdx = 0; CameraIdx < InCameras.Num(); ++CameraIdx)
+	{
+		for (int32 ViewModeIdx = 0; ViewModeIdx < InViewModes.Num(); ++ViewModeIdx)
+		{
+			// The captured images are read back as 8 bit BGRA (as the viewport screenshots)
+			UTextureRenderTarget2D* RenderTarget = NewObject<UTextureRenderTarget2D>(this);
+			RenderTarget->InitCustomFormat(Resolution.X, Resolution.Y, PF_B8G8R8A8, true);
+
+			USceneCaptureComponent2D* CaptureComponent = CreateCaptureComponent(
+				InCameras[CameraIdx], InViewModes[ViewModeIdx], RenderTarget, InMaskClones);
+			if (!CaptureComponent)
+			{
+				UE_LOG(LogTemp, Error, TEXT("%s::%d Could not create the capture component of %s, aborting.."),
+					*FString(__func__), __LINE__, *InCameras[CameraIdx]->GetName());
+				Finish();
+				return false;
+			}
+
+			RenderTargets.Add(RenderTarget);
+			CaptureComponents.Add(CaptureComponent);
+			CaptureIndexes.Emplace(CameraIdx, ViewModeIdx);
+			Readbacks.Add(MakeShared<FRHIGPUTextureReadback, ESPMode::ThreadSafe>(FName("SLVisionCapture")));
+			ReadbackBuffers.Add(MakeShared<TArray<FColor>, ESPMode::ThreadSafe>());
+		}
+	}
+
+	bIsInit = true;
+	return true;
+}
+
+// Render all the views of the current world state and start their read back (false if a read back is pending)
+bool USLVisionSceneCaptureRenderer::Capture()
+{
+	if (!bIsInit || bIsReadbackPending)
+	{
+		return false;
+	}
+
+	// Render every view (the pending transform updates are sent before each capture)
+	for (USceneCaptureComponent2D* CaptureComponent : CaptureComponents)
+	{
+		CaptureComponent->CaptureScene();
+	}
+
+	// Copy the render targets to the staging textures, the copies are executed by the GPU after the captures
+	for (int32 Idx = 0; Idx < RenderTargets.Num(); ++Idx)
+	{
+		FTextureRenderTargetResource* Resource = RenderTargets[Idx]->GameThread_GetRenderTargetResource();
+		TSharedPtr<FRHIGPUTextureReadback, ESPMode::ThreadSafe> Readback = Readbacks[Idx];
+		ENQUEUE_RENDER_COMMAND(SLVisionCopyCapture)(
+			[Resource, Readback](FRHICommandListImmediate& RHICmdList)
+		{
+			Readback->EnqueueCopy(RHICmdList, Resource->GetRenderTargetTexture());
+		});
+	}
+	ReadbackFence.BeginFence();
+	bIsReadbackPending = true;
+
+	World->GetTimerManager().SetTimerForNextTick(this, &USLVisionSceneCaptureRenderer::CheckReadback);
+	return true;
+}
+
+// Wait for any pending read back and remove the capture components
+void USLVisionSceneCaptureRenderer::Finish()
+{
+	if (bIsReadbackPending)
+	{
+		ReadbackFence.Wait();
+		bIsReadbackPending = false;
+		bIsLockPending = false;
+	}
+
+	for (USceneCaptureComponent2D* CaptureComponent : CaptureComponents)
+	{
+		if (CaptureComponent && CaptureComponent->IsValidLowLevel())
+		{
+			CaptureComponent->DestroyComponent();
+		}
+	}
+	CaptureComponents.Empty();
+	RenderTargets.Empty();
+	CaptureIndexes.Empty();
+	Readbacks.Empty();
+	ReadbackBuffers.Empty();
+	bIsInit = false;
+}
+
+// Create the capture component of the camera for the given view mode
+USceneCaptureComponent2D* USLVisionSceneCaptureRenderer::CreateCaptureComponent(ASLVirtualCameraView* Camera, ESLVisionViewMode Mode,
+	UTextureRenderTarget2D* RenderTarget, const TArray<AActor*>& InMaskClones) const
+{
+	USceneCaptureComponent2D* CaptureComponent = NewObject<USceneCaptureComponent2D>(Camera);
+	CaptureComponent->SetupAttachment(Camera->GetCameraComponent());
+	CaptureComponent->RegisterComponent();
+
+	CaptureComponent->FOVAngle = Camera->GetCameraComponent()->FieldOfView;
+	CaptureComponent->bCaptureEveryFrame = false;
+	CaptureComponent->bCaptureOnMovement = false;
+	CaptureComponent->bAlwaysPersistRenderingState = true;
+	CaptureComponent->TextureTarget = RenderTarget;
+	CaptureComponent->CaptureSource = ESceneCaptureSource::SCS_FinalColorLDR;
+	CaptureComponent->ShowFlags.SetMotionBlur(false);
+
+	if (Mode == ESLVisionViewMode::Mask)
+	{
+		// Render only the mask clones, unlit and without blending the mask colors
+		ApplyViewMode(VMI_Unlit, true, CaptureComponent->ShowFlags);
+		CaptureComponent->ShowFlags.SetAntiAliasing(false);
+		CaptureComponent->ShowFlags.SetTemporalAA(false);
+		CaptureComponent->PrimitiveRenderMode = ESceneCapturePrimitiveRenderMode::PRM_UseShowOnlyList;
+		CaptureComponent->ShowOnlyActors = InMaskClones;
+		return CaptureComponent;
+	}
+
+	// The mask clones are only visible in the mask captures
+	CaptureComponent->HiddenActors = InMaskClones;
+
+	if (Mode == ESLVisionViewMode::Unlit)
+	{
+		ApplyViewMode(VMI_Unlit, true, CaptureComponent->ShowFlags);
+	}
+	else if (Mode == ESLVisionViewMode::Depth || Mode == ESLVisionViewMode::Normal)
+	{
+		// Same buffer visualization materials as the viewport renders
+		const FName BufferName = Mode == ESLVisionViewMode::Depth ? FName("SLSceneDepthToCameraPlane") : FName("WorldNormal");
+		UMaterialInterface* BufferMaterial = GetBufferVisualizationData().GetMaterial(BufferName);
+		if (!BufferMaterial)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Could not find the %s buffer visualization material.."),
+				*FString(__func__), __LINE__, *BufferName.ToString());
+			CaptureComponent->DestroyComponent();
+			return nullptr;
+		}
+		CaptureComponent->PostProcessSettings.AddBlendable(BufferMaterial, 1.f);
+	}
+	return CaptureComponent;
+}
+
+// Check every tick if the read back is done and broadcast the images
+void USLVisionSceneCaptureRenderer::CheckReadback()
+{
+	if (!bIsReadbackPending)
+	{
+		return;
+	}
+
+	// Wait for the copy (or lock) commands to be submitted
+	if (!ReadbackFence.IsFenceComplete())
+	{
+		World->GetTimerManager().SetTimerForNextTick(this, &USLVisionSceneCaptureRenderer::CheckReadback);
+		return;
+	}
+
+	if (!bIsLockPending)
+	{
+		// Poll the GPU copies, the staging textures are only mapped when all are done so the lock does not stall
+		for (const auto& Readback : Readbacks)
+		{
+			if (!Readback->IsReady())
+			{
+				World->GetTimerManager().SetTimerForNextTick(this, &USLVisionSceneCaptureRenderer::CheckReadback);
+				return;
+			}
+		}
+
+		// Map the staging textures on the render thread and copy the rows (the staging rows can be padded)
+		const FIntPoint Size = Resolution;
+		TArray<TSharedPtr<FRHIGPUTextureReadback, ESPMode::ThreadSafe>> LockReadbacks = Readbacks;
+		TArray<TSharedPtr<TArray<FColor>, ESPMode::ThreadSafe>> LockBuffers = ReadbackBuffers;
+		ENQUEUE_RENDER_COMMAND(SLVisionLockCapture)(
+			[LockReadbacks, LockBuffers, Size](FRHICommandListImmediate& RHICmdList)
+		{
+			for (int32 Idx = 0; Idx < LockReadbacks.Num(); ++Idx)
+			{
+				TArray<FColor>& Buffer = *LockBuffers[Idx];
+				Buffer.SetNumUninitialized(Size.X * Size.Y);
+				int32 RowPitchInPixels = 0;
+				const FColor* Data = static_cast<const FColor*>(LockReadbacks[Idx]->Lock(RowPitchInPixels));
+				if (Data)
+				{
+					RowPitchInPixels = FMath::Max(RowPitchInPixels, Size.X);
+					for (int32 Row = 0; Row < Size.Y; ++Row)
+					{
+						FMemory::Memcpy(Buffer.GetData() + Row * Size.X, Data + Row * RowPitchInPixels, Size.X * sizeof(FColor));
+					}
+				}
+				else
+				{
+					Buffer.Empty();
+				}
+				LockReadbacks[Idx]->Unlock();
+			}
+		});
+		ReadbackFence.BeginFence();
+		bIsLockPending = true;
+		World->GetTimerManager().SetTimerForNextTick(this, &USLVisionSceneCaptureRenderer::CheckReadback);
+		return;
+	}
+
+	TArray<FSLVisionCapturedImage> Images;
+	Images.Reserve(ReadbackBuffers.Num());
+	for (int32 Idx = 0; Idx < ReadbackBuffers.Num(); ++Idx)
+	{
+		FSLVisionCapturedImage& Image = Images.AddDefaulted_GetRef();
+		Image.CameraIdx = CaptureIndexes[Idx].Key;
+		Image.ViewModeIdx = CaptureIndexes[Idx].Value;
+		Image.Size = Resolution;
+		Image.Bitmap = MoveTemp(*ReadbackBuffers[Idx]);
+		Image.bIsValid = Image.Bitmap.Num() == Resolution.X * Resolution.Y;
+		if (!Image.bIsValid)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Could not read back the image of camera %d, view mode %d.."),
+				*FString(__func__), __LINE__, Image.CameraIdx, Image.ViewModeIdx);
+		}
+	}
+
+	// Allow the next capture to be requested from the callback
+	bIsLockPending = false;
+	bIsReadbackPending = false;
+	OnCapturesReady.ExecuteIfBound(Images);
+}
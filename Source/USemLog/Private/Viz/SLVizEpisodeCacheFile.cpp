@@ -0,0 +1,299 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Viz/SLVizEpisodeCacheFile.h"
+#include "Viz/SLVizEpisodeManager.h"
+#include "Viz/SLVizEpisodeUtils.h"
+#include "Runtime/SLWorldStateFileFormat.h"
+#include "Individuals/SLIndividualManager.h"
+#include "Individuals/Type/SLBaseIndividual.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/FileManager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+// Get the cache file path of the episode (<Saved>/SL/VizCache/<TaskId>/<EpisodeId>.slvc)
+FString FSLVizEpisodeCacheFile::GetFilePath(const FString& TaskId, const FString& EpisodeId)
+{
+	return FPaths::ProjectSavedDir() / TEXT("SL") / TEXT("VizCache") / TaskId / EpisodeId + GetExtension();
+}
+
+// Check if a cache file exists for the episode
+bool FSLVizEpisodeCacheFile::Exists(const FString& TaskId, const FString& EpisodeId)
+{
+	return FPaths::FileExists(GetFilePath(TaskId, EpisodeId));
+}
+
+// Write the episode to its cache file (the handles are replaced by the individual ids)
+bool FSLVizEpisodeCacheFile::Write(const FString& TaskId, const FString& EpisodeId,
+	const FSLVizEpisodeData& InEpisodeData, ASLIndividualManager* IndividualManager)
+{
+	if (!InEpisodeData.IsValid() || IndividualManager == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Invalid episode data or individual manager, cannot write the cache file of %s.."),
+			*FString(__FUNCTION__), __LINE__, *EpisodeId);
+		return false;
+	}
+
+	TArray<FString> HandleToId;
+	HandleToId.SetNum(InEpisodeData.Targets.Num());
+	for (int32 Handle = 0; Handle < InEpisodeData.Targets.Num(); ++Handle)
+	{
+		USLBaseIndividual* Individual = InEpisodeData.Targets[Handle].IsValid() ? IndividualManager->GetIndividualByHandle(Handle) : nullptr;
+		if (Individual)
+		{
+			HandleToId[Handle] = Individual->GetIdValue();
+		}
+	}
+	return Write(TaskId, EpisodeId, InEpisodeData, HandleToId);
+}
+
+// Write the episode to its cache file using the given handle to id mapping (does not access the world, any thread)
+bool FSLVizEpisodeCacheFile::Write(const FString& TaskId, const FString& EpisodeId,
+	const FSLVizEpisodeData& InEpisodeData, const TArray<FString>& HandleToId)
+{
+	if (!InEpisodeData.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Invalid episode data, cannot write the cache file of %s.."),
+			*FString(__FUNCTION__), __LINE__, *EpisodeId);
+		return false;
+	}
+
+	const double ExecBegin = FPlatformTime::Seconds();
+
+	// Ids of the replay targets, the handle is replaced by the index in the ids array
+	TArray<FString> Ids;
+	TArray<int32> HandleToIdIdx;
+	HandleToIdIdx.Init(INDEX_NONE, InEpisodeData.Targets.Num());
+	for (int32 Handle = 0; Handle < InEpisodeData.Targets.Num(); ++Handle)
+	{
+		if (InEpisodeData.Targets[Handle].IsValid() && HandleToId.IsValidIndex(Handle) && !HandleToId[Handle].IsEmpty())
+		{
+			HandleToIdIdx[Handle] = Ids.Add(HandleToId[Handle]);
+		}
+	}
+
+	TArray<uint8> Data;
+	FSLWorldStateFileFormat::WriteValue<uint32>(Data, HeaderMagic);
+	FSLWorldStateFileFormat::WriteValue<int32>(Data, Version);
+	FSLWorldStateFileFormat::WriteValue<int32>(Data, Ids.Num());
+	for (const FString& Id : Ids)
+	{
+		FSLWorldStateFileFormat::WriteString(Data, Id);
+	}
+	FSLWorldStateFileFormat::WriteValue<int32>(Data, InEpisodeData.KeyframeInterval);
+	FSLWorldStateFileFormat::WriteValue<int32>(Data, InEpisodeData.Timestamps.Num());
+	FSLWorldStateFileFormat::WriteValue<int32>(Data, InEpisodeData.Keyframes.Num());
+
+	const int32 TimestampsOffset = Data.AddUninitialized(InEpisodeData.Timestamps.Num() * sizeof(float));
+	FMemory::Memcpy(Data.GetData() + TimestampsOffset, InEpisodeData.Timestamps.GetData(), InEpisodeData.Timestamps.Num() * sizeof(float));
+
+	for (const auto& Keyframe : InEpisodeData.Keyframes)
+	{
+		WriteFrame(Data, Keyframe, HandleToIdIdx);
+	}
+	for (const auto& CompactFrame : InEpisodeData.CompactFrames)
+	{
+		WriteFrame(Data, CompactFrame, HandleToIdIdx);
+	}
+	FSLWorldStateFileFormat::WriteValue<uint32>(Data, EndMagic);
+
+	// Write to a temporary file first, a partially written cache file is never read
+	const FString FilePath = GetFilePath(TaskId, EpisodeId);
+	const FString TmpFilePath = FilePath + TEXT(".tmp");
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(FilePath), true);
+	if (!FFileHelper::SaveArrayToFile(Data, *TmpFilePath) || !IFileManager::Get().Move(*FilePath, *TmpFilePath, true))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not write %s.."), *FString(__FUNCTION__), __LINE__, *FilePath);
+		IFileManager::Get().Delete(*TmpFilePath);
+		return false;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Wrote %s (%d frames, %d ids, %.2f MB) in %f seconds.."),
+		*FString(__FUNCTION__), __LINE__, *FilePath, InEpisodeData.Timestamps.Num(), Ids.Num(),
+		Data.Num() / (1024.0 * 1024.0), FPlatformTime::Seconds() - ExecBegin);
+	return true;
+}
+
+// Read the episode from its cache file (the file is memory mapped, the ids are mapped to the current handles)
+bool FSLVizEpisodeCacheFile::Read(const FString& TaskId, const FString& EpisodeId,
+	ASLIndividualManager* IndividualManager, FSLVizEpisodeData& OutEpisodeData)
+{
+	const FString FilePath = GetFilePath(TaskId, EpisodeId);
+	if (IndividualManager == nullptr || !FPaths::FileExists(FilePath))
+	{
+		return false;
+	}
+
+	const double ExecBegin = FPlatformTime::Seconds();
+
+	// Map the file into memory, fall back to loading it if mapping is not supported
+	TUniquePtr<IMappedFileHandle> MappedHandle(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FilePath));
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	TArray<uint8> LoadedData;
+	const uint8* Data = nullptr;
+	const uint8* End = nullptr;
+	if (MappedHandle.IsValid() && MappedHandle->GetFileSize() > 0)
+	{
+		MappedRegion.Reset(MappedHandle->MapRegion(0, MappedHandle->GetFileSize()));
+	}
+	if (MappedRegion.IsValid())
+	{
+		Data = MappedRegion->GetMappedPtr();
+		End = Data + MappedRegion->GetMappedSize();
+	}
+	else if (FFileHelper::LoadFileToArray(LoadedData, *FilePath))
+	{
+		Data = LoadedData.GetData();
+		End = Data + LoadedData.Num();
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not read %s.."), *FString(__FUNCTION__), __LINE__, *FilePath);
+		return false;
+	}
+
+	// Header
+	uint32 Magic = 0;
+	int32 FileVersion = 0;
+	int32 NumIds = 0;
+	if (!FSLWorldStateFileFormat::ReadValue(Data, End, Magic) || Magic != HeaderMagic
+		|| !FSLWorldStateFileFormat::ReadValue(Data, End, FileVersion) || FileVersion != Version
+		|| !FSLWorldStateFileFormat::ReadValue(Data, End, NumIds) || NumIds < 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not a valid (v%d) episode cache file, it will be rebuilt.."),
+			*FString(__FUNCTION__), __LINE__, *FilePath, Version);
+		return false;
+	}
+	TArray<FString> Ids;
+	Ids.SetNum(NumIds);
+	for (FString& Id : Ids)
+	{
+		if (!FSLWorldStateFileFormat::ReadString(Data, End, Id))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is truncated, it will be rebuilt.."), *FString(__FUNCTION__), __LINE__, *FilePath);
+			return false;
+		}
+	}
+
+	int32 KeyframeInterval = 0;
+	int32 NumFrames = 0;
+	int32 NumKeyframes = 0;
+	if (!FSLWorldStateFileFormat::ReadValue(Data, End, KeyframeInterval) || KeyframeInterval < 1
+		|| !FSLWorldStateFileFormat::ReadValue(Data, End, NumFrames) || NumFrames < 0
+		|| !FSLWorldStateFileFormat::ReadValue(Data, End, NumKeyframes) || NumKeyframes < 0
+		|| Data + NumFrames * sizeof(float) > End)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is truncated, it will be rebuilt.."), *FString(__FUNCTION__), __LINE__, *FilePath);
+		return false;
+	}
+
+	// Map the ids to the handles of the current world and resolve their replay targets once
+	FSLVizEpisodeData EpisodeData(NumFrames, KeyframeInterval);
+	EpisodeData.Id = EpisodeId;
+	TArray<int32> IdIdxToHandle = IndividualManager->GetIndividualHandles(Ids);
+	EpisodeData.Targets.SetNum(IndividualManager->GetNumIndividualHandles());
+	int32 NumUnresolved = 0;
+	for (int32& Handle : IdIdxToHandle)
+	{
+		if (Handle != INDEX_NONE)
+		{
+			EpisodeData.Targets[Handle] = FSLVizEpisodeUtils::GetEpisodeTarget(IndividualManager->GetIndividualByHandle(Handle));
+		}
+		if (Handle == INDEX_NONE || !EpisodeData.Targets[Handle].IsValid())
+		{
+			Handle = INDEX_NONE;
+			NumUnresolved++;
+		}
+	}
+	if (NumUnresolved > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %d/%d individuals of %s are not in the world, their poses are ignored.."),
+			*FString(__FUNCTION__), __LINE__, NumUnresolved, Ids.Num(), *FilePath);
+	}
+
+	EpisodeData.Timestamps.SetNumUninitialized(NumFrames);
+	FMemory::Memcpy(EpisodeData.Timestamps.GetData(), Data, NumFrames * sizeof(float));
+	Data += NumFrames * sizeof(float);
+
+	EpisodeData.Keyframes.SetNum(NumKeyframes);
+	for (auto& Keyframe : EpisodeData.Keyframes)
+	{
+		if (!ReadFrame(Data, End, IdIdxToHandle, true, Keyframe))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is truncated, it will be rebuilt.."), *FString(__FUNCTION__), __LINE__, *FilePath);
+			return false;
+		}
+	}
+	EpisodeData.CompactFrames.SetNum(NumFrames);
+	for (auto& CompactFrame : EpisodeData.CompactFrames)
+	{
+		if (!ReadFrame(Data, End, IdIdxToHandle, false, CompactFrame))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is truncated, it will be rebuilt.."), *FString(__FUNCTION__), __LINE__, *FilePath);
+			return false;
+		}
+	}
+
+	if (!FSLWorldStateFileFormat::ReadValue(Data, End, Magic) || Magic != EndMagic || !EpisodeData.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is corrupted, it will be rebuilt.."), *FString(__FUNCTION__), __LINE__, *FilePath);
+		return false;
+	}
+
+	OutEpisodeData = MoveTemp(EpisodeData);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Read %s (%d frames, %d keyframes) in %f seconds.."),
+		*FString(__FUNCTION__), __LINE__, *FilePath, NumFrames, NumKeyframes, FPlatformTime::Seconds() - ExecBegin);
+	return true;
+}
+
+// Append the frame poses with the handles replaced by the id indexes
+void FSLVizEpisodeCacheFile::WriteFrame(TArray<uint8>& OutData, const FSLVizEpisodeFrameData& Frame, const TArray<int32>& HandleToIdIdx)
+{
+	// Reserve the number of poses, only the ones of the known handles are written
+	const int32 NumOffset = OutData.AddUninitialized(sizeof(int32));
+	int32 Num = 0;
+	for (const auto& HandlePosePair : Frame.Poses)
+	{
+		const int32 IdIdx = HandleToIdIdx.IsValidIndex(HandlePosePair.Key) ? HandleToIdIdx[HandlePosePair.Key] : INDEX_NONE;
+		if (IdIdx != INDEX_NONE)
+		{
+			FSLWorldStateBinaryFormat::WriteInt(OutData, IdIdx);
+			FSLWorldStateBinaryFormat::WritePose(OutData, HandlePosePair.Value);
+			Num++;
+		}
+	}
+	FMemory::Memcpy(OutData.GetData() + NumOffset, &Num, sizeof(int32));
+}
+
+// Read the frame poses with the id indexes replaced by the handles (the poses of unknown ids are skipped)
+bool FSLVizEpisodeCacheFile::ReadFrame(const uint8*& Data, const uint8* End, const TArray<int32>& IdIdxToHandle,
+	bool bIsKeyframe, FSLVizEpisodeFrameData& OutFrame)
+{
+	int32 Num = 0;
+	if (!FSLWorldStateBinaryFormat::ReadInt(Data, End, Num) || Num < 0)
+	{
+		return false;
+	}
+	OutFrame.Poses.Reserve(Num);
+
+	int32 IdIdx = INDEX_NONE;
+	FTransform Pose;
+	for (int32 EntryIdx = 0; EntryIdx < Num; ++EntryIdx)
+	{
+		if (!FSLWorldStateBinaryFormat::ReadInt(Data, End, IdIdx) || !IdIdxToHandle.IsValidIndex(IdIdx)
+			|| !FSLWorldStateBinaryFormat::ReadPose(Data, End, Pose))
+		{
+			return false;
+		}
+
+		const int32 Handle = IdIdxToHandle[IdIdx];
+		if (Handle != INDEX_NONE)
+		{
+			// The keyframes are used as the base of the seek frames, they need the handle to pose index lookup
+			bIsKeyframe ? OutFrame.Set(Handle, Pose) : OutFrame.Add(Handle, Pose);
+		}
+	}
+	return true;
+}
@@ -0,0 +1,198 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Viz/SLVizEpisodeCacheLoader.h"
+#include "Viz/SLVizEpisodeUtils.h"
+#include "Viz/SLVizEpisodeCacheFile.h"
+#include "Mongo/SLMongoQueryDBHandler.h"
+#include "Individuals/SLIndividualManager.h"
+#include "Individuals/Type/SLBaseIndividual.h"
+#include "Async/Async.h"
+
+// Holds a libmongoc reference for the worker connections
+FSLVizEpisodeCacheLoaderState::FSLVizEpisodeCacheLoaderState()
+{
+	// Initialized here on the game thread, the worker connections only add and release references
+	FSLMongoQueryDBHandler::AcquireMongoLib();
+}
+
+// Releases the libmongoc reference (after the last task finished)
+FSLVizEpisodeCacheLoaderState::~FSLVizEpisodeCacheLoaderState()
+{
+	FSLMongoQueryDBHandler::ReleaseMongoLib();
+}
+
+// Dtor
+FSLVizEpisodeCacheLoader::~FSLVizEpisodeCacheLoader()
+{
+	Cancel();
+}
+
+// Resolve the replay targets and start a background task for every episode, the tasks also write the local cache files if set (game thread)
+bool FSLVizEpisodeCacheLoader::Start(ASLIndividualManager* IndividualManager, const FString& InServerIp, uint16 InServerPort,
+	const FString& InTaskId, const TArray<FString>& EpisodeIds, bool bInWriteCacheFiles)
+{
+	if (State.IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Loader is already started, cannot restart.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+	if (IndividualManager == nullptr || EpisodeIds.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Invalid individual manager or no episodes to load.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	const double ExecBegin = FPlatformTime::Seconds();
+
+	State = MakeShared<FSLVizEpisodeCacheLoaderState, ESPMode::ThreadSafe>();
+	State->ServerIp = InServerIp;
+	State->ServerPort = InServerPort;
+	State->TaskId = InTaskId;
+	State->bWriteCacheFiles = bInWriteCacheFiles;
+
+	// The tasks only read these, the world is not accessed outside of the game thread
+	TMap<FString, int32>& IdToHandle = State->IdToHandle;
+	for (USLBaseIndividual* Individual : IndividualManager->GetIndividuals())
+	{
+		const FString Id = Individual ? Individual->GetIdValue() : FString();
+		if (!Id.IsEmpty())
+		{
+			const int32 Handle = IndividualManager->GetIndividualHandle(Id);
+			if (Handle != INDEX_NONE)
+			{
+				IdToHandle.Add(Id, Handle);
+			}
+		}
+	}
+	State->Targets.SetNum(IndividualManager->GetNumIndividualHandles());
+	State->HandleToId.SetNum(IndividualManager->GetNumIndividualHandles());
+	for (const auto& IdHandlePair : IdToHandle)
+	{
+		State->Targets[IdHandlePair.Value] = FSLVizEpisodeUtils::GetEpisodeTarget(IndividualManager->GetIndividualByHandle(IdHandlePair.Value));
+		State->HandleToId[IdHandlePair.Value] = IdHandlePair.Key;
+	}
+
+	for (const FString& EpisodeId : EpisodeIds)
+	{
+		FSLVizEpisodeCacheJob& Job = Jobs.AddDefaulted_GetRef();
+		Job.EpisodeId = EpisodeId;
+		Job.Result = MakeShared<FSLVizEpisodeData, ESPMode::ThreadSafe>();
+
+		// The tasks keep the state and their result alive, the loader is not accessed
+		TSharedPtr<FSLVizEpisodeCacheLoaderState, ESPMode::ThreadSafe> TaskState = State;
+		TSharedPtr<FSLVizEpisodeData, ESPMode::ThreadSafe> Result = Job.Result;
+		Job.Future = Async(EAsyncExecution::ThreadPool, [TaskState, EpisodeId, Result]()
+		{
+			const bool bBuilt = LoadEpisode(*TaskState, EpisodeId, *Result);
+			TaskState->NumFinished.Increment();
+			return bBuilt;
+		});
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Started caching %d episodes of %s in the background (%d individuals resolved in %f seconds).."),
+		*FString(__FUNCTION__), __LINE__, Jobs.Num(), *InTaskId, IdToHandle.Num(), FPlatformTime::Seconds() - ExecBegin);
+	return true;
+}
+
+// Move the episodes built since the last call to the output array (game thread)
+int32 FSLVizEpisodeCacheLoader::CollectFinished(TArray<FSLVizEpisodeData>& OutEpisodes)
+{
+	int32 NumCollected = 0;
+	for (auto& Job : Jobs)
+	{
+		if (Job.bCollected || !Job.Future.IsReady())
+		{
+			continue;
+		}
+
+		Job.bCollected = true;
+		if (Job.Future.Get())
+		{
+			OutEpisodes.Emplace(MoveTemp(*Job.Result));
+			NumCollected++;
+		}
+		Job.Result.Reset();
+	}
+	return NumCollected;
+}
+
+// Signal the tasks to stop without waiting for them, the episodes which are not collected yet are discarded
+void FSLVizEpisodeCacheLoader::Cancel()
+{
+	// The running tasks finish their current step in the background and release the shared state
+	if (State.IsValid())
+	{
+		State->bCancelRequested = true;
+	}
+	for (auto& Job : Jobs)
+	{
+		Job.bCollected = true;
+		Job.Result.Reset();
+		Job.Future = TFuture<bool>();
+	}
+}
+
+// True while there are episodes which are not collected yet
+bool FSLVizEpisodeCacheLoader::IsRunning() const
+{
+	for (const auto& Job : Jobs)
+	{
+		if (!Job.bCollected)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Fetch, build and write the episode with its own database connection (worker thread)
+bool FSLVizEpisodeCacheLoader::LoadEpisode(const FSLVizEpisodeCacheLoaderState& InState, const FString& EpisodeId, FSLVizEpisodeData& OutEpisodeData)
+{
+	if (InState.bCancelRequested)
+	{
+		return false;
+	}
+
+	const double ExecBegin = FPlatformTime::Seconds();
+
+	FSLMongoQueryDBHandler DBHandler;
+	if (!DBHandler.Connect(InState.ServerIp, InState.ServerPort)
+		|| !DBHandler.SetDatabase(InState.TaskId)
+		|| !DBHandler.SetCollection(EpisodeId))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not connect to episode %s::%s.."),
+			*FString(__FUNCTION__), __LINE__, *InState.TaskId, *EpisodeId);
+		return false;
+	}
+
+	const FSLMongoEpisodeData MongoEpisodeData = DBHandler.GetEpisodeData();
+	DBHandler.Disconnect();
+	const double FetchDuration = FPlatformTime::Seconds() - ExecBegin;
+	if (InState.bCancelRequested)
+	{
+		return false;
+	}
+
+	OutEpisodeData = FSLVizEpisodeData(MongoEpisodeData.Num());
+	OutEpisodeData.Id = EpisodeId;
+	if (!FSLVizEpisodeUtils::BuildEpisodeData(InState.IdToHandle, InState.Targets, MongoEpisodeData, OutEpisodeData))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not build episode %s::%s.."),
+			*FString(__FUNCTION__), __LINE__, *InState.TaskId, *EpisodeId);
+		return false;
+	}
+
+	const double BuildDuration = FPlatformTime::Seconds() - ExecBegin - FetchDuration;
+
+	// The episode is serialized and saved here, a failed write only means it is rebuilt in the next session
+	if (InState.bWriteCacheFiles && !InState.bCancelRequested)
+	{
+		FSLVizEpisodeCacheFile::Write(InState.TaskId, EpisodeId, OutEpisodeData, InState.HandleToId);
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Episode %s::%s (%d frames): fetch=[%f], build=[%f], write=[%f] seconds.."),
+		*FString(__FUNCTION__), __LINE__, *InState.TaskId, *EpisodeId, MongoEpisodeData.Num(),
+		FetchDuration, BuildDuration, FPlatformTime::Seconds() - ExecBegin - FetchDuration - BuildDuration);
+	return true;
+}
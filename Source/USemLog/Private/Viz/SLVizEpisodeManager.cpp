@@ -3,7 +3,9 @@
 
 #include "Viz/SLVizEpisodeManager.h"
 #include "Viz/SLVizEpisodeUtils.h"
+#include "Viz/SLVizEpisodeStreamer.h"
 #include "Components/PoseableMeshComponent.h"
+#include "TimerManager.h"
 
 // Sets default values
 ASLVizEpisodeManager::ASLVizEpisodeManager()
@@ -16,12 +18,18 @@ ASLVizEpisodeManager::ASLVizEpisodeManager()
 	bEpisodeLoaded = false;
 	bLoopReplay = false;
 	bReplayRunning = false;
+	bClockReplay = false;
 
 	EpisodeDefaultUpdateRate = 0.f;
+	ReplaySpeed = 1.f;
+	ReplayTime = 0.f;
+	InterpFrameIndex = INDEX_NONE;
 	ActiveFrameIndex = INDEX_NONE;
 	ReplayFirstFrameIndex = INDEX_NONE;
 	ReplayLastFrameIndex = INDEX_NONE;
 	ReplayStepSize = 1;
+	PendingGotoFrameIndex = INDEX_NONE;
+	StreamStartTime = 0.0;
 
 #if WITH_EDITORONLY_DATA
 	// Make manager sprite smaller (used to easily find the actor in the world)
@@ -34,12 +42,18 @@ void ASLVizEpisodeManager::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	if (!ApplyNextFrameChanges())
+	// Streamed episode waiting for the window of the goto frame
+	if (PendingGotoFrameIndex != INDEX_NONE)
+	{
+		return;
+	}
+
+	const bool bHasNextFrame = bClockReplay ? ApplyClockTime(DeltaTime) : ApplyNextFrameChanges();
+	if (!bHasNextFrame)
 	{
 		if (bLoopReplay)
 		{
-			ActiveFrameIndex = ReplayFirstFrameIndex;
-			GotoFrame(ActiveFrameIndex);
+			GotoFrame(ReplayFirstFrameIndex);
 		}
 		else
 		{
@@ -48,6 +62,13 @@ void ASLVizEpisodeManager::Tick(float DeltaTime)
 	}
 }
 
+// Called when actor removed from game or game ended
+void ASLVizEpisodeManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+	ClearStream();
+}
+
 // Set the whole world as a visual, disable physics, collisions, attachments, unnecesary components
 void ASLVizEpisodeManager::ConvertWorld()
 {
@@ -88,8 +109,20 @@ void ASLVizEpisodeManager::LoadEpisode(const FSLVizEpisodeData& InEpisodeData)
 	// Clear any previous episode
 	ClearEpisode();
 
-	// Set the episode data
+	// Set the episode data, the frames only keep the poses of the replayed targets
 	EpisodeData = InEpisodeData;
+	SetReplayTargets();
+	int32 NumPruned = 0;
+	for (auto& Keyframe : EpisodeData.Keyframes)
+	{
+		NumPruned += PruneFrame(Keyframe);
+	}
+	for (auto& CompactFrame : EpisodeData.CompactFrames)
+	{
+		NumPruned += PruneFrame(CompactFrame);
+	}
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Removed %d poses of static or unresolved targets from episode %s.."),
+		*FString(__FUNCTION__), __LINE__, NumPruned, *EpisodeData.Id);
 
 	// Calculate a default update rate  
 	CalcRealtimeAproxUpdateRateValue(256);
@@ -101,11 +134,62 @@ void ASLVizEpisodeManager::LoadEpisode(const FSLVizEpisodeData& InEpisodeData)
 	GotoFrame(0);
 }
 
+// Load the episode in windows from the initialized streamer, the frames are applied as soon as they are loaded
+bool ASLVizEpisodeManager::LoadEpisodeStreamed(TSharedPtr<FSLVizEpisodeStreamer> InStreamer)
+{
+	if (!InStreamer.IsValid() || InStreamer->GetTimestamps().Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Episode streamer is not initialized.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	// Stop any active replay and clear any previous episode
+	ClearEpisode();
+
+	// The timestamps are known upfront, the frames are filled in as the windows are loaded
+	Streamer = InStreamer;
+	EpisodeData.Id = Streamer->GetEpisodeId();
+	EpisodeData.Targets = Streamer->GetTargets();
+	SetReplayTargets();
+	EpisodeData.KeyframeInterval = Streamer->GetWindowSize();
+	EpisodeData.Timestamps = Streamer->GetTimestamps();
+	EpisodeData.CompactFrames.SetNum(EpisodeData.Timestamps.Num());
+	StreamWindowStates.Init(ESLVizStreamWindowState::Unloaded, Streamer->GetNumWindows());
+	StreamWindowStates[0] = ESLVizStreamWindowState::Requested;
+	StreamStartTime = FPlatformTime::Seconds();
+
+	if (!Streamer->Start())
+	{
+		ClearStream();
+		EpisodeData.Clear();
+		return false;
+	}
+
+	// Consume the loaded windows independently of the replay tick
+	GetWorld()->GetTimerManager().SetTimer(StreamTimerHandle, this, &ASLVizEpisodeManager::UpdateStream, 0.02f, true);
+
+	// Calculate a default update rate
+	CalcRealtimeAproxUpdateRateValue(256);
+
+	// Mark the episode loaded flag to true
+	bEpisodeLoaded = true;
+
+	// Goto first frame (applied as soon as the first window is loaded)
+	GotoFrame(0);
+	return true;
+}
+
 // Remove episode data
 void ASLVizEpisodeManager::ClearEpisode()
 {
 	StopReplay();
+	ClearStream();
 	EpisodeData.Clear();
+	Skeletons.Empty();
+	SeekFrame = FSLVizEpisodeFrameData();
+	InterpStartFrame = FSLVizEpisodeFrameData();
+	InterpFrame = FSLVizEpisodeFrameData();
+	InterpFrameIndex = INDEX_NONE;
 	ActiveFrameIndex = INDEX_NONE;
 	ReplayFirstFrameIndex = INDEX_NONE;
 	ReplayLastFrameIndex = INDEX_NONE;
@@ -129,14 +213,27 @@ bool ASLVizEpisodeManager::GotoFrame(int32 FrameIndex)
 		return false;
 	}
 
-	if(!EpisodeData.FullFrames.IsValidIndex(FrameIndex))
+	if(!EpisodeData.CompactFrames.IsValidIndex(FrameIndex))
 	{
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d Frame index is not valid, this should not happen.."), *FString(__FUNCTION__), __LINE__);
 		return false;
 	}
 
+	// The clock replay continues from the frame time
+	ReplayTime = EpisodeData.Timestamps[FrameIndex];
+	InterpFrameIndex = INDEX_NONE;
+
+	// Streamed episode, defer the goto until the window of the frame is loaded
+	if (Streamer.IsValid() && !IsFrameStreamed(FrameIndex))
+	{
+		PendingGotoFrameIndex = FrameIndex;
+		RequestStreamedFrame(FrameIndex);
+		return true;
+	}
+	PendingGotoFrameIndex = INDEX_NONE;
+
+	ApplyReconstructedFrame(FrameIndex);
 	ActiveFrameIndex = FrameIndex;
-	ApplyPoses(EpisodeData.FullFrames[FrameIndex]);
 
 	//UE_LOG(LogTemp, Log, TEXT("%s::%d Applied poses from frame %d.."), *FString(__FUNCTION__), __LINE__, ActiveFrameIndex);
 	return true;
@@ -177,6 +274,7 @@ bool ASLVizEpisodeManager::Play(const FSLVizEpisodePlayParams& PlayParams)
 
 	// Should the replay be looped
 	bLoopReplay = PlayParams.bLoop;
+	SetReplayClock(PlayParams.bUseClock, PlayParams.Speed);
 
 	// Goto first frame
 	GotoFrame(ReplayFirstFrameIndex);
@@ -184,7 +282,7 @@ bool ASLVizEpisodeManager::Play(const FSLVizEpisodePlayParams& PlayParams)
 	// Start playing the frames
 	StartReplay();
 
-	return false;
+	return true;
 }
 
 // Play whole episode
@@ -258,6 +356,19 @@ void ASLVizEpisodeManager::SetReplayParams(bool bLoop, float UpdateRate, int32 S
 	UpdateRate > 0.f ? SetActorTickInterval(UpdateRate) : SetActorTickInterval(EpisodeDefaultUpdateRate);
 }
 
+// Set the clock replay (episode time follows the wall clock times the speed factor, the poses are interpolated)
+void ASLVizEpisodeManager::SetReplayClock(bool bUseClock, float Speed)
+{
+	bClockReplay = bUseClock;
+	ReplaySpeed = FMath::Clamp(Speed, 0.1f, 20.f);
+	InterpFrameIndex = INDEX_NONE;
+	if (bClockReplay)
+	{
+		// Update with every rendered frame
+		SetActorTickInterval(0.f);
+	}
+}
+
 // Set replay to pause or play
 void ASLVizEpisodeManager::SetPauseReplay(bool bPause)
 {
@@ -281,6 +392,69 @@ void ASLVizEpisodeManager::StopReplay()
 	}
 }
 
+// Check that the sequential (compact changes) replay between the given frames ends in the same world state
+// as applying the full last frame, the world is left in the last frame state (not available for streamed episodes)
+bool ASLVizEpisodeManager::CheckDeltaReplay(int32 FirstFrame, int32 LastFrame, float Tolerance)
+{
+	if (Streamer.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Not available for streamed episodes.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	if (bReplayRunning)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Replay is running, stop it first.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	if (FirstFrame > LastFrame || !EpisodeData.CompactFrames.IsValidIndex(LastFrame) || !GotoFrame(FirstFrame))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Invalid frame interval [%d, %d].."), *FString(__FUNCTION__), __LINE__, FirstFrame, LastFrame);
+		return false;
+	}
+
+	// Sequential replay, only the changes of every frame are applied
+	for (int32 Idx = FirstFrame + 1; Idx <= LastFrame; ++Idx)
+	{
+		ApplyPoses(EpisodeData.CompactFrames[Idx]);
+	}
+	TArray<FTransform> DeltaPoses;
+	GetReplayedPoses(DeltaPoses);
+
+	// Full frame reconstructed from its keyframe
+	ActiveFrameIndex = INDEX_NONE;
+	ApplyReconstructedFrame(LastFrame);
+	ActiveFrameIndex = LastFrame;
+	TArray<FTransform> FullPoses;
+	GetReplayedPoses(FullPoses);
+
+	int32 NumMismatches = 0;
+	float MaxLocError = 0.f;
+	for (int32 Handle = 0; Handle < FullPoses.Num(); ++Handle)
+	{
+		const FSLVizEpisodeTarget& Target = EpisodeData.Targets[Handle];
+		if (!Target.IsReplayed())
+		{
+			continue;
+		}
+
+		MaxLocError = FMath::Max(MaxLocError, FVector::Dist(DeltaPoses[Handle].GetLocation(), FullPoses[Handle].GetLocation()));
+		if (!DeltaPoses[Handle].Equals(FullPoses[Handle], Tolerance))
+		{
+			NumMismatches++;
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Frame %d mismatch of handle %d (%s %s): sequential=[%s] full=[%s].."),
+				*FString(__FUNCTION__), __LINE__, LastFrame, Handle,
+				Target.Actor ? *Target.Actor->GetName() : *Target.PMC->GetName(), *Target.BoneName.ToString(),
+				*DeltaPoses[Handle].ToString(), *FullPoses[Handle].ToString());
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Frames [%d, %d]: %d mismatches, max location error %f.."),
+		*FString(__FUNCTION__), __LINE__, FirstFrame, LastFrame, NumMismatches, MaxLocError);
+	return NumMismatches == 0;
+}
+
 //// Goto the next nth frame
 //void ASLVizEpisodeManager::Next(int32 StepSize, bool bLoop)
 //{	
@@ -476,26 +650,135 @@ bool ASLVizEpisodeManager::ApplyNextFrameChanges()
 {
 	if (ActiveFrameIndex < ReplayLastFrameIndex)
 	{
+		// Streamed episode, wait for the loader if the replay caught up with it
+		const int32 NextFrameIndex = ActiveFrameIndex + 1;
+		if (Streamer.IsValid() && EpisodeData.CompactFrames.IsValidIndex(NextFrameIndex) && !IsFrameStreamed(NextFrameIndex))
+		{
+			RequestStreamedFrame(NextFrameIndex);
+			return true;
+		}
+
 		ActiveFrameIndex++;
-		//if (EpisodeData.CompactFrames.IsValidIndex(ActiveFrameIndex))
-		if (EpisodeData.FullFrames.IsValidIndex(ActiveFrameIndex))
+		if (EpisodeData.CompactFrames.IsValidIndex(ActiveFrameIndex))
 		{
-			//ApplyPoses(EpisodeData.CompactFrames[ActiveFrameIndex]);
-			ApplyPoses(EpisodeData.FullFrames[ActiveFrameIndex]);
+			// The world is in the previous frame state, only the changes need to be applied
+			ApplyPoses(EpisodeData.CompactFrames[ActiveFrameIndex]);
 			return true;
 		}
 		else
 		{
-			//UE_LOG(LogTemp, Warning, TEXT("%s::%d ActiveFrameIndex=%d (Num=%d) is not valid, this should not happen.."),
-			//	*FString(__FUNCTION__), __LINE__, ActiveFrameIndex, EpisodeData.CompactFrames.Num());
 			UE_LOG(LogTemp, Warning, TEXT("%s::%d ActiveFrameIndex=%d (Num=%d) is not valid, this should not happen.."),
-				*FString(__FUNCTION__), __LINE__, ActiveFrameIndex, EpisodeData.FullFrames.Num());
+				*FString(__FUNCTION__), __LINE__, ActiveFrameIndex, EpisodeData.CompactFrames.Num());
 			ActiveFrameIndex--;
 		}
 	}
 	return false;	
 }
 
+// Advance the replay time and apply the interpolated poses (return false if the last frame is reached)
+bool ASLVizEpisodeManager::ApplyClockTime(float DeltaTime)
+{
+	const int32 LastFrameIndex = FMath::Min(ReplayLastFrameIndex, EpisodeData.Timestamps.Num() - 1);
+	if (ActiveFrameIndex == INDEX_NONE || ActiveFrameIndex >= LastFrameIndex)
+	{
+		return false;
+	}
+
+	float NextReplayTime = ReplayTime + DeltaTime * ReplaySpeed;
+
+	// Streamed episode, the windows past the prefetch range are evicted before they are reached,
+	// limit the step so the replay (and the interpolation target) stays within the kept windows
+	int32 MaxFrameIndex = LastFrameIndex;
+	if (Streamer.IsValid())
+	{
+		const int32 LastKeptWindow = EpisodeData.GetKeyframeIndex(ActiveFrameIndex) + Streamer->GetNumPrefetchWindows();
+		const int32 LastKeptFrameIndex = EpisodeData.GetKeyframeFrameIndex(LastKeptWindow + 1) - 1;
+		if (LastKeptFrameIndex < LastFrameIndex)
+		{
+			MaxFrameIndex = FMath::Max(LastKeptFrameIndex - 1, ActiveFrameIndex);
+			NextReplayTime = FMath::Min(NextReplayTime, EpisodeData.Timestamps[MaxFrameIndex]);
+		}
+	}
+
+	if (NextReplayTime >= EpisodeData.Timestamps[LastFrameIndex])
+	{
+		if (Streamer.IsValid() && !IsFrameStreamed(LastFrameIndex))
+		{
+			RequestStreamedFrame(LastFrameIndex);
+			return true;
+		}
+
+		// Finish in the exact last frame state
+		ReplayTime = EpisodeData.Timestamps[LastFrameIndex];
+		ApplyReconstructedFrame(LastFrameIndex);
+		ActiveFrameIndex = LastFrameIndex;
+		InterpFrameIndex = INDEX_NONE;
+		return false;
+	}
+
+	// Frame before the replay time and the one after it (interpolated towards)
+	const int32 FrameIndex = FMath::Clamp(FSLVizEpisodeUtils::BinarySearchLessEqual(EpisodeData.Timestamps, NextReplayTime), ActiveFrameIndex, MaxFrameIndex);
+	const int32 NextFrameIndex = FrameIndex + 1;
+
+	// Streamed episode, hold the time until the loader catches up; when the step crosses windows the frame
+	// is reconstructed from its own window keyframe and compact frames, so that window needs to be loaded as well
+	if (Streamer.IsValid())
+	{
+		const bool bFrameStreamed = IsFrameStreamed(FrameIndex);
+		const bool bNextFrameStreamed = IsFrameStreamed(NextFrameIndex);
+		if (!bFrameStreamed)
+		{
+			RequestStreamedFrame(FrameIndex);
+		}
+		if (!bNextFrameStreamed)
+		{
+			RequestStreamedFrame(NextFrameIndex);
+		}
+		if (!bFrameStreamed || !bNextFrameStreamed)
+		{
+			return true;
+		}
+	}
+	ReplayTime = NextReplayTime;
+
+	// Apply the changes up to the frame, the targets interpolated so far are changed by the passed frames
+	if (FrameIndex != ActiveFrameIndex)
+	{
+		ApplyReconstructedFrame(FrameIndex);
+		ActiveFrameIndex = FrameIndex;
+	}
+
+	// Store the start poses of the targets changed by the next frame
+	const FSLVizEpisodeFrameData& NextFrame = EpisodeData.CompactFrames[NextFrameIndex];
+	if (InterpFrameIndex != NextFrameIndex)
+	{
+		InterpStartFrame.Reset();
+		for (const auto& HandlePosePair : NextFrame.Poses)
+		{
+			InterpStartFrame.Add(HandlePosePair.Key, GetReplayedPose(HandlePosePair.Key));
+		}
+		InterpFrameIndex = NextFrameIndex;
+	}
+
+	const float FrameDuration = EpisodeData.Timestamps[NextFrameIndex] - EpisodeData.Timestamps[FrameIndex];
+	const float Alpha = FrameDuration > SMALL_NUMBER
+		? FMath::Clamp((ReplayTime - EpisodeData.Timestamps[FrameIndex]) / FrameDuration, 0.f, 1.f) : 1.f;
+
+	// The start poses are in the same order as the next frame poses
+	InterpFrame.Reset();
+	for (int32 Idx = 0; Idx < NextFrame.Poses.Num(); ++Idx)
+	{
+		const FTransform& StartPose = InterpStartFrame.Poses[Idx].Value;
+		const FTransform& EndPose = NextFrame.Poses[Idx].Value;
+		InterpFrame.Add(NextFrame.Poses[Idx].Key, FTransform(
+			FQuat::Slerp(StartPose.GetRotation(), EndPose.GetRotation(), Alpha),
+			FMath::Lerp(StartPose.GetLocation(), EndPose.GetLocation(), Alpha),
+			FMath::Lerp(StartPose.GetScale3D(), EndPose.GetScale3D(), Alpha)));
+	}
+	ApplyPoses(InterpFrame);
+	return true;
+}
+
 // Start replay
 void ASLVizEpisodeManager::StartReplay()
 {
@@ -506,34 +789,199 @@ void ASLVizEpisodeManager::StartReplay()
 // Apply frame poses
 void ASLVizEpisodeManager::ApplyPoses(const FSLVizEpisodeFrameData& Frame)
 {
-	for (const auto& ActorPosePair : Frame.ActorPoses)
+	// Only the movable actors are set as targets (see SetReplayTargets)
+	const TArray<FSLVizEpisodeTarget>& Targets = EpisodeData.Targets;
+	for (const auto& HandlePosePair : Frame.Poses)
+	{
+		if (AActor* Actor = Targets[HandlePosePair.Key].Actor)
+		{
+			Actor->SetActorTransform(HandlePosePair.Value);
+		}
+	}
+
+	// Gather the bone poses in component space (the actor poses are already set, so are the component transforms)
+	for (const auto& HandlePosePair : Frame.Poses)
+	{
+		const FSLVizEpisodeTarget& Target = Targets[HandlePosePair.Key];
+		if (Target.SkeletonIndex != INDEX_NONE)
+		{
+			FSLVizEpisodeSkeleton& Skeleton = Skeletons[Target.SkeletonIndex];
+			if (!Skeleton.bDirty)
+			{
+				BeginSkeletonUpdate(Skeleton);
+			}
+			Skeleton.ComponentSpaceTransforms[Target.BoneIndex] =
+				HandlePosePair.Value.GetRelativeTransform(Skeleton.PMC->GetComponentTransform());
+		}
+	}
+
+	// Apply every changed skeleton in one batch
+	for (auto& Skeleton : Skeletons)
 	{
-		// todo, static components can be ignored (might make sense to remove them form the episode data)
-		if (ActorPosePair.Key->GetRootComponent()->Mobility != EComponentMobility::Static)
+		if (Skeleton.bDirty)
 		{
-			ActorPosePair.Key->SetActorTransform(ActorPosePair.Value);
+			EndSkeletonUpdate(Skeleton);
 		}
 	}
+}
 
-	// todo, without this multiple iteration the bones are weirdly offseted
-	for (int32 Idx = 0; Idx < 5; Idx++)
+// Precompute the replayed targets: ignore the static actors, collect the poseable mesh components of the bone targets
+void ASLVizEpisodeManager::SetReplayTargets()
+{
+	Skeletons.Empty();
+	TMap<UPoseableMeshComponent*, int32> PMCToSkeletonIdx;
+	int32 NumStatic = 0;
+	for (auto& Target : EpisodeData.Targets)
 	{
-		for (const auto& PMCBonePosesPair : Frame.BonePoses)
+		// Static actors are never moved, their poses are not applied
+		if (Target.Actor && (!Target.Actor->GetRootComponent() || Target.Actor->GetRootComponent()->Mobility == EComponentMobility::Static))
 		{
-			UPoseableMeshComponent* PMC = PMCBonePosesPair.Key;
-			for (const auto& BoneIndexPosePair : PMCBonePosesPair.Value)
+			Target.Actor = nullptr;
+			NumStatic++;
+		}
+
+		Target.SkeletonIndex = INDEX_NONE;
+		if (!Target.PMC || !Target.PMC->SkeletalMesh)
+		{
+			continue;
+		}
+
+		int32 SkeletonIdx;
+		if (const int32* ExistingIdx = PMCToSkeletonIdx.Find(Target.PMC))
+		{
+			SkeletonIdx = *ExistingIdx;
+		}
+		else
+		{
+			SkeletonIdx = Skeletons.AddDefaulted();
+			FSLVizEpisodeSkeleton& Skeleton = Skeletons[SkeletonIdx];
+			Skeleton.PMC = Target.PMC;
+			const int32 NumBones = Target.PMC->BoneSpaceTransforms.Num();
+			Skeleton.ParentIndexes.SetNumUninitialized(NumBones);
+			for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
 			{
-				const FName BoneName = PMC->GetBoneName(BoneIndexPosePair.Key);
-				PMC->SetBoneTransformByName(BoneName, BoneIndexPosePair.Value, EBoneSpaces::WorldSpace);
+				Skeleton.ParentIndexes[BoneIdx] = Target.PMC->SkeletalMesh->RefSkeleton.GetParentIndex(BoneIdx);
 			}
+			Skeleton.ComponentSpaceTransforms.SetNum(NumBones);
+			PMCToSkeletonIdx.Add(Target.PMC, SkeletonIdx);
+		}
+
+		if (Skeletons[SkeletonIdx].ParentIndexes.IsValidIndex(Target.BoneIndex))
+		{
+			Target.SkeletonIndex = SkeletonIdx;
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Bone index %d is not valid in %s, the bone will not be replayed.."),
+				*FString(__FUNCTION__), __LINE__, Target.BoneIndex, *Target.PMC->GetName());
+		}
+	}
+	UE_LOG(LogTemp, Log, TEXT("%s::%d %d targets, %d static actors ignored, %d skeletons.."),
+		*FString(__FUNCTION__), __LINE__, EpisodeData.Targets.Num(), NumStatic, Skeletons.Num());
+}
+
+// Remove the poses of the targets which are not replayed from the frame
+int32 ASLVizEpisodeManager::PruneFrame(FSLVizEpisodeFrameData& Frame) const
+{
+	const TArray<FSLVizEpisodeTarget>& Targets = EpisodeData.Targets;
+	return Frame.RemoveAll([&Targets](int32 Handle)
+	{
+		return !Targets.IsValidIndex(Handle) || !Targets[Handle].IsReplayed();
+	});
+}
+
+// Get the world poses of all the replayed targets (indexed by the handles)
+void ASLVizEpisodeManager::GetReplayedPoses(TArray<FTransform>& OutPoses) const
+{
+	OutPoses.SetNum(EpisodeData.Targets.Num());
+	for (int32 Handle = 0; Handle < OutPoses.Num(); ++Handle)
+	{
+		OutPoses[Handle] = GetReplayedPose(Handle);
+	}
+}
+
+// Get the current world pose of the replayed target
+FTransform ASLVizEpisodeManager::GetReplayedPose(int32 Handle) const
+{
+	const FSLVizEpisodeTarget& Target = EpisodeData.Targets[Handle];
+	if (Target.Actor)
+	{
+		return Target.Actor->GetActorTransform();
+	}
+	else if (Target.SkeletonIndex != INDEX_NONE)
+	{
+		// Computed from the bone space transforms (does not require a refresh)
+		return Target.PMC->GetBoneTransformByName(Target.BoneName, EBoneSpaces::WorldSpace);
+	}
+	return FTransform::Identity;
+}
+
+// Compute the current component space bone poses of the skeleton before setting the frame bone poses
+void ASLVizEpisodeManager::BeginSkeletonUpdate(FSLVizEpisodeSkeleton& Skeleton) const
+{
+	// The parents always come before their children in the reference skeleton
+	const TArray<FTransform>& BoneSpaceTransforms = Skeleton.PMC->BoneSpaceTransforms;
+	for (int32 BoneIdx = 0; BoneIdx < Skeleton.ParentIndexes.Num(); ++BoneIdx)
+	{
+		const int32 ParentIdx = Skeleton.ParentIndexes[BoneIdx];
+		Skeleton.ComponentSpaceTransforms[BoneIdx] = ParentIdx == INDEX_NONE ? BoneSpaceTransforms[BoneIdx]
+			: BoneSpaceTransforms[BoneIdx] * Skeleton.ComponentSpaceTransforms[ParentIdx];
+	}
+	Skeleton.bDirty = true;
+}
+
+// Convert the component space bone poses to bone space and refresh the skeleton transforms once
+void ASLVizEpisodeManager::EndSkeletonUpdate(FSLVizEpisodeSkeleton& Skeleton) const
+{
+	// Bones without a recorded pose in the frame keep their component space pose
+	TArray<FTransform>& BoneSpaceTransforms = Skeleton.PMC->BoneSpaceTransforms;
+	for (int32 BoneIdx = 0; BoneIdx < Skeleton.ParentIndexes.Num(); ++BoneIdx)
+	{
+		const int32 ParentIdx = Skeleton.ParentIndexes[BoneIdx];
+		BoneSpaceTransforms[BoneIdx] = ParentIdx == INDEX_NONE ? Skeleton.ComponentSpaceTransforms[BoneIdx]
+			: Skeleton.ComponentSpaceTransforms[BoneIdx].GetRelativeTransform(Skeleton.ComponentSpaceTransforms[ParentIdx]);
+	}
+	Skeleton.PMC->MarkRefreshTransformDirty();
+	Skeleton.bDirty = false;
+}
+
+// Apply the poses of the given frame reconstructed from the nearest keyframe (or from the active frame if closer)
+void ASLVizEpisodeManager::ApplyReconstructedFrame(int32 FrameIndex)
+{
+	const int32 KeyframeIndex = EpisodeData.GetKeyframeIndex(FrameIndex);
+	const int32 KeyframeFrameIndex = EpisodeData.GetKeyframeFrameIndex(KeyframeIndex);
+
+	if (ActiveFrameIndex != INDEX_NONE && ActiveFrameIndex < FrameIndex && ActiveFrameIndex >= KeyframeFrameIndex)
+	{
+		// Forward seek closer than the keyframe (same window), the world already is in the active frame state, apply only the changes
+		SeekFrame.Reset();
+		for (int32 Idx = ActiveFrameIndex + 1; Idx <= FrameIndex; ++Idx)
+		{
+			SeekFrame.Merge(EpisodeData.CompactFrames[Idx]);
 		}
+		ApplyPoses(SeekFrame);
+	}
+	else if (FrameIndex == KeyframeFrameIndex)
+	{
+		ApplyPoses(EpisodeData.Keyframes[KeyframeIndex]);
+	}
+	else
+	{
+		// Start from the keyframe and apply the changes forward
+		SeekFrame = EpisodeData.Keyframes[KeyframeIndex];
+		for (int32 Idx = KeyframeFrameIndex + 1; Idx <= FrameIndex; ++Idx)
+		{
+			SeekFrame.Merge(EpisodeData.CompactFrames[Idx]);
+		}
+		ApplyPoses(SeekFrame);
 	}
 }
 
 // Calculate an approximation of the update rate value to coincide with realtime
 void ASLVizEpisodeManager::CalcRealtimeAproxUpdateRateValue(int32 MaxNumSteps)
 {
-	if (!EpisodeData.IsValid())
+	// Streamed episodes only have the timestamps at this point
+	if (!EpisodeData.IsValid() && !Streamer.IsValid())
 	{
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d Episode data is not valid, cannot aprox a default update rate"),
 			*FString(__FUNCTION__), __LINE__);
@@ -567,3 +1015,126 @@ void ASLVizEpisodeManager::CalcRealtimeAproxUpdateRateValue(int32 MaxNumSteps)
 		*FString(__FUNCTION__), __LINE__, EpisodeDefaultUpdateRate);
 }
 
+/* Streaming */
+// Consume the loaded windows, apply pending gotos and evict the windows outside of the prefetch range
+void ASLVizEpisodeManager::UpdateStream()
+{
+	if (!Streamer.IsValid())
+	{
+		return;
+	}
+
+	if (Streamer->HasFailed())
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Streaming episode %s failed, clearing episode.."),
+			*FString(__FUNCTION__), __LINE__, *EpisodeData.Id);
+		ClearEpisode();
+		return;
+	}
+
+	TUniquePtr<FSLVizEpisodeStreamWindow> Window;
+	while (Streamer->DequeueWindow(Window))
+	{
+		const int32 WindowIndex = Window->WindowIndex;
+
+		// Keyframes are loaded in order
+		if (Window->bHasKeyframe && WindowIndex == EpisodeData.Keyframes.Num())
+		{
+			PruneFrame(Window->Keyframe);
+			EpisodeData.Keyframes.Emplace(MoveTemp(Window->Keyframe));
+		}
+
+		if (Window->CompactFrames.Num() > 0)
+		{
+			const int32 FirstFrameIndex = EpisodeData.GetKeyframeFrameIndex(WindowIndex);
+			for (int32 Idx = 0; Idx < Window->CompactFrames.Num(); ++Idx)
+			{
+				PruneFrame(Window->CompactFrames[Idx]);
+				EpisodeData.CompactFrames[FirstFrameIndex + Idx] = MoveTemp(Window->CompactFrames[Idx]);
+			}
+			StreamWindowStates[WindowIndex] = ESLVizStreamWindowState::Loaded;
+		}
+		else
+		{
+			// Only the keyframe was loaded (the window was behind the play head), request it again if needed
+			StreamWindowStates[WindowIndex] = ESLVizStreamWindowState::Unloaded;
+		}
+	}
+
+	if (PendingGotoFrameIndex != INDEX_NONE && IsFrameStreamed(PendingGotoFrameIndex))
+	{
+		if (ActiveFrameIndex == INDEX_NONE)
+		{
+			UE_LOG(LogTemp, Log, TEXT("%s::%d First frame of episode %s available after [%f] seconds.."),
+				*FString(__FUNCTION__), __LINE__, *EpisodeData.Id, FPlatformTime::Seconds() - StreamStartTime);
+		}
+		GotoFrame(PendingGotoFrameIndex);
+	}
+
+	if (ActiveFrameIndex != INDEX_NONE)
+	{
+		Streamer->SetPlayHead(ActiveFrameIndex);
+		EvictStreamedWindows();
+	}
+}
+
+// Check if the frame can be applied (its window and keyframe are loaded)
+bool ASLVizEpisodeManager::IsFrameStreamed(int32 FrameIndex) const
+{
+	const int32 WindowIndex = EpisodeData.GetKeyframeIndex(FrameIndex);
+	return StreamWindowStates.IsValidIndex(WindowIndex)
+		&& StreamWindowStates[WindowIndex] == ESLVizStreamWindowState::Loaded
+		&& EpisodeData.Keyframes.IsValidIndex(WindowIndex);
+}
+
+// Request the window of the frame from the streamer (if not already requested)
+void ASLVizEpisodeManager::RequestStreamedFrame(int32 FrameIndex)
+{
+	const int32 WindowIndex = EpisodeData.GetKeyframeIndex(FrameIndex);
+	if (StreamWindowStates.IsValidIndex(WindowIndex) && StreamWindowStates[WindowIndex] == ESLVizStreamWindowState::Unloaded)
+	{
+		StreamWindowStates[WindowIndex] = ESLVizStreamWindowState::Requested;
+		Streamer->RequestFrame(FrameIndex);
+	}
+}
+
+// Release the compact frames of the windows outside of the prefetch range
+void ASLVizEpisodeManager::EvictStreamedWindows()
+{
+	// Keep the previous window for short backward seeks
+	const int32 PlayHeadWindow = EpisodeData.GetKeyframeIndex(ActiveFrameIndex);
+	const int32 FirstKeptWindow = PlayHeadWindow - 1;
+	const int32 LastKeptWindow = PlayHeadWindow + Streamer->GetNumPrefetchWindows();
+	const int32 PendingWindow = PendingGotoFrameIndex != INDEX_NONE ? EpisodeData.GetKeyframeIndex(PendingGotoFrameIndex) : INDEX_NONE;
+	for (int32 WindowIndex = 0; WindowIndex < StreamWindowStates.Num(); ++WindowIndex)
+	{
+		if (StreamWindowStates[WindowIndex] == ESLVizStreamWindowState::Loaded
+			&& (WindowIndex < FirstKeptWindow || WindowIndex > LastKeptWindow)
+			&& WindowIndex != PendingWindow)
+		{
+			const int32 FirstFrameIndex = EpisodeData.GetKeyframeFrameIndex(WindowIndex);
+			const int32 EndFrameIndex = FMath::Min(FirstFrameIndex + EpisodeData.KeyframeInterval, EpisodeData.CompactFrames.Num());
+			for (int32 FrameIndex = FirstFrameIndex; FrameIndex < EndFrameIndex; ++FrameIndex)
+			{
+				EpisodeData.CompactFrames[FrameIndex] = FSLVizEpisodeFrameData();
+			}
+			StreamWindowStates[WindowIndex] = ESLVizStreamWindowState::Unloaded;
+		}
+	}
+}
+
+// Stop the loader and clear the streaming state
+void ASLVizEpisodeManager::ClearStream()
+{
+	if (GetWorld())
+	{
+		GetWorld()->GetTimerManager().ClearTimer(StreamTimerHandle);
+	}
+	if (Streamer.IsValid())
+	{
+		Streamer->Finish();
+		Streamer.Reset();
+	}
+	StreamWindowStates.Empty();
+	PendingGotoFrameIndex = INDEX_NONE;
+}
@@ -76,126 +76,235 @@ void FSLVizEpisodeUtils::AddPoseablMeshComponentsToSkeletalActors(UWorld* World)
 	}
 }
 
+// Get the replay target (actor or poseable mesh bone) of the individual
+FSLVizEpisodeTarget FSLVizEpisodeUtils::GetEpisodeTarget(USLBaseIndividual* Individual)
+{
+	FSLVizEpisodeTarget Target;
+	if (Individual == nullptr)
+	{
+		return Target;
+	}
+
+	if (Individual->IsA(USLRigidIndividual::StaticClass())
+		|| Individual->IsA(USLSkeletalIndividual::StaticClass())
+		|| Individual->IsA(USLVirtualViewIndividual::StaticClass()))
+	{
+		Target.Actor = Individual->GetParentActor();
+	}
+	else if (auto BI = Cast<USLBoneIndividual>(Individual))
+	{
+		Target.PMC = BI->GetPoseableMeshComponent();
+		Target.BoneIndex = BI->GetBoneIndex();
+	}
+	else if (auto VBI = Cast<USLVirtualBoneIndividual>(Individual))
+	{
+		Target.PMC = VBI->GetPoseableMeshComponent();
+		Target.BoneIndex = VBI->GetBoneIndex();
+	}
+
+	if (Target.PMC)
+	{
+		Target.BoneName = Target.PMC->GetBoneName(Target.BoneIndex);
+	}
+	return Target;
+}
+
 // Build the full replay episode data from the mongo compact form
 bool FSLVizEpisodeUtils::BuildEpisodeData(ASLIndividualManager* IndividualManager,
-	const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData,
+	const FSLMongoEpisodeData& InMongoEpisodeData,
 	FSLVizEpisodeData& OutVizEpisodeData)
 {
-	double ExecBegin = FPlatformTime::Seconds();
-	/* First frame (FullFrame -  contains all the data) */
-	// Process first frame (contains all individuals -- the rest of the frames contain only individuals that have moved)
-	FSLVizEpisodeFrameData FullFrameData;
+	if (InMongoEpisodeData.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d The episode data is empty.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
 
-	// Iterate individuals with their poses
-	for (const auto& IndividualPosePair : InMongoEpisodeData[0].Value)
+	/* Individual handles (the frames are processed without any id lookups) */
+	// Map the meta indexes of the episode to the individual handles and resolve their replay targets once
+	TArray<int32> MetaToHandle = IndividualManager->GetIndividualHandles(InMongoEpisodeData.IndividualIds);
+	OutVizEpisodeData.Targets.Empty();
+	OutVizEpisodeData.Targets.SetNum(IndividualManager->GetNumIndividualHandles());
+	for (const int32 Handle : MetaToHandle)
 	{
-		const FString IndividualId = IndividualPosePair.Key;
-		const FTransform IndividualPose = IndividualPosePair.Value;
+		if (Handle != INDEX_NONE)
+		{
+			OutVizEpisodeData.Targets[Handle] = GetEpisodeTarget(IndividualManager->GetIndividualByHandle(Handle));
+		}
+	}
+	return BuildFrames(MetaToHandle, InMongoEpisodeData, OutVizEpisodeData);
+}
+
+// Build the replay episode data with already resolved replay targets, does not access the world (safe to call from worker threads)
+bool FSLVizEpisodeUtils::BuildEpisodeData(const TMap<FString, int32>& IdToHandle,
+	const TArray<FSLVizEpisodeTarget>& Targets,
+	const FSLMongoEpisodeData& InMongoEpisodeData,
+	FSLVizEpisodeData& OutVizEpisodeData)
+{
+	if (InMongoEpisodeData.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d The episode data is empty.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
 
-		if (auto Individual = IndividualManager->GetIndividual(IndividualId))
+	// Only the targets of the episode individuals are set
+	TArray<int32> MetaToHandle;
+	MetaToHandle.Reserve(InMongoEpisodeData.IndividualIds.Num());
+	OutVizEpisodeData.Targets.Empty();
+	OutVizEpisodeData.Targets.SetNum(Targets.Num());
+	for (const FString& Id : InMongoEpisodeData.IndividualIds)
+	{
+		const int32* Handle = IdToHandle.Find(Id);
+		if (Handle && Targets.IsValidIndex(*Handle))
 		{
-			if (Individual->IsA(USLRigidIndividual::StaticClass())
-			|| Individual->IsA(USLSkeletalIndividual::StaticClass())
-			|| Individual->IsA(USLVirtualViewIndividual::StaticClass()))
-			{
-				FullFrameData.ActorPoses.Emplace(Individual->GetParentActor(), IndividualPose);
-			}
-			else if (auto BI = Cast<USLBoneIndividual>(Individual))
-			{
-				FullFrameData.BonePoses.FindOrAdd(BI->GetPoseableMeshComponent()).Add(BI->GetBoneIndex(), IndividualPose);
-			}
-			else if (auto VBI = Cast<USLVirtualBoneIndividual>(Individual))
-			{
-				FullFrameData.BonePoses.FindOrAdd(VBI->GetPoseableMeshComponent()).Add(VBI->GetBoneIndex(), IndividualPose);
-			}
+			MetaToHandle.Add(*Handle);
+			OutVizEpisodeData.Targets[*Handle] = Targets[*Handle];
 		}
 		else
 		{
-			UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not find individual with id=%s, this should not happen, aborting.."),
-				*FString(__FUNCTION__), __LINE__, *IndividualPosePair.Key);
-			return false;
+			MetaToHandle.Add(INDEX_NONE);
 		}
 	}
-	// Add the timestamp
-	//OutVizEpisodeData.Timestamps[0] = InMongoEpisodeData[0].Key;
-	OutVizEpisodeData.Timestamps.Emplace(InMongoEpisodeData[0].Key);
+	return BuildFrames(MetaToHandle, InMongoEpisodeData, OutVizEpisodeData);
+}
+
+// Build the keyframes and compact frames using the meta index to handle mapping and the episode targets
+bool FSLVizEpisodeUtils::BuildFrames(const TArray<int32>& MetaToHandle,
+	const FSLMongoEpisodeData& InMongoEpisodeData,
+	FSLVizEpisodeData& OutVizEpisodeData)
+{
+	double ExecBegin = FPlatformTime::Seconds();
+	const TArray<FSLVizEpisodeTarget>& Targets = OutVizEpisodeData.Targets;
 
-	double FirstFrameDuration = FPlatformTime::Seconds() - ExecBegin;
+	/* First frame (FullFrame -  contains all the data) */
+	// Process first frame (contains all individuals -- the rest of the frames contain only individuals that have moved)
+	FSLVizEpisodeFrameData FullFrameData;
 
-	// Add the individuals poses
-	//OutVizEpisodeData.Frames[0] = FullFrameData;
-	OutVizEpisodeData.FullFrames.Emplace(FullFrameData);
-	OutVizEpisodeData.CompactFrames.Emplace(FullFrameData);
+	const int32 KeyframeInterval = FMath::Max(OutVizEpisodeData.KeyframeInterval, 1);
+	OutVizEpisodeData.KeyframeInterval = KeyframeInterval;
+	double FirstFrameDuration = 0.0;
 
-	/* Process the following frames */
 	// Update full frame with the new transform values
-	// Create compact frame holding only the changes fromt he previous frame
-	for (int32 FrameIndex = 1; FrameIndex < InMongoEpisodeData.Num(); ++FrameIndex)
+	// Create compact frame holding only the changes from the previous frame
+	for (int32 FrameIndex = 0; FrameIndex < InMongoEpisodeData.Num(); ++FrameIndex)
 	{
 		if (FrameIndex % 250 == 0) { UE_LOG(LogTemp, Log, TEXT(" processing frame %d / %d .."),  FrameIndex, InMongoEpisodeData.Num()); }
 
-		// TODO will emplace make a copy, or one needs to make one here ?
-		//FSLVizEpisodeFrameData PrevFrameCopy = FullFrameData;
+		const FSLMongoEpisodeFrame& MongoFrame = InMongoEpisodeData.Frames[FrameIndex];
 		FSLVizEpisodeFrameData CompactFrameData;
+		CompactFrameData.Poses.Reserve(MongoFrame.Poses.Num());
 
 		// Iterate individuals with their poses
-		for (const auto& IndividualPosePair : InMongoEpisodeData[FrameIndex].Value)
+		for (const auto& MetaIdxPosePair : MongoFrame.Poses)
 		{
-			const FString IndividualId = IndividualPosePair.Key;
-			const FTransform IndividualPose = IndividualPosePair.Value;
-			if (auto Individual = IndividualManager->GetIndividual(IndividualId))
-			{
-				if (Individual->IsA(USLRigidIndividual::StaticClass())
-					|| Individual->IsA(USLSkeletalIndividual::StaticClass())
-					|| Individual->IsA(USLVirtualViewIndividual::StaticClass()))
-				{
-					// Update the full frame with the new value
-					//if (auto FoundActorPose = FullFrameData.ActorPoses.Find(RI->GetParentActor())){(*FoundActorPose) = IndividualPose;}
-					FullFrameData.ActorPoses.FindChecked(Individual->GetParentActor()) = IndividualPose;
-					// Add as new data to the compact frame
-					CompactFrameData.ActorPoses.Emplace(Individual->GetParentActor(), IndividualPose);
-
-					if (IndividualId.Equals("6HI1inL7OUKmqNXGXI81YA"))
-					{
-						UE_LOG(LogTemp, Log, TEXT("%s::%d Pose=%s;"), *FString(__FUNCTION__), __LINE__, *IndividualPose.ToString());
-					}
-				}
-				else if (auto BI = Cast<USLBoneIndividual>(Individual))
-				{
-					FullFrameData.BonePoses.FindOrAdd(BI->GetPoseableMeshComponent()).Add(BI->GetBoneIndex(), IndividualPose);
-					CompactFrameData.BonePoses.FindOrAdd(BI->GetPoseableMeshComponent()).Add(BI->GetBoneIndex(), IndividualPose);
-				}
-				else if (auto VBI = Cast<USLVirtualBoneIndividual>(Individual))
-				{
-					FullFrameData.BonePoses.FindOrAdd(VBI->GetPoseableMeshComponent()).Add(VBI->GetBoneIndex(), IndividualPose);
-					CompactFrameData.BonePoses.FindOrAdd(VBI->GetPoseableMeshComponent()).Add(VBI->GetBoneIndex(), IndividualPose);
-				}
-			}
-			else
+			const int32 Handle = MetaToHandle[MetaIdxPosePair.Key];
+			if (Handle == INDEX_NONE)
 			{
 				UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not find individual with id=%s, this should not happen, aborting.."),
-					*FString(__FUNCTION__), __LINE__, *IndividualId);
+					*FString(__FUNCTION__), __LINE__, *InMongoEpisodeData.IndividualIds[MetaIdxPosePair.Key]);
 				return false;
 			}
+
+			if (Targets[Handle].IsValid())
+			{
+				FullFrameData.Set(Handle, MetaIdxPosePair.Value);
+				CompactFrameData.Add(Handle, MetaIdxPosePair.Value);
+			}
 		}
 
 		// Add the timestamp
-		//OutVizEpisodeData.Timestamps[FrameIndex] = InMongoEpisodeData[FrameIndex].Key;
-		OutVizEpisodeData.Timestamps.Emplace(InMongoEpisodeData[FrameIndex].Key);
+		OutVizEpisodeData.Timestamps.Emplace(MongoFrame.Timestamp);
 
-		// Add the individuals poses
-		//OutFullEpisodeData.Frames[FrameIndex] = FullFrameData;
-		OutVizEpisodeData.FullFrames.Emplace(FullFrameData);
-		OutVizEpisodeData.CompactFrames.Emplace(CompactFrameData);
+		// Add the individuals poses, store only the changes, and the full frame at every keyframe interval
+		if (FrameIndex % KeyframeInterval == 0)
+		{
+			OutVizEpisodeData.Keyframes.Emplace(FullFrameData);
+		}
+		OutVizEpisodeData.CompactFrames.Emplace(MoveTemp(CompactFrameData));
+
+		if (FrameIndex == 0)
+		{
+			FirstFrameDuration = FPlatformTime::Seconds() - ExecBegin;
+		}
 	}
 	
 	double FollowingFramesDuration = FPlatformTime::Seconds() - ExecBegin - FirstFrameDuration;
-	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: first frame=[%f], following frames(num=%d)=[%f], total=[%f] seconds..;"),
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: first frame=[%f], following frames(num=%d)=[%f], total=[%f] seconds; keyframes=%d (interval=%d); memory=%.2f MB..;"),
 		*FString(__func__), __LINE__, FirstFrameDuration, OutVizEpisodeData.Timestamps.Num(),
-		FollowingFramesDuration, FPlatformTime::Seconds() - ExecBegin);
+		FollowingFramesDuration, FPlatformTime::Seconds() - ExecBegin,
+		OutVizEpisodeData.Keyframes.Num(), KeyframeInterval, OutVizEpisodeData.GetAllocatedSize() / (1024.0 * 1024.0));
 	return true;
 }
 
+// Reconstruct the full frame from the nearest previous keyframe and the following compact frames
+bool FSLVizEpisodeUtils::ReconstructFrame(const FSLVizEpisodeData& InVizEpisodeData, int32 FrameIndex, FSLVizEpisodeFrameData& OutFrame)
+{
+	if (!InVizEpisodeData.CompactFrames.IsValidIndex(FrameIndex))
+	{
+		return false;
+	}
+	const int32 KeyframeIndex = InVizEpisodeData.GetKeyframeIndex(FrameIndex);
+	if (!InVizEpisodeData.Keyframes.IsValidIndex(KeyframeIndex))
+	{
+		return false;
+	}
+	OutFrame = InVizEpisodeData.Keyframes[KeyframeIndex];
+	for (int32 Idx = InVizEpisodeData.GetKeyframeFrameIndex(KeyframeIndex) + 1; Idx <= FrameIndex; ++Idx)
+	{
+		OutFrame.Merge(InVizEpisodeData.CompactFrames[Idx]);
+	}
+	return true;
+}
+
+// Build the episode with the given keyframe intervals and log the memory usage and the random seek latencies
+void FSLVizEpisodeUtils::BenchmarkKeyframeIntervals(ASLIndividualManager* IndividualManager,
+	const FSLMongoEpisodeData& InMongoEpisodeData,
+	const TArray<int32>& KeyframeIntervals, int32 NumSeeks)
+{
+	if (InMongoEpisodeData.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d The episode data is empty.."), *FString(__FUNCTION__), __LINE__);
+		return;
+	}
+
+	// Use the same seek positions for every interval
+	FRandomStream RandomStream(0);
+	TArray<int32> SeekFrameIndexes;
+	for (int32 Idx = 0; Idx < NumSeeks; ++Idx)
+	{
+		SeekFrameIndexes.Add(RandomStream.RandHelper(InMongoEpisodeData.Num()));
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Benchmarking %d frames with %d random seeks:"),
+		*FString(__FUNCTION__), __LINE__, InMongoEpisodeData.Num(), NumSeeks);
+	for (const int32 KeyframeInterval : KeyframeIntervals)
+	{
+		const double BuildStart = FPlatformTime::Seconds();
+		FSLVizEpisodeData VizEpisodeData(InMongoEpisodeData.Num(), KeyframeInterval);
+		if (!BuildEpisodeData(IndividualManager, InMongoEpisodeData, VizEpisodeData))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not build the episode data, aborting.."), *FString(__FUNCTION__), __LINE__);
+			return;
+		}
+		const double BuildDuration = FPlatformTime::Seconds() - BuildStart;
+
+		FSLVizEpisodeFrameData Frame;
+		double MaxSeekDuration = 0.0;
+		const double SeekStart = FPlatformTime::Seconds();
+		for (const int32 FrameIndex : SeekFrameIndexes)
+		{
+			const double Start = FPlatformTime::Seconds();
+			ReconstructFrame(VizEpisodeData, FrameIndex, Frame);
+			MaxSeekDuration = FMath::Max(MaxSeekDuration, FPlatformTime::Seconds() - Start);
+		}
+		const double AvgSeekDuration = NumSeeks > 0 ? (FPlatformTime::Seconds() - SeekStart) / NumSeeks : 0.0;
+
+		UE_LOG(LogTemp, Log, TEXT("\t interval=%d; keyframes=%d; memory=%.2f MB; build=%.3f s; seek avg=%.3f ms, max=%.3f ms;"),
+			VizEpisodeData.KeyframeInterval, VizEpisodeData.Keyframes.Num(), VizEpisodeData.GetAllocatedSize() / (1024.0 * 1024.0),
+			BuildDuration, AvgSeekDuration * 1000.0, MaxSeekDuration * 1000.0);
+	}
+}
+
 
 // Executes a binary search for element Item in array Array using the <= operator (from ProfilerCommon::FBinaryFindIndex)
 int32 FSLVizEpisodeUtils::BinarySearchLessEqual(const TArray<float>& Array, float Value)
@@ -0,0 +1,364 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Viz/SLVizEpisodeStreamer.h"
+#include "Viz/SLVizEpisodeUtils.h"
+#include "Individuals/SLIndividualManager.h"
+#include "Individuals/Type/SLBaseIndividual.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+
+// Ctor
+FSLVizEpisodeStreamer::FSLVizEpisodeStreamer() :
+	WindowSize(FSLVizEpisodeData::DefaultKeyframeInterval),
+	NumPrefetchWindows(4),
+	NumWindows(0),
+	WorkEvent(nullptr),
+	Thread(nullptr),
+	NumUnknownIndividuals(0)
+{
+	bStopRequested = false;
+	bFailed = false;
+}
+
+// Dtor
+FSLVizEpisodeStreamer::~FSLVizEpisodeStreamer()
+{
+	Finish();
+}
+
+// Connect to the episode, load the frame timestamps and resolve the replay targets (game thread)
+bool FSLVizEpisodeStreamer::Init(ASLIndividualManager* IndividualManager, const FString& ServerIp, uint16 ServerPort,
+	const FString& InTaskId, const FString& InEpisodeId, int32 InWindowSize, int32 InNumPrefetchWindows)
+{
+	if (Thread != nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Loader thread is already running, cannot re-init.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+	if (IndividualManager == nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Invalid individual manager.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	const double ExecBegin = FPlatformTime::Seconds();
+
+	// The loader uses its own connection, the query manager connection stays on the game thread
+	if (!DBHandler.Connect(ServerIp, ServerPort)
+		|| !DBHandler.SetDatabase(InTaskId)
+		|| !DBHandler.SetCollection(InEpisodeId))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not connect to episode %s::%s.."),
+			*FString(__FUNCTION__), __LINE__, *InTaskId, *InEpisodeId);
+		return false;
+	}
+
+	// The timestamps give the frame indexes and the window bounds before any frame data is loaded
+	DBTimestamps = DBHandler.GetEpisodeTimestamps();
+	if (DBTimestamps.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Episode %s::%s has no frames.."),
+			*FString(__FUNCTION__), __LINE__, *InTaskId, *InEpisodeId);
+		return false;
+	}
+	Timestamps.Reset(DBTimestamps.Num());
+	for (const double Ts : DBTimestamps)
+	{
+		Timestamps.Add(Ts);
+	}
+
+	EpisodeId = InEpisodeId;
+	WindowSize = FMath::Max(InWindowSize, 1);
+	NumPrefetchWindows = FMath::Max(InNumPrefetchWindows, 1);
+	NumWindows = (DBTimestamps.Num() - 1) / WindowSize + 1;
+	NumUnknownIndividuals = 0;
+	SetTargets(IndividualManager);
+	if (IdToHandle.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d There are no individuals in the world which can be replayed.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Streaming episode %s::%s: frames=%d, windows=%d (size=%d, prefetch=%d), individuals=%d, init=[%f] seconds..;"),
+		*FString(__FUNCTION__), __LINE__, *InTaskId, *InEpisodeId, Timestamps.Num(), NumWindows, WindowSize,
+		NumPrefetchWindows, IdToHandle.Num(), FPlatformTime::Seconds() - ExecBegin);
+	return true;
+}
+
+// Start the loader thread
+bool FSLVizEpisodeStreamer::Start()
+{
+	if (Thread != nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Loader thread is already running.."), *FString(__FUNCTION__), __LINE__);
+		return true;
+	}
+	if (NumWindows == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Nothing to load, call init first.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	bStopRequested = false;
+	bFailed = false;
+	PlayHeadWindow.Set(0);
+	SeekWindow.Set(0);
+	NextWindow.Set(0);
+	WorkEvent = FPlatformProcess::GetSynchEventFromPool();
+	Thread = FRunnableThread::Create(this, TEXT("SL_VizEpisodeStreamer"), 0, TPri_BelowNormal);
+	if (Thread == nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not create the episode loader thread.."), *FString(__FUNCTION__), __LINE__);
+		FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+		WorkEvent = nullptr;
+		return false;
+	}
+	return true;
+}
+
+// Signal the loader thread to stop, blocks until done
+void FSLVizEpisodeStreamer::Finish()
+{
+	if (Thread == nullptr)
+	{
+		return;
+	}
+
+	Stop();
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
+
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	WorkEvent = nullptr;
+
+	// Drop any unconsumed windows
+	LoadedWindows.Empty();
+	ReloadRequests.Empty();
+}
+
+// Set the frame currently replayed, windows are prefetched ahead of it
+void FSLVizEpisodeStreamer::SetPlayHead(int32 FrameIndex)
+{
+	const int32 Window = FMath::Clamp(FrameIndex / WindowSize, 0, NumWindows - 1);
+	if (PlayHeadWindow.Set(Window) != Window && WorkEvent)
+	{
+		WorkEvent->Trigger();
+	}
+}
+
+// Request the window of the given frame (loaded in order if ahead of the loader, reloaded otherwise)
+void FSLVizEpisodeStreamer::RequestFrame(int32 FrameIndex)
+{
+	const int32 Window = FMath::Clamp(FrameIndex / WindowSize, 0, NumWindows - 1);
+	PlayHeadWindow.Set(Window);
+	if (Window < NextWindow.GetValue())
+	{
+		ReloadRequests.Enqueue(Window);
+	}
+	else
+	{
+		SeekWindow.Set(Window);
+	}
+	if (WorkEvent)
+	{
+		WorkEvent->Trigger();
+	}
+}
+
+// Get the next loaded window (false if none available)
+bool FSLVizEpisodeStreamer::DequeueWindow(TUniquePtr<FSLVizEpisodeStreamWindow>& OutWindow)
+{
+	return LoadedWindows.Dequeue(OutWindow);
+}
+
+// Loader thread loop
+uint32 FSLVizEpisodeStreamer::Run()
+{
+	// Running full frame, the keyframes can only be built by loading the windows in order
+	FSLVizEpisodeFrameData FullFrame;
+
+	while (!bStopRequested)
+	{
+		// Reloads of evicted windows have priority, they are required by the play head
+		int32 ReloadWindow = INDEX_NONE;
+		if (ReloadRequests.Dequeue(ReloadWindow))
+		{
+			LoadWindow(ReloadWindow, nullptr, true);
+			continue;
+		}
+
+		// Load in order until the prefetch window ahead of the play head (or the seek target) is reached
+		const int32 PlayHead = PlayHeadWindow.GetValue();
+		const int32 TargetWindow = FMath::Min(FMath::Max(PlayHead + NumPrefetchWindows, SeekWindow.GetValue()), NumWindows - 1);
+		const int32 Window = NextWindow.GetValue();
+		if (Window <= TargetWindow)
+		{
+			// Windows already behind the play head are only needed for the keyframes
+			LoadWindow(Window, &FullFrame, Window + 1 >= PlayHead);
+			NextWindow.Increment();
+			continue;
+		}
+
+		// Sleep until the play head moves or a reload is requested
+		WorkEvent->Wait(50);
+	}
+	return 0;
+}
+
+// Signal the loader thread to exit
+void FSLVizEpisodeStreamer::Stop()
+{
+	bStopRequested = true;
+	if (WorkEvent)
+	{
+		WorkEvent->Trigger();
+	}
+}
+
+// Map the ids of the world individuals to handles and resolve their replay targets
+void FSLVizEpisodeStreamer::SetTargets(ASLIndividualManager* IndividualManager)
+{
+	// The episode ids are mapped per window (the meta collection is optional), so every world individual is resolved up front
+	IdToHandle.Empty();
+	Targets.Empty();
+	Targets.SetNum(IndividualManager->GetNumIndividualHandles());
+	for (USLBaseIndividual* Individual : IndividualManager->GetIndividuals())
+	{
+		const FString Id = Individual ? Individual->GetIdValue() : FString();
+		const int32 Handle = Id.IsEmpty() ? INDEX_NONE : IndividualManager->GetIndividualHandle(Id);
+		if (Handle != INDEX_NONE)
+		{
+			Targets[Handle] = FSLVizEpisodeUtils::GetEpisodeTarget(IndividualManager->GetIndividualByHandle(Handle));
+			if (Targets[Handle].IsValid())
+			{
+				IdToHandle.Add(Id, Handle);
+			}
+		}
+	}
+}
+
+// Map the individual ids of the loaded window to handles (INDEX_NONE for the individuals which cannot be replayed)
+void FSLVizEpisodeStreamer::GetWindowHandles(const TArray<FString>& WindowIds, TArray<int32>& OutHandles)
+{
+	OutHandles.Reset(WindowIds.Num());
+	for (const FString& Id : WindowIds)
+	{
+		if (const int32* Handle = IdToHandle.Find(Id))
+		{
+			OutHandles.Add(*Handle);
+		}
+		else
+		{
+			// Unknown ids are added to the mapping so they are reported only once
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not find the replay target of the individual with id=%s, its poses are skipped.."),
+				*FString(__FUNCTION__), __LINE__, *Id);
+			IdToHandle.Add(Id, INDEX_NONE);
+			OutHandles.Add(INDEX_NONE);
+			NumUnknownIndividuals++;
+		}
+	}
+}
+
+// Load the window from the database, FullFrame is updated if the window is loaded in order
+void FSLVizEpisodeStreamer::LoadWindow(int32 WindowIndex, FSLVizEpisodeFrameData* FullFrame, bool bKeepFrames)
+{
+	const double ExecBegin = FPlatformTime::Seconds();
+
+	const int32 FirstFrameIndex = WindowIndex * WindowSize;
+	const int32 NumFrames = FMath::Min(WindowSize, DBTimestamps.Num() - FirstFrameIndex);
+	const FSLMongoEpisodeData MongoData = DBHandler.GetEpisodeData(
+		DBTimestamps[FirstFrameIndex], DBTimestamps[FirstFrameIndex + NumFrames - 1]);
+	if (MongoData.Frames.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not load window %d of episode %s, stopping.."),
+			*FString(__FUNCTION__), __LINE__, WindowIndex, *EpisodeId);
+		bFailed = true;
+		bStopRequested = true;
+		return;
+	}
+
+	// The id indexes of the poses are only valid for this query (ids missing from the meta collection are appended per query)
+	TArray<int32> WindowHandles;
+	GetWindowHandles(MongoData.IndividualIds, WindowHandles);
+
+	// Align the frames by their timestamps (both sorted), frames with duplicate timestamps take the following slots
+	TArray<const FSLMongoEpisodeFrame*> SlotFrames;
+	SlotFrames.Init(nullptr, NumFrames);
+	int32 Slot = 0;
+	int32 NumSkipped = 0;
+	for (const auto& MongoFrame : MongoData.Frames)
+	{
+		while (Slot < NumFrames && Timestamps[FirstFrameIndex + Slot] < MongoFrame.Timestamp)
+		{
+			Slot++;
+		}
+		if (Slot < NumFrames && Timestamps[FirstFrameIndex + Slot] == MongoFrame.Timestamp)
+		{
+			SlotFrames[Slot++] = &MongoFrame;
+		}
+		else
+		{
+			NumSkipped++;
+		}
+	}
+	const int32 NumMissing = NumFrames + NumSkipped - MongoData.Frames.Num();
+	if (NumSkipped > 0 || NumMissing > 0)
+	{
+		// Missing frames are replayed as empty deltas (the individuals keep their previous poses)
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Window %d returned %d frames for %d timestamps (skipped=%d, missing=%d).."),
+			*FString(__FUNCTION__), __LINE__, WindowIndex, MongoData.Frames.Num(), NumFrames, NumSkipped, NumMissing);
+	}
+
+	TUniquePtr<FSLVizEpisodeStreamWindow> Window = MakeUnique<FSLVizEpisodeStreamWindow>();
+	Window->WindowIndex = WindowIndex;
+	if (bKeepFrames)
+	{
+		Window->CompactFrames.SetNum(NumFrames);
+	}
+
+	FSLVizEpisodeFrameData CompactFrame;
+	for (int32 Idx = 0; Idx < NumFrames; ++Idx)
+	{
+		CompactFrame.Reset();
+		if (SlotFrames[Idx])
+		{
+			ConvertFrame(*SlotFrames[Idx], WindowHandles, CompactFrame);
+		}
+
+		if (FullFrame)
+		{
+			FullFrame->Merge(CompactFrame);
+			if (Idx == 0)
+			{
+				Window->Keyframe = *FullFrame;
+				Window->bHasKeyframe = true;
+			}
+		}
+
+		if (bKeepFrames)
+		{
+			Window->CompactFrames[Idx] = CompactFrame;
+		}
+	}
+
+	UE_LOG(LogTemp, Verbose, TEXT("%s::%d Loaded window %d (frames=%d, keyframe=%d, compact=%d) in [%f] seconds..;"),
+		*FString(__FUNCTION__), __LINE__, WindowIndex, NumFrames, Window->bHasKeyframe, bKeepFrames,
+		FPlatformTime::Seconds() - ExecBegin);
+	LoadedWindows.Enqueue(MoveTemp(Window));
+}
+
+// Convert the database frame to a replay frame (the poses are keyed by the window individual id indexes)
+void FSLVizEpisodeStreamer::ConvertFrame(const FSLMongoEpisodeFrame& InFrame, const TArray<int32>& WindowHandles, FSLVizEpisodeFrameData& OutFrame)
+{
+	OutFrame.Poses.Reserve(InFrame.Poses.Num());
+	for (const auto& IdIdxPosePair : InFrame.Poses)
+	{
+		const int32 Handle = WindowHandles.IsValidIndex(IdIdxPosePair.Key) ? WindowHandles[IdIdxPosePair.Key] : INDEX_NONE;
+		if (Handle != INDEX_NONE)
+		{
+			OutFrame.Add(Handle, IdIdxPosePair.Value);
+		}
+	}
+}
@@ -7,6 +7,9 @@
 #include "Viz/SLVizHighlightManager.h"
 //#include "Viz/SLVizEpisodeManager.h"
 #include "Viz/SLVizEpisodeUtils.h"
+#include "Viz/SLVizEpisodeStreamer.h"
+#include "Viz/SLVizEpisodeCacheFile.h"
+#include "Viz/SLVizEpisodeCacheLoader.h"
 #include "Viz/SLVizCameraDirector.h"
 #include "Individuals/SLIndividualManager.h"
 
@@ -18,6 +21,7 @@
 #include "Components/SkeletalMeshComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "EngineUtils.h"
+#include "TimerManager.h"
 
 
 #if WITH_EDITOR
@@ -31,6 +35,7 @@ ASLVizManager::ASLVizManager()
 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = false;
 	bIsInit = false;
+	bUseEpisodeCacheFiles = true;
 
 	IndividualManager = nullptr;
 	HighlightManager = nullptr;
@@ -115,6 +120,7 @@ void ASLVizManager::Init()
 // Clear any created markers / viz components
 void ASLVizManager::Reset()
 {
+	CancelEpisodeCaching();
 	RemoveAllIndividualHighlights();
 	IndividualManager = nullptr;
 	HighlightManager = nullptr;
@@ -862,7 +868,7 @@ bool ASLVizManager::IsWorldConvertedToVisualizationMode() const
 }
 
 // Cache the episode data
-bool ASLVizManager::CacheEpisodeData(const FString& Id, const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData)
+bool ASLVizManager::CacheEpisodeData(const FString& Id, const FSLMongoEpisodeData& InMongoEpisodeData)
 {
 	if (!bIsInit)
 	{
@@ -918,6 +924,142 @@ bool ASLVizManager::LoadCachedEpisodeData(const FString& Id)
 	return true;
 }
 
+// Cache the episode from its local cache file (false if there is no valid file)
+bool ASLVizManager::CacheEpisodeDataFromFile(const FString& TaskId, const FString& Id)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+	if (IsEpisodeCached(Id))
+	{
+		return true;
+	}
+	if (!bUseEpisodeCacheFiles)
+	{
+		return false;
+	}
+
+	FSLVizEpisodeData VizEpisodeData;
+	if (FSLVizEpisodeCacheFile::Read(TaskId, Id, IndividualManager, VizEpisodeData))
+	{
+		CachedEpisodeData.Add(Id, MoveTemp(VizEpisodeData));
+		return true;
+	}
+	return false;
+}
+
+// Fetch and build the not yet cached episodes concurrently in the background, they are cached as soon as they are built
+bool ASLVizManager::CacheEpisodesAsync(const FString& ServerIp, uint16 ServerPort, const FString& TaskId, const TArray<FString>& Ids)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+	if (IsCachingEpisodes())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s episodes are already being cached, cancel first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+
+	// The local cache files are read directly, only the remaining episodes are queried
+	TArray<FString> IdsToLoad;
+	for (const FString& Id : Ids)
+	{
+		if (!IsEpisodeCached(Id) && !CacheEpisodeDataFromFile(TaskId, Id))
+		{
+			IdsToLoad.AddUnique(Id);
+		}
+	}
+	if (IdsToLoad.Num() == 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d %s all %d episodes are cached.."), *FString(__FUNCTION__), __LINE__, *GetName(), Ids.Num());
+		return true;
+	}
+
+	EpisodeCacheLoader = MakeShared<FSLVizEpisodeCacheLoader>();
+	if (!EpisodeCacheLoader->Start(IndividualManager, ServerIp, ServerPort, TaskId, IdsToLoad, bUseEpisodeCacheFiles))
+	{
+		EpisodeCacheLoader.Reset();
+		return false;
+	}
+	GetWorld()->GetTimerManager().SetTimer(EpisodeCacheTimerHandle, this, &ASLVizManager::UpdateEpisodeCaching, 0.1f, true);
+	return true;
+}
+
+// Cancel the background episode caching without blocking, the already cached episodes are kept
+void ASLVizManager::CancelEpisodeCaching()
+{
+	if (EpisodeCacheLoader.IsValid())
+	{
+		if (EpisodeCacheLoader->IsRunning())
+		{
+			UE_LOG(LogTemp, Log, TEXT("%s::%d %s cancelling, %d/%d episodes finished.."), *FString(__FUNCTION__), __LINE__,
+				*GetName(), EpisodeCacheLoader->GetNumFinished(), EpisodeCacheLoader->Num());
+		}
+		EpisodeCacheLoader->Cancel();
+		EpisodeCacheLoader.Reset();
+	}
+	if (GetWorld())
+	{
+		GetWorld()->GetTimerManager().ClearTimer(EpisodeCacheTimerHandle);
+	}
+}
+
+// True while episodes are cached in the background
+bool ASLVizManager::IsCachingEpisodes() const
+{
+	return EpisodeCacheLoader.IsValid() && EpisodeCacheLoader->IsRunning();
+}
+
+// Cache the episodes built in the background and report the progress
+void ASLVizManager::UpdateEpisodeCaching()
+{
+	if (!EpisodeCacheLoader.IsValid())
+	{
+		GetWorld()->GetTimerManager().ClearTimer(EpisodeCacheTimerHandle);
+		return;
+	}
+
+	TArray<FSLVizEpisodeData> BuiltEpisodes;
+	if (EpisodeCacheLoader->CollectFinished(BuiltEpisodes) > 0)
+	{
+		// The cache files are already written by the background tasks
+		for (FSLVizEpisodeData& EpisodeData : BuiltEpisodes)
+		{
+			const FString Id = EpisodeData.Id;
+			CachedEpisodeData.Add(Id, MoveTemp(EpisodeData));
+		}
+		UE_LOG(LogTemp, Log, TEXT("%s::%d %s cached %d new episodes, progress %d/%d.."), *FString(__FUNCTION__), __LINE__,
+			*GetName(), BuiltEpisodes.Num(), EpisodeCacheLoader->GetNumFinished(), EpisodeCacheLoader->Num());
+	}
+
+	if (!EpisodeCacheLoader->IsRunning())
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d %s background episode caching finished (%d episodes).."), *FString(__FUNCTION__), __LINE__,
+			*GetName(), EpisodeCacheLoader->Num());
+		EpisodeCacheLoader.Reset();
+		GetWorld()->GetTimerManager().ClearTimer(EpisodeCacheTimerHandle);
+	}
+}
+
+// Write the cached episode to its local cache file (read instead of querying the database in the next sessions)
+bool ASLVizManager::WriteEpisodeCacheFile(const FString& TaskId, const FString& Id) const
+{
+	if (!bIsInit || !bUseEpisodeCacheFiles)
+	{
+		return false;
+	}
+	if (!IsEpisodeCached(Id))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s the episode (%s) data is not cached.."), *FString(__FUNCTION__), __LINE__, *GetName(), *Id);
+		return false;
+	}
+	return FSLVizEpisodeCacheFile::Write(TaskId, Id, CachedEpisodeData[Id], IndividualManager);
+}
+
 // Replay cached episode 
 bool ASLVizManager::ReplayCachedEpisode(const FString& Id, const FSLVizEpisodePlayParams& Params)
 {
@@ -961,7 +1103,7 @@ bool ASLVizManager::GotoCachedEpisodeFrame(const FString& Id, float Ts)
 }
 
 // Change the data into an episode format and load it to the episode replay manager
-void ASLVizManager::LoadEpisodeData(const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData)
+void ASLVizManager::LoadEpisodeData(const FSLMongoEpisodeData& InMongoEpisodeData)
 {
 	if (!bIsInit)
 	{
@@ -988,6 +1130,30 @@ void ASLVizManager::LoadEpisodeData(const TArray<TPair<float, TMap<FString, FTra
 	}
 }
 
+// Stream the episode from the database in windows, the replay can start as soon as the first window is loaded
+bool ASLVizManager::LoadEpisodeDataStreamed(const FString& ServerIp, uint16 ServerPort, const FString& TaskId, const FString& EpisodeId, int32 NumPrefetchWindows)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+	if (!EpisodeManager->IsWorldConverted())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s cannot load episode data because the world is not set as visual only.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+
+	TSharedPtr<FSLVizEpisodeStreamer> Streamer = MakeShared<FSLVizEpisodeStreamer>();
+	if (!Streamer->Init(IndividualManager, ServerIp, ServerPort, TaskId, EpisodeId,
+		FSLVizEpisodeData::DefaultKeyframeInterval, NumPrefetchWindows))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s could not stream episode %s::%s.."), *FString(__FUNCTION__), __LINE__, *GetName(), *TaskId, *EpisodeId);
+		return false;
+	}
+	return EpisodeManager->LoadEpisodeStreamed(Streamer);
+}
+
 // Check if any episode is loaded (return the name of the episode)
 bool ASLVizManager::IsEpisodeLoaded() const
 {
@@ -1019,13 +1185,15 @@ bool ASLVizManager::PlayEpisode(FSLVizEpisodePlayParams PlayParams)
 		return false;
 	}
 	EpisodeManager->SetReplayParams(PlayParams.bLoop, PlayParams.UpdateRate, PlayParams.StepSize);
+	EpisodeManager->SetReplayClock(PlayParams.bUseClock, PlayParams.Speed);
 	if (PlayParams.StartTime < 0.f && PlayParams.EndTime < 0.f)
 	{
 		return EpisodeManager->PlayEpisode();
 	}
 	else
 	{
-		return EpisodeManager->PlayTimeline(PlayParams.StartTime, PlayParams.EndTime);
+		// Handles open ended timelines (negative end time)
+		return EpisodeManager->Play(PlayParams);
 	}
 }
 
@@ -1038,6 +1206,7 @@ bool ASLVizManager::PlayEpisodeTimeline(float StartTime, float EndTime, FSLVizEp
 		return false;
 	}
 	EpisodeManager->SetReplayParams(PlayParams.bLoop, PlayParams.UpdateRate, PlayParams.StepSize);
+	EpisodeManager->SetReplayClock(PlayParams.bUseClock, PlayParams.Speed);
 	return EpisodeManager->PlayTimeline(StartTime, EndTime);
 }
 
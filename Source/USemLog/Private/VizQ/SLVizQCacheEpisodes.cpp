@@ -6,6 +6,26 @@
 #include "Mongo/SLMongoQueryManager.h"
 #include "Viz/SLVizManager.h"
 
+#if WITH_EDITOR
+// Called when a property is changed in the editor
+void USLVizQCacheEpisodes::PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// Get the changed property name
+	FName PropertyName = (PropertyChangedEvent.Property != NULL) ?
+		PropertyChangedEvent.Property->GetFName() : NAME_None;
+
+	if (PropertyName == GET_MEMBER_NAME_CHECKED(USLVizQCacheEpisodes, bCancelButton))
+	{
+		bCancelButton = false;
+		if (IsReadyForManualExecution())
+		{
+			KnowrobManager->GetVizManager()->CancelEpisodeCaching();
+		}
+	}
+}
+#endif // WITH_EDITOR
 
 // Virtual implementation of the execute function
 void USLVizQCacheEpisodes::ExecuteImpl(ASLKnowrobManager* KRManager)
@@ -13,15 +33,31 @@ void USLVizQCacheEpisodes::ExecuteImpl(ASLKnowrobManager* KRManager)
 	ASLVizManager* VizManager = KRManager->GetVizManager();
 	ASLMongoQueryManager* MongoQueryManager = KRManager->GetMongoQueryManager();
 
+	// Only the registration of the built episodes runs on the game thread
+	if (bAsync)
+	{
+		if (!VizManager->CacheEpisodesAsync(MongoQueryManager->GetServerIp(), MongoQueryManager->GetServerPort(), Task, Episodes))
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Could not start caching the episodes of %s, execution aborted .."),
+				*FString(__FUNCTION__), __LINE__, *Task);
+		}
+		return;
+	}
+
 	for (const auto Episode : Episodes)
 	{
-		if (!VizManager->IsEpisodeCached(Episode))
+		// Episodes are immutable, a local cache file from a previous session is used instead of the database
+		if (!VizManager->IsEpisodeCached(Episode) && !VizManager->CacheEpisodeDataFromFile(Task, Episode))
 		{
 			UE_LOG(LogTemp, Log, TEXT("%s::%d Collecting episode %s::%s .."),
 				*FString(__FUNCTION__), __LINE__, *Task, *Episode);
 
 			auto EpisodeData = MongoQueryManager->GetEpisodeData(Task, Episode);
-			if (!VizManager->CacheEpisodeData(Episode, EpisodeData))
+			if (VizManager->CacheEpisodeData(Episode, EpisodeData))
+			{
+				VizManager->WriteEpisodeCacheFile(Task, Episode);
+			}
+			else
 			{
 				UE_LOG(LogTemp, Error, TEXT("%s::%d Could not cache episode %s::%s, execution aborted .."),
 					*FString(__FUNCTION__), __LINE__, *Task, *Episode);
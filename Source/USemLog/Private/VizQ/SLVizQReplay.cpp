@@ -37,7 +37,14 @@ void USLVizQReplay::PostEditChangeProperty(struct FPropertyChangedEvent& Propert
 		{
 			if (IsReadyForManualExecution())
 			{
-				KnowrobManager->GetVizManager()->GotoCachedEpisodeFrame(Episode, StartTime);
+				if (bStream)
+				{
+					KnowrobManager->GetVizManager()->GotoEpisodeFrame(StartTime);
+				}
+				else
+				{
+					KnowrobManager->GetVizManager()->GotoCachedEpisodeFrame(Episode, StartTime);
+				}
 			}
 		}
 	}
@@ -50,8 +57,39 @@ void USLVizQReplay::ExecuteImpl(ASLKnowrobManager* KRManager)
 	ASLVizManager* VizManager = KRManager->GetVizManager();
 	ASLMongoQueryManager* MongoQueryManager = KRManager->GetMongoQueryManager();
 
-	// Retrieve and cache episode
-	if (!VizManager->IsEpisodeCached(Episode))
+	// Stream the episode, the frames are applied as soon as their windows are loaded
+	if (bStream)
+	{
+		if (!VizManager->LoadEpisodeDataStreamed(MongoQueryManager->GetServerIp(), MongoQueryManager->GetServerPort(), Task, Episode))
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Could not stream episode %s::%s, execution aborted .."),
+				*FString(__FUNCTION__), __LINE__, *Task, *Episode);
+			return;
+		}
+
+		if (Type == ESLVizQReplayType::Goto)
+		{
+			VizManager->GotoEpisodeFrame(StartTime);
+		}
+		else if (Type == ESLVizQReplayType::Replay)
+		{
+			FSLVizEpisodePlayParams Params;
+			Params.StartTime = StartTime;
+			Params.EndTime = EndTime;
+			Params.bLoop = bLoop;
+			Params.UpdateRate = UpdateRate;
+			Params.StepSize = StepSize;
+			Params.bUseClock = bUseClock;
+			Params.Speed = Speed;
+		Params.bUseClock = bUseClock;
+		Params.Speed = Speed;
+			VizManager->PlayEpisode(Params);
+		}
+		return;
+	}
+
+	// Retrieve and cache episode (from the local cache file if available)
+	if (!VizManager->IsEpisodeCached(Episode) && !VizManager->CacheEpisodeDataFromFile(Task, Episode))
 	{
 		UE_LOG(LogTemp, Log, TEXT("%s::%d Collecting episode %s::%s .."),
 			*FString(__FUNCTION__), __LINE__, *Task, *Episode);
@@ -62,6 +100,7 @@ void USLVizQReplay::ExecuteImpl(ASLKnowrobManager* KRManager)
 				*FString(__FUNCTION__), __LINE__, *Task, *Episode);
 			return;
 		}
+		VizManager->WriteEpisodeCacheFile(Task, Episode);
 	}
 
 	// Execute task
@@ -77,6 +116,8 @@ void USLVizQReplay::ExecuteImpl(ASLKnowrobManager* KRManager)
 		Params.bLoop = bLoop;
 		Params.UpdateRate = UpdateRate;
 		Params.StepSize = StepSize;
+		Params.bUseClock = bUseClock;
+		Params.Speed = Speed;
 		VizManager->ReplayCachedEpisode(Episode, Params);
 	}
 }